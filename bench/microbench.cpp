@@ -0,0 +1,428 @@
+/*
+  ISC License
+
+  Copyright (c) 2016, Antonio SJ Musumeci <trapexit@spawn.link>
+
+  Permission to use, copy, modify, and/or distribute this software for any
+  purpose with or without fee is hereby granted, provided that the above
+  copyright notice and this permission notice appear in all copies.
+
+  THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+  WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+  MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+  ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+  WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+  ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+  OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+*/
+
+/*
+  Microbenchmarks for the CPU side of bbf: bad block list parsing,
+  the block to file map, sense decoding, identity parsing and burnin
+  pattern generation / comparison and the restore CRC32C. Built and run with `make bench`.
+
+  Each benchmark is repeated until it has run for at least MIN_TIME
+  seconds and the average per operation is reported. The numbers are
+  only meaningful relative to another build on the same machine.
+*/
+
+#include "badblockfile.hpp"
+#include "badblockset.hpp"
+#include "blocktofilemapper.hpp"
+#include "bufpool.hpp"
+#include "crc32c.hpp"
+#include "pattern.hpp"
+#include "sensedata.hpp"
+#include "sg.hpp"
+#include "time.hpp"
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <iomanip>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+namespace l
+{
+  static const double MIN_TIME = 0.5;
+
+  static volatile uint64_t sink;
+
+  typedef void (*Func)(void);
+
+  struct Bench
+  {
+    const char *name;
+    Func        func;
+    uint64_t    ops;
+    const char *unit;
+  };
+
+  static
+  uint64_t
+  xorshift(uint64_t &state_)
+  {
+    state_ ^= (state_ << 13);
+    state_ ^= (state_ >> 7);
+    state_ ^= (state_ << 17);
+
+    return state_;
+  }
+
+  /* bad block lists */
+
+  static const uint64_t BADBLOCK_COUNT = 100000;
+
+  static std::string           badblock_path;
+  static std::vector<uint64_t> badblocks;
+
+  static
+  void
+  badblocks_setup(void)
+  {
+    int fd;
+    char path[] = "/tmp/bbf-bench.XXXXXX";
+    uint64_t rng = 1;
+
+    fd = ::mkstemp(path);
+    if(fd >= 0)
+      ::close(fd);
+    badblock_path = path;
+
+    for(uint64_t i = 0; i < BADBLOCK_COUNT; i++)
+      badblocks.push_back(xorshift(rng) % 0xFFFFFFFFFULL);
+    std::sort(badblocks.begin(),badblocks.end());
+  }
+
+  static
+  void
+  badblockfile_write(void)
+  {
+    BadBlockFile::write(badblock_path,badblocks);
+  }
+
+  static
+  void
+  badblockfile_read(void)
+  {
+    std::vector<uint64_t> blocks;
+
+    BadBlockFile::read(badblock_path,blocks);
+    sink += blocks.size();
+  }
+
+  static
+  void
+  badblockfile_to_runs(void)
+  {
+    std::vector<BadBlockFile::Run> runs;
+
+    BadBlockFile::to_runs(badblocks,runs);
+    sink += runs.size();
+  }
+
+  /* appends in scan order, then the same list merged in again */
+  static
+  void
+  badblockset_insert(void)
+  {
+    BadBlockSet set;
+
+    for(uint64_t i = 0; i < BADBLOCK_COUNT; i++)
+      set.insert(badblocks[i]);
+    set.insert(badblocks);
+    sink += set.run_count();
+  }
+
+  /* block to file map */
+
+  static const uint64_t FILE_COUNT   = 10000;
+  static const uint64_t EXTENT_COUNT = 200000;
+  static const uint64_t FIND_COUNT   = 100000;
+
+  static std::vector<std::string>         paths;
+  static std::vector<BlockToFileMapper::Extent> extents;
+  static BlockToFileMapper                b2fm;
+
+  /*
+    Files of 20 extents each laid out with some fragmentation: most
+    extents follow the previous one of the same file so compress()
+    has work, the rest jump elsewhere. Shuffled into walk order.
+  */
+  static
+  void
+  b2fm_setup(void)
+  {
+    uint64_t rng = 2;
+    uint64_t block = 0;
+
+    for(uint64_t i = 0; i < FILE_COUNT; i++)
+      {
+        std::ostringstream os;
+
+        os << "/mnt/data/dir" << (i % 100) << "/file" << i;
+        paths.push_back(os.str());
+      }
+
+    for(uint64_t i = 0; i < EXTENT_COUNT; i++)
+      {
+        BlockToFileMapper::Extent extent;
+
+        if((xorshift(rng) % 4) == 0)
+          block += (xorshift(rng) % 4096);
+
+        extent.start  = block;
+        extent.length = (1 + (xorshift(rng) % 256));
+        extent.file   = (i / (EXTENT_COUNT / FILE_COUNT));
+        block        += extent.length;
+
+        extents.push_back(extent);
+      }
+
+    for(uint64_t i = extents.size() - 1; i > 0; i--)
+      std::swap(extents[i],extents[xorshift(rng) % (i + 1)]);
+
+    std::vector<BlockToFileMapper::Extent> copy(extents);
+    b2fm.load(paths,copy);
+  }
+
+  static
+  void
+  b2fm_build(void)
+  {
+    BlockToFileMapper m;
+    std::vector<BlockToFileMapper::Extent> copy(extents);
+
+    m.load(paths,copy);
+    sink += m.size();
+  }
+
+  static
+  void
+  b2fm_find(void)
+  {
+    uint64_t rng = 3;
+    const uint64_t end = (b2fm.start(b2fm.size() - 1) +
+                          b2fm.length(b2fm.size() - 1));
+
+    for(uint64_t i = 0; i < FIND_COUNT; i++)
+      sink += b2fm.find(xorshift(rng) % end).first;
+  }
+
+  static
+  void
+  b2fm_find_batch(void)
+  {
+    uint64_t rng = 3;
+    std::vector<uint64_t> blocks;
+    std::vector<BlockToFileMapper::Match> matches;
+    const uint64_t end = (b2fm.start(b2fm.size() - 1) +
+                          b2fm.length(b2fm.size() - 1));
+
+    blocks.reserve(FIND_COUNT);
+    for(uint64_t i = 0; i < FIND_COUNT; i++)
+      blocks.push_back(xorshift(rng) % end);
+    std::sort(blocks.begin(),blocks.end());
+
+    b2fm.find_all(blocks,matches);
+    sink += matches.size();
+  }
+
+  /* sense data & identity */
+
+  static
+  void
+  sense_asc_ascq(void)
+  {
+    int rv = 0;
+
+    for(unsigned int asc = 0; asc < 256; asc++)
+      for(unsigned int ascq = 0; ascq < 256; ascq++)
+        rv += SenseData::asc_ascq_to_errno(asc,ascq);
+
+    sink += rv;
+  }
+
+  static
+  void
+  sense_to_string(void)
+  {
+    uint64_t rv = 0;
+
+    for(unsigned int code = 0; code < 65536; code++)
+      rv += (uintptr_t)SenseData::error_to_string(code << 16);
+
+    sink += rv;
+  }
+
+  static
+  void
+  sense_decode(void)
+  {
+    uint64_t rv = 0;
+    SenseData::Decoded decoded;
+    uint8_t sb[34] =
+      {
+        0x72,0x03,0x11,0x04,0x00,0x00,0x00,0x1A,
+        0x00,0x0A,0x80,0x00,0x00,0x00,0x00,0x00,0x12,0x34,0x56,0x78,
+        0x09,0x0C,0x00,0x40,0x00,0x01,0x00,0x78,0x00,0x56,0x00,0x34,0x40,0x51
+      };
+
+    for(unsigned int i = 0; i < 1000; i++)
+      {
+        sb[19] = i;
+        SenseData::decode(sb,sizeof(sb),decoded);
+        rv += (decoded.info + decoded.ata_lba);
+      }
+
+    sink += rv;
+  }
+
+  static char identity_buf[256*2];
+
+  static
+  void
+  identity_setup(void)
+  {
+    uint64_t rng = 4;
+
+    for(size_t i = 0; i < sizeof(identity_buf); i++)
+      identity_buf[i] = (char)(' ' + (xorshift(rng) % 64));
+  }
+
+  static
+  void
+  identity_parse(void)
+  {
+    sg::identity ident;
+
+    for(int i = 0; i < 1000; i++)
+      {
+        sg::buf_to_identity(identity_buf,ident);
+        sink += ident.rpm;
+      }
+  }
+
+  /* burnin patterns */
+
+  static const uint64_t PATTERN_BLOCKS = 2048;
+  static const uint64_t PATTERN_BS     = 512;
+
+  static char *pattern_buf;
+
+  static
+  void
+  pattern_setup(void)
+  {
+    pattern_buf = (char*)BufPool::get(PATTERN_BLOCKS * PATTERN_BS);
+  }
+
+  static
+  void
+  pattern_run(const Pattern::Type type_)
+  {
+    Pattern::Pattern p;
+
+    p.type  = type_;
+    p.value = ((type_ == Pattern::CONSTANT) ? 0x55 : 0x1234);
+
+    Pattern::fill(p,pattern_buf,0,PATTERN_BLOCKS,PATTERN_BS);
+    sink += Pattern::verify(p,pattern_buf,0,PATTERN_BLOCKS,PATTERN_BS);
+  }
+
+  static void pattern_constant(void) { pattern_run(Pattern::CONSTANT); }
+  static void pattern_lba(void)      { pattern_run(Pattern::LBA); }
+  static void pattern_random(void)   { pattern_run(Pattern::RANDOM); }
+
+  /* burnin restore check */
+
+  static
+  void
+  crc32c_block(void)
+  {
+    for(uint64_t i = 0; i < PATTERN_BLOCKS; i++)
+      sink += CRC32C::calculate(&pattern_buf[i * PATTERN_BS],PATTERN_BS);
+  }
+
+  static
+  void
+  run(const Bench &bench_)
+  {
+    uint64_t iterations;
+    double begin;
+    double elapsed;
+
+    bench_.func();
+
+    iterations = 0;
+    begin      = Time::get_monotonic();
+    do
+      {
+        bench_.func();
+        iterations++;
+        elapsed = (Time::get_monotonic() - begin);
+      }
+    while(elapsed < MIN_TIME);
+
+    std::cout << std::left
+              << std::setw(24) << bench_.name
+              << std::right << std::fixed
+              << std::setprecision(2)
+              << std::setw(14) << ((elapsed / iterations) * 1000000.0) << " us/iter"
+              << std::setw(14) << ((bench_.ops * iterations) / elapsed / 1000000.0)
+              << " M" << bench_.unit << "/s"
+              << std::endl;
+  }
+}
+
+int
+main(int    argc_,
+     char **argv_)
+{
+  static const l::Bench benches[] =
+    {
+      {"badblockfile_write", l::badblockfile_write,   l::BADBLOCK_COUNT,        "blocks"},
+      {"badblockfile_read",  l::badblockfile_read,    l::BADBLOCK_COUNT,        "blocks"},
+      {"badblockfile_runs",  l::badblockfile_to_runs, l::BADBLOCK_COUNT,        "blocks"},
+      {"badblockset_insert", l::badblockset_insert,   l::BADBLOCK_COUNT * 2,    "blocks"},
+      {"b2fm_build",         l::b2fm_build,           l::EXTENT_COUNT,          "extents"},
+      {"b2fm_find",          l::b2fm_find,            l::FIND_COUNT,            "lookups"},
+      {"b2fm_find_batch",    l::b2fm_find_batch,      l::FIND_COUNT,            "lookups"},
+      {"sense_asc_ascq",     l::sense_asc_ascq,       65536,                    "lookups"},
+      {"sense_to_string",    l::sense_to_string,      65536,                    "lookups"},
+      {"sense_decode",       l::sense_decode,         1000,                     "decodes"},
+      {"identity_parse",     l::identity_parse,       1000,                     "parses"},
+      {"pattern_constant",   l::pattern_constant,     l::PATTERN_BLOCKS * l::PATTERN_BS, "bytes"},
+      {"pattern_lba",        l::pattern_lba,          l::PATTERN_BLOCKS * l::PATTERN_BS, "bytes"},
+      {"pattern_random",     l::pattern_random,       l::PATTERN_BLOCKS * l::PATTERN_BS, "bytes"},
+      {"crc32c_block",       l::crc32c_block,         l::PATTERN_BLOCKS * l::PATTERN_BS, "bytes"},
+    };
+  const size_t count = (sizeof(benches) / sizeof(benches[0]));
+
+  l::badblocks_setup();
+  l::b2fm_setup();
+  l::identity_setup();
+  l::pattern_setup();
+
+  std::cout << "pattern isa: " << Pattern::isa() << std::endl
+            << "crc32c isa: " << CRC32C::isa() << std::endl;
+  for(size_t i = 0; i < count; i++)
+    {
+      if((argc_ > 1) && !strstr(benches[i].name,argv_[1]))
+        continue;
+
+      l::run(benches[i]);
+    }
+
+  ::unlink(l::badblock_path.c_str());
+  BufPool::put(l::pattern_buf);
+
+  return 0;
+}
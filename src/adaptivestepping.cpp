@@ -0,0 +1,125 @@
+/*
+  ISC License
+
+  Copyright (c) 2016, Antonio SJ Musumeci <trapexit@spawn.link>
+
+  Permission to use, copy, modify, and/or distribute this software for any
+  purpose with or without fee is hereby granted, provided that the above
+  copyright notice and this permission notice appear in all copies.
+
+  THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+  WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+  MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+  ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+  WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+  ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+  OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+*/
+
+#include "adaptivestepping.hpp"
+#include "math.hpp"
+
+#include <stdint.h>
+
+#include <algorithm>
+
+/* successful requests at one size before trying the next */
+static const uint64_t GROW_AFTER = 8;
+/* requests held at the minimum size after an error */
+static const uint64_t ERROR_COOLDOWN = 256;
+/* allowed increase in time per block before shrinking */
+static const double SLOWDOWN_FACTOR = 1.25;
+/* largest request: ATA sector count limit and buffer size */
+static const uint64_t MAX_BLOCKS = 65536;
+static const uint64_t MAX_BYTES  = (16 * 1024 * 1024);
+
+AdaptiveStepping::AdaptiveStepping(const uint64_t min_stepping_,
+                                   const uint64_t max_stepping_)
+  : _min(min_stepping_ ? min_stepping_ : 1),
+    _max(max_stepping_),
+    _stepping(_min),
+    _successes(0),
+    _cooldown(0),
+    _best_spb(0),
+    _last_spb(0)
+{
+  if(_max < _min)
+    _max = _min;
+}
+
+uint64_t
+AdaptiveStepping::limit(const uint64_t min_stepping_,
+                        const uint64_t block_size_)
+{
+  uint64_t max;
+  uint64_t limit;
+
+  limit = std::min(MAX_BLOCKS,(MAX_BYTES / block_size_));
+
+  max = min_stepping_;
+  while((max * 2) <= limit)
+    max *= 2;
+
+  return max;
+}
+
+uint64_t
+AdaptiveStepping::stepping_at(const uint64_t block_) const
+{
+  uint64_t boundary;
+
+  boundary = (math::round_down(block_,_stepping) + _stepping);
+
+  return (boundary - block_);
+}
+
+void
+AdaptiveStepping::success(const uint64_t blocks_,
+                          const double   seconds_)
+{
+  double spb;
+
+  if(blocks_ == 0)
+    return;
+
+  if(_cooldown)
+    {
+      _cooldown--;
+      return;
+    }
+
+  spb = (seconds_ / blocks_);
+  _last_spb = ((_last_spb == 0) ? spb : ((_last_spb * 0.75) + (spb * 0.25)));
+
+  if(++_successes < GROW_AFTER)
+    return;
+
+  _successes = 0;
+
+  if((_best_spb == 0) || (_last_spb < _best_spb))
+    _best_spb = _last_spb;
+
+  if((_last_spb > (_best_spb * SLOWDOWN_FACTOR)) && (_stepping > _min))
+    {
+      _stepping /= 2;
+      _max       = _stepping;
+      _last_spb  = 0;
+      return;
+    }
+
+  if((_stepping * 2) <= _max)
+    {
+      _stepping *= 2;
+      _last_spb  = 0;
+    }
+}
+
+void
+AdaptiveStepping::failure(void)
+{
+  _stepping  = _min;
+  _successes = 0;
+  _cooldown  = ERROR_COOLDOWN;
+  _last_spb  = 0;
+  _best_spb  = 0;
+}
@@ -0,0 +1,65 @@
+/*
+  ISC License
+
+  Copyright (c) 2016, Antonio SJ Musumeci <trapexit@spawn.link>
+
+  Permission to use, copy, modify, and/or distribute this software for any
+  purpose with or without fee is hereby granted, provided that the above
+  copyright notice and this permission notice appear in all copies.
+
+  THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+  WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+  MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+  ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+  WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+  ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+  OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+*/
+
+#pragma once
+
+#include <stdint.h>
+
+/*
+  Picks the number of blocks per request for scan and burnin. Starts
+  at the minimum stepping and doubles the request size after a run of
+  successful requests so long as the time per block doesn't get
+  worse. A size which turns out slower is backed off from and becomes
+  the new maximum. After an error it drops back to the minimum and
+  holds there for a while so the area around the error is read in
+  small pieces.
+
+  Request sizes are always the minimum times a power of 2 and requests
+  never cross a boundary of their own size so everything stays aligned
+  to the minimum stepping.
+*/
+
+class AdaptiveStepping
+{
+public:
+  AdaptiveStepping(const uint64_t min_stepping,
+                   const uint64_t max_stepping);
+
+public:
+  static uint64_t limit(const uint64_t min_stepping,
+                        const uint64_t block_size);
+
+public:
+  uint64_t stepping(void) const { return _stepping; }
+  uint64_t max_stepping(void) const { return _max; }
+  uint64_t stepping_at(const uint64_t block) const;
+
+public:
+  void success(const uint64_t blocks,
+               const double   seconds);
+  void failure(void);
+
+private:
+  uint64_t _min;
+  uint64_t _max;
+  uint64_t _stepping;
+  uint64_t _successes;
+  uint64_t _cooldown;
+  double   _best_spb;
+  double   _last_spb;
+};
@@ -0,0 +1,1095 @@
+/*
+  ISC License
+
+  Copyright (c) 2016, Antonio SJ Musumeci <trapexit@spawn.link>
+
+  Permission to use, copy, modify, and/or distribute this software for any
+  purpose with or without fee is hereby granted, provided that the above
+  copyright notice and this permission notice appear in all copies.
+
+  THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+  WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+  MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+  ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+  WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+  ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+  OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+*/
+
+#include "asyncio.hpp"
+#include "nvme.hpp"
+#include "scsi.hpp"
+#include "sg.hpp"
+#include "simdev.hpp"
+#include "throttle.hpp"
+#include "time.hpp"
+
+#include <errno.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <linux/aio_abi.h>
+#include <linux/io_uring.h>
+#include <linux/nvme_ioctl.h>
+#include <stdint.h>
+#include <string.h>
+#include <scsi/sg.h>
+#include <sys/ioctl.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <sys/uio.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <vector>
+
+namespace l
+{
+  static
+  int
+  io_uring_setup(const unsigned int      entries_,
+                 struct io_uring_params *params_)
+  {
+    return ::syscall(__NR_io_uring_setup,entries_,params_);
+  }
+
+  static
+  int
+  io_uring_enter(const int          fd_,
+                 const unsigned int to_submit_,
+                 const unsigned int min_complete_,
+                 const unsigned int flags_)
+  {
+    return ::syscall(__NR_io_uring_enter,fd_,to_submit_,min_complete_,flags_,NULL,0);
+  }
+
+  static
+  int
+  io_setup(const unsigned int  nr_,
+           aio_context_t      *ctx_)
+  {
+    return ::syscall(__NR_io_setup,nr_,ctx_);
+  }
+
+  static
+  int
+  io_destroy(aio_context_t ctx_)
+  {
+    return ::syscall(__NR_io_destroy,ctx_);
+  }
+
+  static
+  int
+  io_submit(aio_context_t   ctx_,
+            long            nr_,
+            struct iocb   **iocbpp_)
+  {
+    return ::syscall(__NR_io_submit,ctx_,nr_,iocbpp_);
+  }
+
+  static
+  int
+  io_getevents(aio_context_t    ctx_,
+               long             min_nr_,
+               long             max_nr_,
+               struct io_event *events_)
+  {
+    return ::syscall(__NR_io_getevents,ctx_,min_nr_,max_nr_,events_,NULL);
+  }
+
+  template<typename T>
+  static
+  T*
+  offset(void           *base_,
+         const uint32_t  off_)
+  {
+    return (T*)((char*)base_ + off_);
+  }
+}
+
+AsyncIO::AsyncIO()
+  : _backend(NONE),
+    _fd(-1),
+    _depth(0),
+    _pending(0),
+    _aio_ctx(0),
+    _sg_block_size(0),
+    _sg_xfer(SG_PIO),
+    _sg_timeout(0),
+    _sg_verify(false),
+    _sg_scsi(false),
+    _nvme_nsid(0),
+    _nvme_block_size(0),
+    _nvme_timeout(0),
+    _nvme_verify(false),
+    _sim(NULL),
+    _throttle(NULL)
+{
+  ::memset(&_uring,0,sizeof(_uring));
+  _uring.fd = -1;
+}
+
+AsyncIO::~AsyncIO()
+{
+  destroy();
+}
+
+const
+char*
+AsyncIO::backend_to_string(const Backend backend_)
+{
+  switch(backend_)
+    {
+    case IO_URING:
+      return "io_uring";
+    case LIBAIO:
+      return "libaio";
+    case SG:
+      return "sg";
+    case NVME:
+      return "nvme";
+    case SIM:
+      return "sim";
+    case NONE:
+    default:
+      return "none";
+    }
+}
+
+int
+AsyncIO::init(const int          fd_,
+              const unsigned int depth_)
+{
+  int rv;
+
+  destroy();
+
+  if(depth_ == 0)
+    return -EINVAL;
+
+  _fd      = fd_;
+  _depth   = depth_;
+  _pending = 0;
+
+  rv = uring_init();
+  if(rv == 0)
+    {
+      _backend = IO_URING;
+      return 0;
+    }
+
+  rv = aio_init();
+  if(rv == 0)
+    {
+      _backend = LIBAIO;
+      return 0;
+    }
+
+  _fd    = -1;
+  _depth =  0;
+
+  return rv;
+}
+
+/*
+  The sg driver limits each file descriptor to SG_MAX_QUEUE (16)
+  outstanding commands so depth is clamped to that.
+*/
+int
+AsyncIO::init_sg(const std::string  &path_,
+                 const unsigned int  depth_,
+                 const uint64_t      block_size_,
+                 const int           xfer_,
+                 const int           timeout_,
+                 const bool          verify_)
+{
+  int rv;
+  int version;
+
+  destroy();
+
+  if((depth_ == 0) || (block_size_ == 0))
+    return -EINVAL;
+  if(path_.empty())
+    return -ENODEV;
+
+  _fd = ::open(path_.c_str(),O_RDWR|O_NONBLOCK);
+  if(_fd == -1)
+    {
+      rv  = -errno;
+      _fd = -1;
+      return rv;
+    }
+
+  rv = ::ioctl(_fd,SG_GET_VERSION_NUM,&version);
+  if((rv == -1) || (version < 30000))
+    {
+      ::close(_fd);
+      _fd = -1;
+      return -ENOTSUP;
+    }
+
+  _backend       = SG;
+  _depth         = std::min(depth_,(unsigned int)SG_MAX_QUEUE);
+  _pending       = 0;
+  _sg_block_size = block_size_;
+  _sg_xfer       = xfer_;
+  _sg_timeout    = timeout_;
+  _sg_verify     = verify_;
+  _sg_scsi       = false;
+  _sg_requests.resize(_depth);
+  _sg_queued.reserve(_depth);
+
+  return 0;
+}
+
+int
+AsyncIO::init_scsi(const std::string  &path_,
+                   const unsigned int  depth_,
+                   const uint64_t      block_size_,
+                   const int           timeout_,
+                   const bool          verify_)
+{
+  int rv;
+
+  rv = init_sg(path_,depth_,block_size_,SG_PIO,timeout_,verify_);
+  if(rv < 0)
+    return rv;
+
+  _sg_scsi = true;
+
+  return 0;
+}
+
+/*
+  The generic device belongs to the same namespace as the block
+  device so offsets and lengths, which are in bytes like the other
+  backends, become LBAs of the namespace's block size.
+*/
+int
+AsyncIO::init_nvme(const std::string  &path_,
+                   const unsigned int  depth_,
+                   const uint32_t      nsid_,
+                   const uint64_t      block_size_,
+                   const int           timeout_,
+                   const bool          verify_)
+{
+  int rv;
+
+  destroy();
+
+  if((depth_ == 0) || (block_size_ == 0) || (nsid_ == 0))
+    return -EINVAL;
+  if(path_.empty())
+    return -ENODEV;
+
+  _fd = ::open(path_.c_str(),O_RDWR);
+  if(_fd == -1)
+    {
+      rv  = -errno;
+      _fd = -1;
+      return rv;
+    }
+
+  _depth   = depth_;
+  _pending = 0;
+
+  rv = uring_init(IORING_SETUP_SQE128|IORING_SETUP_CQE32);
+  if(rv < 0)
+    {
+      ::close(_fd);
+      _fd    = -1;
+      _depth =  0;
+      return rv;
+    }
+
+  _backend         = NVME;
+  _nvme_nsid       = nsid_;
+  _nvme_block_size = block_size_;
+  _nvme_timeout    = timeout_;
+  _nvme_verify     = verify_;
+  _nvme_len.assign(_depth,0);
+
+  return 0;
+}
+
+int
+AsyncIO::init_sim(const int           fd_,
+                  const unsigned int  depth_,
+                  SimDev             *sim_)
+{
+  destroy();
+
+  if((depth_ == 0) || (sim_ == NULL))
+    return -EINVAL;
+
+  _backend = SIM;
+  _fd      = fd_;
+  _depth   = depth_;
+  _pending = 0;
+  _sim     = sim_;
+
+  return 0;
+}
+
+void
+AsyncIO::destroy(void)
+{
+  switch(_backend)
+    {
+    case IO_URING:
+      uring_destroy();
+      break;
+    case LIBAIO:
+      aio_destroy();
+      break;
+    case SG:
+      sg_destroy();
+      break;
+    case NVME:
+      uring_destroy();
+      ::close(_fd);
+      _nvme_len.clear();
+      break;
+    case SIM:
+      _sim = NULL;
+      _sim_due.clear();
+      break;
+    case NONE:
+      break;
+    }
+
+  _backend  = NONE;
+  _fd       = -1;
+  _depth    = 0;
+  _pending  = 0;
+  _throttle = NULL;
+  _submitted.clear();
+}
+
+void
+AsyncIO::set_throttle(Throttle *throttle_)
+{
+  _throttle = throttle_;
+  _submitted.assign(_depth,0);
+}
+
+int
+AsyncIO::submit(const unsigned int  slot_,
+                const Op            op_,
+                const uint64_t      offset_,
+                void               *buf_,
+                const uint64_t      len_)
+{
+  if(slot_ >= _depth)
+    return -EINVAL;
+
+  if(_throttle != NULL)
+    {
+      double seconds;
+
+      seconds = _throttle->reserve(len_);
+      if(seconds > 0)
+        {
+          flush();
+          Time::sleep(seconds);
+        }
+      _submitted[slot_] = Time::get_monotonic();
+    }
+
+  switch(_backend)
+    {
+    case IO_URING:
+      return uring_submit(slot_,op_,offset_,buf_,len_);
+    case LIBAIO:
+      return aio_submit(slot_,op_,offset_,buf_,len_);
+    case SG:
+      return sg_submit(slot_,op_,offset_,buf_,len_);
+    case NVME:
+      return nvme_submit(slot_,op_,offset_,buf_,len_);
+    case SIM:
+      return sim_submit(slot_,op_,offset_,buf_,len_);
+    case NONE:
+      break;
+    }
+
+  return -ENOTSUP;
+}
+
+int
+AsyncIO::flush(void)
+{
+  switch(_backend)
+    {
+    case IO_URING:
+    case NVME:
+      return uring_flush();
+    case LIBAIO:
+      return aio_flush();
+    case SG:
+      return sg_flush();
+    case SIM:
+      return 0;
+    case NONE:
+      break;
+    }
+
+  return -ENOTSUP;
+}
+
+/*
+  Returns the number of completions appended to `completions`. An
+  interrupted wait returns 0 so the caller can react to signals.
+*/
+int
+AsyncIO::reap(std::vector<Completion> &completions_,
+              const unsigned int       min_)
+{
+  int rv;
+  double now;
+  const size_t count = completions_.size();
+
+  rv = -ENOTSUP;
+  switch(_backend)
+    {
+    case IO_URING:
+      rv = uring_reap(completions_,min_);
+      break;
+    case LIBAIO:
+      rv = aio_reap(completions_,min_);
+      break;
+    case SG:
+      rv = sg_reap(completions_,min_);
+      break;
+    case NVME:
+      rv = nvme_reap(completions_,min_);
+      break;
+    case SIM:
+      rv = sim_reap(completions_,min_);
+      break;
+    case NONE:
+      break;
+    }
+
+  if((_throttle == NULL) || (rv < 0))
+    return rv;
+
+  now = Time::get_monotonic();
+  for(size_t i = count; i < completions_.size(); i++)
+    _throttle->observe(now - _submitted[completions_[i].slot]);
+
+  return rv;
+}
+
+int
+AsyncIO::uring_init(const unsigned int flags_)
+{
+  int fd;
+  struct io_uring_params p;
+
+  ::memset(&p,0,sizeof(p));
+  p.flags = flags_;
+
+  fd = l::io_uring_setup(_depth,&p);
+  if(fd < 0)
+    return -errno;
+
+  _uring.fd       = fd;
+  _uring.sqe_size = (sizeof(struct io_uring_sqe) << !!(flags_ & IORING_SETUP_SQE128));
+  _uring.cqe_size = (sizeof(struct io_uring_cqe) << !!(flags_ & IORING_SETUP_CQE32));
+  _uring.sq_len   = (p.sq_off.array + (p.sq_entries * sizeof(unsigned)));
+  _uring.cq_len   = (p.cq_off.cqes + (p.cq_entries * _uring.cqe_size));
+  _uring.sqes_len = (p.sq_entries * _uring.sqe_size);
+
+  if(p.features & IORING_FEAT_SINGLE_MMAP)
+    _uring.sq_len = _uring.cq_len = std::max(_uring.sq_len,_uring.cq_len);
+
+  _uring.sq_ptr = ::mmap(NULL,_uring.sq_len,
+                         PROT_READ|PROT_WRITE,MAP_SHARED|MAP_POPULATE,
+                         fd,IORING_OFF_SQ_RING);
+  if(_uring.sq_ptr == MAP_FAILED)
+    goto error;
+
+  if(p.features & IORING_FEAT_SINGLE_MMAP)
+    {
+      _uring.cq_ptr = _uring.sq_ptr;
+    }
+  else
+    {
+      _uring.cq_ptr = ::mmap(NULL,_uring.cq_len,
+                             PROT_READ|PROT_WRITE,MAP_SHARED|MAP_POPULATE,
+                             fd,IORING_OFF_CQ_RING);
+      if(_uring.cq_ptr == MAP_FAILED)
+        goto error;
+    }
+
+  _uring.sqes = ::mmap(NULL,_uring.sqes_len,
+                       PROT_READ|PROT_WRITE,MAP_SHARED|MAP_POPULATE,
+                       fd,IORING_OFF_SQES);
+  if(_uring.sqes == MAP_FAILED)
+    goto error;
+
+  _uring.sq_head  = l::offset<unsigned>(_uring.sq_ptr,p.sq_off.head);
+  _uring.sq_tail  = l::offset<unsigned>(_uring.sq_ptr,p.sq_off.tail);
+  _uring.sq_mask  = l::offset<unsigned>(_uring.sq_ptr,p.sq_off.ring_mask);
+  _uring.sq_array = l::offset<unsigned>(_uring.sq_ptr,p.sq_off.array);
+  _uring.cq_head  = l::offset<unsigned>(_uring.cq_ptr,p.cq_off.head);
+  _uring.cq_tail  = l::offset<unsigned>(_uring.cq_ptr,p.cq_off.tail);
+  _uring.cq_mask  = l::offset<unsigned>(_uring.cq_ptr,p.cq_off.ring_mask);
+  _uring.cqes     = l::offset<void>(_uring.cq_ptr,p.cq_off.cqes);
+
+  _iovecs.resize(_depth);
+
+  return 0;
+
+ error:
+  uring_destroy();
+
+  return -ENOMEM;
+}
+
+int
+AsyncIO::uring_submit(const unsigned int  slot_,
+                      const Op            op_,
+                      const uint64_t      offset_,
+                      void               *buf_,
+                      const uint64_t      len_)
+{
+  unsigned tail;
+  unsigned index;
+  struct io_uring_sqe *sqe;
+
+  tail = *_uring.sq_tail;
+  if((tail - __atomic_load_n(_uring.sq_head,__ATOMIC_ACQUIRE)) >= _depth)
+    return -EAGAIN;
+
+  index = (tail & *_uring.sq_mask);
+  sqe   = l::offset<struct io_uring_sqe>(_uring.sqes,index * _uring.sqe_size);
+
+  _iovecs[slot_].iov_base = buf_;
+  _iovecs[slot_].iov_len  = len_;
+
+  ::memset(sqe,0,sizeof(*sqe));
+  sqe->opcode    = ((op_ == READ) ? IORING_OP_READV : IORING_OP_WRITEV);
+  sqe->fd        = _fd;
+  sqe->off       = offset_;
+  sqe->addr      = (uint64_t)&_iovecs[slot_];
+  sqe->len       = 1;
+  sqe->user_data = slot_;
+
+  _uring.sq_array[index] = index;
+  __atomic_store_n(_uring.sq_tail,tail+1,__ATOMIC_RELEASE);
+
+  _pending++;
+
+  return 0;
+}
+
+int
+AsyncIO::uring_flush(void)
+{
+  int rv;
+
+  while(_pending)
+    {
+      rv = l::io_uring_enter(_uring.fd,_pending,0,0);
+      if(rv < 0)
+        {
+          if(errno == EINTR)
+            continue;
+          return -errno;
+        }
+
+      _pending -= rv;
+    }
+
+  return 0;
+}
+
+int
+AsyncIO::uring_reap(std::vector<Completion> &completions_,
+                    const unsigned int       min_)
+{
+  int rv;
+  int count;
+  unsigned head;
+  unsigned tail;
+
+  head = *_uring.cq_head;
+  tail = __atomic_load_n(_uring.cq_tail,__ATOMIC_ACQUIRE);
+  if((head == tail) && min_)
+    {
+      rv = l::io_uring_enter(_uring.fd,0,min_,IORING_ENTER_GETEVENTS);
+      if((rv < 0) && (errno != EINTR))
+        return -errno;
+      tail = __atomic_load_n(_uring.cq_tail,__ATOMIC_ACQUIRE);
+    }
+
+  count = 0;
+  for(; head != tail; head++, count++)
+    {
+      Completion c;
+      const struct io_uring_cqe *cqe;
+
+      cqe = l::offset<const struct io_uring_cqe>(_uring.cqes,
+                                                 (head & *_uring.cq_mask) * _uring.cqe_size);
+
+      c.slot = cqe->user_data;
+      c.res  = cqe->res;
+
+      completions_.push_back(c);
+    }
+
+  __atomic_store_n(_uring.cq_head,head,__ATOMIC_RELEASE);
+
+  return count;
+}
+
+void
+AsyncIO::uring_destroy(void)
+{
+  if(_uring.sqes && (_uring.sqes != MAP_FAILED))
+    ::munmap(_uring.sqes,_uring.sqes_len);
+  if(_uring.cq_ptr && (_uring.cq_ptr != MAP_FAILED) &&
+     (_uring.cq_ptr != _uring.sq_ptr))
+    ::munmap(_uring.cq_ptr,_uring.cq_len);
+  if(_uring.sq_ptr && (_uring.sq_ptr != MAP_FAILED))
+    ::munmap(_uring.sq_ptr,_uring.sq_len);
+  if(_uring.fd != -1)
+    ::close(_uring.fd);
+
+  ::memset(&_uring,0,sizeof(_uring));
+  _uring.fd = -1;
+
+  _iovecs.clear();
+}
+
+int
+AsyncIO::nvme_submit(const unsigned int  slot_,
+                     const Op            op_,
+                     const uint64_t      offset_,
+                     void               *buf_,
+                     const uint64_t      len_)
+{
+  uint8_t opcode;
+  unsigned tail;
+  unsigned index;
+  uint64_t lba;
+  uint64_t blocks;
+  struct io_uring_sqe *sqe;
+
+  tail = *_uring.sq_tail;
+  if((tail - __atomic_load_n(_uring.sq_head,__ATOMIC_ACQUIRE)) >= _depth)
+    return -EAGAIN;
+
+  lba    = (offset_ / _nvme_block_size);
+  blocks = (len_ / _nvme_block_size);
+  if(blocks == 0)
+    return -EINVAL;
+
+  opcode = nvme::NVME_CMD_READ;
+  if(op_ == WRITE)
+    opcode = nvme::NVME_CMD_WRITE;
+  else if(_nvme_verify)
+    opcode = nvme::NVME_CMD_VERIFY;
+
+  index = (tail & *_uring.sq_mask);
+  sqe   = l::offset<struct io_uring_sqe>(_uring.sqes,index * _uring.sqe_size);
+
+  ::memset(sqe,0,_uring.sqe_size);
+  sqe->opcode    = IORING_OP_URING_CMD;
+  sqe->fd        = _fd;
+  sqe->cmd_op    = NVME_URING_CMD_IO;
+  sqe->user_data = slot_;
+
+  nvme::prepare_rw(*(struct nvme_uring_cmd*)sqe->cmd,
+                   opcode,
+                   _nvme_nsid,
+                   lba,
+                   blocks,
+                   ((opcode == nvme::NVME_CMD_VERIFY) ? NULL : buf_),
+                   ((opcode == nvme::NVME_CMD_VERIFY) ? 0 : len_),
+                   _nvme_timeout);
+
+  _nvme_len[slot_] = len_;
+
+  _uring.sq_array[index] = index;
+  __atomic_store_n(_uring.sq_tail,tail+1,__ATOMIC_RELEASE);
+
+  _pending++;
+
+  return 0;
+}
+
+/*
+  A passthrough command completes with 0 rather than the bytes
+  transferred, a positive NVMe status when the device failed it or
+  -errno when the kernel did.
+*/
+int
+AsyncIO::nvme_reap(std::vector<Completion> &completions_,
+                   const unsigned int       min_)
+{
+  int rv;
+  const size_t count = completions_.size();
+
+  rv = uring_reap(completions_,min_);
+  if(rv < 0)
+    return rv;
+
+  for(size_t i = count; i < completions_.size(); i++)
+    {
+      Completion &c = completions_[i];
+
+      if(c.res == 0)
+        c.res = _nvme_len[c.slot];
+      else if(c.res > 0)
+        c.res = nvme::status_to_errno(c.res);
+    }
+
+  return rv;
+}
+
+int
+AsyncIO::aio_init(void)
+{
+  int rv;
+
+  _aio_ctx = 0;
+  rv = l::io_setup(_depth,&_aio_ctx);
+  if(rv < 0)
+    return -errno;
+
+  _iocbs.resize(_depth);
+  _iocbpp.reserve(_depth);
+  _events.resize(_depth);
+
+  return 0;
+}
+
+int
+AsyncIO::aio_submit(const unsigned int  slot_,
+                    const Op            op_,
+                    const uint64_t      offset_,
+                    void               *buf_,
+                    const uint64_t      len_)
+{
+  struct iocb *cb;
+
+  cb = &_iocbs[slot_];
+
+  ::memset(cb,0,sizeof(*cb));
+  cb->aio_data       = slot_;
+  cb->aio_lio_opcode = ((op_ == READ) ? IOCB_CMD_PREAD : IOCB_CMD_PWRITE);
+  cb->aio_fildes     = _fd;
+  cb->aio_buf        = (uint64_t)buf_;
+  cb->aio_nbytes     = len_;
+  cb->aio_offset     = offset_;
+
+  _iocbpp.push_back(cb);
+
+  _pending++;
+
+  return 0;
+}
+
+int
+AsyncIO::aio_flush(void)
+{
+  int rv;
+  size_t done;
+
+  done = 0;
+  while(done < _iocbpp.size())
+    {
+      rv = l::io_submit(_aio_ctx,_iocbpp.size() - done,&_iocbpp[done]);
+      if(rv < 0)
+        {
+          if(errno == EINTR)
+            continue;
+          return -errno;
+        }
+
+      done += rv;
+    }
+
+  _iocbpp.clear();
+  _pending = 0;
+
+  return 0;
+}
+
+int
+AsyncIO::aio_reap(std::vector<Completion> &completions_,
+                  const unsigned int       min_)
+{
+  int rv;
+
+  rv = l::io_getevents(_aio_ctx,min_,_events.size(),&_events[0]);
+  if(rv < 0)
+    return ((errno == EINTR) ? 0 : -errno);
+
+  for(int i = 0; i < rv; i++)
+    {
+      Completion c;
+
+      c.slot = _events[i].data;
+      c.res  = _events[i].res;
+
+      completions_.push_back(c);
+    }
+
+  return rv;
+}
+
+void
+AsyncIO::aio_destroy(void)
+{
+  if(_aio_ctx)
+    l::io_destroy(_aio_ctx);
+
+  _aio_ctx = 0;
+  _iocbs.clear();
+  _iocbpp.clear();
+  _events.clear();
+}
+
+int
+AsyncIO::sg_submit(const unsigned int  slot_,
+                   const Op            op_,
+                   const uint64_t      offset_,
+                   void               *buf_,
+                   const uint64_t      len_)
+{
+  uint64_t lba;
+  uint64_t blocks;
+  SGRequest *req;
+
+  req    = &_sg_requests[slot_];
+  lba    = (offset_ / _sg_block_size);
+  blocks = (len_ / _sg_block_size);
+
+  if(_sg_scsi && _sg_verify && (op_ == READ))
+    scsi::prepare_verify(req->hdr,req->cdb,req->sb,lba,blocks,_sg_timeout);
+  else if(_sg_scsi)
+    scsi::prepare_rw(req->hdr,
+                     req->cdb,
+                     req->sb,
+                     ((op_ == READ) ? SG_READ : SG_WRITE),
+                     lba,
+                     blocks,
+                     buf_,
+                     len_,
+                     _sg_timeout);
+  else if(_sg_verify && (op_ == READ))
+    sg::prepare_verify(req->hdr,req->cdb,req->sb,lba,blocks,_sg_timeout);
+  else
+    sg::prepare_rw(req->hdr,
+                   req->cdb,
+                   req->sb,
+                   ((op_ == READ) ? SG_READ : SG_WRITE),
+                   _sg_xfer,
+                   lba,
+                   blocks,
+                   buf_,
+                   len_,
+                   _sg_timeout);
+
+  req->len = len_;
+
+  /*
+    prepare_rw() sets pack_id to the LBA truncated to an int which
+    goes negative past 2^31 sectors and can collide with the -1
+    wildcard or another request. The slot is unique while in flight.
+  */
+  req->hdr.pack_id = slot_;
+  _sg_pack_ids[req->hdr.pack_id] = slot_;
+  _sg_queued.push_back(slot_);
+
+  _pending++;
+
+  return 0;
+}
+
+/*
+  A command the driver refuses is reported back as a failed
+  completion on the next reap so the caller's in flight accounting
+  stays correct.
+*/
+int
+AsyncIO::sg_flush(void)
+{
+  ssize_t rv;
+
+  for(size_t i = 0; i < _sg_queued.size(); i++)
+    {
+      SGRequest *req = &_sg_requests[_sg_queued[i]];
+
+      do
+        {
+          rv = ::write(_fd,&req->hdr,sizeof(req->hdr));
+        }
+      while((rv == -1) && (errno == EINTR));
+
+      if(rv == -1)
+        {
+          Completion c;
+
+          c.slot = _sg_queued[i];
+          c.res  = -errno;
+
+          _sg_pack_ids.erase(req->hdr.pack_id);
+          _sg_failed.push_back(c);
+        }
+    }
+
+  _sg_queued.clear();
+  _pending = 0;
+
+  return 0;
+}
+
+int
+AsyncIO::sg_reap(std::vector<Completion> &completions_,
+                 const unsigned int       min_)
+{
+  int rv;
+  int count;
+  struct pollfd pfd;
+
+  count = _sg_failed.size();
+  completions_.insert(completions_.end(),_sg_failed.begin(),_sg_failed.end());
+  _sg_failed.clear();
+
+  while(!_sg_pack_ids.empty())
+    {
+      Completion c;
+      sg_io_hdr_t hdr;
+      std::map<int,unsigned int>::iterator i;
+
+      ::memset(&hdr,0,sizeof(hdr));
+      hdr.interface_id = 'S';
+      hdr.pack_id      = -1;
+
+      rv = ::read(_fd,&hdr,sizeof(hdr));
+      if(rv == -1)
+        {
+          if(errno == EINTR)
+            return count;
+          if(errno != EAGAIN)
+            return -errno;
+          if(count >= (int)min_)
+            break;
+
+          pfd.fd     = _fd;
+          pfd.events = POLLIN;
+          rv = ::poll(&pfd,1,-1);
+          if((rv == -1) && (errno == EINTR))
+            return count;
+          if(rv == -1)
+            return -errno;
+          continue;
+        }
+
+      i = _sg_pack_ids.find(hdr.pack_id);
+      if(i == _sg_pack_ids.end())
+        continue;
+
+      c.slot = i->second;
+      c.res  = (_sg_scsi ?
+                scsi::io_hdr_to_errno(hdr) :
+                sg::io_hdr_to_errno(hdr));
+      if(c.res == 0)
+        c.res = _sg_requests[c.slot].len;
+
+      _sg_pack_ids.erase(i);
+      completions_.push_back(c);
+      count++;
+    }
+
+  return count;
+}
+
+void
+AsyncIO::sg_destroy(void)
+{
+  if(_fd != -1)
+    ::close(_fd);
+
+  _sg_requests.clear();
+  _sg_queued.clear();
+  _sg_failed.clear();
+  _sg_pack_ids.clear();
+}
+
+int
+AsyncIO::sim_submit(const unsigned int  slot_,
+                    const Op            op_,
+                    const uint64_t      offset_,
+                    void               *buf_,
+                    const uint64_t      len_)
+{
+  int64_t rv;
+  uint64_t lba;
+  uint64_t blocks;
+  Completion c;
+  const uint64_t lbs = _sim->logical_block_size();
+
+  lba    = (offset_ / lbs);
+  blocks = (len_ / lbs);
+
+  rv = _sim->io(_fd,(op_ == WRITE),lba,blocks,buf_);
+
+  c.slot = slot_;
+  c.res  = ((rv < 0) ? rv : (rv * lbs));
+
+  _sim_due.insert(std::make_pair(Time::get_monotonic() +
+                                 _sim->latency(lba,blocks),
+                                 c));
+
+  return 0;
+}
+
+/*
+  Waits for the min'th earliest request to be due and returns
+  everything due by then.
+*/
+int
+AsyncIO::sim_reap(std::vector<Completion> &completions_,
+                  const unsigned int       min_)
+{
+  int rv;
+  int count;
+  double now;
+  std::multimap<double,Completion>::iterator i;
+
+  if(_sim_due.empty())
+    return 0;
+
+  rv = _sim->reap();
+  if(rv < 0)
+    return rv;
+
+  now = Time::get_monotonic();
+  if(min_)
+    {
+      double due;
+
+      i = _sim_due.begin();
+      std::advance(i,std::min((size_t)min_,_sim_due.size()) - 1);
+      due = i->first;
+      if(due > now)
+        {
+          Time::sleep(due - now);
+          now = due;
+        }
+    }
+
+  count = 0;
+  for(i = _sim_due.begin(); (i != _sim_due.end()) && (i->first <= now); count++)
+    {
+      completions_.push_back(i->second);
+      _sim_due.erase(i++);
+    }
+
+  return count;
+}
@@ -0,0 +1,253 @@
+/*
+  ISC License
+
+  Copyright (c) 2016, Antonio SJ Musumeci <trapexit@spawn.link>
+
+  Permission to use, copy, modify, and/or distribute this software for any
+  purpose with or without fee is hereby granted, provided that the above
+  copyright notice and this permission notice appear in all copies.
+
+  THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+  WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+  MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+  ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+  WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+  ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+  OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+*/
+
+#pragma once
+
+#include <linux/aio_abi.h>
+#include <scsi/sg.h>
+#include <stdint.h>
+#include <sys/uio.h>
+
+#include <map>
+#include <string>
+#include <vector>
+
+/*
+  Queue of asynchronous reads and writes against a single file
+  descriptor. io_uring is used when the kernel supports it with
+  Linux native AIO as a fallback. Requests are identified by a slot
+  number in [0,depth) which the caller manages and which is returned
+  with the completion.
+
+  init_sg() instead drives ATA passthrough commands through the sg
+  character device's write() / read() interface. Completions are
+  matched back to slots by the sg_io_hdr pack_id, which is set to
+  the slot number. init_scsi() does
+  the same with native READ(16), WRITE(16) and VERIFY(16) for SCSI
+  disks.
+
+  init_nvme() sends NVMe Read, Write or Verify commands through
+  io_uring passthrough (IORING_OP_URING_CMD) on the namespace's
+  generic character device. The ring uses 128 byte SQEs, which carry
+  the command, and 32 byte CQEs. The NVMe status of a failed command
+  is mapped to -errno in the completion.
+
+  init_sim() queues requests against a SimDev. Each is carried out
+  on submit and completes after its simulated latency, independent
+  of anything else in flight.
+
+  With a Throttle set submit() waits for its go ahead, flushing what
+  is already queued first, and reap() reports each request's time
+  from submit to completion back to it.
+*/
+
+class SimDev;
+class Throttle;
+
+class AsyncIO
+{
+public:
+  enum Backend
+    {
+      NONE,
+      IO_URING,
+      LIBAIO,
+      SG,
+      NVME,
+      SIM
+    };
+
+  enum Op
+    {
+      READ,
+      WRITE
+    };
+
+  struct Completion
+  {
+    unsigned int slot;
+    int64_t      res;
+  };
+
+public:
+  AsyncIO();
+  ~AsyncIO();
+
+public:
+  int  init(const int          fd,
+            const unsigned int depth);
+  int  init_sg(const std::string  &path,
+               const unsigned int  depth,
+               const uint64_t      block_size,
+               const int           xfer,
+               const int           timeout,
+               const bool          verify);
+  int  init_scsi(const std::string  &path,
+                 const unsigned int  depth,
+                 const uint64_t      block_size,
+                 const int           timeout,
+                 const bool          verify);
+  int  init_nvme(const std::string  &path,
+                 const unsigned int  depth,
+                 const uint32_t      nsid,
+                 const uint64_t      block_size,
+                 const int           timeout,
+                 const bool          verify);
+  int  init_sim(const int           fd,
+                const unsigned int  depth,
+                SimDev             *sim);
+  void destroy(void);
+
+  void set_throttle(Throttle *throttle);
+
+public:
+  int submit(const unsigned int  slot,
+             const Op            op,
+             const uint64_t      offset,
+             void               *buf,
+             const uint64_t      len);
+  int flush(void);
+  int reap(std::vector<Completion> &completions,
+           const unsigned int       min);
+
+public:
+  Backend      backend(void) const { return _backend; }
+  unsigned int depth(void) const { return _depth; }
+
+  static const char *backend_to_string(const Backend backend);
+
+private:
+  int  uring_init(const unsigned int flags = 0);
+  int  uring_submit(const unsigned int  slot,
+                    const Op            op,
+                    const uint64_t      offset,
+                    void               *buf,
+                    const uint64_t      len);
+  int  uring_flush(void);
+  int  uring_reap(std::vector<Completion> &completions,
+                  const unsigned int       min);
+  void uring_destroy(void);
+
+  int  aio_init(void);
+  int  aio_submit(const unsigned int  slot,
+                  const Op            op,
+                  const uint64_t      offset,
+                  void               *buf,
+                  const uint64_t      len);
+  int  aio_flush(void);
+  int  aio_reap(std::vector<Completion> &completions,
+                const unsigned int       min);
+  void aio_destroy(void);
+
+  int  sg_submit(const unsigned int  slot,
+                 const Op            op,
+                 const uint64_t      offset,
+                 void               *buf,
+                 const uint64_t      len);
+  int  sg_flush(void);
+  int  sg_reap(std::vector<Completion> &completions,
+               const unsigned int       min);
+  void sg_destroy(void);
+
+  int  nvme_submit(const unsigned int  slot,
+                   const Op            op,
+                   const uint64_t      offset,
+                   void               *buf,
+                   const uint64_t      len);
+  int  nvme_reap(std::vector<Completion> &completions,
+                 const unsigned int       min);
+
+  int  sim_submit(const unsigned int  slot,
+                  const Op            op,
+                  const uint64_t      offset,
+                  void               *buf,
+                  const uint64_t      len);
+  int  sim_reap(std::vector<Completion> &completions,
+                const unsigned int       min);
+
+private:
+  Backend      _backend;
+  int          _fd;
+  unsigned int _depth;
+  unsigned int _pending;
+
+private:
+  struct URing
+  {
+    int       fd;
+    void     *sq_ptr;
+    size_t    sq_len;
+    void     *cq_ptr;
+    size_t    cq_len;
+    void     *sqes;
+    size_t    sqes_len;
+    size_t    sqe_size;
+    size_t    cqe_size;
+    unsigned *sq_head;
+    unsigned *sq_tail;
+    unsigned *sq_mask;
+    unsigned *sq_array;
+    unsigned *cq_head;
+    unsigned *cq_tail;
+    unsigned *cq_mask;
+    void     *cqes;
+  };
+
+  URing _uring;
+  std::vector<struct iovec> _iovecs;
+
+private:
+  aio_context_t                _aio_ctx;
+  std::vector<struct iocb>     _iocbs;
+  std::vector<struct iocb*>    _iocbpp;
+  std::vector<struct io_event> _events;
+
+private:
+  struct SGRequest
+  {
+    sg_io_hdr_t hdr;
+    uint8_t     cdb[16];
+    uint8_t     sb[32];
+    uint64_t    len;
+  };
+
+  uint64_t                   _sg_block_size;
+  int                        _sg_xfer;
+  int                        _sg_timeout;
+  bool                       _sg_verify;
+  bool                       _sg_scsi;
+  std::vector<SGRequest>     _sg_requests;
+  std::vector<unsigned int>  _sg_queued;
+  std::vector<Completion>    _sg_failed;
+  std::map<int,unsigned int> _sg_pack_ids;
+
+private:
+  uint32_t              _nvme_nsid;
+  uint64_t              _nvme_block_size;
+  int                   _nvme_timeout;
+  bool                  _nvme_verify;
+  std::vector<uint64_t> _nvme_len;
+
+private:
+  SimDev                          *_sim;
+  std::multimap<double,Completion> _sim_due;
+
+private:
+  Throttle           *_throttle;
+  std::vector<double> _submitted;
+};
@@ -16,9 +16,16 @@
   OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
 */
 
+#include <errno.h>
+#include <fcntl.h>
 #include <stdint.h>
 #include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
 
+#include <algorithm>
 #include <string>
 #include <vector>
 #include <iostream>
@@ -26,9 +33,13 @@
 #include <sstream>
 
 #include "badblockfile.hpp"
+#include "badblockset.hpp"
 #include "captcha.hpp"
 #include "blkdev.hpp"
 
+#define BBF_MAGIC   "BBFRUNS"
+#define BBF_VERSION 1
+
 std::string
 BadBlockFile::filepath(const BlkDev &blkdev)
 {
@@ -60,46 +71,185 @@ _read(std::istream          &stream,
     }
 }
 
+BadBlockFile::Format
+BadBlockFile::format(const std::string &filepath)
+{
+  char magic[sizeof(((Header*)0)->magic)];
+  std::ifstream file;
+
+  if(filepath == "-")
+    return TEXT;
+
+  file.open(filepath.c_str(),std::ios::in|std::ios::binary);
+  if(!file.is_open())
+    return NONE;
+
+  file.read(magic,sizeof(magic));
+  if((file.gcount() == sizeof(magic)) &&
+     !::memcmp(magic,BBF_MAGIC,sizeof(magic)))
+    return BINARY;
+
+  return TEXT;
+}
+
+/*
+  An explicitly requested format wins. Otherwise an existing file
+  keeps its format and new files are text.
+*/
+BadBlockFile::Format
+BadBlockFile::output_format(const std::string &filepath,
+                            const Format       requested)
+{
+  Format existing;
+
+  if(requested != NONE)
+    return requested;
+
+  existing = format(filepath);
+  if(existing == NONE)
+    return TEXT;
+
+  return existing;
+}
+
+/*
+  Returns the number of blocks read which for the binary format is
+  the expanded run lengths.
+*/
+static
 int
-BadBlockFile::read(const std::string     &filepath,
-                   std::vector<uint64_t> &blocks)
+_read(const std::string     &filepath,
+      std::vector<uint64_t> &blocks,
+      const BlkDev          *blkdev)
 {
+  int rv;
+  const size_t size = blocks.size();
+
   if(filepath == "-")
     {
       _read(std::cin,blocks);
     }
+  else if(BadBlockFile::format(filepath) == BadBlockFile::BINARY)
+    {
+      BadBlockFile::Map map;
+
+      rv = ((blkdev == NULL) ?
+            map.open(filepath) :
+            map.open(filepath,*blkdev));
+      if(rv < 0)
+        return rv;
+
+      for(uint64_t i = 0; i < map.run_count(); i++)
+        for(uint64_t j = 0; j < map.runs()[i].length; j++)
+          blocks.push_back(map.runs()[i].start + j);
+    }
   else
     {
       std::ifstream file;
 
       file.open(filepath.c_str());
       if(!file.is_open() || file.bad())
-        return -1;
+        return -ENOENT;
 
       _read(file,blocks);
 
       file.close();
     }
 
-  return 0;
+  return (blocks.size() - size);
+}
+
+int
+BadBlockFile::read(const std::string     &filepath,
+                   std::vector<uint64_t> &blocks)
+{
+  return _read(filepath,blocks,NULL);
+}
+
+int
+BadBlockFile::read(const std::string     &filepath,
+                   std::vector<uint64_t> &blocks,
+                   const BlkDev          &blkdev)
+{
+  return _read(filepath,blocks,&blkdev);
+}
+
+/*
+  Binary runs are merged straight into the set. Text lists are read
+  in full first since they may be unsorted and repeat blocks.
+*/
+static
+int
+_read(const std::string &filepath,
+      BadBlockSet       &blocks,
+      const BlkDev      *blkdev)
+{
+  int rv;
+  const uint64_t size = blocks.size();
+
+  if((filepath != "-") && (BadBlockFile::format(filepath) == BadBlockFile::BINARY))
+    {
+      BadBlockFile::Map map;
+
+      rv = ((blkdev == NULL) ?
+            map.open(filepath) :
+            map.open(filepath,*blkdev));
+      if(rv < 0)
+        return rv;
+
+      for(uint64_t i = 0; i < map.run_count(); i++)
+        blocks.insert(map.runs()[i].start,map.runs()[i].length);
+    }
+  else
+    {
+      std::vector<uint64_t> list;
+
+      rv = _read(filepath,list,blkdev);
+      if(rv < 0)
+        return rv;
+
+      blocks.insert(list);
+    }
+
+  return (blocks.size() - size);
+}
+
+int
+BadBlockFile::read(const std::string &filepath,
+                   BadBlockSet       &blocks)
+{
+  return _read(filepath,blocks,NULL);
+}
+
+int
+BadBlockFile::read(const std::string &filepath,
+                   BadBlockSet       &blocks,
+                   const BlkDev      &blkdev)
+{
+  return _read(filepath,blocks,&blkdev);
 }
 
 static
 void
-_write(std::ostream                &stream,
-       const std::vector<uint64_t> &blocks)
+_write(std::ostream                         &stream,
+       const std::vector<BadBlockFile::Run> &runs)
 {
-  for(size_t i = 0, ei = blocks.size(); i != ei; i++)
-    stream << blocks[i] << std::endl;
+  for(size_t i = 0, ei = runs.size(); i != ei; i++)
+    for(uint64_t j = 0; j < runs[i].length; j++)
+      stream << (runs[i].start + j) << '\n';
+  stream.flush();
 }
 
+static
 int
-BadBlockFile::write(const std::string           &filepath,
-                    const std::vector<uint64_t> &blocks)
+_write_text(const std::string                    &filepath,
+            const std::vector<BadBlockFile::Run> &runs)
 {
   if(filepath == "-")
     {
-      _write(std::cout,blocks);
+      _write(std::cout,runs);
+      if(std::cout.fail())
+        return -EIO;
     }
   else
     {
@@ -107,12 +257,236 @@ BadBlockFile::write(const std::string           &filepath,
 
       file.open(filepath.c_str());
       if(!file.is_open() || file.bad())
-        return -1;
+        return -EACCES;
 
-      _write(file,blocks);
+      _write(file,runs);
 
       file.close();
+      if(file.fail())
+        return -EIO;
+    }
+
+  return 0;
+}
+
+/* text lists are written sorted and without duplicates */
+int
+BadBlockFile::write(const std::string           &filepath,
+                    const std::vector<uint64_t> &blocks)
+{
+  std::vector<Run> runs;
+
+  to_runs(blocks,runs);
+
+  return _write_text(filepath,runs);
+}
+
+void
+BadBlockFile::to_runs(const std::vector<uint64_t> &blocks_,
+                      std::vector<Run>            &runs_)
+{
+  std::vector<uint64_t> sorted(blocks_);
+
+  std::sort(sorted.begin(),sorted.end());
+  sorted.erase(std::unique(sorted.begin(),sorted.end()),sorted.end());
+
+  for(size_t i = 0; i < sorted.size(); i++)
+    {
+      if(!runs_.empty() &&
+         ((runs_.back().start + runs_.back().length) == sorted[i]))
+        {
+          runs_.back().length++;
+          continue;
+        }
+
+      Run run;
+
+      run.start  = sorted[i];
+      run.length = 1;
+
+      runs_.push_back(run);
     }
+}
+
+static
+int
+_write_binary(const std::string                    &filepath,
+              const std::vector<BadBlockFile::Run> &runs,
+              const BlkDev                         &blkdev)
+{
+  std::ofstream file;
+  BadBlockFile::Header header;
+
+  ::memset(&header,0,sizeof(header));
+  ::memcpy(header.magic,BBF_MAGIC,sizeof(header.magic));
+  ::strncpy(header.captcha,
+            captcha::calculate(blkdev).c_str(),
+            sizeof(header.captcha) - 1);
+  header.version             = BBF_VERSION;
+  header.logical_block_size  = blkdev.logical_block_size();
+  header.logical_block_count = blkdev.logical_block_count();
+  header.run_count           = runs.size();
+  for(size_t i = 0; i < runs.size(); i++)
+    header.block_count += runs[i].length;
+
+  file.open(filepath.c_str(),std::ios::out|std::ios::binary|std::ios::trunc);
+  if(!file.is_open() || file.bad())
+    return -EACCES;
+
+  file.write((const char*)&header,sizeof(header));
+  if(!runs.empty())
+    file.write((const char*)&runs[0],runs.size() * sizeof(BadBlockFile::Run));
+
+  file.close();
+  if(file.fail())
+    return -EIO;
 
   return 0;
 }
+
+int
+BadBlockFile::write(const std::string           &filepath,
+                    const std::vector<uint64_t> &blocks,
+                    const BlkDev                &blkdev,
+                    const Format                 format)
+{
+  std::vector<Run> runs;
+
+  to_runs(blocks,runs);
+  if((format == BINARY) && (filepath != "-"))
+    return _write_binary(filepath,runs,blkdev);
+
+  return _write_text(filepath,runs);
+}
+
+int
+BadBlockFile::write(const std::string &filepath,
+                    const BadBlockSet &blocks,
+                    const BlkDev      &blkdev,
+                    const Format       format)
+{
+  if((format == BINARY) && (filepath != "-"))
+    return _write_binary(filepath,blocks.runs(),blkdev);
+
+  return _write_text(filepath,blocks.runs());
+}
+
+BadBlockFile::Map::Map()
+  : _addr(MAP_FAILED),
+    _len(0),
+    _header(NULL),
+    _runs(NULL),
+    _run_count(0)
+{
+}
+
+BadBlockFile::Map::~Map()
+{
+  close();
+}
+
+int
+BadBlockFile::Map::open(const std::string &filepath_)
+{
+  int fd;
+  int rv;
+  struct stat st;
+
+  close();
+
+  fd = ::open(filepath_.c_str(),O_RDONLY);
+  if(fd == -1)
+    return -errno;
+
+  rv = ::fstat(fd,&st);
+  if(rv == -1)
+    {
+      rv = -errno;
+      ::close(fd);
+      return rv;
+    }
+
+  if(st.st_size < (off_t)sizeof(Header))
+    {
+      ::close(fd);
+      return -EINVAL;
+    }
+
+  _len  = st.st_size;
+  _addr = ::mmap(NULL,_len,PROT_READ,MAP_SHARED,fd,0);
+  ::close(fd);
+  if(_addr == MAP_FAILED)
+    return -errno;
+
+  _header = (const Header*)_addr;
+  _runs   = (const Run*)((const char*)_addr + sizeof(Header));
+  if(::memcmp(_header->magic,BBF_MAGIC,sizeof(_header->magic)) ||
+     (_header->version != BBF_VERSION) ||
+     (_header->run_count > ((_len - sizeof(Header)) / sizeof(Run))))
+    {
+      close();
+      return -EINVAL;
+    }
+
+  _run_count = _header->run_count;
+
+  return 0;
+}
+
+int
+BadBlockFile::Map::open(const std::string &filepath_,
+                        const BlkDev      &blkdev_)
+{
+  int rv;
+  std::string captcha;
+
+  rv = open(filepath_);
+  if(rv < 0)
+    return rv;
+
+  captcha = captcha::calculate(blkdev_);
+  if((_header->logical_block_size != blkdev_.logical_block_size()) ||
+     ::strncmp(_header->captcha,captcha.c_str(),sizeof(_header->captcha) - 1))
+    {
+      close();
+      return -EXDEV;
+    }
+
+  return 0;
+}
+
+void
+BadBlockFile::Map::close(void)
+{
+  if(_addr != MAP_FAILED)
+    ::munmap(_addr,_len);
+
+  _addr      = MAP_FAILED;
+  _len       = 0;
+  _header    = NULL;
+  _runs      = NULL;
+  _run_count = 0;
+}
+
+bool
+BadBlockFile::Map::contains(const uint64_t block_) const
+{
+  uint64_t lo;
+  uint64_t hi;
+
+  lo = 0;
+  hi = _run_count;
+  while(lo < hi)
+    {
+      const uint64_t mid = (lo + ((hi - lo) / 2));
+
+      if(block_ < _runs[mid].start)
+        hi = mid;
+      else if(block_ >= (_runs[mid].start + _runs[mid].length))
+        lo = (mid + 1);
+      else
+        return true;
+    }
+
+  return false;
+}
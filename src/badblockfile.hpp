@@ -26,13 +26,105 @@
 
 #include "blkdev.hpp"
 
+class BadBlockSet;
+
+/*
+  Bad block lists are stored either as text, one decimal LBA per
+  line, or in a binary format of sorted, coalesced (start,length)
+  runs behind a header recording the device's captcha and geometry:
+
+    Header                      (64 bytes)
+    Run[header.run_count]       (16 bytes each)
+
+  All integers are little endian. read() detects which format a file
+  is in. Binary files can also be opened through BadBlockFile::Map
+  which mmaps them and answers lookups by binary search without
+  expanding the list. Given the device, a binary file recorded from
+  a different captcha or logical block size is refused with -EXDEV.
+*/
+
 namespace BadBlockFile
 {
+  enum Format
+    {
+      NONE,
+      TEXT,
+      BINARY
+    };
+
+  struct Header
+  {
+    char     magic[8];
+    uint32_t version;
+    uint32_t logical_block_size;
+    uint64_t logical_block_count;
+    char     captcha[24];
+    uint64_t run_count;
+    uint64_t block_count;
+  };
+
+  struct Run
+  {
+    uint64_t start;
+    uint64_t length;
+  };
+
+  class Map
+  {
+  public:
+    Map();
+    ~Map();
+
+  public:
+    int  open(const std::string &filepath);
+    int  open(const std::string &filepath,
+              const BlkDev      &blkdev);
+    void close(void);
+
+  public:
+    const Header *header(void) const { return _header; }
+    const Run    *runs(void) const { return _runs; }
+    uint64_t      run_count(void) const { return _run_count; }
+
+    bool contains(const uint64_t block) const;
+
+  private:
+    void         *_addr;
+    size_t        _len;
+    const Header *_header;
+    const Run    *_runs;
+    uint64_t      _run_count;
+  };
+
   std::string filepath(const BlkDev &blkdev);
 
+  Format format(const std::string &filepath);
+  Format output_format(const std::string &filepath,
+                       const Format       requested);
+
   int read(const std::string     &filepath,
            std::vector<uint64_t> &blocks);
+  int read(const std::string &filepath,
+           BadBlockSet       &blocks);
+  int read(const std::string     &filepath,
+           std::vector<uint64_t> &blocks,
+           const BlkDev          &blkdev);
+  int read(const std::string &filepath,
+           BadBlockSet       &blocks,
+           const BlkDev      &blkdev);
 
   int write(const std::string           &filepath,
             const std::vector<uint64_t> &blocks);
+
+  int write(const std::string           &filepath,
+            const std::vector<uint64_t> &blocks,
+            const BlkDev                &blkdev,
+            const Format                 format);
+  int write(const std::string &filepath,
+            const BadBlockSet &blocks,
+            const BlkDev      &blkdev,
+            const Format       format);
+
+  void to_runs(const std::vector<uint64_t> &blocks,
+               std::vector<Run>            &runs);
 };
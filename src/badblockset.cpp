@@ -0,0 +1,197 @@
+/*
+  ISC License
+
+  Copyright (c) 2016, Antonio SJ Musumeci <trapexit@spawn.link>
+
+  Permission to use, copy, modify, and/or distribute this software for any
+  purpose with or without fee is hereby granted, provided that the above
+  copyright notice and this permission notice appear in all copies.
+
+  THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+  WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+  MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+  ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+  WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+  ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+  OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+*/
+
+#include "badblockset.hpp"
+
+#include <algorithm>
+
+namespace l
+{
+  static
+  bool
+  run_end_le(const BadBlockFile::Run &run_,
+             const uint64_t           block_)
+  {
+    return ((run_.start + run_.length) < block_);
+  }
+}
+
+BadBlockSet::BadBlockSet()
+  : _count(0)
+{
+
+}
+
+void
+BadBlockSet::insert(const uint64_t block_)
+{
+  insert(block_,1);
+}
+
+/*
+  Merges [start,start+length) with every run it overlaps or touches.
+  `i` is the first run which ends at or after start.
+*/
+void
+BadBlockSet::insert(const uint64_t start_,
+                    const uint64_t length_)
+{
+  uint64_t end;
+  std::vector<Run>::iterator i;
+  std::vector<Run>::iterator j;
+
+  if(length_ == 0)
+    return;
+
+  end = (start_ + length_);
+  if(_runs.empty() || (start_ > (_runs.back().start + _runs.back().length)))
+    {
+      Run run;
+
+      run.start  = start_;
+      run.length = length_;
+      _runs.push_back(run);
+      _count += length_;
+      return;
+    }
+
+  i = std::lower_bound(_runs.begin(),_runs.end(),start_,l::run_end_le);
+  if(i == _runs.end() || (end < i->start))
+    {
+      Run run;
+
+      run.start  = start_;
+      run.length = length_;
+      _runs.insert(i,run);
+      _count += length_;
+      return;
+    }
+
+  // i touches the new range, fold in every later run it reaches
+  for(j = i; (j != _runs.end()) && (j->start <= end); ++j)
+    {
+      end     = std::max(end,(j->start + j->length));
+      _count -= j->length;
+    }
+
+  i->start  = std::min(i->start,start_);
+  i->length = (end - i->start);
+  _count   += i->length;
+
+  _runs.erase(i + 1,j);
+}
+
+void
+BadBlockSet::insert(const std::vector<uint64_t> &blocks_)
+{
+  BadBlockSet other;
+  std::vector<Run> runs;
+
+  BadBlockFile::to_runs(blocks_,runs);
+  if(_runs.empty())
+    {
+      _runs.swap(runs);
+      _count = 0;
+      for(size_t i = 0; i < _runs.size(); i++)
+        _count += _runs[i].length;
+      return;
+    }
+
+  other._runs.swap(runs);
+  insert(other);
+}
+
+/* linear merge of two sorted run lists */
+void
+BadBlockSet::insert(const BadBlockSet &other_)
+{
+  size_t a;
+  size_t b;
+  std::vector<Run> merged;
+
+  if(other_.empty())
+    return;
+
+  merged.reserve(_runs.size() + other_._runs.size());
+
+  a = b = 0;
+  _count = 0;
+  while((a < _runs.size()) || (b < other_._runs.size()))
+    {
+      Run next;
+
+      if((b == other_._runs.size()) ||
+         ((a < _runs.size()) && (_runs[a].start <= other_._runs[b].start)))
+        next = _runs[a++];
+      else
+        next = other_._runs[b++];
+
+      if(!merged.empty() &&
+         (next.start <= (merged.back().start + merged.back().length)))
+        {
+          Run &last = merged.back();
+          const uint64_t end = std::max((last.start + last.length),
+                                        (next.start + next.length));
+
+          _count     -= last.length;
+          last.length = (end - last.start);
+          _count     += last.length;
+          continue;
+        }
+
+      merged.push_back(next);
+      _count += next.length;
+    }
+
+  _runs.swap(merged);
+}
+
+void
+BadBlockSet::clear(void)
+{
+  _runs.clear();
+  _count = 0;
+}
+
+bool
+BadBlockSet::contains(const uint64_t block_) const
+{
+  std::vector<Run>::const_iterator i;
+
+  i = std::lower_bound(_runs.begin(),_runs.end(),block_ + 1,l::run_end_le);
+
+  return ((i != _runs.end()) && (i->start <= block_));
+}
+
+uint64_t
+BadBlockSet::last(void) const
+{
+  if(_runs.empty())
+    return 0;
+
+  return (_runs.back().start + _runs.back().length - 1);
+}
+
+void
+BadBlockSet::blocks(std::vector<uint64_t> &blocks_) const
+{
+  blocks_.reserve(blocks_.size() + _count);
+  for(size_t i = 0; i < _runs.size(); i++)
+    for(uint64_t j = 0; j < _runs[i].length; j++)
+      blocks_.push_back(_runs[i].start + j);
+}
@@ -0,0 +1,65 @@
+/*
+  ISC License
+
+  Copyright (c) 2016, Antonio SJ Musumeci <trapexit@spawn.link>
+
+  Permission to use, copy, modify, and/or distribute this software for any
+  purpose with or without fee is hereby granted, provided that the above
+  copyright notice and this permission notice appear in all copies.
+
+  THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+  WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+  MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+  ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+  WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+  ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+  OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+*/
+
+#pragma once
+
+#include "badblockfile.hpp"
+
+#include <stdint.h>
+
+#include <vector>
+
+/*
+  Sorted, deduplicated set of bad blocks kept as coalesced runs so
+  memory scales with the number of distinct runs rather than with the
+  blocks found or how many times a list has been reimported. Inserting
+  at or past the end, the usual case while scanning, is O(1). Anything
+  else is a binary search plus, when a new run is needed, a move of
+  the runs after it.
+*/
+
+class BadBlockSet
+{
+public:
+  typedef BadBlockFile::Run Run;
+
+public:
+  BadBlockSet();
+
+public:
+  void insert(const uint64_t block);
+  void insert(const uint64_t start,
+              const uint64_t length);
+  void insert(const std::vector<uint64_t> &blocks);
+  void insert(const BadBlockSet &other);
+  void clear(void);
+
+public:
+  bool     contains(const uint64_t block) const;
+  bool     empty(void) const { return _runs.empty(); }
+  uint64_t size(void) const { return _count; }
+  uint64_t run_count(void) const { return _runs.size(); }
+  uint64_t last(void) const;
+  void     blocks(std::vector<uint64_t> &blocks) const;
+
+  const std::vector<Run> &runs(void) const { return _runs; }
+
+private:
+  std::vector<Run> _runs;
+  uint64_t         _count;
+};
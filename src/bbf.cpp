@@ -16,14 +16,20 @@
   OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
 */
 
+#include "bbf_bench.hpp"
 #include "bbf_burnin.hpp"
 #include "bbf_captcha.hpp"
+#include "bbf_daemon.hpp"
+#include "bbf_discard.hpp"
 #include "bbf_dump_files.hpp"
 #include "bbf_file_blocks.hpp"
 #include "bbf_find_files.hpp"
 #include "bbf_fix.hpp"
 #include "bbf_fix_file.hpp"
 #include "bbf_info.hpp"
+#include "bbf_rescan.hpp"
+#include "bbf_rescue.hpp"
+#include "bbf_sanitize.hpp"
 #include "bbf_scan.hpp"
 #include "bbf_security_erase.hpp"
 #include "bbf_write_uncorrectable.hpp"
@@ -48,6 +54,10 @@ process_instruction(const Options &opts)
       return bbf::info(opts);
     case Options::SCAN:
       return bbf::scan(opts);
+    case Options::RESCAN:
+      return bbf::rescan(opts);
+    case Options::RESCUE:
+      return bbf::rescue(opts);
     case Options::FIX:
       return bbf::fix(opts);
     case Options::FIX_FILE:
@@ -65,12 +75,23 @@ process_instruction(const Options &opts)
       return bbf::write_uncorrectable(opts);
     case Options::BURNIN:
       return bbf::burnin(opts);
+    case Options::BENCH:
+      return bbf::bench(opts);
+    case Options::DISCARD:
+      return bbf::discard(opts);
     case Options::CAPTCHA:
       return bbf::captcha(opts);
+    case Options::DAEMON:
+      return bbf::daemon(opts);
     case Options::SECURITY_ERASE:
       return bbf::security_erase(opts);
     case Options::ENHANCED_SECURITY_ERASE:
       return bbf::enhanced_security_erase(opts);
+    case Options::SANITIZE:
+    case Options::SANITIZE_CRYPTO_SCRAMBLE:
+    case Options::SANITIZE_BLOCK_ERASE:
+    case Options::SANITIZE_OVERWRITE:
+      return bbf::sanitize(opts);
     }
 
   return AppError::success();
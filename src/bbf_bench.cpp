@@ -0,0 +1,559 @@
+/*
+  ISC License
+
+  Copyright (c) 2016, Antonio SJ Musumeci <trapexit@spawn.link>
+
+  Permission to use, copy, modify, and/or distribute this software for any
+  purpose with or without fee is hereby granted, provided that the above
+  copyright notice and this permission notice appear in all copies.
+
+  THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+  WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+  MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+  ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+  WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+  ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+  OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+*/
+
+#include <errno.h>
+#include <fcntl.h>
+#include <stdint.h>
+#include <string.h>
+
+#include <algorithm>
+#include <iomanip>
+#include <iostream>
+#include <vector>
+
+#include "asyncio.hpp"
+#include "blkdev.hpp"
+#include "bufpool.hpp"
+#include "captcha.hpp"
+#include "errors.hpp"
+#include "nvme.hpp"
+#include "options.hpp"
+#include "progress.hpp"
+#include "sg.hpp"
+#include "signals.hpp"
+#include "time.hpp"
+
+/*
+  Every combination of engine, operation, access pattern, request size
+  and queue depth is run for SECONDS against [start_block,end_block).
+  Queue depth 1 goes through BlkDev::read / write like a synchronous
+  scan, deeper queues through AsyncIO like --queue-depth.
+*/
+
+namespace l
+{
+  static const double SECONDS = 1.0;
+
+  enum Engine
+    {
+      OS,
+      OS_DIRECT,
+      ATA,
+      VERIFY
+    };
+
+  struct Test
+  {
+    Engine       engine;
+    bool         write;
+    bool         random;
+    uint64_t     stepping;
+    unsigned int depth;
+  };
+
+  struct Result
+  {
+    int          error;
+    unsigned int depth;
+    double       seconds;
+    Progress     stats;
+  };
+
+  static
+  const char*
+  engine_to_string(const Engine engine_)
+  {
+    switch(engine_)
+      {
+      case OS:
+        return "os";
+      case OS_DIRECT:
+        return "os-direct";
+      case ATA:
+        return "ata";
+      case VERIFY:
+        return "verify";
+      }
+
+    return "unknown";
+  }
+
+  static
+  uint64_t
+  xorshift(uint64_t &state_)
+  {
+    state_ ^= (state_ << 13);
+    state_ ^= (state_ >> 7);
+    state_ ^= (state_ << 17);
+
+    return state_;
+  }
+
+  /*
+    Sequential tests wrap around to the start of the range. Without
+    O_DIRECT the range is dropped from the page cache each time so
+    rereads measure the device rather than memory.
+  */
+  static
+  uint64_t
+  next_block(BlkDev         &blkdev_,
+             const Test     &test_,
+             const uint64_t  start_,
+             const uint64_t  end_,
+             uint64_t       &cursor_,
+             uint64_t       &rng_)
+  {
+    uint64_t block;
+
+    if(test_.random)
+      return (start_ + ((xorshift(rng_) % ((end_ - start_) / test_.stepping)) *
+                        test_.stepping));
+
+    if((cursor_ + test_.stepping) > end_)
+      {
+        cursor_ = start_;
+        if(test_.engine == OS)
+          ::posix_fadvise(blkdev_.fd(),0,0,POSIX_FADV_DONTNEED);
+      }
+
+    block    = cursor_;
+    cursor_ += test_.stepping;
+
+    return block;
+  }
+
+  static
+  int
+  run_sync(BlkDev         &blkdev_,
+           const Test     &test_,
+           const uint64_t  start_,
+           const uint64_t  end_,
+           char           *buf_,
+           const uint64_t  buflen_,
+           Result         &result_)
+  {
+    int64_t rv;
+    uint64_t rng;
+    uint64_t block;
+    uint64_t cursor;
+    double now;
+    double begin;
+    double request_time;
+
+    rng    = 0x9E3779B97F4A7C15ULL;
+    cursor = start_;
+    begin  = Time::get_monotonic();
+    now    = begin;
+    while((now - begin) < SECONDS)
+      {
+        if(signals::signaled_to_exit())
+          break;
+
+        block = next_block(blkdev_,test_,start_,end_,cursor,rng);
+
+        request_time = now;
+        rv = (test_.write ?
+              blkdev_.write(block,test_.stepping,buf_,buflen_) :
+              blkdev_.read(block,test_.stepping,buf_,buflen_));
+        now = Time::get_monotonic();
+        if(rv < 0)
+          return rv;
+
+        result_.stats.add_request(buflen_,now - request_time);
+      }
+
+    result_.depth   = 1;
+    result_.seconds = (now - begin);
+
+    return 0;
+  }
+
+  static
+  int
+  aio_init(AsyncIO      &aio_,
+           const BlkDev &blkdev_,
+           const Test   &test_)
+  {
+    switch(test_.engine)
+      {
+      case OS:
+      case OS_DIRECT:
+        if(blkdev_.sim())
+          return aio_.init_sim(blkdev_.fd(),test_.depth,blkdev_.sim());
+        return aio_.init(blkdev_.fd(),test_.depth);
+      case ATA:
+      case VERIFY:
+        if(blkdev_.nvme_nsid())
+          return aio_.init_nvme(nvme::generic_path(blkdev_.fd()),
+                                test_.depth,
+                                blkdev_.nvme_nsid(),
+                                blkdev_.logical_block_size(),
+                                blkdev_.timeout(),
+                                (test_.engine == VERIFY));
+        if(blkdev_.is_scsi())
+          return aio_.init_scsi(sg::generic_path(blkdev_.fd()),
+                                test_.depth,
+                                blkdev_.logical_block_size(),
+                                blkdev_.timeout(),
+                                (test_.engine == VERIFY));
+        return aio_.init_sg(sg::generic_path(blkdev_.fd()),
+                            test_.depth,
+                            blkdev_.logical_block_size(),
+                            blkdev_.ata_xfer(),
+                            blkdev_.timeout(),
+                            (test_.engine == VERIFY));
+      }
+
+    return -ENOTSUP;
+  }
+
+  static
+  int
+  run_async(BlkDev         &blkdev_,
+            const Test     &test_,
+            const uint64_t  start_,
+            const uint64_t  end_,
+            char           *bufs_,
+            const uint64_t  buflen_,
+            Result         &result_)
+  {
+    int rv;
+    AsyncIO aio;
+    uint64_t rng;
+    uint64_t cursor;
+    double now;
+    double begin;
+    bool stopping;
+    unsigned int inflight;
+    std::vector<unsigned int> free_slots;
+    std::vector<double> slot_time;
+    std::vector<AsyncIO::Completion> completions;
+    const uint64_t lbs = blkdev_.logical_block_size();
+
+    rv = aio_init(aio,blkdev_,test_);
+    if(rv < 0)
+      return rv;
+
+    slot_time.resize(aio.depth());
+    for(unsigned int i = aio.depth(); i != 0; i--)
+      free_slots.push_back(i - 1);
+
+    rng      = 0x9E3779B97F4A7C15ULL;
+    cursor   = start_;
+    inflight = 0;
+    stopping = false;
+    begin    = Time::get_monotonic();
+    now      = begin;
+    while(!stopping || inflight)
+      {
+        if(((now - begin) >= SECONDS) || signals::signaled_to_exit())
+          stopping = true;
+
+        while(!stopping && !free_slots.empty())
+          {
+            uint64_t block;
+            const unsigned int slot = free_slots.back();
+
+            block = next_block(blkdev_,test_,start_,end_,cursor,rng);
+            rv = aio.submit(slot,
+                            (test_.write ? AsyncIO::WRITE : AsyncIO::READ),
+                            block * lbs,
+                            &bufs_[slot * buflen_],
+                            buflen_);
+            if(rv < 0)
+              break;
+
+            free_slots.pop_back();
+            slot_time[slot] = now;
+            inflight++;
+          }
+
+        rv = aio.flush();
+        if((rv < 0) || (inflight == 0))
+          break;
+
+        completions.clear();
+        rv = aio.reap(completions,1);
+        if(rv < 0)
+          break;
+
+        now = Time::get_monotonic();
+        for(size_t i = 0; i < completions.size(); i++)
+          {
+            const unsigned int slot = completions[i].slot;
+
+            inflight--;
+            free_slots.push_back(slot);
+            if(completions[i].res != (int64_t)buflen_)
+              {
+                rv       = ((completions[i].res < 0) ? completions[i].res : -EIO);
+                stopping = true;
+                continue;
+              }
+
+            result_.stats.add_request(buflen_,now - slot_time[slot]);
+          }
+      }
+
+    result_.depth   = aio.depth();
+    result_.seconds = (now - begin);
+
+    // let anything still queued after an error finish before the
+    // buffers are reused
+    while(inflight)
+      {
+        completions.clear();
+        if(aio.reap(completions,1) < 0)
+          break;
+        inflight -= std::min((size_t)inflight,completions.size());
+      }
+
+    return ((rv < 0) ? rv : 0);
+  }
+
+  static
+  void
+  print_header(std::ostream &os_)
+  {
+    os_ << std::left
+        << std::setw(10) << "engine"
+        << std::setw(7)  << "op"
+        << std::setw(8)  << "pattern"
+        << std::right
+        << std::setw(10) << "size"
+        << std::setw(5)  << "qd"
+        << std::setw(11) << "MB/s"
+        << std::setw(11) << "IOPS"
+        << std::setw(10) << "p50 ms"
+        << std::setw(10) << "p99 ms"
+        << std::setw(10) << "max ms"
+        << std::endl;
+  }
+
+  static
+  void
+  print_result(std::ostream   &os_,
+               const Test     &test_,
+               const uint64_t  lbs_,
+               const Result   &result_)
+  {
+    const double seconds = ((result_.seconds > 0) ? result_.seconds : 1.0);
+
+    os_ << std::left
+        << std::setw(10) << engine_to_string(test_.engine)
+        << std::setw(7)  << (test_.write ? "write" : "read")
+        << std::setw(8)  << (test_.random ? "random" : "seq")
+        << std::right
+        << std::setw(10) << (test_.stepping * lbs_)
+        << std::setw(5)  << result_.depth;
+
+    if(result_.error < 0)
+      {
+        os_ << "  failed [" << Error::to_string(-result_.error) << "]" << std::endl;
+        return;
+      }
+
+    os_ << std::fixed
+        << std::setprecision(2)
+        << std::setw(11) << (result_.stats.bytes() / seconds / (1024.0 * 1024.0))
+        << std::setprecision(0)
+        << std::setw(11) << (result_.stats.requests() / seconds)
+        << std::setprecision(3)
+        << std::setw(10) << (result_.stats.latency_percentile(0.5) / 1000.0)
+        << std::setw(10) << (result_.stats.latency_percentile(0.99) / 1000.0)
+        << std::setw(10) << (result_.stats.latency_percentile(1.0) / 1000.0)
+        << std::endl;
+  }
+
+  static
+  void
+  set_engine(BlkDev       &blkdev_,
+             const Engine  engine_)
+  {
+    switch(engine_)
+      {
+      case OS:
+      case OS_DIRECT:
+        blkdev_.set_rw_os();
+        break;
+      case ATA:
+        blkdev_.set_rw_ata();
+        break;
+      case VERIFY:
+        blkdev_.set_rw_verify();
+        break;
+      }
+  }
+
+  static
+  void
+  add_unique(std::vector<uint64_t> &values_,
+             const uint64_t         value_)
+  {
+    if(std::find(values_.begin(),values_.end(),value_) == values_.end())
+      values_.push_back(value_);
+  }
+}
+
+static
+AppError
+bench(const Options &opts)
+{
+  int rv;
+  char *buf;
+  BlkDev blkdev;
+  BlkDev direct;
+  uint64_t lbs;
+  uint64_t buflen;
+  uint64_t start_block;
+  uint64_t end_block;
+  std::vector<l::Engine> engines;
+  std::vector<uint64_t> steppings;
+  std::vector<uint64_t> depths;
+
+  if(opts.destructive)
+    rv = blkdev.open_rdwr(opts.device,!opts.force);
+  else
+    rv = blkdev.open_read(opts.device);
+  if(rv < 0)
+    return AppError::opening_device(-rv,opts.device);
+
+  if(opts.destructive)
+    {
+      const std::string captcha = captcha::calculate(blkdev);
+      if(opts.captcha != captcha)
+        return AppError::captcha(opts.captcha,captcha);
+    }
+
+  lbs         = blkdev.logical_block_size();
+  start_block = opts.start_block;
+  end_block   = std::min(opts.end_block,blkdev.logical_block_count());
+  if(start_block >= end_block)
+    return AppError::argument_invalid("start block >= end block");
+
+  // the first handle already holds any exclusive open
+  engines.push_back(l::OS);
+  rv = (opts.destructive ?
+        direct.open_rdwr(opts.device,false,true) :
+        direct.open_read(opts.device,true));
+  if(rv == 0)
+    engines.push_back(l::OS_DIRECT);
+  if(blkdev.has_identity() || blkdev.nvme_nsid() || blkdev.is_scsi())
+    {
+      engines.push_back(l::ATA);
+      engines.push_back(l::VERIFY);
+    }
+
+  if(opts.stepping)
+    {
+      steppings.push_back(opts.stepping);
+    }
+  else
+    {
+      l::add_unique(steppings,blkdev.block_stepping());
+      l::add_unique(steppings,std::max((uint64_t)(64 * 1024) / lbs,blkdev.block_stepping()));
+      l::add_unique(steppings,std::max((uint64_t)(1024 * 1024) / lbs,blkdev.block_stepping()));
+    }
+
+  depths.push_back(1);
+  if(opts.queue_depth > 1)
+    {
+      depths.push_back(opts.queue_depth);
+    }
+  else
+    {
+      depths.push_back(8);
+      depths.push_back(32);
+    }
+
+  buflen = (*std::max_element(steppings.begin(),steppings.end()) * lbs *
+            *std::max_element(depths.begin(),depths.end()));
+  buf = (char*)BufPool::get(buflen);
+  if(buf == NULL)
+    return AppError::runtime(ENOMEM,"unable to allocate buffer");
+  ::memset(buf,0,buflen);
+
+  std::cout << "start block: " << start_block << std::endl
+            << "end block: " << end_block << std::endl
+            << "logical block size: " << lbs << std::endl
+            << "physical block size: " << blkdev.physical_block_size() << std::endl
+            << "seconds per test: " << l::SECONDS << std::endl;
+  if(opts.destructive)
+    std::cout << "Warning: write tests overwrite blocks "
+              << start_block << " - " << end_block << std::endl;
+  std::cout << std::endl;
+
+  l::print_header(std::cout);
+  for(size_t e = 0; e < engines.size(); e++)
+    for(int w = 0; w < (opts.destructive ? 2 : 1); w++)
+      for(int r = 0; r < 2; r++)
+        for(size_t s = 0; s < steppings.size(); s++)
+          for(size_t d = 0; d < depths.size(); d++)
+            {
+              l::Test test;
+              l::Result result;
+              BlkDev &dev = ((engines[e] == l::OS_DIRECT) ? direct : blkdev);
+
+              if(signals::signaled_to_exit())
+                break;
+
+              test.engine   = engines[e];
+              test.write    = (w == 1);
+              test.random   = (r == 1);
+              test.stepping = steppings[s];
+              test.depth    = depths[d];
+              if((test.stepping > (end_block - start_block)) ||
+                 (test.write && (test.engine == l::VERIFY)))
+                continue;
+
+              l::set_engine(dev,test.engine);
+              if(test.engine == l::OS)
+                ::posix_fadvise(dev.fd(),0,0,POSIX_FADV_DONTNEED);
+
+              result.error   = 0;
+              result.depth   = test.depth;
+              result.seconds = 0;
+              if(test.depth == 1)
+                result.error = l::run_sync(dev,test,start_block,end_block,
+                                           buf,test.stepping * lbs,result);
+              else
+                result.error = l::run_async(dev,test,start_block,end_block,
+                                            buf,test.stepping * lbs,result);
+
+              l::print_result(std::cout,test,lbs,result);
+            }
+
+  BufPool::put(buf);
+
+  direct.close();
+
+  rv = blkdev.close();
+  if(rv < 0)
+    return AppError::closing_device(-rv,opts.device);
+
+  return AppError::success();
+}
+
+namespace bbf
+{
+  AppError
+  bench(const Options &opts)
+  {
+    return ::bench(opts);
+  }
+}
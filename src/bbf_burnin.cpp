@@ -17,20 +17,40 @@
 */
 
 #include <errno.h>
+#include <linux/blkzoned.h>
+#include <pthread.h>
+#include <signal.h>
 #include <stdint.h>
+#include <string.h>
 
+#include <algorithm>
 #include <iostream>
 #include <utility>
 
+#include "adaptivestepping.hpp"
+#include "asyncio.hpp"
 #include "badblockfile.hpp"
+#include "badblockset.hpp"
 #include "blkdev.hpp"
+#include "blkdevsetup.hpp"
+#include "bufpool.hpp"
 #include "captcha.hpp"
+#include "crc32c.hpp"
+#include "discard.hpp"
 #include "errors.hpp"
-#include "info.hpp"
+#include "journal.hpp"
 #include "math.hpp"
+#include "multidevice.hpp"
+#include "nvme.hpp"
 #include "options.hpp"
+#include "pattern.hpp"
+#include "progress.hpp"
+#include "progressreporter.hpp"
+#include "sg.hpp"
 #include "signals.hpp"
+#include "smart.hpp"
 #include "time.hpp"
+#include "zoned.hpp"
 
 static
 uint64_t
@@ -48,198 +68,2058 @@ trim_stepping(const BlkDev   &blkdev_,
   return std::min(block_count - block_,stepping_);
 }
 
+/*
+  Mismatching blocks are appended to mismatched_ and -EILSEQ returned
+  so only those, not the whole request, end up in the bad block list.
+*/
+static
+int
+compare_pattern(const Pattern::Pattern &pattern_,
+                const char             *rbuf_,
+                const uint64_t          block_,
+                const uint64_t          stepping_,
+                const uint64_t          lbs_,
+                std::vector<uint64_t>  &mismatched_)
+{
+  int rv;
+  int64_t off;
+  uint64_t done;
+
+  rv   = 0;
+  done = 0;
+  while(done < stepping_)
+    {
+      off = Pattern::verify(pattern_,&rbuf_[done * lbs_],block_ + done,stepping_ - done,lbs_);
+      if(off < 0)
+        break;
+
+      done += (off / lbs_);
+      mismatched_.push_back(block_ + done);
+      done++;
+      rv = -EILSEQ;
+    }
+
+  return rv;
+}
+
+static
+int
+write_read_compare(BlkDev                 &blkdev,
+                   const uint64_t          stepping_,
+                   const uint64_t          block,
+                   char                   *wbuf_,
+                   char                   *rbuf_,
+                   const size_t            buflen_,
+                   const int               retries,
+                   const Pattern::Pattern &pattern_,
+                   std::vector<uint64_t>  &mismatched_)
+{
+  int rv;
+  const uint64_t lbs = blkdev.logical_block_size();
+
+  Pattern::fill(pattern_,wbuf_,block,stepping_,lbs);
+
+  rv = -1;
+  for(uint64_t i = 0; ((i <= retries) && (rv < 0)); i++)
+    rv = blkdev.write(block,stepping_,wbuf_,buflen_);
+
+  if(rv < 0)
+    return rv;
+
+  rv = -1;
+  for(uint64_t i = 0; ((i <= retries) && (rv < 0)); i++)
+    rv = blkdev.read(block,stepping_,rbuf_,buflen_);
+
+  if(rv < 0)
+    return rv;
+
+  return compare_pattern(pattern_,rbuf_,block,stepping_,lbs,mismatched_);
+}
+
+/*
+  Runs patterns_ from first_ on and puts the original data in buf_
+  back. error_ carries the result of any patterns already run.
+*/
+static
+int
+burn_patterns(BlkDev                  &blkdev,
+              const uint64_t           stepping_,
+              const uint64_t           block,
+              const char              *buf_,
+              char                    *wbuf_,
+              char                    *rbuf_,
+              const size_t             len_,
+              const uint64_t           retries,
+              const Pattern::Patterns &patterns_,
+              const size_t             first_,
+              int                      error_,
+              std::vector<uint64_t>   &mismatched_)
+{
+  int rv;
+
+  for(size_t i = first_; i < patterns_.size(); i++)
+    {
+      rv = write_read_compare(blkdev,stepping_,block,wbuf_,rbuf_,len_,
+                              retries,patterns_[i],mismatched_);
+      if((rv < 0) && ((error_ == 0) || (error_ == -EILSEQ)))
+        error_ = rv;
+    }
+
+  rv = -1;
+  for(uint64_t i = 0; ((i <= retries) && (rv < 0)); i++)
+    rv = blkdev.write(block,stepping_,buf_,len_);
+  if(rv < 0)
+    error_ = rv;
+
+  // an I/O error condemns the whole range
+  if(error_ != -EILSEQ)
+    mismatched_.clear();
+
+  return error_;
+}
+
+static
+int
+burn_block(BlkDev                  &blkdev,
+           const uint64_t           stepping_,
+           const uint64_t           block,
+           char                    *buf_,
+           char                    *wbuf_,
+           char                    *rbuf_,
+           const size_t             buflen_,
+           const uint64_t           retries,
+           const Pattern::Patterns &patterns_,
+           std::vector<uint64_t>   &mismatched_)
+{
+  int rv;
+  size_t len;
+
+  len = std::min(buflen_,(size_t)(stepping_ * blkdev.logical_block_size()));
+
+  rv = -1;
+  for(uint64_t i = 0; ((i <= retries) && (rv < 0)); i++)
+    rv = blkdev.read(block,stepping_,buf_,len);
+
+  if(rv < 0)
+    ::memset(buf_,0,len);
+
+  return burn_patterns(blkdev,stepping_,block,buf_,wbuf_,rbuf_,len,
+                       retries,patterns_,0,0,mismatched_);
+}
+
+/*
+  Restores are checked against a CRC32C of each block of the original
+  data taken before the patterns overwrite it. The check is deferred:
+  stripes are read back RESTORE_BATCH at a time, well after their
+  restore was written, into a buffer already in use for comparing so
+  the original data isn't kept twice.
+*/
+static const size_t RESTORE_BATCH = 64;
+
+struct RestoreCheck
+{
+  struct Stripe
+  {
+    uint64_t block;
+    uint64_t stepping;
+    size_t   crc;
+  };
+
+  std::vector<Stripe>   stripes;
+  std::vector<uint32_t> crcs;
+};
+
+static
+void
+restore_record(RestoreCheck   &rc_,
+               const uint64_t  block_,
+               const uint64_t  stepping_,
+               const char     *buf_,
+               const uint64_t  lbs_)
+{
+  RestoreCheck::Stripe stripe;
+
+  stripe.block    = block_;
+  stripe.stepping = stepping_;
+  stripe.crc      = rc_.crcs.size();
+  rc_.stripes.push_back(stripe);
+
+  for(uint64_t i = 0; i < stepping_; i++)
+    rc_.crcs.push_back(CRC32C::calculate(&buf_[i * lbs_],lbs_));
+}
+
+/* lowest block whose restore is yet to be checked, for the journal */
+static
+uint64_t
+restore_watermark(const RestoreCheck &rc_,
+                  const uint64_t      block_)
+{
+  uint64_t rv;
+
+  rv = block_;
+  for(size_t i = 0; i < rc_.stripes.size(); i++)
+    rv = std::min(rv,rc_.stripes[i].block);
+
+  return rv;
+}
+
+/*
+  Reads back the recorded stripes and adds the blocks which don't
+  match their CRC, or can't be read, to badblocks_.
+*/
+static
+void
+restore_verify(BlkDev                &blkdev_,
+               RestoreCheck          &rc_,
+               char                  *buf_,
+               const size_t           buflen_,
+               const uint64_t         retries_,
+               std::vector<uint64_t> &badblocks_)
+{
+  int64_t rv;
+  const uint64_t lbs = blkdev_.logical_block_size();
+
+  for(size_t i = 0; i < rc_.stripes.size(); i++)
+    {
+      const RestoreCheck::Stripe &stripe = rc_.stripes[i];
+
+      rv = -1;
+      for(uint64_t r = 0; ((r <= retries_) && (rv < 0)); r++)
+        rv = blkdev_.read(stripe.block,stripe.stepping,buf_,buflen_);
+
+      for(uint64_t b = 0; b < stripe.stepping; b++)
+        {
+          if((rv >= 0) &&
+             (CRC32C::calculate(&buf_[b * lbs],lbs) == rc_.crcs[stripe.crc + b]))
+            continue;
+          badblocks_.push_back(stripe.block + b);
+        }
+    }
+
+  rc_.stripes.clear();
+  rc_.crcs.clear();
+}
+
+static
+void
+add_badblocks(const uint64_t         block_,
+              const uint64_t         stepping_,
+              const int              rv_,
+              std::vector<uint64_t> &mismatched_,
+              std::vector<uint64_t> &badblocks_)
+{
+  if(rv_ == -EILSEQ)
+    {
+      std::sort(mismatched_.begin(),mismatched_.end());
+      mismatched_.erase(std::unique(mismatched_.begin(),mismatched_.end()),
+                        mismatched_.end());
+      badblocks_.insert(badblocks_.end(),mismatched_.begin(),mismatched_.end());
+      return;
+    }
+
+  for(uint64_t i = 0; i < stepping_; i++)
+    badblocks_.push_back(block_ + i);
+}
+
+static
+int
+burnin_loop(BlkDev                  &blkdev,
+            const uint64_t          start_block,
+            const uint64_t          end_block,
+            const uint64_t          stepping_,
+            char                    *buf_,
+            const size_t            buflen_,
+            std::vector<uint64_t>   &badblocks,
+            const uint64_t          max_errors_,
+            const int               retries,
+            const Pattern::Patterns &patterns_,
+            AdaptiveStepping        *adaptive_,
+            Progress                *progress_,
+            Journal                 *journal_)
+{
+  int rv;
+  uint64_t block;
+  uint64_t stepping;
+  double request_time;
+  char *wbuf;
+  char *rbuf;
+  RestoreCheck restore;
+  std::vector<uint64_t> mismatched;
+  const uint64_t lbsize = blkdev.logical_block_size();
+
+  wbuf = (char*)BufPool::get(buflen_);
+  rbuf = (char*)BufPool::get(buflen_);
+  if((wbuf == NULL) || (rbuf == NULL))
+    {
+      BufPool::put(wbuf);
+      BufPool::put(rbuf);
+      return -ENOMEM;
+    }
+
+  block = start_block;
+  while(block < end_block)
+    {
+      if(signals::signaled_to_exit() || progress_->cancelled())
+        break;
+
+      progress_->set_current(block);
+      progress_->set_bad(badblocks);
+
+      if(journal_)
+        journal_->update(restore_watermark(restore,block),badblocks);
+
+      stepping = (adaptive_ ?
+                  std::min(adaptive_->stepping_at(block),end_block - block) :
+                  stepping_);
+      stepping = trim_stepping(blkdev,block,stepping);
+
+      request_time = Time::get_monotonic();
+      mismatched.clear();
+      rv = burn_block(blkdev,stepping,block,buf_,wbuf,rbuf,buflen_,
+                      retries,patterns_,mismatched);
+      request_time = (Time::get_monotonic() - request_time);
+      progress_->add_request(stepping * lbsize,request_time);
+      block += stepping;
+      if(rv >= 0)
+        {
+          if(adaptive_)
+            adaptive_->success(stepping,request_time);
+          restore_record(restore,block-stepping,stepping,buf_,lbsize);
+          if(restore.stripes.size() >= RESTORE_BATCH)
+            restore_verify(blkdev,restore,rbuf,buflen_,retries,badblocks);
+          continue;
+        }
+      if(rv == -EINVAL)
+        {
+          block -= stepping;
+          break;
+        }
+
+      if(adaptive_)
+        adaptive_->failure();
+
+      add_badblocks(block-stepping,stepping,rv,mismatched,badblocks);
+
+      if(badblocks.size() > max_errors_)
+        break;
+    }
+
+  restore_verify(blkdev,restore,rbuf,buflen_,retries,badblocks);
+
+  if(journal_)
+    journal_->checkpoint(block,badblocks);
+
+  progress_->set_current(block);
+  progress_->set_bad(badblocks);
+
+  BufPool::put(wbuf);
+  BufPool::put(rbuf);
+
+  return ((rv == -EILSEQ) ? -EIO : rv);
+}
+
+/*
+  OS writes and reads go through io_uring / libaio on the block device
+  itself and ATA ones through the sg character device, or NVMe
+  passthrough, or native SCSI commands through sg, as with scan.
+*/
+static
+int
+burnin_aio_init(AsyncIO       &aio_,
+                const BlkDev  &blkdev_,
+                const Options &opts_)
+{
+  int rv;
+
+  rv = -ENOTSUP;
+  switch(opts_.rwtype)
+    {
+    case Options::OS:
+      if(blkdev_.sim())
+        rv = aio_.init_sim(blkdev_.fd(),opts_.queue_depth,blkdev_.sim());
+      else
+        rv = aio_.init(blkdev_.fd(),opts_.queue_depth);
+      break;
+    case Options::ATA:
+      if(blkdev_.nvme_nsid())
+        {
+          rv = aio_.init_nvme(nvme::generic_path(blkdev_.fd()),
+                              opts_.queue_depth,
+                              blkdev_.nvme_nsid(),
+                              blkdev_.logical_block_size(),
+                              blkdev_.timeout(),
+                              false);
+          break;
+        }
+      if(blkdev_.is_scsi())
+        {
+          rv = aio_.init_scsi(sg::generic_path(blkdev_.fd()),
+                              opts_.queue_depth,
+                              blkdev_.logical_block_size(),
+                              blkdev_.timeout(),
+                              false);
+          break;
+        }
+      rv = aio_.init_sg(sg::generic_path(blkdev_.fd()),
+                        opts_.queue_depth,
+                        blkdev_.logical_block_size(),
+                        blkdev_.ata_xfer(),
+                        blkdev_.timeout(),
+                        false);
+      break;
+    default:
+      break;
+    }
+
+  if(rv == 0)
+    aio_.set_throttle(blkdev_.throttle());
+
+  return rv;
+}
+
+/*
+  State of one stripe in the pipeline. Each slot owns a stripe from
+  reading its original data to restoring it and has at most one
+  request in flight, so the stripe's own write -> read order holds
+  while other slots' requests overlap it.
+*/
+struct BurnSlot
+{
+  enum Phase
+    {
+      FREE,
+      READ_ORIGINAL,
+      WRITE_PATTERN,
+      READ_PATTERN,
+      RESTORE
+    };
+
+  Phase                 phase;
+  uint64_t              block;
+  uint64_t              stepping;
+  size_t                pattern;
+  int                   error;
+  char                 *buf;
+  char                 *wbuf;
+  char                 *rbuf;
+  std::vector<uint64_t> mismatched;
+};
+
+static
+uint64_t
+burn_watermark(const std::vector<BurnSlot> &slots_,
+               const uint64_t               next_block_)
+{
+  uint64_t rv;
+
+  rv = next_block_;
+  for(size_t i = 0; i < slots_.size(); i++)
+    if(slots_[i].phase != BurnSlot::FREE)
+      rv = std::min(rv,slots_[i].block);
+
+  return rv;
+}
+
+static
+int
+burn_slot_submit(AsyncIO        &aio_,
+                 const unsigned  slot_,
+                 BurnSlot       &s_,
+                 const uint64_t  lbs_)
+{
+  void *buf;
+  AsyncIO::Op op;
+
+  switch(s_.phase)
+    {
+    case BurnSlot::READ_ORIGINAL:
+      op  = AsyncIO::READ;
+      buf = s_.buf;
+      break;
+    case BurnSlot::WRITE_PATTERN:
+      op  = AsyncIO::WRITE;
+      buf = s_.wbuf;
+      break;
+    case BurnSlot::READ_PATTERN:
+      op  = AsyncIO::READ;
+      buf = s_.rbuf;
+      break;
+    case BurnSlot::RESTORE:
+      op  = AsyncIO::WRITE;
+      buf = s_.buf;
+      break;
+    default:
+      return -EINVAL;
+    }
+
+  return aio_.submit(slot_,op,s_.block * lbs_,buf,s_.stepping * lbs_);
+}
+
+/*
+  Advances a slot whose request completed successfully. Returns true
+  once the stripe has been restored.
+*/
+static
+bool
+burn_slot_advance(BurnSlot                &s_,
+                  const Pattern::Patterns &patterns_,
+                  const uint64_t           lbs_)
+{
+  int rv;
+
+  switch(s_.phase)
+    {
+    case BurnSlot::READ_PATTERN:
+      rv = compare_pattern(patterns_[s_.pattern],s_.rbuf,
+                           s_.block,s_.stepping,lbs_,s_.mismatched);
+      if((rv < 0) && (s_.error == 0))
+        s_.error = rv;
+      s_.pattern++;
+      // fall through
+    case BurnSlot::READ_ORIGINAL:
+      if(s_.pattern < patterns_.size())
+        {
+          Pattern::fill(patterns_[s_.pattern],s_.wbuf,s_.block,s_.stepping,lbs_);
+          s_.phase = BurnSlot::WRITE_PATTERN;
+        }
+      else
+        {
+          s_.phase = BurnSlot::RESTORE;
+        }
+      return false;
+    case BurnSlot::WRITE_PATTERN:
+      s_.phase = BurnSlot::READ_PATTERN;
+      return false;
+    default:
+      break;
+    }
+
+  return true;
+}
+
+/*
+  Writes the stripe's original data back, with --retries.
+*/
+static
+int
+burn_slot_restore(BlkDev         &blkdev_,
+                  BurnSlot       &s_,
+                  const uint64_t  retries_)
+{
+  int rv;
+  const size_t len = (s_.stepping * blkdev_.logical_block_size());
+
+  rv = -1;
+  for(uint64_t i = 0; ((i <= retries_) && (rv < 0)); i++)
+    rv = blkdev_.write(s_.block,s_.stepping,s_.buf,len);
+
+  return rv;
+}
+
+/*
+  A request which failed or came back short is retried synchronously
+  from the step it failed at, with --retries, the same as burn_block.
+*/
+static
+int
+burn_slot_fallback(BlkDev                  &blkdev_,
+                   BurnSlot                &s_,
+                   const uint64_t           retries_,
+                   const Pattern::Patterns &patterns_)
+{
+  int rv;
+  const size_t len = (s_.stepping * blkdev_.logical_block_size());
+
+  switch(s_.phase)
+    {
+    case BurnSlot::READ_ORIGINAL:
+      return burn_block(blkdev_,s_.stepping,s_.block,s_.buf,s_.wbuf,s_.rbuf,
+                        len,retries_,patterns_,s_.mismatched);
+    case BurnSlot::WRITE_PATTERN:
+    case BurnSlot::READ_PATTERN:
+      return burn_patterns(blkdev_,s_.stepping,s_.block,s_.buf,s_.wbuf,s_.rbuf,
+                           len,retries_,patterns_,s_.pattern,s_.error,
+                           s_.mismatched);
+    default:
+      break;
+    }
+
+  rv = burn_slot_restore(blkdev_,s_,retries_);
+  if(rv < 0)
+    s_.error = rv;
+  if(s_.error != -EILSEQ)
+    s_.mismatched.clear();
+
+  return s_.error;
+}
+
+/*
+  After a failed reap the pipeline can't be advanced. Whatever the
+  kernel will still complete is waited for and every stripe past
+  reading its original data has that written back synchronously so
+  a non-destructive burnin never leaves patterns behind. The stripes
+  aren't tested further.
+*/
+static
+void
+burn_slots_abort(BlkDev                &blkdev_,
+                 AsyncIO               &aio_,
+                 std::vector<BurnSlot> &slots_,
+                 unsigned int          &inflight_,
+                 const uint64_t         retries_,
+                 RestoreCheck          &restore_,
+                 std::vector<uint64_t> &badblocks_)
+{
+  int rv;
+  std::vector<AsyncIO::Completion> completions;
+  const uint64_t lbs = blkdev_.logical_block_size();
+
+  while(inflight_)
+    {
+      completions.clear();
+      rv = aio_.reap(completions,inflight_);
+      if(rv < 0)
+        break;
+      inflight_ -= completions.size();
+    }
+
+  for(size_t i = 0; i < slots_.size(); i++)
+    {
+      BurnSlot &s = slots_[i];
+
+      if((s.phase == BurnSlot::FREE) || (s.phase == BurnSlot::READ_ORIGINAL))
+        {
+          s.phase = BurnSlot::FREE;
+          continue;
+        }
+
+      rv = burn_slot_restore(blkdev_,s,retries_);
+      if(rv < 0)
+        add_badblocks(s.block,s.stepping,rv,s.mismatched,badblocks_);
+      else
+        restore_record(restore_,s.block,s.stepping,s.buf,lbs);
+      s.phase = BurnSlot::FREE;
+    }
+}
+
+/*
+  Same as burnin_loop but keeps up to `aio.depth()` stripes in the
+  pipeline so the drive writes one stripe while another is read back
+  and a third compared. Each completion reaped moves its stripe on a
+  step; all the requests that produces, restores included, go to the
+  kernel together with a single flush.
+*/
+static
+int
+burnin_loop_async(BlkDev                  &blkdev,
+                  AsyncIO                 &aio,
+                  const uint64_t           start_block,
+                  const uint64_t           end_block,
+                  const uint64_t           stepping_,
+                  char                    *bufs_,
+                  const size_t             buflen_,
+                  std::vector<uint64_t>   &badblocks,
+                  const uint64_t           max_errors_,
+                  const int                retries,
+                  const Pattern::Patterns &patterns_,
+                  Progress                *progress_,
+                  Journal                 *journal_)
+{
+  int rv;
+  int error;
+  int submit_rv;
+  uint64_t block;
+  uint64_t blocks_done;
+  uint64_t stop_block;
+  unsigned int inflight;
+  char *vbuf;
+  RestoreCheck restore;
+  std::vector<BurnSlot> slots;
+  std::vector<unsigned int> free_slots;
+  std::vector<unsigned int> ready;
+  std::vector<AsyncIO::Completion> completions;
+  const uint64_t lbsize = blkdev.logical_block_size();
+
+  vbuf = (char*)BufPool::get(buflen_);
+  if(vbuf == NULL)
+    return -ENOMEM;
+
+  slots.resize(aio.depth());
+  for(unsigned int i = 0; i < aio.depth(); i++)
+    {
+      slots[i].phase = BurnSlot::FREE;
+      slots[i].buf   = &bufs_[((i * 3) + 0) * buflen_];
+      slots[i].wbuf  = &bufs_[((i * 3) + 1) * buflen_];
+      slots[i].rbuf  = &bufs_[((i * 3) + 2) * buflen_];
+    }
+  for(unsigned int i = aio.depth(); i != 0; i--)
+    free_slots.push_back(i - 1);
+
+  error       = 0;
+  inflight    = 0;
+  blocks_done = 0;
+  stop_block  = ~0ULL;
+  block       = start_block;
+  while((block < end_block) || inflight || !ready.empty())
+    {
+      if(signals::signaled_to_exit() || progress_->cancelled())
+        {
+          stop_block = std::min(stop_block,burn_watermark(slots,block));
+          block      = end_block;
+        }
+
+      progress_->set_current(start_block+blocks_done);
+      progress_->set_bad(badblocks);
+
+      if(journal_)
+        journal_->update(std::min(stop_block,
+                                  restore_watermark(restore,burn_watermark(slots,block))),
+                         badblocks);
+
+      // stripes already in the pipeline are finished even when
+      // stopping so their original data is put back
+      submit_rv = 0;
+      while(!ready.empty())
+        {
+          const unsigned int slot = ready.back();
+
+          submit_rv = burn_slot_submit(aio,slot,slots[slot],lbsize);
+          if(submit_rv < 0)
+            break;
+
+          ready.pop_back();
+          inflight++;
+        }
+
+      while((block < end_block) && !free_slots.empty())
+        {
+          unsigned int slot;
+          uint64_t stepping;
+
+          stepping = trim_stepping(blkdev,block,stepping_);
+          if(stepping == 0)
+            {
+              block = end_block;
+              break;
+            }
+
+          slot = free_slots.back();
+          slots[slot].phase    = BurnSlot::READ_ORIGINAL;
+          slots[slot].block    = block;
+          slots[slot].stepping = stepping;
+          slots[slot].pattern  = 0;
+          slots[slot].error    = 0;
+          slots[slot].mismatched.clear();
+
+          submit_rv = burn_slot_submit(aio,slot,slots[slot],lbsize);
+          if(submit_rv < 0)
+            {
+              slots[slot].phase = BurnSlot::FREE;
+              break;
+            }
+
+          free_slots.pop_back();
+          block += stepping;
+          inflight++;
+        }
+
+      rv = aio.flush();
+      if(rv < 0)
+        {
+          error      = rv;
+          stop_block = std::min(stop_block,burn_watermark(slots,block));
+          block      = end_block;
+        }
+
+      if(inflight == 0)
+        {
+          // nothing the kernel could complete: finish stripes by hand
+          for(size_t i = 0; i < ready.size(); i++)
+            {
+              BurnSlot &s = slots[ready[i]];
+
+              rv = burn_slot_fallback(blkdev,s,retries,patterns_);
+              if(rv < 0)
+                add_badblocks(s.block,s.stepping,rv,s.mismatched,badblocks);
+              else
+                restore_record(restore,s.block,s.stepping,s.buf,lbsize);
+              blocks_done += s.stepping;
+              s.phase = BurnSlot::FREE;
+              free_slots.push_back(ready[i]);
+            }
+          ready.clear();
+          if((block < end_block) && (submit_rv == 0))
+            continue;
+          if(submit_rv < 0)
+            error = submit_rv;
+          stop_block = std::min(stop_block,block);
+          break;
+        }
+
+      completions.clear();
+      rv = aio.reap(completions,1);
+      if(rv < 0)
+        {
+          error      = rv;
+          stop_block = std::min(stop_block,burn_watermark(slots,block));
+          block      = end_block;
+          burn_slots_abort(blkdev,aio,slots,inflight,retries,restore,badblocks);
+          ready.clear();
+          break;
+        }
+
+      for(size_t i = 0; i < completions.size(); i++)
+        {
+          const unsigned int slot = completions[i].slot;
+          const int64_t      res  = completions[i].res;
+          BurnSlot          &s    = slots[slot];
+
+          inflight--;
+
+          if(res == (int64_t)(s.stepping * lbsize))
+            {
+              if(!burn_slot_advance(s,patterns_,lbsize))
+                {
+                  ready.push_back(slot);
+                  continue;
+                }
+              rv = s.error;
+              if(rv != -EILSEQ)
+                s.mismatched.clear();
+            }
+          else
+            {
+              rv = burn_slot_fallback(blkdev,s,retries,patterns_);
+            }
+
+          if(rv >= 0)
+            restore_record(restore,s.block,s.stepping,s.buf,lbsize);
+
+          blocks_done += s.stepping;
+          s.phase = BurnSlot::FREE;
+          free_slots.push_back(slot);
+
+          if(rv >= 0)
+            continue;
+          if(rv == -EINVAL)
+            {
+              error      = rv;
+              stop_block = std::min(stop_block,s.block);
+              block      = end_block;
+              continue;
+            }
+
+          add_badblocks(s.block,s.stepping,rv,s.mismatched,badblocks);
+          if(badblocks.size() > max_errors_)
+            {
+              stop_block = std::min(stop_block,burn_watermark(slots,block));
+              block      = end_block;
+            }
+        }
+
+      if(restore.stripes.size() >= RESTORE_BATCH)
+        restore_verify(blkdev,restore,vbuf,buflen_,retries,badblocks);
+    }
+
+  restore_verify(blkdev,restore,vbuf,buflen_,retries,badblocks);
+  BufPool::put(vbuf);
+
+  if(journal_)
+    journal_->checkpoint(std::min(stop_block,burn_watermark(slots,block)),
+                         badblocks);
+
+  progress_->set_current(start_block+blocks_done);
+  progress_->set_bad(badblocks);
+
+  return error;
+}
+
+/*
+  Pattern major requests default to 1MiB so each pass streams through
+  the window with large sequential I/O.
+*/
+#define PATTERN_MAJOR_BYTES (1024 * 1024)
+#define WRITE_CACHE_WINDOW_BYTES (64 * 1024 * 1024)
+
+static
+uint64_t
+pattern_major_stepping(const BlkDev   &blkdev_,
+                       const uint64_t  stepping_)
+{
+  if(stepping_ != 0)
+    return stepping_;
+
+  return std::max(blkdev_.block_stepping(),
+                  (PATTERN_MAJOR_BYTES / blkdev_.logical_block_size()));
+}
+
+/*
+  Reads or writes [block_,block_+count_) whole and only when that
+  fails retries it as one batch of physical block sized pieces,
+  marking those which still fail as bad. Pieces which can't be read
+  are zeroed.
+*/
+static
+int
+rw_chunk(BlkDev                &blkdev_,
+         const bool             write_,
+         const uint64_t         block_,
+         const uint64_t         count_,
+         char                  *buf_,
+         const int              retries_,
+         std::vector<uint64_t> &bad_)
+{
+  int rv;
+  int error;
+  uint64_t piece;
+  std::vector<size_t> idx;
+  std::vector<BlkDev::Request> reqs;
+  std::vector<BlkDev::Request> retry;
+  const uint64_t lbs = blkdev_.logical_block_size();
+
+  rv = -1;
+  for(uint64_t i = 0; ((i <= retries_) && (rv < 0)); i++)
+    rv = (write_ ?
+          blkdev_.write(block_,count_,buf_,(count_ * lbs)) :
+          blkdev_.read(block_,count_,buf_,(count_ * lbs)));
+  if((rv >= 0) || (rv == -EINVAL))
+    return rv;
+
+  for(uint64_t b = 0; b < count_; b += piece)
+    {
+      BlkDev::Request req;
+
+      piece = std::min(blkdev_.block_stepping(),count_ - b);
+
+      req.lba    = (block_ + b);
+      req.blocks = piece;
+      req.buf    = &buf_[b * lbs];
+      req.buflen = (piece * lbs);
+      req.op     = (write_ ? BlkDev::WRITE : BlkDev::READ);
+      reqs.push_back(req);
+    }
+
+  blkdev_.submit(reqs);
+  for(int i = 0; i < retries_; i++)
+    {
+      idx.clear();
+      retry.clear();
+      for(size_t r = 0; r < reqs.size(); r++)
+        {
+          if(reqs[r].rv >= 0)
+            continue;
+          idx.push_back(r);
+          retry.push_back(reqs[r]);
+        }
+
+      if(retry.empty())
+        break;
+
+      blkdev_.submit(retry);
+      for(size_t r = 0; r < idx.size(); r++)
+        reqs[idx[r]] = retry[r];
+    }
+
+  error = 0;
+  for(size_t r = 0; r < reqs.size(); r++)
+    {
+      const BlkDev::Request &req = reqs[r];
+
+      if(req.rv >= 0)
+        continue;
+      if(req.rv == -EINVAL)
+        return req.rv;
+
+      if(!write_)
+        ::memset(req.buf,0,req.buflen);
+      for(uint64_t i = 0; i < req.blocks; i++)
+        bad_.push_back(req.lba + i);
+      error = req.rv;
+    }
+
+  return error;
+}
+
+/*
+  Position shown while a window is worked on: how far through all of
+  the window's passes it is, scaled onto the window so it only ever
+  moves forward.
+*/
+static
+uint64_t
+window_position(const uint64_t win_start_,
+                const uint64_t win_len_,
+                const uint64_t passes_,
+                const uint64_t pass_,
+                const uint64_t offset_)
+{
+  return (win_start_ + (((pass_ * win_len_) + offset_) / passes_));
+}
+
+/*
+  One window of a pattern major burnin: unless destructive the
+  window's data is read into save_, then each pattern is written
+  across the whole window and only then read back and compared,
+  before the saved data is written back. Stopping part way still
+  restores the window. With --write-cache flush the drive's cache is
+  flushed once after each pattern's write pass so the read back hits
+  the media. Failures are recorded in bad_; only -EINVAL (out of
+  range) or a failed flush is returned.
+*/
+static
+int
+burn_window(BlkDev                  &blkdev_,
+            const uint64_t           win_start_,
+            const uint64_t           win_end_,
+            const uint64_t           stepping_,
+            char                    *save_,
+            char                    *wbuf_,
+            char                    *rbuf_,
+            const int                retries_,
+            const Pattern::Patterns &patterns_,
+            std::vector<uint64_t>   &bad_,
+            const bool               flush_,
+            Progress                *progress_)
+{
+  int rv;
+  int error;
+  uint64_t pass;
+  uint64_t count;
+  const uint64_t lbs     = blkdev_.logical_block_size();
+  const uint64_t win_len = (win_end_ - win_start_);
+  const uint64_t passes  = ((patterns_.size() * 2) + (save_ ? 2 : 0));
+
+  error = 0;
+  pass  = 0;
+  if(save_)
+    {
+      for(uint64_t b = win_start_; b < win_end_; b += count)
+        {
+          count = std::min(stepping_,win_end_ - b);
+          rv = rw_chunk(blkdev_,false,b,count,&save_[(b - win_start_) * lbs],
+                        retries_,bad_);
+          if(rv == -EINVAL)
+            return rv;
+          progress_->set_current(window_position(win_start_,win_len,passes,
+                                                   pass,b - win_start_));
+        }
+      pass++;
+    }
+
+  for(size_t i = 0; i < patterns_.size(); i++)
+    {
+      const Pattern::Pattern &pattern = patterns_[i];
+
+      if(signals::signaled_to_exit() || progress_->cancelled())
+        break;
+
+      for(uint64_t b = win_start_; b < win_end_; b += count)
+        {
+          count = std::min(stepping_,win_end_ - b);
+          Pattern::fill(pattern,wbuf_,b,count,lbs);
+          rv = rw_chunk(blkdev_,true,b,count,wbuf_,retries_,bad_);
+          if(rv == -EINVAL)
+            {
+              error = rv;
+              break;
+            }
+          progress_->set_current(window_position(win_start_,win_len,passes,
+                                                   pass,b - win_start_));
+        }
+      pass++;
+      if(error == -EINVAL)
+        break;
+
+      if(flush_)
+        {
+          rv = blkdev_.flush_write_cache();
+          if(rv < 0)
+            {
+              error = rv;
+              break;
+            }
+        }
+
+      for(uint64_t b = win_start_; b < win_end_; b += count)
+        {
+          count = std::min(stepping_,win_end_ - b);
+          rv = rw_chunk(blkdev_,false,b,count,rbuf_,retries_,bad_);
+          if(rv == -EINVAL)
+            {
+              error = rv;
+              break;
+            }
+          compare_pattern(pattern,rbuf_,b,count,lbs,bad_);
+          progress_->set_current(window_position(win_start_,win_len,passes,
+                                                   pass,b - win_start_));
+        }
+      pass++;
+      if(error == -EINVAL)
+        break;
+    }
+
+  if(save_)
+    {
+      for(uint64_t b = win_start_; b < win_end_; b += count)
+        {
+          count = std::min(stepping_,win_end_ - b);
+          rv = rw_chunk(blkdev_,true,b,count,&save_[(b - win_start_) * lbs],
+                        retries_,bad_);
+          if(rv == -EINVAL)
+            error = rv;
+        }
+
+      if(flush_)
+        {
+          rv = blkdev_.flush_write_cache();
+          if((rv < 0) && (error == 0))
+            error = rv;
+        }
+    }
+
+  return error;
+}
+
+static
+int
+burnin_pattern_major(BlkDev                  &blkdev,
+                     const uint64_t           start_block,
+                     const uint64_t           end_block,
+                     const uint64_t           stepping_,
+                     const uint64_t           window_,
+                     char                    *save_,
+                     char                    *wbuf_,
+                     char                    *rbuf_,
+                     std::vector<uint64_t>   &badblocks,
+                     const uint64_t           max_errors_,
+                     const int                retries,
+                     const Pattern::Patterns &patterns_,
+                     const bool               flush_,
+                     Progress                *progress_,
+                     Journal                 *journal_)
+{
+  int rv;
+  uint64_t block;
+  uint64_t win_end;
+  std::vector<uint64_t> bad;
+
+  rv    = 0;
+  block = start_block;
+  while(block < end_block)
+    {
+      if(signals::signaled_to_exit() || progress_->cancelled())
+        break;
+
+      if(journal_)
+        journal_->update(block,badblocks);
+
+      win_end = std::min(block + window_,end_block);
+
+      bad.clear();
+      rv = burn_window(blkdev,block,win_end,stepping_,save_,wbuf_,rbuf_,
+                       retries,patterns_,bad,flush_,progress_);
+
+      std::sort(bad.begin(),bad.end());
+      bad.erase(std::unique(bad.begin(),bad.end()),bad.end());
+      badblocks.insert(badblocks.end(),bad.begin(),bad.end());
+      progress_->set_bad(badblocks);
+
+      if(rv < 0)
+        break;
+      // an interrupted window has to be run again in full
+      if(signals::signaled_to_exit() || progress_->cancelled())
+        break;
+
+      block = win_end;
+      if(badblocks.size() > max_errors_)
+        break;
+    }
+
+  if(journal_)
+    journal_->checkpoint(block,badblocks);
+
+  progress_->set_current(block);
+  progress_->set_bad(badblocks);
+
+  return rv;
+}
+
+/*
+  --window / --destructive / --write-cache: each pattern is written
+  over a whole window before being read back rather than cycling all
+  the patterns over one stripe at a time. Destructive runs don't save
+  or restore anything and default to the whole range as a single
+  window. Flushing or FUA writes only pay off spread over a window and
+  so default to one of 64MiB.
+*/
+/*
+  --discard: reset the SSD's mapping of the range so the patterns are
+  written to erased flash, and read it back expecting zeros which
+  finds unreadable blocks at read speed before the slower pattern
+  passes. Non-zero blocks are only bad if the drive guarantees zeros.
+*/
 static
 int
-write_read_compare(BlkDev         &blkdev,
-                   const uint64_t  stepping_,
-                   const uint64_t  block,
-                   char           *buf_,
-                   const size_t    buflen_,
-                   const int       retries,
-                   const char     *write_buf)
+discard_verify(BlkDev                &blkdev_,
+               const uint64_t         start_block_,
+               const uint64_t         end_block_,
+               const uint64_t         stepping_,
+               std::vector<uint64_t> &badblocks_,
+               std::ostream          &os_,
+               Progress              *progress_)
 {
   int rv;
+  int64_t skipped;
+  uint64_t nonzero;
 
-  rv = -1;
-  for(uint64_t i = 0; ((i <= retries) && (rv < 0)); i++)
-    rv = blkdev.write(block,stepping_,write_buf,buflen_);
+  os_ << "\r\x1B[2KDiscarding: "
+      << start_block_
+      << " - "
+      << end_block_
+      << std::endl;
 
-  if(rv < 0)
-    return rv;
+  skipped = Discard::range(blkdev_,start_block_,end_block_,progress_);
+  if(skipped < 0)
+    return skipped;
+  if(skipped > 0)
+    os_ << "\r\x1B[2KWarning: device refused to discard "
+        << skipped << " blocks" << std::endl;
 
-  rv = -1;
-  for(uint64_t i = 0; ((i <= retries) && (rv < 0)); i++)
-    rv = blkdev.read(block,stepping_,buf_,buflen_);
+  os_ << "\r\x1B[2KVerifying zeros: "
+      << start_block_
+      << " - "
+      << end_block_
+      << std::endl;
 
-  if(rv < 0)
-    return rv;
+  progress_->set_range(start_block_,end_block_,blkdev_.logical_block_size());
+  rv = Discard::verify_zero(blkdev_,
+                            start_block_,
+                            end_block_,
+                            stepping_,
+                            badblocks_,
+                            nonzero,
+                            progress_);
+  if(nonzero)
+    os_ << "\r\x1B[2KWarning: " << nonzero
+        << " blocks not zero after discard"
+        << (blkdev_.discard_zeroes() ? " - marked bad" : "")
+        << std::endl;
+
+  return rv;
+}
+
+static
+AppError
+burnin_by_pattern(BlkDev                &blkdev,
+                  const Options         &opts,
+                  std::vector<uint64_t> &badblocks,
+                  std::ostream          &os,
+                  Progress              *progress,
+                  Journal               *journal)
+{
+  int              rv;
+  bool             report;
+  char            *save;
+  char            *wbuf;
+  char            *rbuf;
+  uint64_t         lbs;
+  uint64_t         window;
+  uint64_t         start_block;
+  uint64_t         end_block;
+  uint64_t         stepping;
+  Progress         local_progress;
+  ProgressReporter reporter;
+  Smart::Snapshot smart_before;
+  Smart::Snapshot smart_after;
+
+  lbs      = blkdev.logical_block_size();
+  stepping = pattern_major_stepping(blkdev,opts.stepping);
+
+  start_block = math::round_down(opts.start_block,stepping);
+  end_block   = std::min(opts.end_block,blkdev.logical_block_count());
+  end_block   = math::round_up(end_block,stepping);
+  end_block   = std::min(end_block,blkdev.logical_block_count());
+
+  if(opts.window != 0)
+    window = opts.window;
+  else if(opts.destructive)
+    window = (end_block - start_block);
+  else
+    window = (WRITE_CACHE_WINDOW_BYTES / lbs);
+  window = math::round_up(std::max(window,stepping),stepping);
+
+  if(journal)
+    journal->set_end(end_block);
+
+  os << "start block: "
+     << start_block << std::endl
+     << "end block: "
+     << end_block << std::endl
+     << "stepping: "
+     << stepping << std::endl
+     << "logical block size: "
+     << lbs << std::endl
+     << "physical block size: "
+     << blkdev.physical_block_size() << std::endl
+     << "r/w size: "
+     << stepping << " blocks / "
+     << (stepping * lbs) << " bytes"
+     << std::endl
+     << "window: "
+     << window << " blocks / "
+     << (window * lbs) << " bytes"
+     << (opts.destructive ? " (destructive)" : "")
+     << std::endl;
+
+  if(opts.discard)
+    os << "discard: before & after patterns (zeros after discard "
+       << (blkdev.discard_zeroes() ? "guaranteed" : "not guaranteed")
+       << ")" << std::endl;
+
+  switch(opts.write_cache)
+    {
+    case Options::WRITE_CACHE_FLUSH:
+      os << "write cache: flush per window pass" << std::endl;
+      break;
+    case Options::WRITE_CACHE_FUA:
+      os << "write cache: force unit access" << std::endl;
+      if((opts.rwtype == Options::OS) && !opts.direct)
+        os << "Warning: without --direct reads may be served from"
+           << " the page cache" << std::endl;
+      break;
+    default:
+      break;
+    }
+
+  if((opts.rwtype != Options::OS) && blkdev.nvme_nsid())
+    os << "nvme namespace: "
+       << blkdev.nvme_nsid()
+       << std::endl;
+  else if((opts.rwtype != Options::OS) && blkdev.is_scsi())
+    os << "scsi commands: READ(16) / WRITE(16) / VERIFY(16)"
+       << std::endl;
+  else if((opts.rwtype == Options::ATA) && blkdev.has_identity())
+    os << "ata transfer mode: "
+       << sg::xfer_mode_to_string(blkdev.ata_xfer())
+       << std::endl;
+
+  os << "patterns: "
+     << Pattern::to_string(opts.patterns)
+     << " (" << Pattern::isa() << ")"
+     << std::endl;
+
+  if(opts.adaptive || (opts.queue_depth > 1))
+    os << "Warning: adaptive stepping and queue depth are not supported"
+       << " with pattern major burnin - ignoring"
+       << std::endl;
+
+  save = NULL;
+  if(!opts.destructive)
+    {
+      save = (char*)BufPool::get(window * lbs);
+      if(save == NULL)
+        return AppError::runtime(ENOMEM,"unable to allocate window buffer");
+    }
+
+  wbuf = (char*)BufPool::get(stepping * lbs);
+  rbuf = (char*)BufPool::get(stepping * lbs);
+  if((wbuf == NULL) || (rbuf == NULL))
+    {
+      BufPool::put(save);
+      BufPool::put(wbuf);
+      BufPool::put(rbuf);
+      return AppError::runtime(ENOMEM,"unable to allocate buffer");
+    }
+
+  report = (progress == NULL);
+  if(report)
+    progress = &local_progress;
+  progress->set_range(start_block,end_block,lbs);
+  progress->set_bad(badblocks);
 
-  rv = ::memcmp(write_buf,buf_,buflen_);
-  if(rv != 0)
-    return -EIO;
+  Smart::snapshot(blkdev,smart_before,progress);
 
-  return 0;
+  if(report)
+    reporter.start(os,*progress);
+
+  rv = 0;
+  if(opts.discard)
+    {
+      rv = discard_verify(blkdev,start_block,end_block,stepping,badblocks,os,progress);
+      progress->set_range(start_block,end_block,lbs);
+      progress->set_bad(badblocks);
+    }
+
+  os << "\r\x1B[2KBurning: "
+     << start_block
+     << " - "
+     << end_block
+     << std::endl;
+
+  blkdev.set_fua(opts.write_cache == Options::WRITE_CACHE_FUA);
+
+  if(rv == 0)
+    rv = burnin_pattern_major(blkdev,
+                              start_block,
+                              end_block,
+                              stepping,
+                              window,
+                              save,
+                              wbuf,
+                              rbuf,
+                              badblocks,
+                              opts.max_errors,
+                              opts.retries,
+                              opts.patterns,
+                              (opts.write_cache == Options::WRITE_CACHE_FLUSH),
+                              progress,
+                              journal);
+
+  blkdev.set_fua(false);
+
+  if(opts.discard && (rv >= 0))
+    {
+      os << "\r\x1B[2KDiscarding: "
+         << start_block
+         << " - "
+         << end_block
+         << std::endl;
+      progress->set_range(start_block,end_block,lbs);
+      rv = std::min(Discard::range(blkdev,start_block,end_block,progress),
+                    (int64_t)0);
+    }
+
+  BufPool::put(save);
+  BufPool::put(wbuf);
+  BufPool::put(rbuf);
+
+  Smart::snapshot(blkdev,smart_after,progress);
+
+  if(report)
+    {
+      reporter.stop();
+      os << std::endl;
+    }
+
+  Smart::print(os,smart_before,smart_after);
+
+  if(rv < 0)
+    return AppError::runtime(-rv,"error when performing burnin");
+
+  return AppError::success();
 }
 
+/*
+  Zoned devices: sequential zones can only be written at their write
+  pointer so a stripe can't be rewritten in place. Each zone is reset
+  and each pattern written through it in order, read back and
+  compared, leaving it reset once done. Several zones are burned at
+  once, each by its own thread, but never more than the device can
+  keep open. Only destructive burnins are possible.
+*/
+static const uint64_t ZONE_JOBS = 4;
+
+struct ZoneJob
+{
+  BlkDev                         *blkdev;
+  const Options                  *opts;
+  const std::vector<Zoned::Zone> *zones;
+  std::vector<char>              *done;
+  uint64_t                       *next;
+  uint64_t                       *bad;
+  uint64_t                        stepping;
+  std::vector<uint64_t>           badblocks;
+  Progress                       *progress;
+  int                             rv;
+  int                             finished;
+  pthread_t                       thread;
+  bool                            started;
+};
+
+/*
+  A write which fails leaves the write pointer where the drive
+  stopped so the rest of the zone can't be written this pass: the
+  failed chunk is marked bad and only what was written is read back.
+*/
 static
 int
-burn_block(BlkDev         &blkdev,
-           const uint64_t  stepping_,
-           const uint64_t  block,
-           char           *buf_,
-           const size_t    buflen_,
-           const uint64_t  retries,
-           const std::vector<std::vector<char> > &patterns_)
+burn_zone(BlkDev                  &blkdev_,
+          const Zoned::Zone       &zone_,
+          const uint64_t           stepping_,
+          char                    *wbuf_,
+          char                    *rbuf_,
+          const int                retries_,
+          const Pattern::Patterns &patterns_,
+          const bool               flush_,
+          std::vector<uint64_t>   &bad_,
+          uint64_t                *bad_count_,
+          Progress                *progress_)
 {
   int rv;
+  uint64_t end;
+  uint64_t count;
+  uint64_t written;
+  std::vector<uint64_t> bad;
+  const uint64_t lbs = blkdev_.logical_block_size();
 
-  rv = -1;
-  for(uint64_t i = 0; ((i <= retries) && (rv < 0)); i++)
-    rv = blkdev.read(block,stepping_,buf_,buflen_);
+  end = (zone_.start + zone_.capacity);
+  for(size_t i = 0; i < patterns_.size(); i++)
+    {
+      const Pattern::Pattern &pattern = patterns_[i];
 
-  if(rv < 0)
-    ::memset(buf_,0,buflen_);
+      if(signals::signaled_to_exit() || progress_->cancelled())
+        return 0;
 
-  for(uint64_t i = 0; i < patterns_.size(); i++)
-    rv = write_read_compare(blkdev,stepping_,block,buf_,buflen_,retries,&patterns_[i][0]);
+      rv = Zoned::reset(blkdev_,zone_);
+      if(rv < 0)
+        return rv;
 
-  rv = -1;
-  for(uint64_t i = 0; ((i <= retries) && (rv < 0)); i++)
-    rv = blkdev.write(block,stepping_,buf_,buflen_);
+      written = zone_.start;
+      for(uint64_t b = zone_.start; b < end; b += count)
+        {
+          count = std::min(stepping_,end - b);
+          Pattern::fill(pattern,wbuf_,b,count,lbs);
+          rv = blkdev_.write(b,count,wbuf_,(count * lbs));
+          if(rv == -EINVAL)
+            return rv;
+          if(rv < 0)
+            {
+              for(uint64_t j = 0; j < count; j++)
+                bad.push_back(b + j);
+              progress_->advance(2 * (end - b));
+              break;
+            }
+          written = (b + count);
+          progress_->advance(count);
+        }
 
-  return rv;
+      if(flush_)
+        {
+          rv = blkdev_.flush_write_cache();
+          if(rv < 0)
+            return rv;
+        }
+
+      for(uint64_t b = zone_.start; b < written; b += count)
+        {
+          count = std::min(stepping_,written - b);
+          rv = rw_chunk(blkdev_,false,b,count,rbuf_,retries_,bad);
+          if(rv == -EINVAL)
+            return rv;
+          compare_pattern(pattern,rbuf_,b,count,lbs,bad);
+          progress_->advance(count);
+        }
+
+      std::sort(bad.begin(),bad.end());
+      bad.erase(std::unique(bad.begin(),bad.end()),bad.end());
+      __atomic_add_fetch(bad_count_,bad.size(),__ATOMIC_RELAXED);
+      bad_.insert(bad_.end(),bad.begin(),bad.end());
+      bad.clear();
+    }
+
+  return Zoned::reset(blkdev_,zone_);
 }
 
 static
 int
-burnin_loop(BlkDev                &blkdev,
-            const uint64_t         start_block,
-            const uint64_t         end_block,
-            const uint64_t         stepping_,
-            char                  *buf_,
-            const size_t           buflen_,
-            std::vector<uint64_t> &badblocks,
-            const uint64_t         max_errors_,
-            const int              retries)
+burnin_zone_job(ZoneJob *job_)
 {
   int rv;
-  uint64_t block;
-  uint64_t stepping;
-  double current_time;
-  std::vector<std::vector<char> > patterns;
-  const double start_time = Time::get_monotonic();
-
-  patterns.resize(4);
-  patterns[0].resize(buflen_,0x00);
-  patterns[1].resize(buflen_,0x55);
-  patterns[2].resize(buflen_,0xAA);
-  patterns[3].resize(buflen_,0xFF);
+  char *wbuf;
+  char *rbuf;
+  uint64_t i;
+  const Options &opts = *job_->opts;
+  const uint64_t lbs  = job_->blkdev->logical_block_size();
 
-  current_time = Time::get_monotonic();
-  Info::print(std::cout,start_time,current_time,
-              start_block,end_block,start_block,badblocks);
+  wbuf = (char*)BufPool::get(job_->stepping * lbs);
+  rbuf = (char*)BufPool::get(job_->stepping * lbs);
+  if((wbuf == NULL) || (rbuf == NULL))
+    {
+      BufPool::put(wbuf);
+      BufPool::put(rbuf);
+      return -ENOMEM;
+    }
 
-  block = start_block;
-  while(block < end_block)
+  rv = 0;
+  while(!signals::signaled_to_exit() && !job_->progress->cancelled())
     {
-      if(signals::signaled_to_exit())
+      i = __atomic_fetch_add(job_->next,1,__ATOMIC_RELAXED);
+      if(i >= job_->zones->size())
         break;
 
-      if(signals::dec(SIGALRM))
+      rv = burn_zone(*job_->blkdev,
+                     (*job_->zones)[i],
+                     job_->stepping,
+                     wbuf,
+                     rbuf,
+                     opts.retries,
+                     opts.patterns,
+                     (opts.write_cache == Options::WRITE_CACHE_FLUSH),
+                     job_->badblocks,
+                     job_->bad,
+                     job_->progress);
+      if(rv < 0)
+        break;
+      if(signals::signaled_to_exit() || job_->progress->cancelled())
+        break;
+
+      (*job_->done)[i] = 1;
+    }
+
+  BufPool::put(wbuf);
+  BufPool::put(rbuf);
+
+  return rv;
+}
+
+static
+void*
+burnin_zone_job_main(void *arg_)
+{
+  sigset_t set;
+  ZoneJob *job = (ZoneJob*)arg_;
+
+  /* leave signal handling to the coordinating thread */
+  sigfillset(&set);
+  pthread_sigmask(SIG_BLOCK,&set,NULL);
+
+  job->rv = burnin_zone_job(job);
+  __atomic_store_n(&job->finished,1,__ATOMIC_RELEASE);
+
+  return NULL;
+}
+
+static
+bool
+burnin_zone_jobs_done(const std::vector<ZoneJob*> &jobs_)
+{
+  for(size_t i = 0; i < jobs_.size(); i++)
+    if(jobs_[i]->started &&
+       !__atomic_load_n(&jobs_[i]->finished,__ATOMIC_ACQUIRE))
+      return false;
+
+  return true;
+}
+
+static
+AppError
+burnin_zoned(BlkDev                         &blkdev,
+             const Options                  &opts,
+             const std::vector<Zoned::Zone> &all_zones,
+             std::vector<uint64_t>          &badblocks,
+             std::ostream                   &os,
+             Progress                       *progress,
+             Journal                        *journal)
+{
+  int              rv;
+  bool             report;
+  uint64_t         lbs;
+  uint64_t         next;
+  uint64_t         bad;
+  uint64_t         blocks;
+  uint64_t         stepping;
+  uint64_t         max_open;
+  uint64_t         job_count;
+  uint64_t         resume;
+  uint64_t         end_block;
+  Progress         local_progress;
+  ProgressReporter reporter;
+  Smart::Snapshot  smart_before;
+  Smart::Snapshot  smart_after;
+  std::vector<char>        done;
+  std::vector<ZoneJob*>    jobs;
+  std::vector<Zoned::Zone> zones;
+
+  if(!opts.destructive)
+    return AppError::runtime(ENOTSUP,
+                             "zoned devices can only be burned in with --destructive");
+
+  lbs       = blkdev.logical_block_size();
+  stepping  = pattern_major_stepping(blkdev,opts.stepping);
+  end_block = std::min(opts.end_block,blkdev.logical_block_count());
+
+  blocks = 0;
+  for(size_t i = 0; i < all_zones.size(); i++)
+    {
+      const Zoned::Zone &zone = all_zones[i];
+
+      // a zone is reset and rewritten whole so only those entirely
+      // within the range may be touched
+      if(zone.start < opts.start_block)
+        {
+          if((zone.start + zone.length) > opts.start_block)
+            os << "Warning: skipping zone at block " << zone.start
+               << " partly before the start block" << std::endl;
+          continue;
+        }
+      if((zone.start + zone.length) > end_block)
+        {
+          if(zone.start < end_block)
+            os << "Warning: skipping zone at block " << zone.start
+               << " partly past the end block" << std::endl;
+          break;
+        }
+      if(!Zoned::usable(zone))
         {
-          signals::alarm(1);
-          current_time = Time::get_monotonic();
-          Info::print(std::cout,start_time,current_time,
-                      start_block,end_block,block,badblocks);
+          os << "Warning: skipping "
+             << (zone.cond == BLK_ZONE_COND_OFFLINE ? "offline" : "read only")
+             << " zone at block " << zone.start
+             << std::endl;
+          continue;
         }
 
-      stepping = trim_stepping(blkdev,block,stepping_);
+      zones.push_back(zone);
+      blocks += zone.capacity;
+    }
 
-      rv = burn_block(blkdev,stepping_,block,buf_,buflen_,retries,patterns);
-      block += stepping;
-      if(rv >= 0)
-        continue;
-      if(rv == -EINVAL)
-        break;
+  if(zones.empty())
+    return AppError::argument_invalid("no writable zones in range");
 
-      current_time = Time::get_monotonic();
-      Info::print(std::cout,start_time,current_time,
-                  start_block,end_block,block,badblocks);
+  max_open  = Zoned::max_open_zones(blkdev);
+  job_count = ((opts.jobs > 1) ? opts.jobs : ZONE_JOBS);
+  if(max_open != 0)
+    job_count = std::min(job_count,max_open);
+  job_count = std::min(job_count,(uint64_t)zones.size());
 
-      for(uint64_t i = 0; i < stepping; i++)
-        badblocks.push_back(block+i);
+  end_block = (zones.back().start + zones.back().length);
+  if(journal)
+    journal->set_end(end_block);
 
-      if(badblocks.size() > max_errors_)
+  os << "start block: "
+     << zones.front().start << std::endl
+     << "end block: "
+     << end_block << std::endl
+     << "logical block size: "
+     << lbs << std::endl
+     << "physical block size: "
+     << blkdev.physical_block_size() << std::endl
+     << "r/w size: "
+     << stepping << " blocks / "
+     << (stepping * lbs) << " bytes"
+     << std::endl
+     << "zones: "
+     << zones.size() << " (" << blocks << " writable blocks)"
+     << std::endl
+     << "zone jobs: "
+     << job_count
+     << " (max open zones: ";
+  if(max_open)
+    os << max_open;
+  else
+    os << "unlimited";
+  os << ")" << std::endl;
+
+  if((opts.rwtype == Options::OS) && !opts.direct)
+    os << "Warning: without --direct page cache writeback may reach"
+       << " sequential zones out of order" << std::endl;
+
+  os << "patterns: "
+     << Pattern::to_string(opts.patterns)
+     << " (" << Pattern::isa() << ")"
+     << std::endl;
+
+  if(opts.discard || opts.adaptive || (opts.queue_depth > 1) || (opts.window != 0))
+    os << "Warning: discard, adaptive stepping, queue depth and window"
+       << " are not supported with zoned burnin - ignoring"
+       << std::endl;
+
+  report = (progress == NULL);
+  if(report)
+    progress = &local_progress;
+  progress->set_range(0,(blocks * opts.patterns.size() * 2),lbs);
+  progress->set_bad(badblocks);
+
+  Smart::snapshot(blkdev,smart_before,progress);
+
+  if(report)
+    reporter.start(os,*progress);
+
+  os << "\r\x1B[2KBurning: "
+     << zones.front().start
+     << " - "
+     << end_block
+     << std::endl;
+
+  blkdev.set_fua(opts.write_cache == Options::WRITE_CACHE_FUA);
+
+  next = 0;
+  bad  = badblocks.size();
+  done.resize(zones.size(),0);
+  for(uint64_t i = 0; i < job_count; i++)
+    {
+      ZoneJob *job = new ZoneJob();
+
+      job->blkdev   = &blkdev;
+      job->opts     = &opts;
+      job->zones    = &zones;
+      job->done     = &done;
+      job->next     = &next;
+      job->bad      = &bad;
+      job->stepping = stepping;
+      job->progress = progress;
+      job->rv       = 0;
+      job->finished = 0;
+      job->started  = false;
+
+      jobs.push_back(job);
+    }
+
+  rv = 0;
+  for(size_t i = 0; i < jobs.size(); i++)
+    {
+      rv = pthread_create(&jobs[i]->thread,NULL,burnin_zone_job_main,jobs[i]);
+      if(rv != 0)
+        {
+          rv = -rv;
+          break;
+        }
+
+      jobs[i]->started = true;
+    }
+
+  while(!burnin_zone_jobs_done(jobs))
+    {
+      uint64_t count;
+
+      count = __atomic_load_n(&bad,__ATOMIC_RELAXED);
+      if((rv < 0) ||
+         (count > opts.max_errors) ||
+         signals::signaled_to_exit())
+        progress->cancel();
+
+      progress->set_bad(count);
+
+      Time::sleep(0.1);
+    }
+
+  blkdev.set_fua(false);
+
+  for(size_t i = 0; i < jobs.size(); i++)
+    {
+      if(jobs[i]->started)
+        pthread_join(jobs[i]->thread,NULL);
+      if((jobs[i]->rv < 0) && (rv == 0))
+        rv = jobs[i]->rv;
+      badblocks.insert(badblocks.end(),
+                       jobs[i]->badblocks.begin(),
+                       jobs[i]->badblocks.end());
+      delete jobs[i];
+    }
+
+  std::sort(badblocks.begin(),badblocks.end());
+  badblocks.erase(std::unique(badblocks.begin(),badblocks.end()),badblocks.end());
+  progress->set_bad(badblocks);
+
+  // resuming starts over at the first zone not burned through
+  resume = end_block;
+  for(size_t i = 0; i < zones.size(); i++)
+    if(!done[i])
+      {
+        resume = zones[i].start;
         break;
+      }
+
+  if(journal)
+    journal->checkpoint(resume,badblocks);
+
+  Smart::snapshot(blkdev,smart_after,progress);
+
+  if(report)
+    {
+      reporter.stop();
+      os << std::endl;
     }
 
-  current_time = Time::get_monotonic();
-  Info::print(std::cout,start_time,current_time,
-              start_block,end_block,block,badblocks);
+  Smart::print(os,smart_before,smart_after);
 
-  return rv;
+  if(rv < 0)
+    return AppError::runtime(-rv,"error when performing burnin");
+
+  return AppError::success();
 }
 
 static
 AppError
 burnin(BlkDev                &blkdev,
        const Options         &opts,
-       std::vector<uint64_t> &badblocks)
-{
-  int       rv;
-  int       retries;
-  char     *buf;
-  size_t    buflen;
-  uint64_t  start_block;
-  uint64_t  end_block;
-  uint64_t  stepping;
-
-  retries     = opts.retries;
-  stepping    = ((opts.stepping == 0) ?
-                 blkdev.block_stepping() :
-                 opts.stepping);
-  buflen      = (stepping * blkdev.logical_block_size());
+       std::vector<uint64_t> &badblocks,
+       std::ostream          &os,
+       Progress              *progress,
+       Journal               *journal)
+{
+  int              rv;
+  bool             report;
+  int              retries;
+  char            *buf;
+  size_t           buflen;
+  AsyncIO          aio;
+  uint64_t         start_block;
+  uint64_t         end_block;
+  uint64_t         stepping;
+  uint64_t         max_stepping;
+  Progress         local_progress;
+  ProgressReporter reporter;
+  Smart::Snapshot smart_before;
+  Smart::Snapshot smart_after;
+
+  {
+    std::vector<Zoned::Zone> zones;
+
+    rv = Zoned::report(blkdev,zones);
+    if(rv < 0)
+      os << "Warning: unable to report zones ["
+         << Error::to_string(-rv)
+         << "]"
+         << std::endl;
+    else if(rv > 0)
+      return burnin_zoned(blkdev,opts,zones,badblocks,os,progress,journal);
+  }
+
+  if((opts.window != 0) ||
+     opts.destructive ||
+     (opts.write_cache != Options::WRITE_CACHE_DEFAULT))
+    return burnin_by_pattern(blkdev,opts,badblocks,os,progress,journal);
+
+  retries      = opts.retries;
+  stepping     = ((opts.stepping == 0) ?
+                  blkdev.block_stepping() :
+                  opts.stepping);
+  max_stepping = (opts.adaptive ?
+                  AdaptiveStepping::limit(stepping,blkdev.logical_block_size()) :
+                  stepping);
+  buflen       = (max_stepping * blkdev.logical_block_size());
+
+  AdaptiveStepping adaptive(stepping,max_stepping);
+
   start_block = math::round_down(opts.start_block,stepping);
   end_block   = std::min(opts.end_block,blkdev.logical_block_count());
   end_block   = math::round_up(end_block,stepping);
   end_block   = std::min(end_block,blkdev.logical_block_count());
 
-  std::cout << "start block: "
-            << start_block << std::endl
-            << "end block: "
-            << end_block << std::endl
-            << "stepping: "
-            << stepping << std::endl
-            << "logical block size: "
-            << blkdev.logical_block_size() << std::endl
-            << "physical block size: "
-            << blkdev.physical_block_size() << std::endl
-            << "r/w size: "
-            << stepping << " blocks / "
-            << buflen << " bytes"
-            << std::endl;
-
-  signals::alarm(1);
-
-  std::cout << "\r\x1B[2KBurning: "
-            << start_block
-            << " - "
-            << end_block
-            << std::endl;
-
-  buf = new char[buflen];
-  rv = burnin_loop(blkdev,
-                   start_block,
-                   end_block,
-                   stepping,
-                   buf,
-                   buflen,
-                   badblocks,
-                   opts.max_errors,
-                   retries);
-  delete[] buf;
-
-  std::cout << std::endl;
+  if(journal)
+    journal->set_end(end_block);
+
+  os << "start block: "
+     << start_block << std::endl
+     << "end block: "
+     << end_block << std::endl
+     << "stepping: "
+     << stepping << std::endl
+     << "logical block size: "
+     << blkdev.logical_block_size() << std::endl
+     << "physical block size: "
+     << blkdev.physical_block_size() << std::endl
+     << "r/w size: "
+     << stepping << " blocks / "
+     << (stepping * blkdev.logical_block_size()) << " bytes"
+     << std::endl;
+
+  if((opts.rwtype != Options::OS) && blkdev.nvme_nsid())
+    os << "nvme namespace: "
+       << blkdev.nvme_nsid()
+       << std::endl;
+  else if((opts.rwtype != Options::OS) && blkdev.is_scsi())
+    os << "scsi commands: READ(16) / WRITE(16) / VERIFY(16)"
+       << std::endl;
+  else if((opts.rwtype == Options::ATA) && blkdev.has_identity())
+    os << "ata transfer mode: "
+       << sg::xfer_mode_to_string(blkdev.ata_xfer())
+       << std::endl;
+
+  os << "patterns: "
+     << Pattern::to_string(opts.patterns)
+     << " (" << Pattern::isa() << ")"
+     << std::endl;
+
+  if(opts.adaptive)
+    os << "adaptive stepping: "
+       << stepping << " - " << max_stepping << " blocks"
+       << std::endl;
+
+  rv = -ENOTSUP;
+  if((opts.queue_depth > 1) && !opts.adaptive)
+    {
+      rv = burnin_aio_init(aio,blkdev,opts);
+      if(rv < 0)
+        os << "Warning: unable to setup async I/O ["
+           << Error::to_string(-rv)
+           << "] - falling back to synchronous writes and reads"
+           << std::endl;
+    }
+  else if((opts.queue_depth > 1) && opts.adaptive)
+    {
+      os << "Warning: queue depth not supported with adaptive stepping"
+         << " - falling back to synchronous writes and reads"
+         << std::endl;
+    }
+
+  if(rv == 0)
+    os << "async engine: "
+       << AsyncIO::backend_to_string(aio.backend())
+       << " (queue depth: " << aio.depth() << ")"
+       << std::endl;
+
+  report = (progress == NULL);
+  if(report)
+    progress = &local_progress;
+  progress->set_range(start_block,end_block,blkdev.logical_block_size());
+  progress->set_bad(badblocks);
+
+  os << "\r\x1B[2KBurning: "
+     << start_block
+     << " - "
+     << end_block
+     << std::endl;
+
+  Smart::snapshot(blkdev,smart_before,progress);
+
+  if(report)
+    reporter.start(os,*progress);
+
+  // each stripe in the pipeline needs original, write & read buffers
+  buf = (char*)BufPool::get(buflen * ((rv == 0) ? (aio.depth() * 3) : 1));
+  if(buf == NULL)
+    return AppError::runtime(ENOMEM,"unable to allocate buffer");
+
+  if(rv == 0)
+    rv = burnin_loop_async(blkdev,
+                           aio,
+                           start_block,
+                           end_block,
+                           stepping,
+                           buf,
+                           buflen,
+                           badblocks,
+                           opts.max_errors,
+                           retries,
+                           opts.patterns,
+                           progress,
+                           journal);
+  else
+    rv = burnin_loop(blkdev,
+                     start_block,
+                     end_block,
+                     stepping,
+                     buf,
+                     buflen,
+                     badblocks,
+                     opts.max_errors,
+                     retries,
+                     opts.patterns,
+                     (opts.adaptive ? &adaptive : NULL),
+                     progress,
+                     journal);
+  BufPool::put(buf);
+
+  Smart::snapshot(blkdev,smart_after,progress);
+
+  if(report)
+    {
+      reporter.stop();
+      os << std::endl;
+    }
+
+  Smart::print(os,smart_before,smart_after);
 
   if(rv < 0)
     return AppError::runtime(-rv,"error when performing burnin");
@@ -248,37 +2128,74 @@ burnin(BlkDev                &blkdev,
 }
 
 static
-void
-set_blkdev_rwtype(BlkDev                &blkdev,
-                  const Options::RWType  rwtype)
+BadBlockFile::Format
+output_format(const std::string     &filepath,
+              const Options::Format  format)
 {
-  switch(rwtype)
+  switch(format)
     {
-    case Options::ATA:
-      blkdev.set_rw_ata();
-      break;
-    case Options::OS:
-      blkdev.set_rw_os();
+    case Options::FORMAT_TEXT:
+      return BadBlockFile::TEXT;
+    case Options::FORMAT_BINARY:
+      return BadBlockFile::BINARY;
+    case Options::FORMAT_AUTO:
       break;
     }
+
+  return BadBlockFile::output_format(filepath,BadBlockFile::NONE);
+}
+
+/*
+  Paces requests to the device per --max-rate, --max-iops and
+  --latency-target and drops to the idle I/O class with --idle.
+*/
+static
+void
+set_blkdev_throttle(BlkDev        &blkdev,
+                    Throttle      &throttle,
+                    const Options &opts,
+                    std::ostream  &os)
+{
+  if(opts.idle)
+    {
+      int rv;
+
+      rv = Throttle::set_idle_priority();
+      if(rv < 0)
+        os << "Warning: unable to set idle I/O priority ["
+           << Error::to_string(-rv)
+           << "]"
+           << std::endl;
+    }
+
+  if(throttle.enabled())
+    blkdev.set_throttle(&throttle);
 }
 
 static
 AppError
-burnin(const Options &opts)
+burnin(const Options &opts,
+       std::ostream  &os,
+       Progress      *progress)
 {
   int rv;
   AppError err;
+  Throttle throttle(opts.max_rate * 1024 * 1024,
+                    opts.max_iops,
+                    opts.latency_target / 1000.0);
   BlkDev blkdev;
   std::string captcha;
   std::string input_file;
   std::string output_file;
+  BadBlockSet known;
   std::vector<uint64_t> badblocks;
+  Options burnin_opts(opts);
+  Journal journal;
 
   input_file  = opts.input_file;
   output_file = opts.output_file;
 
-  rv = blkdev.open_rdwr(opts.device,!opts.force);
+  rv = blkdev.open_rdwr(opts.device,!opts.force,opts.direct);
   if(rv < 0)
     return AppError::opening_device(-rv,opts.device);
 
@@ -292,21 +2209,32 @@ burnin(const Options &opts)
   if(input_file.empty())
     input_file = output_file;
 
-  rv = BadBlockFile::read(input_file,badblocks);
+  rv = BadBlockFile::read(input_file,known,blkdev);
   if(rv < 0)
-    std::cout << "Warning: unable to open " << input_file << std::endl;
+    os << "Warning: unable to open " << input_file << std::endl;
   else
-    std::cout << "Imported bad blocks from " << input_file << std::endl;
+    os << "Imported bad blocks from " << input_file << std::endl;
 
-  set_blkdev_rwtype(blkdev,opts.rwtype);
+  BlkDevSetup::rwtype(blkdev,opts.rwtype);
+  BlkDevSetup::recovery(blkdev,opts,os);
+  set_blkdev_throttle(blkdev,throttle,opts,os);
 
-  err = burnin(blkdev,opts,badblocks);
+  journal.begin(output_file,opts.resume,badblocks,burnin_opts.start_block,os);
 
-  rv = BadBlockFile::write(output_file,badblocks);
+  err = burnin(blkdev,burnin_opts,badblocks,os,progress,&journal);
+
+  known.insert(badblocks);
+  rv = BadBlockFile::write(output_file,
+                           known,
+                           blkdev,
+                           output_format(output_file,opts.format));
   if((rv < 0) && err.succeeded())
     err = AppError::writing_badblocks_file(-rv,output_file);
-  else if(!badblocks.empty())
-    std::cout << "Bad blocks written to " << output_file << std::endl;
+  else if(!known.empty())
+    os << "Bad blocks written to " << output_file << std::endl;
+
+  if((rv == 0) && journal.complete())
+    journal.remove();
 
   rv = blkdev.close();
   if((rv < 0) && err.succeeded())
@@ -315,11 +2243,31 @@ burnin(const Options &opts)
   return err;
 }
 
+static
+AppError
+burnin_worker(const Options &opts,
+              std::ostream  &os,
+              Progress      &progress)
+{
+  return ::burnin(opts,os,&progress);
+}
+
 namespace bbf
 {
   AppError
   burnin(const Options &opts)
   {
-    return ::burnin(opts);
+    if(opts.devices.size() > 1)
+      return MultiDevice::run(opts,burnin_worker);
+
+    return ::burnin(opts,std::cout,NULL);
+  }
+
+  AppError
+  burnin(const Options &opts,
+         std::ostream  &os,
+         Progress      &progress)
+  {
+    return ::burnin(opts,os,&progress);
   }
 }
@@ -0,0 +1,866 @@
+/*
+  ISC License
+
+  Copyright (c) 2016, Antonio SJ Musumeci <trapexit@spawn.link>
+
+  Permission to use, copy, modify, and/or distribute this software for any
+  purpose with or without fee is hereby granted, provided that the above
+  copyright notice and this permission notice appear in all copies.
+
+  THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+  WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+  MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+  ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+  WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+  ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+  OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+*/
+
+#include "bbf_daemon.hpp"
+
+#include "bbf_burnin.hpp"
+#include "bbf_find_files.hpp"
+#include "bbf_fix.hpp"
+#include "bbf_scan.hpp"
+
+#include "blkdev.hpp"
+#include "captcha.hpp"
+#include "errors.hpp"
+#include "options.hpp"
+#include "progress.hpp"
+#include "signals.hpp"
+#include "time.hpp"
+#include "topology.hpp"
+
+#include <errno.h>
+#include <getopt.h>
+#include <poll.h>
+#include <pthread.h>
+#include <signal.h>
+#include <stdint.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/types.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+#include <deque>
+#include <iomanip>
+#include <iostream>
+#include <map>
+#include <sstream>
+#include <string>
+#include <vector>
+
+/*
+  bbf daemon <socket>: a long running process accepting jobs over a
+  Unix stream socket, one command per line:
+
+    submit <instruction> [options] <path>
+                      queue scan, burnin, fix or find-files as the
+                      command line would run it
+    status [<id>]     one JSON object per job
+    devices           one JSON object per device session
+    output <id>       the report of a finished job
+    cancel <id>       stop a running job or drop a queued one
+    forget <id>       drop a finished job
+    shutdown          cancel everything and exit
+
+  Each reply ends with a line "ok [...]" or "error <message>".
+
+  A device session is kept per path from its first job on: the device
+  stays open, identified and with its captcha known, so destructive
+  jobs with the wrong captcha are refused when submitted. A device
+  runs one job at a time; the rest queue behind it. --jobs limits how
+  many run at once across all devices. --max-rate and --max-iops
+  given to the daemon cap every job's own, and --idle applies to all.
+*/
+
+namespace l
+{
+  enum State
+    {
+      QUEUED,
+      RUNNING,
+      FINISHED,
+      CANCELLED
+    };
+
+  struct Job
+  {
+    uint64_t           id;
+    Options            opts;
+    std::string        args;
+    State              state;
+    Progress           progress;
+    std::ostringstream os;
+    AppError           err;
+    double             started;
+    double             finished;
+    pthread_t          thread;
+  };
+
+  struct Session
+  {
+    std::string        device;
+    BlkDev             blkdev;
+    bool               opened;
+    std::string        captcha;
+    Job               *active;
+    std::deque<Job*>   queue;
+    uint64_t           jobs;
+  };
+
+  struct Client
+  {
+    int         fd;
+    std::string buf;
+  };
+
+  struct Daemon
+  {
+    const Options                   *opts;
+    int                              fd;
+    uint64_t                         next_id;
+    uint64_t                         running;
+    bool                             shutdown;
+    std::map<uint64_t,Job*>          jobs;
+    std::map<std::string,Session*>   sessions;
+    std::vector<Client>              clients;
+  };
+
+  static const size_t MAX_LINE     = 4096;
+  static const size_t MAX_FINISHED = 256;
+
+  static
+  const char*
+  state_to_string(const State state_)
+  {
+    switch(state_)
+      {
+      case QUEUED:
+        return "queued";
+      case RUNNING:
+        return "running";
+      case FINISHED:
+        return "finished";
+      case CANCELLED:
+        return "cancelled";
+      }
+
+    return "unknown";
+  }
+
+  static
+  const char*
+  instruction_to_string(const Options::Instruction instruction_)
+  {
+    switch(instruction_)
+      {
+      case Options::SCAN:
+        return "scan";
+      case Options::BURNIN:
+        return "burnin";
+      case Options::FIX:
+        return "fix";
+      case Options::FIND_FILES:
+        return "find-files";
+      default:
+        break;
+      }
+
+    return "unknown";
+  }
+
+  /* as Metrics does: anything which would need escaping is replaced */
+  static
+  std::string
+  quote(const std::string &str_)
+  {
+    std::string rv;
+
+    rv += '"';
+    for(size_t i = 0; i < str_.size(); i++)
+      {
+        const char c = str_[i];
+
+        if((c == '"') || (c == '\\') || ((unsigned char)c < 0x20))
+          rv += '_';
+        else
+          rv += c;
+      }
+    rv += '"';
+
+    return rv;
+  }
+
+  static
+  std::vector<std::string>
+  split(const std::string &str_)
+  {
+    std::string token;
+    std::istringstream is(str_);
+    std::vector<std::string> rv;
+
+    while(is >> token)
+      rv.push_back(token);
+
+    return rv;
+  }
+
+  static
+  uint64_t
+  min_budget(const uint64_t job_,
+             const uint64_t daemon_)
+  {
+    if(daemon_ == 0)
+      return job_;
+    if(job_ == 0)
+      return daemon_;
+
+    return std::min(job_,daemon_);
+  }
+
+  static
+  void
+  reply(const int          fd_,
+        const std::string &str_)
+  {
+    ssize_t rv;
+    size_t  done;
+
+    done = 0;
+    while(done < str_.size())
+      {
+        rv = ::send(fd_,&str_[done],(str_.size() - done),MSG_NOSIGNAL);
+        if((rv == -1) && (errno == EINTR))
+          continue;
+        if(rv <= 0)
+          return;
+        done += rv;
+      }
+  }
+
+  /*
+    Parses the words after "submit" as bbf's own command line. getopt
+    keeps its position in globals so is reset for every job; only the
+    control thread parses.
+  */
+  static
+  AppError
+  parse_job(const std::vector<std::string> &words_,
+            Options                        &opts_)
+  {
+    AppError err;
+    std::vector<char*> argv;
+
+    argv.push_back((char*)"bbf");
+    for(size_t i = 1; i < words_.size(); i++)
+      argv.push_back((char*)words_[i].c_str());
+    argv.push_back(NULL);
+
+    optind = 0;
+    err = opts_.parse((argv.size() - 1),&argv[0]);
+    if(!err.succeeded())
+      return err;
+
+    switch(opts_.instruction)
+      {
+      case Options::SCAN:
+      case Options::BURNIN:
+      case Options::FIX:
+      case Options::FIND_FILES:
+        break;
+      default:
+        return AppError::argument_invalid("only scan, burnin, fix and"
+                                          " find-files can be submitted");
+      }
+
+    if(opts_.devices.size() > 1)
+      return AppError::argument_invalid("one path per job");
+    if(opts_.stream)
+      return AppError::argument_invalid("stream not supported by the daemon");
+
+    return AppError::success();
+  }
+
+  static
+  Session*
+  session(Daemon            &daemon_,
+          const std::string &device_)
+  {
+    int rv;
+    Session *s;
+    std::map<std::string,Session*>::iterator i;
+
+    i = daemon_.sessions.find(device_);
+    if(i != daemon_.sessions.end())
+      return i->second;
+
+    s = new Session();
+    s->device = device_;
+    s->active = NULL;
+    s->jobs   = 0;
+
+    // find-files and scan of files act on paths which aren't devices
+    rv = s->blkdev.open_read(device_);
+    s->opened = (rv >= 0);
+    if(s->opened)
+      {
+        s->captcha = captcha::calculate(s->blkdev);
+        s->blkdev.has_identity();
+      }
+
+    daemon_.sessions[device_] = s;
+
+    return s;
+  }
+
+  static
+  void*
+  job_main(void *arg_)
+  {
+    int node;
+    sigset_t set;
+    Job *job = (Job*)arg_;
+
+    /* leave signal handling to the control thread */
+    sigfillset(&set);
+    pthread_sigmask(SIG_BLOCK,&set,NULL);
+
+    node = ((Topology::nodes() > 1) ?
+            Topology::device_node(job->opts.device) :
+            -1);
+    if(node >= 0)
+      Topology::bind(node);
+
+    switch(job->opts.instruction)
+      {
+      case Options::SCAN:
+        job->err = bbf::scan(job->opts,job->os,job->progress);
+        break;
+      case Options::BURNIN:
+        job->err = bbf::burnin(job->opts,job->os,job->progress);
+        break;
+      case Options::FIX:
+        job->err = bbf::fix(job->opts,job->os,job->progress);
+        break;
+      case Options::FIND_FILES:
+        job->err = bbf::find_files(job->opts,job->os,job->progress);
+        break;
+      default:
+        break;
+      }
+
+    job->progress.finish();
+
+    return NULL;
+  }
+
+  static
+  void
+  write_job(std::ostream &os_,
+            const Job    &job_)
+  {
+    double elapsed;
+    const Progress &p = job_.progress;
+
+    elapsed = 0;
+    if(job_.state == RUNNING)
+      elapsed = (Time::get_monotonic() - job_.started);
+    else if(job_.state != QUEUED)
+      elapsed = (job_.finished - job_.started);
+
+    os_ << std::fixed << std::setprecision(2)
+        << "{\"id\":" << job_.id
+        << ",\"state\":\"" << state_to_string(job_.state) << '"'
+        << ",\"instruction\":\"" << instruction_to_string(job_.opts.instruction) << '"'
+        << ",\"device\":" << quote(job_.opts.device)
+        << ",\"args\":" << quote(job_.args)
+        << ",\"elapsed\":" << elapsed
+        << ",\"start_block\":" << p.start_block()
+        << ",\"end_block\":" << p.end_block()
+        << ",\"current_block\":" << p.current_block()
+        << ",\"bad_blocks\":" << p.bad_blocks()
+        << ",\"bytes\":" << p.bytes()
+        << ",\"requests\":" << p.requests()
+        << ",\"retries\":" << p.retries()
+        << ",\"mb_per_second\":"
+        << ((elapsed > 0) ? ((p.bytes() / elapsed) / (1024.0 * 1024.0)) : 0.0);
+    if(p.reallocated() != UINT64_MAX)
+      os_ << ",\"reallocated_sectors\":" << p.reallocated();
+    if(p.pending() != UINT64_MAX)
+      os_ << ",\"pending_sectors\":" << p.pending();
+    os_ << ",\"latency_usec\":{\"p50\":" << p.latency_percentile(0.5)
+        << ",\"p99\":" << p.latency_percentile(0.99)
+        << ",\"max\":" << p.latency_percentile(1.0)
+        << "}";
+    if((job_.state == FINISHED) || (job_.state == CANCELLED))
+      os_ << ",\"result\":" << quote(job_.err.succeeded() ?
+                                     "success" :
+                                     job_.err.to_string());
+    os_ << "}\n";
+  }
+
+  static
+  void
+  write_session(std::ostream  &os_,
+                const Session &s_)
+  {
+    os_ << "{\"device\":" << quote(s_.device)
+        << ",\"open\":" << (s_.opened ? "true" : "false");
+    if(s_.opened)
+      os_ << ",\"captcha\":" << quote(s_.captcha)
+          << ",\"size_in_bytes\":" << s_.blkdev.size_in_bytes()
+          << ",\"logical_block_size\":" << s_.blkdev.logical_block_size();
+    os_ << ",\"active\":";
+    if(s_.active)
+      os_ << s_.active->id;
+    else
+      os_ << "null";
+    os_ << ",\"queued\":" << s_.queue.size()
+        << ",\"jobs\":" << s_.jobs
+        << "}\n";
+  }
+
+  static
+  std::string
+  submit(Daemon                         &daemon_,
+         const std::vector<std::string> &words_,
+         const std::string              &line_)
+  {
+    Job *job;
+    AppError err;
+    Session *s;
+    std::ostringstream os;
+    const Options &dopts = *daemon_.opts;
+
+    job = new Job();
+    err = parse_job(words_,job->opts);
+    if(!err.succeeded())
+      {
+        delete job;
+        return ("error " + err.to_string() + "\n");
+      }
+
+    job->opts.max_rate = min_budget(job->opts.max_rate,dopts.max_rate);
+    job->opts.max_iops = min_budget(job->opts.max_iops,dopts.max_iops);
+    job->opts.idle     = (job->opts.idle || dopts.idle);
+
+    s = session(daemon_,job->opts.device);
+    if(s->opened &&
+       ((job->opts.instruction == Options::BURNIN) ||
+        (job->opts.instruction == Options::FIX)) &&
+       (job->opts.captcha != s->captcha))
+      {
+        err = AppError::captcha(job->opts.captcha,s->captcha);
+        delete job;
+        return ("error " + err.to_string() + "\n");
+      }
+
+    job->id       = daemon_.next_id++;
+    job->args     = line_.substr(line_.find_first_not_of(" \t",line_.find("submit") + 6));
+    job->state    = QUEUED;
+    job->started  = 0;
+    job->finished = 0;
+
+    daemon_.jobs[job->id] = job;
+    s->queue.push_back(job);
+    s->jobs++;
+
+    os << "ok " << job->id << "\n";
+
+    return os.str();
+  }
+
+  static
+  Job*
+  find_job(Daemon                         &daemon_,
+           const std::vector<std::string> &words_)
+  {
+    uint64_t id;
+    std::map<uint64_t,Job*>::iterator i;
+
+    if(words_.size() != 2)
+      return NULL;
+
+    id = ::strtoull(words_[1].c_str(),NULL,10);
+    i  = daemon_.jobs.find(id);
+
+    return ((i == daemon_.jobs.end()) ? NULL : i->second);
+  }
+
+  static
+  void
+  unqueue(Daemon &daemon_,
+          Job    *job_)
+  {
+    Session *s;
+
+    s = daemon_.sessions[job_->opts.device];
+    for(std::deque<Job*>::iterator
+          i = s->queue.begin(), ei = s->queue.end(); i != ei; ++i)
+      if(*i == job_)
+        {
+          s->queue.erase(i);
+          break;
+        }
+  }
+
+  static
+  std::string
+  command(Daemon            &daemon_,
+          const std::string &line_)
+  {
+    Job *job;
+    std::ostringstream os;
+    std::vector<std::string> words;
+
+    words = split(line_);
+    if(words.empty())
+      return std::string();
+
+    if(words[0] == "submit")
+      return submit(daemon_,words,line_);
+
+    if(words[0] == "status")
+      {
+        if(words.size() == 1)
+          {
+            for(std::map<uint64_t,Job*>::const_iterator
+                  i = daemon_.jobs.begin(), ei = daemon_.jobs.end(); i != ei; ++i)
+              write_job(os,*i->second);
+            os << "ok\n";
+            return os.str();
+          }
+
+        job = find_job(daemon_,words);
+        if(job == NULL)
+          return "error no such job\n";
+        write_job(os,*job);
+        os << "ok\n";
+        return os.str();
+      }
+
+    if(words[0] == "devices")
+      {
+        for(std::map<std::string,Session*>::const_iterator
+              i = daemon_.sessions.begin(), ei = daemon_.sessions.end(); i != ei; ++i)
+          write_session(os,*i->second);
+        os << "ok\n";
+        return os.str();
+      }
+
+    if(words[0] == "output")
+      {
+        job = find_job(daemon_,words);
+        if(job == NULL)
+          return "error no such job\n";
+        if((job->state == QUEUED) || (job->state == RUNNING))
+          return "error job not finished\n";
+        os << job->os.str() << "ok\n";
+        return os.str();
+      }
+
+    if(words[0] == "cancel")
+      {
+        job = find_job(daemon_,words);
+        if(job == NULL)
+          return "error no such job\n";
+        if(job->state == RUNNING)
+          job->progress.cancel();
+        else if(job->state == QUEUED)
+          {
+            unqueue(daemon_,job);
+            job->state = CANCELLED;
+            job->err   = AppError::runtime(ECANCELED,"cancelled before starting");
+          }
+        return "ok\n";
+      }
+
+    if(words[0] == "forget")
+      {
+        job = find_job(daemon_,words);
+        if(job == NULL)
+          return "error no such job\n";
+        if((job->state == QUEUED) || (job->state == RUNNING))
+          return "error job not finished\n";
+        daemon_.jobs.erase(job->id);
+        delete job;
+        return "ok\n";
+      }
+
+    if(words[0] == "shutdown")
+      {
+        daemon_.shutdown = true;
+        return "ok\n";
+      }
+
+    return ("error unknown command " + words[0] + "\n");
+  }
+
+  /*
+    Reaps finished jobs, starts the next job of each idle device while
+    under --jobs and drops the oldest finished jobs past MAX_FINISHED.
+  */
+  static
+  void
+  schedule(Daemon &daemon_)
+  {
+    int rv;
+    uint64_t finished;
+    const uint64_t limit = ((daemon_.opts->jobs != 0) ? daemon_.opts->jobs : ~0ULL);
+
+    for(std::map<std::string,Session*>::iterator
+          i = daemon_.sessions.begin(), ei = daemon_.sessions.end(); i != ei; ++i)
+      {
+        Session *s = i->second;
+
+        if(s->active && s->active->progress.done())
+          {
+            pthread_join(s->active->thread,NULL);
+            s->active->finished = Time::get_monotonic();
+            s->active->state    = (s->active->progress.cancelled() ?
+                                   CANCELLED :
+                                   FINISHED);
+            s->active = NULL;
+            daemon_.running--;
+          }
+      }
+
+    for(std::map<std::string,Session*>::iterator
+          i = daemon_.sessions.begin(), ei = daemon_.sessions.end(); i != ei; ++i)
+      {
+        Job *job;
+        Session *s = i->second;
+
+        if(daemon_.shutdown || (daemon_.running >= limit))
+          break;
+        if(s->active || s->queue.empty())
+          continue;
+
+        job = s->queue.front();
+        s->queue.pop_front();
+
+        job->started = Time::get_monotonic();
+        rv = pthread_create(&job->thread,NULL,job_main,job);
+        if(rv != 0)
+          {
+            job->state    = FINISHED;
+            job->finished = job->started;
+            job->err      = AppError::runtime(rv,"unable to create job thread");
+            continue;
+          }
+
+        job->state = RUNNING;
+        s->active  = job;
+        daemon_.running++;
+      }
+
+    finished = 0;
+    for(std::map<uint64_t,Job*>::const_iterator
+          i = daemon_.jobs.begin(), ei = daemon_.jobs.end(); i != ei; ++i)
+      if((i->second->state == FINISHED) || (i->second->state == CANCELLED))
+        finished++;
+
+    for(std::map<uint64_t,Job*>::iterator
+          i = daemon_.jobs.begin(); (finished > MAX_FINISHED) && (i != daemon_.jobs.end());)
+      {
+        if((i->second->state != FINISHED) && (i->second->state != CANCELLED))
+          {
+            ++i;
+            continue;
+          }
+
+        delete i->second;
+        daemon_.jobs.erase(i++);
+        finished--;
+      }
+  }
+
+  static
+  int
+  listen_on(const std::string &path_)
+  {
+    int fd;
+    int rv;
+    struct sockaddr_un addr;
+
+    if(path_.size() >= sizeof(addr.sun_path))
+      return -ENAMETOOLONG;
+
+    ::memset(&addr,0,sizeof(addr));
+    addr.sun_family = AF_UNIX;
+    ::strcpy(addr.sun_path,path_.c_str());
+
+    fd = ::socket(AF_UNIX,SOCK_STREAM|SOCK_CLOEXEC,0);
+    if(fd == -1)
+      return -errno;
+
+    // a socket left by a daemon which is no longer running
+    rv = ::connect(fd,(struct sockaddr*)&addr,sizeof(addr));
+    if(rv == 0)
+      {
+        ::close(fd);
+        return -EADDRINUSE;
+      }
+    ::unlink(path_.c_str());
+
+    rv = ::bind(fd,(struct sockaddr*)&addr,sizeof(addr));
+    if(rv == 0)
+      rv = ::chmod(path_.c_str(),0600);
+    if(rv == 0)
+      rv = ::listen(fd,16);
+    if(rv == -1)
+      {
+        rv = -errno;
+        ::close(fd);
+        return rv;
+      }
+
+    return fd;
+  }
+
+  /* false once the client hung up */
+  static
+  struct pollfd
+  poll_in(const int fd_)
+  {
+    struct pollfd pfd;
+
+    pfd.fd      = fd_;
+    pfd.events  = POLLIN;
+    pfd.revents = 0;
+
+    return pfd;
+  }
+
+  static
+  bool
+  serve(Daemon &daemon_,
+        Client &client_)
+  {
+    ssize_t rv;
+    size_t  pos;
+    char    buf[1024];
+
+    rv = ::read(client_.fd,buf,sizeof(buf));
+    if((rv == -1) && (errno == EINTR))
+      return true;
+    if(rv <= 0)
+      return false;
+
+    client_.buf.append(buf,rv);
+    while((pos = client_.buf.find('\n')) != std::string::npos)
+      {
+        std::string line;
+
+        line = client_.buf.substr(0,pos);
+        client_.buf.erase(0,pos + 1);
+        reply(client_.fd,command(daemon_,line));
+      }
+
+    if(client_.buf.size() > MAX_LINE)
+      {
+        reply(client_.fd,"error line too long\n");
+        return false;
+      }
+
+    return true;
+  }
+
+  static
+  void
+  stop(Daemon &daemon_)
+  {
+    daemon_.shutdown = true;
+    for(std::map<std::string,Session*>::iterator
+          i = daemon_.sessions.begin(), ei = daemon_.sessions.end(); i != ei; ++i)
+      if(i->second->active)
+        i->second->active->progress.cancel();
+
+    while(daemon_.running)
+      {
+        schedule(daemon_);
+        Time::sleep(0.1);
+      }
+
+    for(size_t i = 0; i < daemon_.clients.size(); i++)
+      ::close(daemon_.clients[i].fd);
+    for(std::map<uint64_t,Job*>::iterator
+          i = daemon_.jobs.begin(), ei = daemon_.jobs.end(); i != ei; ++i)
+      delete i->second;
+    for(std::map<std::string,Session*>::iterator
+          i = daemon_.sessions.begin(), ei = daemon_.sessions.end(); i != ei; ++i)
+      {
+        if(i->second->opened)
+          i->second->blkdev.close();
+        delete i->second;
+      }
+  }
+}
+
+namespace bbf
+{
+  AppError
+  daemon(const Options &opts_)
+  {
+    l::Daemon daemon;
+    std::vector<struct pollfd> fds;
+
+    daemon.opts     = &opts_;
+    daemon.next_id  = 1;
+    daemon.running  = 0;
+    daemon.shutdown = false;
+
+    daemon.fd = l::listen_on(opts_.device);
+    if(daemon.fd < 0)
+      return AppError::opening_file(-daemon.fd,opts_.device);
+
+    std::cout << "Listening on " << opts_.device << std::endl;
+
+    while(!daemon.shutdown && !signals::signaled_to_exit())
+      {
+        int rv;
+
+        fds.clear();
+        fds.push_back(l::poll_in(daemon.fd));
+        for(size_t i = 0; i < daemon.clients.size(); i++)
+          fds.push_back(l::poll_in(daemon.clients[i].fd));
+
+        rv = ::poll(&fds[0],fds.size(),100);
+        if((rv == -1) && (errno != EINTR))
+          break;
+
+        for(size_t i = daemon.clients.size(); (rv > 0) && (i != 0); i--)
+          {
+            if(fds[i].revents == 0)
+              continue;
+            if(l::serve(daemon,daemon.clients[i - 1]))
+              continue;
+
+            ::close(daemon.clients[i - 1].fd);
+            daemon.clients.erase(daemon.clients.begin() + (i - 1));
+          }
+
+        if((rv > 0) && (fds[0].revents & POLLIN))
+          {
+            l::Client client;
+
+            client.fd = ::accept4(daemon.fd,NULL,NULL,SOCK_CLOEXEC);
+            if(client.fd != -1)
+              daemon.clients.push_back(client);
+          }
+
+        l::schedule(daemon);
+      }
+
+    l::stop(daemon);
+
+    ::close(daemon.fd);
+    ::unlink(opts_.device.c_str());
+
+    return AppError::success();
+  }
+}
@@ -0,0 +1,196 @@
+/*
+  ISC License
+
+  Copyright (c) 2016, Antonio SJ Musumeci <trapexit@spawn.link>
+
+  Permission to use, copy, modify, and/or distribute this software for any
+  purpose with or without fee is hereby granted, provided that the above
+  copyright notice and this permission notice appear in all copies.
+
+  THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+  WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+  MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+  ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+  WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+  ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+  OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+*/
+
+#include <errno.h>
+#include <stdint.h>
+
+#include <algorithm>
+#include <iostream>
+#include <vector>
+
+#include "badblockfile.hpp"
+#include "badblockset.hpp"
+#include "blkdev.hpp"
+#include "blkdevsetup.hpp"
+#include "captcha.hpp"
+#include "discard.hpp"
+#include "errors.hpp"
+#include "math.hpp"
+#include "options.hpp"
+#include "progress.hpp"
+#include "progressreporter.hpp"
+#include "time.hpp"
+
+/*
+  Discard (TRIM) the range then read it back expecting zeros. Much
+  faster than a destructive burnin on an SSD as the drive returns
+  unmapped blocks without touching flash, while still surfacing
+  blocks the drive can't read. Blocks found bad are merged into the
+  bad block list like scan.
+*/
+
+static
+BadBlockFile::Format
+output_format(const std::string     &filepath,
+              const Options::Format  format)
+{
+  switch(format)
+    {
+    case Options::FORMAT_TEXT:
+      return BadBlockFile::TEXT;
+    case Options::FORMAT_BINARY:
+      return BadBlockFile::BINARY;
+    case Options::FORMAT_AUTO:
+      break;
+    }
+
+  return BadBlockFile::output_format(filepath,BadBlockFile::NONE);
+}
+
+static
+AppError
+discard(const Options &opts)
+{
+  int rv;
+  bool strict;
+  int64_t skipped;
+  double start;
+  BlkDev blkdev;
+  uint64_t nonzero;
+  uint64_t stepping;
+  uint64_t start_block;
+  uint64_t end_block;
+  Progress progress;
+  ProgressReporter reporter;
+  std::string captcha;
+  std::string input_file;
+  std::string output_file;
+  BadBlockSet known;
+  std::vector<uint64_t> badblocks;
+
+  rv = blkdev.open_rdwr(opts.device,!opts.force,opts.direct);
+  if(rv < 0)
+    return AppError::opening_device(-rv,opts.device);
+
+  captcha = captcha::calculate(blkdev);
+  if(opts.captcha != captcha)
+    return AppError::captcha(opts.captcha,captcha);
+
+  BlkDevSetup::rwtype(blkdev,opts.rwtype);
+
+  output_file = opts.output_file;
+  if(output_file.empty())
+    output_file = BadBlockFile::filepath(blkdev);
+  input_file = opts.input_file;
+  if(input_file.empty())
+    input_file = output_file;
+
+  rv = BadBlockFile::read(input_file,known,blkdev);
+  if(rv < 0)
+    std::cout << "Warning: unable to open " << input_file << std::endl;
+  else
+    std::cout << "Imported bad blocks from " << input_file << std::endl;
+
+  stepping    = ((opts.stepping == 0) ? blkdev.block_stepping() : opts.stepping);
+  start_block = math::round_down(opts.start_block,stepping);
+  end_block   = std::min(opts.end_block,blkdev.logical_block_count());
+
+  std::cout << "start block: " << start_block << std::endl
+            << "end block: " << end_block << std::endl
+            << "stepping: " << stepping << std::endl
+            << "zeros after discard: "
+            << (blkdev.discard_zeroes() ? "guaranteed" : "not guaranteed")
+            << std::endl;
+
+  start = Time::get_monotonic();
+  progress.set_range(start_block,end_block,blkdev.logical_block_size());
+  std::cout << "\r\x1B[2KDiscarding: "
+            << start_block
+            << " - "
+            << end_block
+            << std::endl;
+  reporter.start(std::cout,progress);
+  skipped = Discard::range(blkdev,start_block,end_block,&progress);
+  reporter.stop();
+  std::cout << std::endl;
+  if(skipped < 0)
+    return AppError::runtime(-skipped,"error when discarding");
+
+  std::cout << "Discarded in " << (Time::get_monotonic() - start) << "s" << std::endl;
+  if(skipped > 0)
+    std::cout << "Warning: device refused to discard "
+              << skipped << " blocks" << std::endl;
+
+  start = Time::get_monotonic();
+  progress.set_range(start_block,end_block,blkdev.logical_block_size());
+  std::cout << "\r\x1B[2KVerifying: "
+            << start_block
+            << " - "
+            << end_block
+            << std::endl;
+  reporter.start(std::cout,progress);
+  rv = Discard::verify_zero(blkdev,
+                            start_block,
+                            end_block,
+                            stepping,
+                            badblocks,
+                            nonzero,
+                            &progress);
+  reporter.stop();
+  std::cout << std::endl;
+
+  strict = blkdev.discard_zeroes();
+  std::cout << "Verified in " << (Time::get_monotonic() - start) << "s" << std::endl
+            << "unreadable blocks: "
+            << (badblocks.size() - (strict ? nonzero : 0)) << std::endl
+            << "non-zero blocks: " << nonzero
+            << (strict ? " (counted as bad)" : "") << std::endl;
+
+  known.insert(badblocks);
+  if(!known.empty())
+    {
+      int err;
+
+      err = BadBlockFile::write(output_file,
+                                known,
+                                blkdev,
+                                output_format(output_file,opts.format));
+      if(err < 0)
+        return AppError::writing_badblocks_file(-err,output_file);
+
+      std::cout << "Bad blocks written to " << output_file << std::endl;
+    }
+
+  if(rv < 0)
+    return AppError::runtime(-rv,"error when verifying");
+
+  rv = blkdev.close();
+  if(rv < 0)
+    return AppError::closing_device(-rv,opts.device);
+
+  return AppError::success();
+}
+
+namespace bbf
+{
+  AppError
+  discard(const Options &opts)
+  {
+    return ::discard(opts);
+  }
+}
@@ -17,33 +17,113 @@
 */
 
 #include <iostream>
-#include <utility>
+#include <string>
+#include <vector>
+
+#include <errno.h>
+#include <pthread.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <unistd.h>
 
 #include "blocktofilemapper.hpp"
 #include "errors.hpp"
 #include "options.hpp"
+#include "progress.hpp"
+#include "progressreporter.hpp"
 
-std::ostream &
-operator<<(std::ostream                                      &os,
-           const BlockToFileMapper::BlockMap::const_iterator &i)
+namespace l
 {
-  os << i->first << " - "
-     << (i->first + i->second.first - 1)
-     << " "
-     << i->second.second;
-}
+  static const size_t WRITER_BUFSIZE = (1024 * 1024);
 
-std::ostream &
-operator<<(std::ostream                      &os,
-           const BlockToFileMapper::BlockMap &bm)
-{
-  for(BlockToFileMapper::BlockMap::const_iterator
-        i = bm.begin(), ei = bm.end();
-      i != ei;
-      ++i)
+  /*
+    Lines are collected into a large buffer and written out with
+    write(2) when it fills, so throughput is bound by the output
+    rather than per line stream overhead. Shared by the walker threads
+    when streaming.
+  */
+  class Writer
+  {
+  public:
+    Writer(const int fd_)
+      : _fd(fd_),
+        _error(0)
     {
-      os << i << std::endl;
+      pthread_mutex_init(&_lock,NULL);
+      _buf.reserve(WRITER_BUFSIZE + 4096);
     }
+
+    ~Writer()
+    {
+      pthread_mutex_destroy(&_lock);
+    }
+
+  public:
+    void lock(void)   { pthread_mutex_lock(&_lock); }
+    void unlock(void) { pthread_mutex_unlock(&_lock); }
+
+    void
+    line(const uint64_t     start_,
+         const uint64_t     length_,
+         const std::string &path_)
+    {
+      char tmp[64];
+
+      ::snprintf(tmp,sizeof(tmp),"%llu - %llu ",
+                 (unsigned long long)start_,
+                 (unsigned long long)(start_ + length_ - 1));
+      _buf += tmp;
+      _buf += path_;
+      _buf += '\n';
+
+      if(_buf.size() >= WRITER_BUFSIZE)
+        flush();
+    }
+
+    int
+    flush(void)
+    {
+      size_t off;
+
+      off = 0;
+      while((off < _buf.size()) && (_error == 0))
+        {
+          ssize_t rv;
+
+          rv = ::write(_fd,&_buf[off],_buf.size() - off);
+          if((rv == -1) && (errno == EINTR))
+            continue;
+          if(rv == -1)
+            _error = -errno;
+          else
+            off += rv;
+        }
+
+      _buf.clear();
+
+      return _error;
+    }
+
+  private:
+    int             _fd;
+    int             _error;
+    std::string     _buf;
+    pthread_mutex_t _lock;
+  };
+
+  static
+  void
+  write_dir(const std::vector<std::string>               &paths_,
+            const std::vector<BlockToFileMapper::Extent> &extents_,
+            void                                         *data_)
+  {
+    Writer *w = (Writer*)data_;
+
+    w->lock();
+    for(uint64_t i = 0, ei = extents_.size(); i != ei; i++)
+      w->line(extents_[i].start,extents_[i].length,paths_[extents_[i].file]);
+    w->unlock();
+  }
 }
 
 namespace bbf
@@ -52,13 +132,36 @@ namespace bbf
   dump_files(const Options &opts)
   {
     int rv;
+    bool report;
+    Progress progress;
     BlockToFileMapper b2fm;
+    ProgressReporter reporter;
+    l::Writer writer(STDOUT_FILENO);
+
+    // stdout is the listing so the count of files walked goes to a
+    // terminal on stderr or nowhere
+    report = ::isatty(STDERR_FILENO);
+    if(report)
+      reporter.start(std::cerr,progress,"Files");
+
+    if(opts.unsorted)
+      rv = b2fm.stream(opts.device,opts.jobs,l::write_dir,&writer,&progress);
+    else
+      rv = b2fm.scan(opts.device,opts.jobs,opts.cache_file,&progress);
+
+    if(report)
+      {
+        reporter.stop();
+        std::cerr << std::endl;
+      }
 
-    rv = b2fm.scan(opts.device);
     if(rv < 0)
       return AppError::opening_device(-rv,opts.device);
 
-    std::cout << b2fm.blockmap();
+    for(uint64_t i = 0, ei = b2fm.size(); i != ei; i++)
+      writer.line(b2fm.start(i),b2fm.length(i),b2fm.path(i));
+
+    writer.flush();
 
     return AppError::success();
   }
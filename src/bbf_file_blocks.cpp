@@ -18,6 +18,7 @@
 
 #include <stdint.h>
 
+#include <algorithm>
 #include <iostream>
 #include <utility>
 
@@ -31,23 +32,29 @@ namespace bbf
   file_blocks(const Options &opts)
   {
     int rv;
+    int64_t offset;
     File::BlockVector blockvector;
 
     rv = File::blocks(opts.device,blockvector);
     if(rv < 0)
       return AppError::opening_file(-rv,opts.device);
 
+    // report whole disk LBAs like `scan` of the disk does
+    offset = std::max(File::lba_offset(opts.device),(int64_t)0);
+
     for(uint64_t i = 0, ei = blockvector.size(); i != ei; i++)
       {
-        uint64_t        j = blockvector[i].block;
+        uint64_t        j = blockvector[i].block + offset;
         const uint64_t ej = blockvector[i].length + j;
 
         for(; j != ej; j++)
           {
-            std::cout << j << std::endl;
+            std::cout << j << '\n';
           }
       }
 
+    std::cout.flush();
+
     return AppError::success();
   }
 }
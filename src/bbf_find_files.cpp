@@ -17,44 +17,289 @@
 */
 
 #include "badblockfile.hpp"
+#include "blkdev.hpp"
 #include "blocktofilemapper.hpp"
 #include "errors.hpp"
+#include "file.hpp"
+#include "filetoblkdev.hpp"
+#include "fsmap.hpp"
 #include "options.hpp"
+#include "progress.hpp"
+#include "progressreporter.hpp"
 
+#include <algorithm>
+#include <fstream>
 #include <iostream>
+#include <set>
+#include <string>
 #include <utility>
+#include <vector>
 
 #include <stdint.h>
+#include <unistd.h>
 
-namespace bbf
+namespace l
 {
-  AppError
-  find_files(const Options &opts)
+  static
+  bool
+  match_block_lt(const BlockToFileMapper::Match &a_,
+                 const BlockToFileMapper::Match &b_)
   {
-    int rv;
-    BlockToFileMapper b2fm;
-    std::vector<uint64_t> badblocks;
+    return (a_.first < b_.first);
+  }
+}
+
+/*
+  A list from `scan` of the whole disk is used as is. A binary list
+  whose geometry is that of the partition itself was recorded relative
+  to it and is shifted by the partition's start.
+*/
+static
+uint64_t
+input_offset(const std::string &input_file,
+             const std::string &basepath,
+             const uint64_t     offset)
+{
+  BlkDev blkdev;
+  std::string devpath;
+  BadBlockFile::Map map;
+
+  if(offset == 0)
+    return 0;
+  if(BadBlockFile::format(input_file) != BadBlockFile::BINARY)
+    return 0;
+  if(map.open(input_file) < 0)
+    return 0;
+
+  devpath = FileToBlkDev::find(basepath);
+  if(devpath.empty() || (blkdev.open_read(devpath) < 0))
+    return 0;
+
+  if(map.header()->logical_block_count != blkdev.logical_block_count())
+    return 0;
+
+  return offset;
+}
+
+static
+int
+find_files_fsmap(const std::string           &basepath,
+                 const std::vector<uint64_t> &badblocks,
+                 const uint64_t               shift,
+                 const uint64_t               offset,
+                 std::ostream                &os)
+{
+  int rv;
+  int64_t blocksize;
+  std::set<uint64_t> inodes;
+  std::vector<uint64_t> fsblocks;
+  FSMap::BlockOwners owners;
+  FSMap::InodePaths paths;
+
+  blocksize = File::logical_block_size(basepath);
+  if(blocksize < 0)
+    return blocksize;
+
+  // GETFSMAP speaks in offsets within the filesystem's own device
+  for(uint64_t i = 0, ei = badblocks.size(); i != ei; i++)
+    if((badblocks[i] + shift) >= offset)
+      fsblocks.push_back(badblocks[i] + shift - offset);
+
+  rv = FSMap::owners(basepath,blocksize,fsblocks,owners);
+  if(rv < 0)
+    return rv;
+
+  for(FSMap::BlockOwners::const_iterator
+        i = owners.begin(), ei = owners.end();
+      i != ei;
+      ++i)
+    inodes.insert(i->second.begin(),i->second.end());
+
+  if(!inodes.empty())
+    FSMap::inode_paths(basepath,inodes,paths);
+
+  const std::string none = "[none]";
+  for(uint64_t i = 0, ei = badblocks.size(); i != ei; i++)
+    {
+      bool found;
+      const uint64_t badblock = badblocks[i];
+      FSMap::BlockOwners::const_iterator owner = owners.end();
+
+      found = false;
+      if((badblock + shift) >= offset)
+        owner = owners.find(badblock + shift - offset);
+      for(uint64_t j = 0; (owner != owners.end()) && (j < owner->second.size()); j++)
+        {
+          FSMap::InodePaths::const_iterator p;
+
+          p = paths.find(owner->second[j]);
+          if(p == paths.end())
+            continue;
+
+          found = true;
+          os << badblock
+             << " "
+             << p->second.front()
+             << std::endl;
+        }
+
+      if(!found)
+        os << badblock
+           << " "
+           << none
+           << std::endl;
+    }
+
+  return 0;
+}
+
+/*
+  Without a progress_ of the caller's the walk is shown on stderr
+  when it is a terminal.
+*/
+static
+void
+build_map(const Options     &opts,
+          BlockToFileMapper &b2fm,
+          Progress          *progress_)
+{
+  bool report;
+  Progress progress;
+  ProgressReporter reporter;
 
-    rv = BadBlockFile::read(opts.input_file,badblocks);
-    if(rv < 0)
-      return AppError::reading_badblocks_file(-rv,opts.input_file);
+  report = ((progress_ == NULL) && ::isatty(STDERR_FILENO));
+  if(report)
+    reporter.start(std::cerr,progress,"Files");
 
-    b2fm.scan(opts.device);
+  b2fm.scan(opts.device,opts.jobs,opts.cache_file,
+            (progress_ ? progress_ : &progress));
 
-    const std::string none = "[none]";
-    for(uint64_t i = 0, ei = badblocks.size(); i != ei; i++)
-      {
-        std::pair<bool,std::string> entry;
-        const uint64_t badblock = badblocks[i];
+  if(report)
+    {
+      reporter.stop();
+      std::cerr << std::endl;
+    }
+}
+
+/*
+  --stream: the map is built, or loaded from --cache, before anything
+  is read and each block is then looked up and reported the moment
+  it arrives, so the output of `scan --stream` can be piped in while
+  the scan is still running. The input is text, already whole disk
+  LBAs, and nothing is sorted or deduplicated.
+*/
+static
+AppError
+find_files_stream(const Options &opts)
+{
+  uint64_t block;
+  std::istream *is;
+  std::ifstream file;
+  BlockToFileMapper b2fm;
+  std::vector<const std::string*> paths;
+  const std::string input_file = (opts.input_file.empty() ? "-" : opts.input_file);
+
+  is = &std::cin;
+  if(input_file != "-")
+    {
+      file.open(input_file.c_str());
+      if(!file.is_open())
+        return AppError::reading_badblocks_file(ENOENT,input_file);
+      is = &file;
+    }
+
+  build_map(opts,b2fm,NULL);
+
+  const std::string none = "[none]";
+  while(*is >> block)
+    {
+      paths.clear();
+      b2fm.find_all(block,paths);
+      if(paths.empty())
+        std::cout << block << " " << none << std::endl;
+      for(size_t i = 0; i < paths.size(); i++)
+        std::cout << block << " " << *paths[i] << std::endl;
+    }
 
-        entry = b2fm.find(badblock);
+  return AppError::success();
+}
+
+static
+AppError
+find_files(const Options &opts,
+           std::ostream  &os,
+           Progress      *progress)
+{
+  int rv;
+  uint64_t shift;
+  uint64_t offset;
+  BlockToFileMapper b2fm;
+  std::vector<uint64_t> badblocks;
+
+  rv = BadBlockFile::read(opts.input_file,badblocks);
+  if(rv < 0)
+    return AppError::reading_badblocks_file(-rv,opts.input_file);
 
-        std::cout << badblock
-                  << " "
-                  << (entry.first ? entry.second : none)
-                  << std::endl;
-      }
+  offset = std::max(File::lba_offset(opts.device),(int64_t)0);
+  shift  = input_offset(opts.input_file,opts.device,offset);
 
+  // resolve just the bad blocks when the filesystem can reverse map
+  // them, otherwise map every file
+  rv = find_files_fsmap(opts.device,badblocks,shift,offset,os);
+  if(rv == 0)
     return AppError::success();
+
+  build_map(opts,b2fm,progress);
+
+  std::vector<uint64_t> blocks;
+  std::vector<BlockToFileMapper::Match> matches;
+
+  // one merge pass over the map for the whole list
+  blocks.reserve(badblocks.size());
+  for(uint64_t i = 0, ei = badblocks.size(); i != ei; i++)
+    blocks.push_back(badblocks[i] + shift);
+  std::sort(blocks.begin(),blocks.end());
+  blocks.erase(std::unique(blocks.begin(),blocks.end()),blocks.end());
+
+  b2fm.find_all(blocks,matches);
+
+  const std::string none = "[none]";
+  for(uint64_t i = 0, ei = badblocks.size(); i != ei; i++)
+    {
+      const uint64_t badblock = badblocks[i];
+      std::vector<BlockToFileMapper::Match>::const_iterator m;
+
+      m = std::lower_bound(matches.begin(),matches.end(),
+                           BlockToFileMapper::Match(badblock + shift,NULL),
+                           l::match_block_lt);
+      if((m == matches.end()) || (m->first != (badblock + shift)))
+        os << badblock << " " << none << std::endl;
+      for(; (m != matches.end()) && (m->first == (badblock + shift)); ++m)
+        os << badblock << " " << *m->second << std::endl;
+    }
+
+  return AppError::success();
+}
+
+namespace bbf
+{
+  AppError
+  find_files(const Options &opts)
+  {
+    if(opts.stream)
+      return find_files_stream(opts);
+
+    return ::find_files(opts,std::cout,NULL);
+  }
+
+  AppError
+  find_files(const Options &opts,
+             std::ostream  &os,
+             Progress      &progress)
+  {
+    if(opts.stream)
+      return AppError::argument_invalid("stream not supported by the daemon");
+
+    return ::find_files(opts,os,&progress);
   }
 }
@@ -23,110 +23,96 @@
 #include <vector>
 
 #include "badblockfile.hpp"
+#include "badblockset.hpp"
 #include "blkdev.hpp"
+#include "blkdevsetup.hpp"
+#include "bufpool.hpp"
 #include "captcha.hpp"
 #include "errors.hpp"
+#include "fixrange.hpp"
 #include "options.hpp"
+#include "progress.hpp"
+#include "progressreporter.hpp"
 #include "signals.hpp"
+#include "smart.hpp"
 
 static
 int
-fix_loop_core(BlkDev             &blkdev_,
-              char               *buf_,
-              const uint64_t      buflen_,
-              const unsigned int  retries_,
-              const uint64_t      badblock_)
-{
-  int rv;
-  uint64_t attempts;
-
-  if(signals::signaled_to_exit())
-    return -EINTR;
-
-  std::cout << "Reading block " << badblock_ << ' ' << std::flush;
-
-  rv = -1;
-  for(attempts = 0; ((attempts <= retries_) && (rv < 0)); attempts++)
-    rv = blkdev_.read(badblock_,1,buf_,buflen_);
-
-  if(rv < 0)
-    std::cout << "failed [" << Error::to_string(-rv) << "] - using zeros";
-  else
-    std::cout << "succeeded";
-  std::cout << " (" << attempts << " attempts)" << std::endl;
-
-  if(rv < 0)
-    memset(buf_,0,buflen_);
-
-  std::cout << "Writing block " << badblock_ << ' ' << std::flush;
-
-  rv = -1;
-  for(attempts = 0; ((attempts <= retries_) && (rv < 0)); attempts++)
-    rv = blkdev_.write(badblock_,1,buf_,buflen_);
-
-  if(rv < 0)
-    std::cout << "failed [" << Error::to_string(-rv) << "]";
-  else
-    std::cout << "succeeded";
-  std::cout << " (" << attempts << " attempts)" << std::endl;
-
-  return 0;
-}
-
-static
-int
-fix_loop(BlkDev                      &blkdev,
-         const std::vector<uint64_t> &badblocks,
-         const unsigned int           retries)
+fix_loop(BlkDev             &blkdev,
+         const BadBlockSet  &badblocks,
+         const uint64_t      stepping,
+         const unsigned int  retries,
+         std::ostream       &os,
+         Progress           *progress)
 {
   int rv;
+  bool report;
   char *buf;
-  uint64_t buflen;
-
-  buflen = blkdev.logical_block_size();
-  buf    = new char[buflen];
-
-  for(uint64_t i = 0, ei = badblocks.size(); i != ei; ++i)
+  Progress local_progress;
+  ProgressReporter reporter;
+  Smart::Snapshot smart_before;
+  Smart::Snapshot smart_after;
+
+  buf = (char*)BufPool::get(stepping * blkdev.logical_block_size());
+  if(buf == NULL)
+    return -ENOMEM;
+
+  // runs are sorted and coalesced so neighbouring bad blocks are
+  // handled by one request
+  const std::vector<BadBlockFile::Run> &runs = badblocks.runs();
+
+  report = (progress == NULL);
+  if(report)
+    progress = &local_progress;
+  progress->set_range(0,badblocks.size(),blkdev.logical_block_size());
+  Smart::snapshot(blkdev,smart_before,progress);
+  if(report)
+    reporter.start(os,*progress);
+
+  rv = 0;
+  for(uint64_t i = 0, ei = runs.size(); i != ei; ++i)
     {
-      rv = fix_loop_core(blkdev,buf,buflen,retries,badblocks[i]);
+      rv = FixRange::fix(blkdev,
+                         runs[i].start,
+                         runs[i].length,
+                         stepping,
+                         retries,
+                         buf,
+                         true,
+                         os);
       if(rv < 0)
         break;
-    }
 
-  delete[] buf;
-
-  return rv;
-}
+      progress->advance(runs[i].length);
+      if(signals::signaled_to_exit() || progress->cancelled())
+        break;
+    }
 
-static
-void
-set_blkdev_rwtype(BlkDev                &blkdev,
-                  const Options::RWType  rwtype)
-{
-  switch(rwtype)
+  Smart::snapshot(blkdev,smart_after,progress);
+  if(report)
     {
-    case Options::ATA:
-      blkdev.set_rw_ata();
-      break;
-    case Options::OS:
-      blkdev.set_rw_os();
-      break;
+      reporter.stop();
+      os << std::endl;
     }
+
+  Smart::print(os,smart_before,smart_after);
+
+  BufPool::put(buf);
+
+  return rv;
 }
 
 static
 AppError
-fix(const Options &opts)
+fix(const Options &opts,
+    std::ostream  &os,
+    Progress      *progress)
 {
   int rv;
   BlkDev blkdev;
-  std::vector<uint64_t> badblocks;
+  BadBlockSet badblocks;
 
-  rv = BadBlockFile::read(opts.input_file,badblocks);
-  if(rv < 0)
-    return AppError::reading_badblocks_file(-rv,opts.input_file);
-
-  rv = blkdev.open_rdwr(opts.device,!opts.force);
+  rv = blkdev.open_rdwr(opts.device,!opts.force,opts.direct);
   if(rv < 0)
     return AppError::opening_device(-rv,opts.device);
 
@@ -134,9 +120,18 @@ fix(const Options &opts)
   if(opts.captcha != captcha)
     return AppError::captcha(opts.captcha,captcha);
 
-  set_blkdev_rwtype(blkdev,opts.rwtype);
+  rv = BadBlockFile::read(opts.input_file,badblocks,blkdev);
+  if(rv < 0)
+    return AppError::reading_badblocks_file(-rv,opts.input_file);
+
+  BlkDevSetup::rwtype(blkdev,opts.rwtype);
 
-  rv = fix_loop(blkdev,badblocks,opts.retries);
+  rv = fix_loop(blkdev,
+                badblocks,
+                FixRange::stepping(blkdev,opts.stepping),
+                opts.retries,
+                os,
+                progress);
 
   rv = blkdev.close();
   if(rv < 0)
@@ -150,6 +145,14 @@ namespace bbf
   AppError
   fix(const Options &opts)
   {
-    return ::fix(opts);
+    return ::fix(opts,std::cout,NULL);
+  }
+
+  AppError
+  fix(const Options &opts,
+      std::ostream  &os,
+      Progress      &progress)
+  {
+    return ::fix(opts,os,&progress);
   }
 }
@@ -19,123 +19,137 @@
 #include <errno.h>
 #include <stdint.h>
 
+#include <algorithm>
 #include <iostream>
 #include <utility>
+#include <vector>
 
+#include "badblockfile.hpp"
 #include "blkdev.hpp"
+#include "blkdevsetup.hpp"
+#include "bufpool.hpp"
 #include "captcha.hpp"
 #include "errors.hpp"
 #include "file.hpp"
 #include "filetoblkdev.hpp"
+#include "fixrange.hpp"
 #include "options.hpp"
+#include "progress.hpp"
+#include "progressreporter.hpp"
 #include "signals.hpp"
 
+/*
+  The file's bad blocks as ranges to rewrite. Neighbouring bad blocks
+  are merged and each range widened to whole physical blocks, without
+  leaving the extent, so a reallocation never half covers a sector.
+  badblocks_ must be sorted and relative to the filesystem's device.
+*/
 static
-int
-fix_file_loop_core(BlkDev             &blkdev_,
-                   char               *buf_,
-                   const uint64_t      buflen_,
-                   const unsigned int  retries_,
-                   const uint64_t      badblock_)
+void
+bad_ranges(const File::BlockVector     &extents_,
+           const std::vector<uint64_t> &badblocks_,
+           const uint64_t               pstep_,
+           File::BlockVector           &ranges_)
 {
-  int rv;
-  uint64_t attempts;
-
-  if(signals::signaled_to_exit())
-    return -EINTR;
-
-  rv = blkdev_.read(badblock_,1,buf_,buflen_);
-  for(attempts = 1; ((attempts <= retries_) && (rv < 0)); attempts++)
-    {
-      std::cout << "Reading block "
-                << badblock_
-                << " failed (attempt "
-                << attempts << " of " << retries_
-                << "[" << Error::to_string(-rv) << "]: trying again"
-                << std::endl;
-      rv = blkdev_.read(badblock_,1,buf_,buflen_);
-    }
-
-  if(rv < 0)
+  for(uint64_t i = 0, ei = extents_.size(); i != ei; i++)
     {
-      std::cout << "Reading block "
-                << badblock_
-                << " failed ("
-                << attempts << " attempts) "
-                << "[" << Error::to_string(-rv) << "]: using zeros"
-                << std::endl;
-      ::memset(buf_,0,buflen_);
-    }
+      const uint64_t start = extents_[i].block;
+      const uint64_t end   = (start + extents_[i].length);
+      std::vector<uint64_t>::const_iterator b;
 
-  rv = blkdev_.write(badblock_,1,buf_,buflen_);
-  for(attempts = 1; ((attempts <= retries_) && (rv < 0)); attempts++)
-    {
-      std::cout << "Writing block "
-                << badblock_
-                << " failed (attempt "
-                << attempts << " of " << retries_
-                << "[" << Error::to_string(-rv) << "]: trying again"
-                << std::endl;
-      rv = blkdev_.write(badblock_,1,buf_,buflen_);
+      b = std::lower_bound(badblocks_.begin(),badblocks_.end(),start);
+      while((b != badblocks_.end()) && (*b < end))
+        {
+          File::Block range;
+          uint64_t range_end;
+
+          range.block = std::max(start,(*b - (*b % pstep_)));
+          range_end   = std::min(end,(*b - (*b % pstep_) + pstep_));
+          for(++b; (b != badblocks_.end()) && (*b < range_end); ++b)
+            ;
+          while((b != badblocks_.end()) && (*b == range_end) && (range_end < end))
+            {
+              range_end = std::min(end,(*b - (*b % pstep_) + pstep_));
+              for(++b; (b != badblocks_.end()) && (*b < range_end); ++b)
+                ;
+            }
+          range.length = (range_end - range.block);
+
+          ranges_.push_back(range);
+        }
     }
-
-  if(rv < 0)
-    std::cout << "Writing block "
-              << badblock_
-              << " failed ("
-              << attempts << " attempts) "
-              << "[" << Error::to_string(-rv) << "]"
-              << std::endl;
-
-  return 0;
 }
 
-
 static
 int
-fix_file_loop(BlkDev                  &blkdev_,
-              const File::BlockVector &blockvector_,
-              const unsigned int       retries_)
+fix_ranges(BlkDev                  &blkdev_,
+           const File::BlockVector &ranges_,
+           const bool               scan_,
+           const uint64_t           stepping_,
+           const unsigned int       retries_)
 {
   int rv;
   char *buf;
+  uint64_t total;
   uint64_t buflen;
+  Progress progress;
+  ProgressReporter reporter;
 
-  buflen = blkdev_.logical_block_size();
-  buf = new char[buflen];
+  buflen = (stepping_ * blkdev_.logical_block_size());
+  buf    = (char*)BufPool::get(buflen);
+  if(buf == NULL)
+    return -ENOMEM;
 
-  for(uint64_t i = 0, ei = blockvector_.size(); i != ei; i++)
+  total = 0;
+  for(uint64_t i = 0, ei = ranges_.size(); i != ei; i++)
+    total += ranges_[i].length;
+
+  progress.set_range(0,total,blkdev_.logical_block_size());
+  reporter.start(std::cout,progress);
+
+  rv = 0;
+  for(uint64_t i = 0, ei = ranges_.size(); (i != ei) && (rv >= 0); i++)
     {
-      uint64_t        j = blockvector_[i].block;
-      const uint64_t ej = blockvector_[i].length + j;
+      uint64_t n;
+      const uint64_t end = (ranges_[i].block + ranges_[i].length);
+
+      if(!scan_)
+        {
+          rv = FixRange::fix(blkdev_,
+                             ranges_[i].block,
+                             ranges_[i].length,
+                             stepping_,
+                             retries_,
+                             buf,
+                             false,
+                             std::cout);
+          progress.advance(ranges_[i].length);
+          continue;
+        }
 
-      for(; j != ej; j++)
+      // only requests which fail to read are rewritten
+      for(uint64_t block = ranges_[i].block; (block < end) && (rv >= 0); block += n)
         {
-          rv = fix_file_loop_core(blkdev_,buf,buflen,retries_,j);
+          if(signals::signaled_to_exit())
+            rv = -EINTR;
           if(rv < 0)
             break;
+
+          n  = std::min(stepping_,(end - block));
+          rv = blkdev_.read(block,n,buf,buflen);
+          if(rv < 0)
+            rv = FixRange::fix(blkdev_,block,n,stepping_,retries_,buf,false,std::cout);
+
+          progress.advance(n);
         }
     }
 
-  delete[] buf;
+  reporter.stop();
+  std::cout << std::endl;
 
-  return rv;
-}
+  BufPool::put(buf);
 
-static
-void
-set_blkdev_rwtype(BlkDev                &blkdev,
-                  const Options::RWType  rwtype)
-{
-  switch(rwtype)
-    {
-    case Options::ATA:
-      blkdev.set_rw_ata();
-      break;
-    case Options::OS:
-      blkdev.set_rw_os();
-      break;
-    }
+  return ((rv < 0) ? rv : 0);
 }
 
 static
@@ -145,6 +159,8 @@ fix_file(const Options &opts)
   int rv;
   BlkDev blkdev;
   std::string devpath;
+  AppError err;
+  File::BlockVector ranges;
   File::BlockVector blockvector;
 
   rv = File::blocks(opts.device,blockvector);
@@ -155,7 +171,7 @@ fix_file(const Options &opts)
   if(devpath.empty())
     return AppError::opening_device(ENOENT,opts.device);
 
-  rv = blkdev.open_rdwr(devpath,!opts.force);
+  rv = blkdev.open_rdwr(devpath,!opts.force,opts.direct);
   if(rv < 0)
     return AppError::opening_device(-rv,devpath);
 
@@ -163,15 +179,43 @@ fix_file(const Options &opts)
   if(opts.captcha != captcha)
     return AppError::captcha(opts.captcha,captcha);
 
-  set_blkdev_rwtype(blkdev,opts.rwtype);
+  BlkDevSetup::rwtype(blkdev,opts.rwtype);
 
-  rv = fix_file_loop(blkdev,blockvector,opts.retries);
+  // with a bad block list only the file's blocks on it are rewritten,
+  // otherwise the file is read and only what fails rewritten
+  if(!opts.input_file.empty())
+    {
+      int64_t offset;
+      std::vector<uint64_t> badblocks;
+      std::vector<uint64_t> fsblocks;
+
+      rv = BadBlockFile::read(opts.input_file,badblocks,blkdev);
+      if(rv < 0)
+        return AppError::reading_badblocks_file(-rv,opts.input_file);
+
+      // the list holds whole disk LBAs like `scan` of the disk reports
+      offset = std::max(File::lba_offset(opts.device),(int64_t)0);
+      for(uint64_t i = 0, ei = badblocks.size(); i != ei; i++)
+        if(badblocks[i] >= (uint64_t)offset)
+          fsblocks.push_back(badblocks[i] - offset);
+      std::sort(fsblocks.begin(),fsblocks.end());
+
+      bad_ranges(blockvector,fsblocks,blkdev.block_stepping(),ranges);
+    }
+
+  rv = fix_ranges(blkdev,
+                  (opts.input_file.empty() ? blockvector : ranges),
+                  opts.input_file.empty(),
+                  FixRange::stepping(blkdev,opts.stepping),
+                  opts.retries);
+  if(rv < 0)
+    err = AppError::runtime(-rv,"error when fixing file");
 
   rv = blkdev.close();
   if(rv < 0)
     return AppError::closing_device(-rv,opts.device);
 
-  return AppError::success();
+  return err;
 }
 
 namespace bbf
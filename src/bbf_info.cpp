@@ -22,7 +22,9 @@
 #include "blkdev.hpp"
 #include "errors.hpp"
 #include "num.hpp"
+#include "nvme.hpp"
 #include "options.hpp"
+#include "smart.hpp"
 
 namespace l
 {
@@ -57,6 +59,8 @@ namespace bbf
     int rv;
     BlkDev blkdev;
     sg::identity ident;
+    nvme::identity nvme_ident;
+    Smart::Snapshot smart;
 
     rv = blkdev.open_read(opts.device);
     if(rv < 0)
@@ -93,8 +97,33 @@ namespace bbf
           << "   - supports_sata_gen2: "       << ident.supports_sata_gen2 << std::endl
           << "   - supports_sata_gen3: "       << ident.supports_sata_gen3 << std::endl
           << "   - trim_supported: "          << ident.trim_supported << std::endl
+          << "   - dma_supported: "           << ident.dma_supported << std::endl
+          << "   - ncq_supported: "           << ident.ncq_supported << std::endl
+          << "   - ata_transfer_mode: "       << sg::xfer_mode_to_string(blkdev.ata_xfer()) << std::endl
           ;
       }
+    else if(blkdev.nvme_nsid() &&
+            (nvme::identify(blkdev.fd(),nvme_ident,blkdev.timeout()) == 0))
+      {
+        std::cout
+          << " - serial_number: "             << nvme_ident.serial_number << std::endl
+          << " - firmware_revision: "         << nvme_ident.firmware_revision << std::endl
+          << " - model_number: "              << nvme_ident.model_number << std::endl
+          << " - nvme_namespace: "            << blkdev.nvme_nsid() << std::endl
+          << " - features:"                   << std::endl
+          << "   - write_uncorrectable: "     << nvme_ident.write_uncorrectable << std::endl
+          << "   - write_zeroes: "            << nvme_ident.write_zeroes << std::endl
+          << "   - verify: "                  << nvme_ident.verify << std::endl
+          << "   - format: "                  << nvme_ident.format << std::endl
+          << "   - format_crypto_erase: "     << nvme_ident.format_crypto_erase << std::endl
+          << "   - block_erase: "             << nvme_ident.sanitize_block_erase << std::endl
+          << "   - overwrite: "               << nvme_ident.sanitize_overwrite << std::endl
+          << "   - crypto_erase: "            << nvme_ident.sanitize_crypto_erase << std::endl
+          ;
+      }
+
+    if(Smart::snapshot(blkdev,smart) == 0)
+      Smart::print(std::cout,smart);
 
     std::cout
       << " - block_size:"  << std::endl
@@ -0,0 +1,330 @@
+/*
+  ISC License
+
+  Copyright (c) 2016, Antonio SJ Musumeci <trapexit@spawn.link>
+
+  Permission to use, copy, modify, and/or distribute this software for any
+  purpose with or without fee is hereby granted, provided that the above
+  copyright notice and this permission notice appear in all copies.
+
+  THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+  WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+  MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+  ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+  WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+  ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+  OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+*/
+
+#include <errno.h>
+#include <stdint.h>
+
+#include <algorithm>
+#include <iostream>
+#include <vector>
+
+#include "badblockfile.hpp"
+#include "blkdev.hpp"
+#include "blkdevsetup.hpp"
+#include "bufpool.hpp"
+#include "errors.hpp"
+#include "options.hpp"
+#include "progress.hpp"
+#include "progressreporter.hpp"
+#include "signals.hpp"
+#include "time.hpp"
+
+/*
+  Re-verify an existing bad block list without scanning the device.
+  The list is coalesced into runs, each widened by --radius blocks on
+  either side, and only those ranges are read. Blocks still failing
+  are retried --retries times, waiting BACKOFF seconds before the
+  first retry and doubling the wait each time after, so a drive busy
+  recovering or reallocating gets time to settle. The list is then
+  rewritten with the blocks which read fine dropped.
+*/
+
+namespace l
+{
+  static const double BACKOFF         = 0.25;
+  static const long   DEFAULT_RETRIES = 3;
+
+  static
+  void
+  ranges(const std::vector<uint64_t>    &badblocks_,
+         const uint64_t                  radius_,
+         const uint64_t                  block_count_,
+         std::vector<BadBlockFile::Run> &ranges_)
+  {
+    std::vector<BadBlockFile::Run> runs;
+
+    BadBlockFile::to_runs(badblocks_,runs);
+
+    for(uint64_t i = 0, ei = runs.size(); i != ei; i++)
+      {
+        BadBlockFile::Run range;
+        uint64_t end;
+
+        if(runs[i].start >= block_count_)
+          continue;
+
+        range.start = ((runs[i].start > radius_) ? (runs[i].start - radius_) : 0);
+        end         = std::min((runs[i].start + runs[i].length + radius_),block_count_);
+
+        if(!ranges_.empty() &&
+           (range.start <= (ranges_.back().start + ranges_.back().length)))
+          {
+            ranges_.back().length = (end - ranges_.back().start);
+            continue;
+          }
+
+        range.length = (end - range.start);
+        ranges_.push_back(range);
+      }
+  }
+
+  /*
+    Read [start,start+length) in stepping sized requests and each
+    block of a failed request individually. Returns the number of
+    blocks processed, less than length if interrupted.
+  */
+  static
+  uint64_t
+  check(BlkDev                &blkdev_,
+        const uint64_t         start_,
+        const uint64_t         length_,
+        const uint64_t         stepping_,
+        char                  *buf_,
+        const uint64_t         buflen_,
+        std::vector<uint64_t> &failed_,
+        Progress              &progress_)
+  {
+    int64_t rv;
+    uint64_t n;
+    const uint64_t end = (start_ + length_);
+
+    for(uint64_t block = start_; block < end; block += n)
+      {
+        if(signals::signaled_to_exit())
+          return (block - start_);
+
+        n  = std::min(stepping_,(end - block));
+        rv = blkdev_.read(block,n,buf_,buflen_);
+        if(rv < 0)
+          {
+            std::vector<BlkDev::Request> reqs(n);
+
+            for(uint64_t i = 0; i < n; i++)
+              {
+                reqs[i].lba    = (block + i);
+                reqs[i].blocks = 1;
+                reqs[i].buf    = buf_;
+                reqs[i].buflen = buflen_;
+                reqs[i].op     = BlkDev::READ;
+              }
+
+            blkdev_.submit(reqs);
+            for(uint64_t i = 0; i < n; i++)
+              if(reqs[i].rv < 0)
+                failed_.push_back(reqs[i].lba);
+          }
+
+        progress_.advance(n);
+        progress_.set_bad(failed_);
+      }
+
+    return length_;
+  }
+
+  /* retry the failed blocks with exponential backoff between rounds */
+  static
+  void
+  retry(BlkDev                &blkdev_,
+        const long             retries_,
+        char                  *buf_,
+        const uint64_t         buflen_,
+        std::vector<uint64_t> &failed_,
+        std::ostream          &os_)
+  {
+    double delay;
+
+    delay = BACKOFF;
+    for(long round = 1; (round <= retries_) && !failed_.empty(); round++)
+      {
+        uint64_t o;
+
+        os_ << "Retry " << round << '/' << retries_
+            << ": " << failed_.size() << " blocks after "
+            << delay << "s" << std::endl;
+
+        Time::sleep(delay);
+        delay *= 2;
+
+        o = 0;
+        for(uint64_t i = 0, ei = failed_.size(); i != ei; i++)
+          {
+            if(signals::signaled_to_exit())
+              return;
+            if(blkdev_.read(failed_[i],1,buf_,buflen_) < 0)
+              failed_[o++] = failed_[i];
+            else
+              os_ << "Block " << failed_[i] << " recovered" << std::endl;
+          }
+
+        failed_.resize(o);
+      }
+  }
+}
+
+/* --format or else that of the list being replaced */
+static
+BadBlockFile::Format
+output_format(const Options::Format  format,
+              const std::string     &input_file)
+{
+  switch(format)
+    {
+    case Options::FORMAT_TEXT:
+      return BadBlockFile::TEXT;
+    case Options::FORMAT_BINARY:
+      return BadBlockFile::BINARY;
+    case Options::FORMAT_AUTO:
+      break;
+    }
+
+  return BadBlockFile::output_format(input_file,BadBlockFile::NONE);
+}
+
+static
+AppError
+rescan(const Options &opts)
+{
+  int rv;
+  char *buf;
+  long retries;
+  BlkDev blkdev;
+  uint64_t total;
+  uint64_t buflen;
+  uint64_t stepping;
+  uint64_t checked;
+  Progress progress;
+  ProgressReporter reporter;
+  std::string input_file;
+  std::string output_file;
+  std::vector<uint64_t> badblocks;
+  std::vector<uint64_t> failed;
+  std::vector<uint64_t> result;
+  std::vector<BadBlockFile::Run> ranges;
+
+  rv = blkdev.open_read(opts.device,opts.direct);
+  if(rv < 0)
+    return AppError::opening_device(-rv,opts.device);
+
+  input_file  = opts.input_file;
+  output_file = opts.output_file;
+  if(input_file.empty())
+    input_file = BadBlockFile::filepath(blkdev);
+  if(output_file.empty())
+    output_file = input_file;
+
+  rv = BadBlockFile::read(input_file,badblocks,blkdev);
+  if(rv < 0)
+    return AppError::reading_badblocks_file(-rv,input_file);
+
+  BlkDevSetup::rwtype(blkdev,opts.rwtype);
+  BlkDevSetup::recovery(blkdev,opts,std::cout);
+
+  std::sort(badblocks.begin(),badblocks.end());
+  badblocks.erase(std::unique(badblocks.begin(),badblocks.end()),badblocks.end());
+
+  l::ranges(badblocks,opts.radius,blkdev.logical_block_count(),ranges);
+
+  stepping = ((opts.stepping == 0) ? blkdev.block_stepping() : opts.stepping);
+  retries  = ((opts.retries == 0) ? l::DEFAULT_RETRIES : opts.retries);
+  buflen   = (stepping * blkdev.logical_block_size());
+
+  total = 0;
+  for(uint64_t i = 0, ei = ranges.size(); i != ei; i++)
+    total += ranges[i].length;
+
+  std::cout << "bad blocks: " << badblocks.size() << std::endl
+            << "ranges: " << ranges.size()
+            << " (radius: " << opts.radius << ")" << std::endl
+            << "blocks: " << total << std::endl;
+
+  buf = (char*)BufPool::get(buflen);
+  if(buf == NULL)
+    return AppError::runtime(ENOMEM,"unable to allocate buffer");
+
+  progress.set_range(0,total,blkdev.logical_block_size());
+  reporter.start(std::cout,progress);
+
+  // blocks of ranges not reached keep their listing
+  checked = 0;
+  for(uint64_t i = 0, ei = ranges.size(); i != ei; i++)
+    {
+      uint64_t n;
+
+      n = l::check(blkdev,
+                   ranges[i].start,
+                   ranges[i].length,
+                   stepping,
+                   buf,
+                   buflen,
+                   failed,
+                   progress);
+      checked = (ranges[i].start + n);
+      if(n != ranges[i].length)
+        break;
+    }
+
+  reporter.stop();
+  std::cout << std::endl;
+
+  l::retry(blkdev,retries,buf,buflen,failed,std::cout);
+
+  BufPool::put(buf);
+
+  result = failed;
+  for(uint64_t i = 0, ei = badblocks.size(); i != ei; i++)
+    if(badblocks[i] >= checked)
+      result.push_back(badblocks[i]);
+  std::sort(result.begin(),result.end());
+  result.erase(std::unique(result.begin(),result.end()),result.end());
+
+  {
+    uint64_t kept;
+
+    kept = 0;
+    for(uint64_t i = 0, ei = badblocks.size(); i != ei; i++)
+      kept += std::binary_search(result.begin(),result.end(),badblocks[i]);
+
+    std::cout << "still bad: " << kept << std::endl
+              << "recovered: " << (badblocks.size() - kept) << std::endl
+              << "newly bad: " << (result.size() - kept) << std::endl;
+  }
+
+  rv = BadBlockFile::write(output_file,
+                           result,
+                           blkdev,
+                           output_format(opts.format,input_file));
+  if(rv < 0)
+    return AppError::writing_badblocks_file(-rv,output_file);
+
+  std::cout << "Bad blocks written to " << output_file << std::endl;
+
+  rv = blkdev.close();
+  if(rv < 0)
+    return AppError::closing_device(-rv,opts.device);
+
+  return AppError::success();
+}
+
+namespace bbf
+{
+  AppError
+  rescan(const Options &opts)
+  {
+    return ::rescan(opts);
+  }
+}
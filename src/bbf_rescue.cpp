@@ -0,0 +1,564 @@
+/*
+  ISC License
+
+  Copyright (c) 2016, Antonio SJ Musumeci <trapexit@spawn.link>
+
+  Permission to use, copy, modify, and/or distribute this software for any
+  purpose with or without fee is hereby granted, provided that the above
+  copyright notice and this permission notice appear in all copies.
+
+  THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+  WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+  MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+  ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+  WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+  ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+  OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+*/
+
+#include <errno.h>
+#include <fcntl.h>
+#include <stdint.h>
+#include <sys/stat.h>
+#include <sys/types.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "badblockfile.hpp"
+#include "badblockset.hpp"
+#include "blkdev.hpp"
+#include "blkdevsetup.hpp"
+#include "bufpool.hpp"
+#include "captcha.hpp"
+#include "errors.hpp"
+#include "journal.hpp"
+#include "options.hpp"
+#include "progress.hpp"
+#include "progressreporter.hpp"
+#include "rescuemap.hpp"
+#include "signals.hpp"
+#include "time.hpp"
+
+/*
+  Copy everything readable from a failing device to an image file or
+  replacement device, getting the most data off first:
+
+    pass 0  copy in large sequential reads. The known bad blocks are
+            skipped from the start and after a read error a region
+            is skipped which doubles with each error in a row. Reads
+            stop short of a sense reported LBA so the blocks before
+            it are kept.
+    pass 1  split the skipped regions: read them physical block by
+            physical block and mark what fails as bad.
+    pass 2+ retry the bad blocks --retries times, now logical block
+            by logical block so the good half of a physical one is
+            still saved.
+
+  Progress is kept in a RescueMap saved every Journal::INTERVAL
+  seconds and at the end so --resume carries on where it stopped.
+  Unreadable blocks are never written leaving zeros (or holes) in an
+  image.
+*/
+
+namespace l
+{
+  static const uint64_t COPY_BYTES      = (1024 * 1024);
+  static const uint64_t MAX_SKIP_BYTES  = (1024 * 1024 * 1024);
+  static const long     DEFAULT_RETRIES = 1;
+
+  struct Rescue
+  {
+    BlkDev      *src;
+    int          dst;
+    RescueMap   *map;
+    std::string  map_path;
+    char        *buf;
+    uint64_t     lbs;
+    double       saved;
+    Progress    *progress;
+  };
+
+  /* as scan: anything but EIO or an ATA error is a bad request */
+  static
+  bool
+  media_error(const int64_t rv_)
+  {
+    return ((rv_ == -EIO) || (rv_ <= -256));
+  }
+
+  static
+  void
+  save(Rescue         &r_,
+       const uint64_t  block_,
+       const bool      force_)
+  {
+    double now;
+
+    now = Time::get_monotonic();
+    if(!force_ && ((now - r_.saved) < Journal::INTERVAL))
+      return;
+
+    r_.map->pos = block_;
+    r_.map->save(r_.map_path);
+    r_.saved = now;
+  }
+
+  static
+  int
+  copy(Rescue         &r_,
+       const uint64_t  block_,
+       const uint64_t  count_,
+       const char     *buf_)
+  {
+    ssize_t rv;
+    size_t  done;
+    const size_t len = (count_ * r_.lbs);
+
+    done = 0;
+    while(done < len)
+      {
+        rv = ::pwrite(r_.dst,&buf_[done],(len - done),((block_ * r_.lbs) + done));
+        if((rv == -1) && (errno == EINTR))
+          continue;
+        if(rv <= 0)
+          return ((rv == -1) ? -errno : -EIO);
+        done += rv;
+      }
+
+    return 0;
+  }
+
+  /*
+    Reads [block_,block_+count_) and on success writes it out and
+    marks it copied. Returns 1 when copied, 0 on a media error with
+    failed_ set as the device reported it and otherwise a negative
+    errno.
+  */
+  static
+  int
+  rescue(Rescue         &r_,
+         const uint64_t  block_,
+         const uint64_t  count_,
+         uint64_t       &failed_)
+  {
+    int rv;
+    int64_t n;
+    double start;
+
+    failed_ = BlkDev::UNKNOWN_LBA;
+    start   = Time::get_monotonic();
+    n = r_.src->read(block_,count_,r_.buf,(count_ * r_.lbs),failed_);
+    r_.progress->add_request(count_ * r_.lbs,(Time::get_monotonic() - start));
+    if(n > 0)
+      {
+        rv = copy(r_,block_,count_,r_.buf);
+        if(rv < 0)
+          return rv;
+
+        r_.map->set(block_,count_,RescueMap::FINISHED);
+
+        return 1;
+      }
+
+    if((n == 0) || media_error(n))
+      return 0;
+
+    return n;
+  }
+
+  static
+  int
+  copy_pass(Rescue         &r_,
+            const uint64_t  chunk_,
+            const uint64_t  max_skip_)
+  {
+    int rv;
+    uint64_t n;
+    uint64_t end;
+    uint64_t skip;
+    uint64_t block;
+    uint64_t limit;
+    uint64_t start;
+    uint64_t length;
+    uint64_t failed;
+
+    skip  = chunk_;
+    limit = 0;
+    block = r_.map->pos;
+    while(r_.map->next(RescueMap::NONTRIED,block,start,length))
+      {
+        end = (start + length);
+        for(block = start; block < end; block += n)
+          {
+            if(signals::signaled_to_exit() || r_.progress->cancelled())
+              return 0;
+
+            r_.progress->set_current(block);
+            save(r_,block,false);
+
+            n = std::min(chunk_,(end - block));
+            if(limit)
+              n = std::min(n,limit);
+            limit = 0;
+
+            rv = rescue(r_,block,n,failed);
+            if(rv < 0)
+              return rv;
+            if(rv > 0)
+              {
+                skip = chunk_;
+                continue;
+              }
+
+            // keep what comes before the LBA the drive reported
+            if((failed > block) && (failed < (block + n)))
+              {
+                limit = (failed - block);
+                n     = 0;
+                continue;
+              }
+
+            // skip further with each error in a row
+            n    = std::min(std::max(skip,n),(end - block));
+            skip = std::min((skip * 2),max_skip_);
+            r_.map->set(block,n,RescueMap::SKIPPED);
+            r_.progress->set_bad(r_.map->count(RescueMap::SKIPPED));
+          }
+      }
+
+    return 0;
+  }
+
+  /*
+    Reads every region of status_ physical block by physical block:
+    what reads is copied, what doesn't is marked bad. The pieces are
+    submitted as batches filling the chunk_ block buffer.
+  */
+  static
+  int
+  split_pass(Rescue                  &r_,
+             const RescueMap::Status  status_,
+             const uint64_t           piece_,
+             const uint64_t           chunk_)
+  {
+    int rv;
+    uint64_t n;
+    uint64_t end;
+    uint64_t used;
+    uint64_t block;
+    uint64_t start;
+    uint64_t length;
+    double seconds;
+    std::vector<BlkDev::Request> reqs;
+
+    block = r_.map->pos;
+    while(r_.map->next(status_,block,start,length))
+      {
+        end = (start + length);
+        for(block = start; block < end; block += used)
+          {
+            if(signals::signaled_to_exit() || r_.progress->cancelled())
+              return 0;
+
+            r_.progress->set_current(block);
+            save(r_,block,false);
+
+            reqs.clear();
+            for(used = 0; (block + used) < end; used += n)
+              {
+                BlkDev::Request req;
+
+                n = std::min((piece_ - ((block + used) % piece_)),
+                             (end - (block + used)));
+                if(!reqs.empty() && ((used + n) > chunk_))
+                  break;
+
+                req.lba    = (block + used);
+                req.blocks = n;
+                req.buf    = &r_.buf[used * r_.lbs];
+                req.buflen = (n * r_.lbs);
+                req.op     = BlkDev::READ;
+                reqs.push_back(req);
+              }
+
+            seconds = Time::get_monotonic();
+            r_.src->submit(reqs);
+            seconds = ((Time::get_monotonic() - seconds) / reqs.size());
+
+            for(size_t i = 0; i < reqs.size(); i++)
+              {
+                const BlkDev::Request &req = reqs[i];
+
+                r_.progress->add_request(req.buflen,seconds);
+                if(req.rv > 0)
+                  {
+                    rv = copy(r_,req.lba,req.blocks,(const char*)req.buf);
+                    if(rv < 0)
+                      return rv;
+                    r_.map->set(req.lba,req.blocks,RescueMap::FINISHED);
+                    continue;
+                  }
+
+                if((req.rv != 0) && !media_error(req.rv))
+                  return req.rv;
+
+                r_.map->set(req.lba,req.blocks,RescueMap::BAD);
+              }
+
+            r_.progress->set_bad(r_.map->count(RescueMap::BAD));
+          }
+      }
+
+    return 0;
+  }
+
+  /*
+    A block device destination is written over so needs the captcha
+    like any other destructive instruction. A file is created and
+    sized to the source.
+  */
+  static
+  AppError
+  open_dst(const Options &opts_,
+           const BlkDev  &src_,
+           int           &fd_)
+  {
+    int rv;
+    struct stat st;
+
+    rv = ::stat(opts_.output_file.c_str(),&st);
+    if((rv == 0) && S_ISBLK(st.st_mode))
+      {
+        BlkDev dst;
+
+        rv = dst.open_read(opts_.output_file);
+        if(rv < 0)
+          return AppError::opening_device(-rv,opts_.output_file);
+        if(dst.size_in_bytes() < src_.size_in_bytes())
+          return AppError::argument_invalid("destination is smaller than the source");
+        if(opts_.captcha != captcha::calculate(dst))
+          return AppError::captcha(opts_.captcha,captcha::calculate(dst));
+        dst.close();
+
+        fd_ = ::open(opts_.output_file.c_str(),O_WRONLY|O_EXCL|O_CLOEXEC);
+        if(fd_ == -1)
+          return AppError::opening_device(errno,opts_.output_file);
+
+        return AppError::success();
+      }
+
+    fd_ = ::open(opts_.output_file.c_str(),O_WRONLY|O_CREAT|O_CLOEXEC,0644);
+    if(fd_ == -1)
+      return AppError::opening_file(errno,opts_.output_file);
+
+    rv = ::ftruncate(fd_,src_.size_in_bytes());
+    if(rv == -1)
+      {
+        rv = errno;
+        ::close(fd_);
+        return AppError::opening_file(rv,opts_.output_file);
+      }
+
+    return AppError::success();
+  }
+
+  /*
+    Beside an image file or, for a device, with the bad block lists
+    under ${HOME} named by the source's captcha.
+  */
+  static
+  std::string
+  map_path(const Options &opts_,
+           const BlkDev  &src_)
+  {
+    struct stat st;
+
+    if((::stat(opts_.output_file.c_str(),&st) == 0) && S_ISBLK(st.st_mode))
+      return (BadBlockFile::filepath(src_) + ".rescue");
+
+    return (opts_.output_file + ".map");
+  }
+}
+
+static
+AppError
+rescue(const Options &opts)
+{
+  int rv;
+  int dst = -1;
+  long retries;
+  BlkDev blkdev;
+  AppError err;
+  uint64_t lbs;
+  uint64_t chunk;
+  uint64_t piece;
+  uint64_t max_skip;
+  uint64_t end_block;
+  RescueMap map;
+  l::Rescue r;
+  Progress progress;
+  ProgressReporter reporter;
+  BadBlockSet known;
+  std::string input_file;
+
+  rv = blkdev.open_read(opts.device,opts.direct);
+  if(rv < 0)
+    return AppError::opening_device(-rv,opts.device);
+
+  BlkDevSetup::rwtype(blkdev,opts.rwtype);
+  BlkDevSetup::recovery(blkdev,opts,std::cout);
+
+  err = l::open_dst(opts,blkdev,dst);
+  if(!err.succeeded())
+    return err;
+
+  lbs       = blkdev.logical_block_size();
+  chunk     = ((opts.stepping == 0) ? (l::COPY_BYTES / lbs) : opts.stepping);
+  chunk     = std::max(chunk,blkdev.block_stepping());
+  piece     = blkdev.block_stepping();
+  retries   = ((opts.retries == 0) ? l::DEFAULT_RETRIES : opts.retries);
+  end_block = std::min(opts.end_block,blkdev.logical_block_count());
+  max_skip  = std::max(chunk,std::min(((end_block - opts.start_block) / 100),
+                                      (l::MAX_SKIP_BYTES / lbs)));
+
+  r.src      = &blkdev;
+  r.dst      = dst;
+  r.map      = &map;
+  r.map_path = l::map_path(opts,blkdev);
+  r.lbs      = lbs;
+  r.saved    = Time::get_monotonic();
+  r.progress = &progress;
+
+  map.reset(opts.start_block,end_block);
+  if(opts.resume)
+    {
+      rv = map.load(r.map_path);
+      if(rv < 0)
+        std::cout << "Warning: no map to resume from at "
+                  << r.map_path << std::endl;
+      else
+        std::cout << "Resuming pass " << map.pass
+                  << " from block " << map.pos
+                  << " (" << map.count(RescueMap::FINISHED) << " blocks copied)"
+                  << std::endl;
+    }
+
+  // known bad blocks are left for the split pass
+  input_file = (opts.input_file.empty() ?
+                BadBlockFile::filepath(blkdev) :
+                opts.input_file);
+  rv = BadBlockFile::read(input_file,known,blkdev);
+  if((rv < 0) && !opts.input_file.empty())
+    {
+      ::close(dst);
+      return AppError::reading_badblocks_file(-rv,input_file);
+    }
+  if((rv >= 0) && (map.pass == 0))
+    {
+      const std::vector<BadBlockSet::Run> &runs = known.runs();
+
+      for(size_t i = 0; i < runs.size(); i++)
+        {
+          uint64_t start;
+          uint64_t end;
+          uint64_t s;
+          uint64_t l;
+
+          start = ((runs[i].start / piece) * piece);
+          end   = (((runs[i].start + runs[i].length + piece - 1) / piece) * piece);
+          for(s = start; map.next(RescueMap::NONTRIED,s,s,l) && (s < end); s += l)
+            map.set(s,std::min(l,(end - s)),RescueMap::SKIPPED);
+        }
+
+      std::cout << "Skipping " << known.size()
+                << " known bad blocks from " << input_file << std::endl;
+    }
+
+  std::cout << "source: " << opts.device << std::endl
+            << "destination: " << opts.output_file << std::endl
+            << "map: " << r.map_path << std::endl
+            << "start block: " << map.start() << std::endl
+            << "end block: " << map.end() << std::endl
+            << "logical block size: " << lbs << std::endl
+            << "read size: " << chunk << " blocks / "
+            << (chunk * lbs) << " bytes" << std::endl
+            << "split size: " << piece << " blocks" << std::endl;
+
+  r.buf = (char*)BufPool::get(chunk * lbs);
+  if(r.buf == NULL)
+    {
+      ::close(dst);
+      return AppError::runtime(ENOMEM,"unable to allocate buffer");
+    }
+
+  progress.set_range(map.start(),map.end(),lbs);
+  reporter.start(std::cout,progress);
+
+  rv = 0;
+  for(; (rv == 0) && (map.pass <= (retries + 1)); map.pass++, map.pos = map.start())
+    {
+      if(signals::signaled_to_exit())
+        break;
+
+      std::cout << "\r\x1B[2K"
+                << ((map.pass == 0) ? "Copying" :
+                    (map.pass == 1) ? "Splitting" :
+                    "Retrying")
+                << ": "
+                << ((map.pass == 0) ? map.count(RescueMap::NONTRIED) :
+                    (map.pass == 1) ? map.count(RescueMap::SKIPPED) :
+                    map.count(RescueMap::BAD))
+                << " blocks"
+                << std::endl;
+
+      progress.set_range(map.start(),map.end(),lbs);
+      if(map.pass == 0)
+        rv = l::copy_pass(r,chunk,max_skip);
+      else if(map.pass == 1)
+        rv = l::split_pass(r,RescueMap::SKIPPED,piece,chunk);
+      else
+        rv = l::split_pass(r,RescueMap::BAD,1,chunk);
+
+      if(signals::signaled_to_exit() || progress.cancelled())
+        break;
+    }
+
+  l::save(r,progress.current_block(),true);
+
+  reporter.stop();
+  std::cout << std::endl;
+
+  BufPool::put(r.buf);
+
+  if(::fsync(dst) == -1)
+    rv = ((rv < 0) ? rv : -errno);
+  ::close(dst);
+
+  std::cout << "copied: " << map.count(RescueMap::FINISHED) << " blocks" << std::endl
+            << "not tried: " << map.count(RescueMap::NONTRIED) << " blocks" << std::endl
+            << "skipped: " << map.count(RescueMap::SKIPPED) << " blocks" << std::endl
+            << "unreadable: " << map.count(RescueMap::BAD) << " blocks" << std::endl
+            << "Map written to " << r.map_path << std::endl;
+
+  if(rv < 0)
+    return AppError::runtime(-rv,"error when rescuing drive");
+
+  rv = blkdev.close();
+  if(rv < 0)
+    return AppError::closing_device(-rv,opts.device);
+
+  return AppError::success();
+}
+
+namespace bbf
+{
+  AppError
+  rescue(const Options &opts)
+  {
+    return ::rescue(opts);
+  }
+}
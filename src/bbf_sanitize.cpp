@@ -0,0 +1,401 @@
+/*
+  ISC License
+
+  Copyright (c) 2016, Antonio SJ Musumeci <trapexit@spawn.link>
+
+  Permission to use, copy, modify, and/or distribute this software for any
+  purpose with or without fee is hereby granted, provided that the above
+  copyright notice and this permission notice appear in all copies.
+
+  THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+  WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+  MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+  ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+  WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+  ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+  OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+*/
+
+#include "blkdev.hpp"
+#include "captcha.hpp"
+#include "errors.hpp"
+#include "multidevice.hpp"
+#include "nvme.hpp"
+#include "options.hpp"
+#include "progress.hpp"
+#include "progressreporter.hpp"
+#include "sg.hpp"
+#include "signals.hpp"
+#include "time.hpp"
+
+#include <iostream>
+#include <string>
+
+#include <errno.h>
+#include <stdint.h>
+
+static const uint64_t TIMEOUT_15_SECS = (15 * 1000);
+
+/*
+  ATA SANITIZE DEVICE returns as soon as the drive has started the
+  operation which then runs in the background, surviving resets and
+  power cycles, so rather than blocking in one long command the drive
+  is polled with SANITIZE STATUS EXT which reports progress in
+  1/65536ths. A sanitize already running when started is simply
+  monitored. Interrupting bbf stops the polling, not the sanitize.
+
+  NVMe Sanitize works the same way with the Sanitize Status log page
+  in place of SANITIZE STATUS EXT.
+*/
+
+namespace l
+{
+  static const double POLL_INTERVAL = 1.0;
+  static const uint64_t PROGRESS_MAX = 65536;
+
+  static
+  const char*
+  method_to_string(const int method_)
+  {
+    switch(method_)
+      {
+      case sg::SG_SANITIZE_CRYPTO_SCRAMBLE:
+        return "crypto scramble";
+      case sg::SG_SANITIZE_BLOCK_ERASE:
+        return "block erase";
+      case sg::SG_SANITIZE_OVERWRITE:
+        return "overwrite";
+      }
+
+    return "unknown";
+  }
+
+  /* the fastest method the drive supports unless one was asked for */
+  static
+  int
+  method(const sg::identity          &ident_,
+         const Options::Instruction   instr_)
+  {
+    switch(instr_)
+      {
+      case Options::SANITIZE_CRYPTO_SCRAMBLE:
+        return (ident_.crypto_scramble ? sg::SG_SANITIZE_CRYPTO_SCRAMBLE : -ENOTSUP);
+      case Options::SANITIZE_BLOCK_ERASE:
+        return (ident_.block_erase ? sg::SG_SANITIZE_BLOCK_ERASE : -ENOTSUP);
+      case Options::SANITIZE_OVERWRITE:
+        return (ident_.overwrite ? sg::SG_SANITIZE_OVERWRITE : -ENOTSUP);
+      default:
+        break;
+      }
+
+    if(ident_.crypto_scramble)
+      return sg::SG_SANITIZE_CRYPTO_SCRAMBLE;
+    if(ident_.block_erase)
+      return sg::SG_SANITIZE_BLOCK_ERASE;
+    if(ident_.overwrite)
+      return sg::SG_SANITIZE_OVERWRITE;
+
+    return -ENOTSUP;
+  }
+
+  static
+  const char*
+  nvme_method_to_string(const int method_)
+  {
+    switch(method_)
+      {
+      case nvme::NVME_SANACT_CRYPTO_ERASE:
+        return "crypto erase";
+      case nvme::NVME_SANACT_BLOCK_ERASE:
+        return "block erase";
+      case nvme::NVME_SANACT_OVERWRITE:
+        return "overwrite";
+      }
+
+    return "unknown";
+  }
+
+  /* crypto scramble is NVMe's crypto erase */
+  static
+  int
+  nvme_method(const nvme::identity        &ident_,
+              const Options::Instruction   instr_)
+  {
+    switch(instr_)
+      {
+      case Options::SANITIZE_CRYPTO_SCRAMBLE:
+        return (ident_.sanitize_crypto_erase ? nvme::NVME_SANACT_CRYPTO_ERASE : -ENOTSUP);
+      case Options::SANITIZE_BLOCK_ERASE:
+        return (ident_.sanitize_block_erase ? nvme::NVME_SANACT_BLOCK_ERASE : -ENOTSUP);
+      case Options::SANITIZE_OVERWRITE:
+        return (ident_.sanitize_overwrite ? nvme::NVME_SANACT_OVERWRITE : -ENOTSUP);
+      default:
+        break;
+      }
+
+    if(ident_.sanitize_crypto_erase)
+      return nvme::NVME_SANACT_CRYPTO_ERASE;
+    if(ident_.sanitize_block_erase)
+      return nvme::NVME_SANACT_BLOCK_ERASE;
+    if(ident_.sanitize_overwrite)
+      return nvme::NVME_SANACT_OVERWRITE;
+
+    return -ENOTSUP;
+  }
+
+  static
+  int
+  status(const BlkDev &blkdev_,
+         uint16_t     &progress_,
+         bool         &in_progress_,
+         bool         &completed_)
+  {
+    int rv;
+
+    if(blkdev_.nvme_nsid())
+      {
+        nvme::sanitize_status status;
+
+        rv = nvme::get_sanitize_status(blkdev_.fd(),status,TIMEOUT_15_SECS);
+        if(rv < 0)
+          return rv;
+
+        progress_    = status.progress;
+        in_progress_ = status.in_progress;
+        completed_   = status.completed;
+      }
+    else
+      {
+        sg::sanitize_status status;
+
+        rv = sg::sanitize_status_ext(blkdev_.fd(),status,TIMEOUT_15_SECS);
+        if(rv < 0)
+          return rv;
+
+        progress_    = status.progress;
+        in_progress_ = status.in_progress;
+        completed_   = status.completed;
+      }
+
+    return 0;
+  }
+
+  static
+  int
+  poll(const BlkDev &blkdev_,
+       Progress     &progress_)
+  {
+    int rv;
+    double next;
+    uint16_t progress;
+    bool in_progress;
+    bool completed;
+
+    while(true)
+      {
+        rv = l::status(blkdev_,progress,in_progress,completed);
+        if(rv < 0)
+          return rv;
+
+        progress_.set_current(in_progress ? progress : PROGRESS_MAX);
+        if(!in_progress)
+          break;
+
+        next = (Time::get_monotonic() + POLL_INTERVAL);
+        while(Time::get_monotonic() < next)
+          {
+            if(signals::signaled_to_exit() || progress_.cancelled())
+              return -EINTR;
+            Time::sleep(0.1);
+          }
+      }
+
+    return (completed ? 0 : -EIO);
+  }
+
+  /* in_progress_ is set when a sanitize was already running */
+  static
+  AppError
+  nvme_start(const BlkDev  &blkdev_,
+             const Options &opts_,
+             std::ostream  &os_,
+             bool          &in_progress_)
+  {
+    int rv;
+    int method;
+    nvme::identity ident;
+    nvme::sanitize_status status;
+
+    rv = nvme::identify(blkdev_.fd(),ident,TIMEOUT_15_SECS);
+    if(rv < 0)
+      return AppError::runtime(-rv,"NVMe identify controller failed");
+    if(!ident.sanitize_crypto_erase &&
+       !ident.sanitize_block_erase &&
+       !ident.sanitize_overwrite)
+      return AppError::runtime(ENOTSUP,"sanitize not supported");
+
+    rv = nvme::get_sanitize_status(blkdev_.fd(),status,TIMEOUT_15_SECS);
+    if(rv < 0)
+      return AppError::runtime(-rv,"sanitize status log failed");
+
+    in_progress_ = status.in_progress;
+    if(in_progress_)
+      return AppError::success();
+
+    method = l::nvme_method(ident,opts_.instruction);
+    if(method < 0)
+      return AppError::runtime(-method,"sanitize method not supported");
+
+    os_ << "Sanitize method: " << l::nvme_method_to_string(method) << std::endl;
+
+    rv = nvme::sanitize(blkdev_.fd(),method,TIMEOUT_15_SECS);
+    if(rv < 0)
+      return AppError::runtime(-rv,"sanitize instruction failed");
+
+    return AppError::success();
+  }
+
+  static
+  AppError
+  ata_start(const BlkDev  &blkdev_,
+            const Options &opts_,
+            std::ostream  &os_,
+            bool          &in_progress_)
+  {
+    int rv;
+    int method;
+    sg::sanitize_status status;
+
+    if(!blkdev_.has_identity())
+      return AppError::runtime(ENOTSUP,"sanitize requires an ATA or NVMe device");
+    if(!blkdev_.identity().sanitize)
+      return AppError::runtime(ENOTSUP,"sanitize feature set not supported");
+
+    rv = sg::sanitize_status_ext(blkdev_.fd(),status,TIMEOUT_15_SECS);
+    if(rv < 0)
+      return AppError::runtime(-rv,"sanitize status instruction failed");
+    if(status.frozen)
+      return AppError::runtime(EBUSY,"Sanitize frozen. Unable to continue.");
+
+    in_progress_ = status.in_progress;
+    if(in_progress_)
+      return AppError::success();
+
+    method = l::method(blkdev_.identity(),opts_.instruction);
+    if(method < 0)
+      return AppError::runtime(-method,"sanitize method not supported");
+
+    os_ << "Sanitize method: " << l::method_to_string(method) << std::endl;
+
+    rv = sg::sanitize(blkdev_.fd(),method,TIMEOUT_15_SECS);
+    if(rv < 0)
+      return AppError::runtime(-rv,"sanitize instruction failed");
+
+    return AppError::success();
+  }
+
+  static
+  AppError
+  sanitize(const BlkDev  &blkdev_,
+           const Options &opts_,
+           std::ostream  &os_,
+           Progress      *progress_)
+  {
+    int rv;
+    bool report;
+    bool in_progress;
+    double start;
+    AppError err;
+    Progress local_progress;
+    ProgressReporter reporter;
+
+    in_progress = false;
+    if(blkdev_.nvme_nsid())
+      err = l::nvme_start(blkdev_,opts_,os_,in_progress);
+    else
+      err = l::ata_start(blkdev_,opts_,os_,in_progress);
+    if(!err.succeeded())
+      return err;
+
+    if(in_progress)
+      os_ << "Sanitize already in progress - monitoring" << std::endl;
+    else
+      os_ << "Sanitize started" << std::endl;
+
+    report = (progress_ == NULL);
+    if(report)
+      progress_ = &local_progress;
+    progress_->set_range(0,PROGRESS_MAX,0);
+
+    if(report)
+      reporter.start(os_,*progress_);
+
+    start = Time::get_monotonic();
+    rv    = l::poll(blkdev_,*progress_);
+
+    if(report)
+      {
+        reporter.stop();
+        os_ << std::endl;
+      }
+
+    if(rv == -EINTR)
+      return AppError::runtime(EINTR,"stopped monitoring - sanitize continues on the device");
+    if(rv < 0)
+      return AppError::runtime(-rv,"sanitize failed");
+
+    os_ << "Sanitize finished in "
+        << (Time::get_monotonic() - start) << "s"
+        << std::endl;
+
+    return AppError::success();
+  }
+
+  static
+  AppError
+  sanitize(const Options &opts_,
+           std::ostream  &os_,
+           Progress      *progress_)
+  {
+    int rv;
+    AppError err;
+    BlkDev blkdev;
+
+    rv = blkdev.open_read(opts_.device);
+    if(rv < 0)
+      return AppError::opening_device(-rv,opts_.device);
+
+    const std::string captcha = captcha::calculate(blkdev);
+    if(opts_.captcha != captcha)
+      return AppError::captcha(opts_.captcha,captcha);
+
+    err = l::sanitize(blkdev,opts_,os_,progress_);
+
+    rv = blkdev.close();
+    if((rv < 0) && err.succeeded())
+      err = AppError::closing_device(-rv,opts_.device);
+
+    return err;
+  }
+
+  static
+  AppError
+  sanitize_worker(const Options &opts_,
+                  std::ostream  &os_,
+                  Progress      &progress_)
+  {
+    return l::sanitize(opts_,os_,&progress_);
+  }
+}
+
+namespace bbf
+{
+  AppError
+  sanitize(const Options &opts_)
+  {
+    if(opts_.devices.size() > 1)
+      return MultiDevice::run(opts_,l::sanitize_worker);
+
+    return l::sanitize(opts_,std::cout,NULL);
+  }
+}
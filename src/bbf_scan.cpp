@@ -17,30 +17,54 @@
 */
 
 #include <errno.h>
+#include <pthread.h>
+#include <signal.h>
 #include <stdint.h>
+#include <math.h>
+#include <sys/stat.h>
 
+#include <algorithm>
 #include <iostream>
 #include <iomanip>
 #include <utility>
+#include <vector>
 
+#include "adaptivestepping.hpp"
+#include "asyncio.hpp"
 #include "badblockfile.hpp"
+#include "badblockset.hpp"
 #include "blkdev.hpp"
+#include "blkdevsetup.hpp"
+#include "blocktofilemapper.hpp"
+#include "bufpool.hpp"
 #include "errors.hpp"
-#include "info.hpp"
+#include "file.hpp"
+#include "filetoblkdev.hpp"
+#include "journal.hpp"
+#include "metrics.hpp"
 #include "math.hpp"
+#include "multidevice.hpp"
+#include "nvme.hpp"
 #include "options.hpp"
+#include "progress.hpp"
+#include "progressreporter.hpp"
+#include "scanorder.hpp"
+#include "sg.hpp"
 #include "signals.hpp"
+#include "simdev.hpp"
+#include "smart.hpp"
 #include "time.hpp"
 
 static
 uint64_t
 trim_stepping(const BlkDev   &blkdev_,
               const uint64_t  block_,
+              const uint64_t  end_block_,
               const uint64_t  stepping_)
 {
   uint64_t block_count;
 
-  block_count = blkdev_.logical_block_count();
+  block_count = std::min(blkdev_.logical_block_count(),end_block_);
 
   if(block_ > block_count)
     return 0;
@@ -48,6 +72,161 @@ trim_stepping(const BlkDev   &blkdev_,
   return std::min(block_count - block_,stepping_);
 }
 
+/*
+  OS reads report unreadable sectors as EIO while ATA passthrough
+  errors are encoded above 255 (see Error::to_string). Anything else
+  (EINVAL, EBADF, ...) is a problem with the request and not the media.
+*/
+static
+bool
+media_error(const int64_t rv_)
+{
+  return ((rv_ == -EIO) || (rv_ <= -256));
+}
+
+/*
+  A read which succeeds only after the drive's own retries is the
+  first sign of a failing sector. Every block of a request taking at
+  least slow_ seconds is recorded as weak; a smaller --stepping gives
+  a more precise list.
+*/
+static
+void
+add_weakblocks(const uint64_t         block_,
+               const uint64_t         stepping_,
+               const double           seconds_,
+               const double           slow_,
+               std::vector<uint64_t> &weakblocks_)
+{
+  if((slow_ <= 0) || (seconds_ < slow_))
+    return;
+
+  for(uint64_t i = 0; i < stepping_; i++)
+    weakblocks_.push_back(block_ + i);
+}
+
+/*
+  A read of no blocks is the end of the device rather than a failure:
+  nothing past it is recorded. Errors which aren't media errors stop
+  the localization and are returned.
+*/
+static
+int
+scan_stride_linear(BlkDev                &blkdev_,
+                   const uint64_t         block_,
+                   const uint64_t         stepping_,
+                   char                  *buf_,
+                   const uint64_t         buflen_,
+                   std::vector<uint64_t> &badblocks_,
+                   uint64_t              &reads_)
+{
+  std::vector<BlkDev::Request> reqs(stepping_);
+
+  for(uint64_t i = 0; i < stepping_; i++)
+    {
+      reqs[i].lba    = (block_ + i);
+      reqs[i].blocks = 1;
+      reqs[i].buf    = buf_;
+      reqs[i].buflen = buflen_;
+      reqs[i].op     = BlkDev::READ;
+    }
+
+  reads_ += stepping_;
+  if(blkdev_.submit(reqs) == 0)
+    return 0;
+
+  for(uint64_t i = 0; i < stepping_; i++)
+    {
+      if(reqs[i].rv == 0)
+        break;
+      if((reqs[i].rv < 0) && !media_error(reqs[i].rv))
+        return reqs[i].rv;
+      if(reqs[i].rv < 0)
+        badblocks_.push_back(reqs[i].lba);
+    }
+
+  return 0;
+}
+
+/*
+  The range [block,block+stepping) is known to have failed. Split it
+  in two and reread each half, only descending into halves which fail,
+  until individual blocks are reached. A single bad block in a large
+  stride costs ~2*log2(stepping) reads rather than `stepping`. The
+  reads made are added to reads_. End of device and non media errors
+  are handled as by scan_stride_linear.
+*/
+static
+int
+scan_stride_bisect(BlkDev                &blkdev_,
+                   const uint64_t         block_,
+                   const uint64_t         stepping_,
+                   char                  *buf_,
+                   const uint64_t         buflen_,
+                   std::vector<uint64_t> &badblocks_,
+                   uint64_t              &reads_)
+{
+  int64_t rv;
+  uint64_t half;
+
+  if(stepping_ == 0)
+    return 0;
+
+  if(stepping_ == 1)
+    {
+      badblocks_.push_back(block_);
+      return 0;
+    }
+
+  half = (stepping_ / 2);
+
+  reads_++;
+  rv = blkdev_.read(block_,half,buf_,buflen_);
+  if(rv == 0)
+    return 0;
+  if((rv < 0) && !media_error(rv))
+    return rv;
+  if(rv < 0)
+    {
+      rv = scan_stride_bisect(blkdev_,block_,half,buf_,buflen_,badblocks_,reads_);
+      if(rv < 0)
+        return rv;
+    }
+
+  reads_++;
+  rv = blkdev_.read(block_+half,stepping_-half,buf_,buflen_);
+  if(rv == 0)
+    return 0;
+  if((rv < 0) && !media_error(rv))
+    return rv;
+  if(rv < 0)
+    return scan_stride_bisect(blkdev_,block_+half,stepping_-half,buf_,buflen_,badblocks_,reads_);
+
+  return 0;
+}
+
+static
+int
+scan_stride_fallback(BlkDev                  &blkdev_,
+                     const Options::Localize  localize_,
+                     const uint64_t           block_,
+                     const uint64_t           stepping_,
+                     char                    *buf_,
+                     const uint64_t           buflen_,
+                     std::vector<uint64_t>   &badblocks_,
+                     uint64_t                &reads_)
+{
+  switch(localize_)
+    {
+    case Options::BISECT:
+      return scan_stride_bisect(blkdev_,block_,stepping_,buf_,buflen_,badblocks_,reads_);
+    case Options::LINEAR:
+      return scan_stride_linear(blkdev_,block_,stepping_,buf_,buflen_,badblocks_,reads_);
+    }
+
+  return 0;
+}
+
 static
 int
 scan_loop(BlkDev                &blkdev,
@@ -57,62 +236,864 @@ scan_loop(BlkDev                &blkdev,
           char                  *buf_,
           const uint64_t         buflen_,
           std::vector<uint64_t> &badblocks,
-          const uint64_t         max_errors_)
+          std::vector<uint64_t> &weakblocks_,
+          const double           slow_,
+          const uint64_t         max_errors_,
+          const Options::Localize localize_,
+          AdaptiveStepping      *adaptive_,
+          Progress              *progress_,
+          Journal               *journal_)
 {
   int rv;
   uint64_t block;
   uint64_t stepping;
-  double current_time;
-  const double start_time = Time::get_monotonic();
-
-  current_time = Time::get_monotonic();
-  Info::print(std::cout,start_time,current_time,
-              start_block,end_block,start_block,badblocks);
+  uint64_t reads;
+  uint64_t failed_lba;
+  double request_time;
+  const uint64_t lbsize = blkdev.logical_block_size();
 
+  rv    = 0;
   block = start_block;
   while(block < end_block)
     {
       if(signals::signaled_to_exit())
         break;
+      if(progress_->cancelled())
+        break;
 
-      if(signals::dec(SIGALRM))
-        {
-          signals::alarm(1);
-          current_time = Time::get_monotonic();
-          Info::print(std::cout,start_time,current_time,
-                      start_block,end_block,block,badblocks);
-        }
+      progress_->set_current(block);
+      progress_->set_bad(badblocks);
 
-      stepping = trim_stepping(blkdev,block,stepping_);
+      if(journal_)
+        journal_->update(block,badblocks);
 
-      rv = blkdev.read(block,stepping,buf_,buflen_);
+      stepping = (adaptive_ ?
+                  std::min(adaptive_->stepping_at(block),end_block - block) :
+                  stepping_);
+      /* after resuming past a reported bad block realign to stepping_ */
+      if(!adaptive_ && ((block - start_block) % stepping_))
+        stepping = (stepping_ - ((block - start_block) % stepping_));
+      stepping = trim_stepping(blkdev,block,end_block,stepping);
+
+      request_time = Time::get_monotonic();
+      rv = blkdev.read(block,stepping,buf_,buflen_,failed_lba);
+      request_time = (Time::get_monotonic() - request_time);
+      progress_->add_request(stepping * lbsize,request_time);
       block += stepping;
       if(rv > 0)
-        continue;
-      if(rv == 0)
+        {
+          add_weakblocks(block-stepping,stepping,request_time,slow_,weakblocks_);
+          if(adaptive_)
+            adaptive_->success(stepping,request_time);
+          continue;
+        }
+      if((rv == 0) || !media_error(rv))
+        {
+          block -= stepping;
+          break;
+        }
+
+      if(adaptive_)
+        adaptive_->failure();
+
+      /*
+        The drive reported the first unreadable block so those before
+        it were read fine: record it and carry on right after it.
+      */
+      if(failed_lba != BlkDev::UNKNOWN_LBA)
+        {
+          badblocks.push_back(failed_lba);
+          block = (failed_lba + 1);
+          rv    = 0;
+          if(badblocks.size() > max_errors_)
+            break;
+          continue;
+        }
+
+      reads = 0;
+      rv = scan_stride_fallback(blkdev,localize_,
+                                block-stepping,stepping,
+                                buf_,buflen_,badblocks,reads);
+      progress_->add_retries(reads);
+      if(rv < 0)
+        {
+          block -= stepping;
+          break;
+        }
+
+      if(badblocks.size() > max_errors_)
+        break;
+    }
+
+  if(journal_)
+    journal_->checkpoint(block,badblocks);
+
+  progress_->set_current(block);
+  progress_->set_bad(badblocks);
+
+  return rv;
+}
+
+/*
+  Stratified random sampling. The range is cut into slices of
+  `stratum` blocks and one stepping sized stripe at a random aligned
+  offset within each is read. A stripe with bad blocks has the slice
+  before, its own and the one after read in full since defects tend
+  to cluster. Only the random stripes count toward the estimate.
+*/
+struct SampleStats
+{
+  uint64_t stratum;
+  uint64_t strata;
+  uint64_t stripes;
+  uint64_t failed;
+  uint64_t sampled;
+  uint64_t dense;
+};
+
+static
+uint64_t
+xorshift(uint64_t &state_)
+{
+  state_ ^= (state_ << 13);
+  state_ ^= (state_ >> 7);
+  state_ ^= (state_ << 17);
+
+  return state_;
+}
+
+static
+int
+scan_sample(BlkDev                &blkdev,
+            const uint64_t         stepping_,
+            const uint64_t         start_block_,
+            const uint64_t         end_block_,
+            const double           percent_,
+            char                  *buf_,
+            const uint64_t         buflen_,
+            std::vector<uint64_t> &badblocks_,
+            std::vector<uint64_t> &weakblocks_,
+            const double           slow_,
+            const uint64_t         max_errors_,
+            const Options::Localize localize_,
+            Progress              *progress_,
+            SampleStats           &stats_)
+{
+  int rv;
+  uint64_t rng;
+  uint64_t prev;
+  uint64_t dense_end;
+
+  stats_.stratum = math::round_up((uint64_t)(stepping_ * (100.0 / percent_)),
+                                  stepping_);
+  stats_.stratum = std::max(stats_.stratum,stepping_);
+  stats_.strata  = (((end_block_ - start_block_) + stats_.stratum - 1) /
+                    stats_.stratum);
+
+  rng = ((uint64_t)(Time::get_monotonic() * 1000000.0) | 1);
+
+  rv        = 0;
+  prev      = end_block_;
+  dense_end = start_block_;
+  for(uint64_t s = start_block_; s < end_block_; s += stats_.stratum)
+    {
+      uint64_t b;
+      uint64_t e;
+      uint64_t from;
+      uint64_t stripes;
+      size_t bad;
+
+      if(signals::signaled_to_exit())
         break;
-      if(rv > -256)
+      if(progress_->cancelled())
         break;
 
-      current_time = Time::get_monotonic();
-      Info::print(std::cout,start_time,current_time,
-                  start_block,end_block,block,badblocks);
+      e = std::min((s + stats_.stratum),end_block_);
+      if(e <= dense_end)
+        continue;
+
+      from    = std::max(s,dense_end);
+      stripes = (((e - from) + stepping_ - 1) / stepping_);
+      b       = (from + ((xorshift(rng) % stripes) * stepping_));
 
-      for(uint64_t i = 0; i < stepping; i++)
+      bad = badblocks_.size();
+      rv  = scan_loop(blkdev,stepping_,b,std::min((b + stepping_),e),
+                      buf_,buflen_,badblocks_,weakblocks_,slow_,
+                      max_errors_,localize_,NULL,progress_,NULL);
+      stats_.stripes++;
+      stats_.sampled += (std::min((b + stepping_),e) - b);
+      if(rv < 0)
+        break;
+      if(badblocks_.size() == bad)
         {
-          rv = blkdev.read(block+i,1,buf_,buflen_);
-          if(rv > 0)
-            continue;
-          badblocks.push_back(block+i);
+          prev = b;
+          continue;
         }
 
-      if(badblocks.size() > max_errors_)
+      stats_.failed++;
+      if(badblocks_.size() > max_errors_)
+        break;
+
+      from = ((s - start_block_) > stats_.stratum) ? (s - stats_.stratum) : start_block_;
+      from = std::max(from,dense_end);
+      e    = std::min((e + stats_.stratum),end_block_);
+
+      rv = scan_loop(blkdev,stepping_,from,b,
+                     buf_,buflen_,badblocks_,weakblocks_,slow_,
+                     max_errors_,localize_,NULL,progress_,NULL);
+      if(rv < 0)
+        break;
+      if(b + stepping_ < e)
+        rv = scan_loop(blkdev,stepping_,(b + stepping_),e,
+                       buf_,buflen_,badblocks_,weakblocks_,slow_,
+                       max_errors_,localize_,NULL,progress_,NULL);
+      stats_.dense += ((e - from) - std::min(stepping_,(e - b)));
+      if((prev >= from) && (prev < b))
+        stats_.dense -= stepping_;
+      prev      = end_block_;
+      dense_end = e;
+      if(rv < 0)
+        break;
+      if(badblocks_.size() > max_errors_)
         break;
     }
 
-  current_time = Time::get_monotonic();
-  Info::print(std::cout,start_time,current_time,
-              start_block,end_block,block,badblocks);
+  progress_->set_current(end_block_);
+
+  return rv;
+}
+
+/*
+  Wilson score upper bound of the failing stripe fraction at 95%.
+  Unlike the normal approximation it stays meaningful with no
+  failures seen, where it is close to the rule of three.
+*/
+static
+double
+wilson_upper(const uint64_t failed_,
+             const uint64_t n_)
+{
+  double p;
+  double n;
+  const double z = 1.96;
+
+  if(n_ == 0)
+    return 1.0;
+
+  n = n_;
+  p = (failed_ / n);
+
+  return std::min(1.0,
+                  ((p + ((z * z) / (2 * n)) +
+                    (z * ::sqrt(((p * (1 - p)) / n) + ((z * z) / (4 * n * n))))) /
+                   (1 + ((z * z) / n))));
+}
+
+static
+void
+print_sample_stats(std::ostream      &os_,
+                   const SampleStats &stats_,
+                   const uint64_t     stepping_,
+                   const uint64_t     start_block_,
+                   const uint64_t     end_block_)
+{
+  double rate;
+  double upper;
+  const uint64_t total   = (end_block_ - start_block_);
+  const uint64_t stripes = ((total + stepping_ - 1) / stepping_);
+
+  rate  = (stats_.stripes ? ((double)stats_.failed / stats_.stripes) : 0);
+  upper = wilson_upper(stats_.failed,stats_.stripes);
+
+  os_ << "sample slice: " << stats_.stratum << " blocks ("
+      << stats_.strata << " slices)" << std::endl
+      << "sampled stripes: " << stats_.stripes << " ("
+      << stats_.failed << " with bad blocks)" << std::endl
+      << std::setprecision(3)
+      << "coverage: " << (total ? ((100.0 * (stats_.sampled + stats_.dense)) / total) : 0)
+      << "% (" << stats_.sampled << " sampled + "
+      << stats_.dense << " around failures of "
+      << total << " blocks)" << std::endl
+      << "bad stripe rate: " << (rate * 100.0)
+      << "% (95% upper bound " << (upper * 100.0) << "%)" << std::endl
+      << "estimated bad stripes: " << (uint64_t)((rate * stripes) + 0.5)
+      << " (95% upper bound " << (uint64_t)((upper * stripes) + 0.5)
+      << " of " << stripes << ")" << std::endl;
+}
+
+/*
+  OS reads go through io_uring / libaio on the block device itself.
+  ATA reads and verifies need the sg character device to have more
+  than one passthrough command outstanding; on an NVMe namespace they
+  become NVMe Read / Verify through io_uring passthrough on its
+  generic device and on a SCSI disk READ(16) / VERIFY(16) through sg.
+*/
+static
+int
+scan_aio_init(AsyncIO       &aio_,
+              const BlkDev  &blkdev_,
+              const Options &opts_)
+{
+  int rv;
+
+  rv = -ENOTSUP;
+  switch(opts_.rwtype)
+    {
+    case Options::OS:
+      if(blkdev_.sim())
+        rv = aio_.init_sim(blkdev_.fd(),opts_.queue_depth,blkdev_.sim());
+      else
+        rv = aio_.init(blkdev_.fd(),opts_.queue_depth);
+      break;
+    case Options::ATA:
+    case Options::VERIFY:
+      if(blkdev_.nvme_nsid())
+        {
+          rv = aio_.init_nvme(nvme::generic_path(blkdev_.fd()),
+                              opts_.queue_depth,
+                              blkdev_.nvme_nsid(),
+                              blkdev_.logical_block_size(),
+                              blkdev_.timeout(),
+                              (opts_.rwtype == Options::VERIFY));
+          break;
+        }
+      if(blkdev_.is_scsi())
+        {
+          rv = aio_.init_scsi(sg::generic_path(blkdev_.fd()),
+                              opts_.queue_depth,
+                              blkdev_.logical_block_size(),
+                              blkdev_.timeout(),
+                              (opts_.rwtype == Options::VERIFY));
+          break;
+        }
+      rv = aio_.init_sg(sg::generic_path(blkdev_.fd()),
+                        opts_.queue_depth,
+                        blkdev_.logical_block_size(),
+                        blkdev_.ata_xfer(),
+                        blkdev_.timeout(),
+                        (opts_.rwtype == Options::VERIFY));
+      break;
+    }
+
+  if(rv == 0)
+    aio_.set_throttle(blkdev_.throttle());
+
+  return rv;
+}
+
+/*
+  Reads are submitted in order so every block below the lowest one
+  still in flight (or the next to be submitted) has been processed.
+  Free slots have a stepping of 0.
+*/
+static
+uint64_t
+async_watermark(const std::vector<uint64_t> &slot_block_,
+                const std::vector<uint64_t> &slot_stepping_,
+                const uint64_t               next_block_)
+{
+  uint64_t rv;
+
+  rv = next_block_;
+  for(size_t i = 0; i < slot_block_.size(); i++)
+    if(slot_stepping_[i] != 0)
+      rv = std::min(rv,slot_block_[i]);
+
+  return rv;
+}
+
+/*
+  Same as scan_loop but keeps up to `aio.depth()` reads in flight.
+  Completions arrive out of order so progress is reported as the
+  number of blocks completed rather than the position of the last
+  read. A failed or short read falls back to the same per block
+  rescan as the synchronous loop.
+*/
+static
+int
+scan_loop_async(BlkDev                &blkdev,
+                AsyncIO               &aio,
+                const uint64_t         stepping_,
+                const uint64_t         start_block,
+                const uint64_t         end_block,
+                char                  *bufs_,
+                const uint64_t         buflen_,
+                std::vector<uint64_t> &badblocks,
+                std::vector<uint64_t> &weakblocks_,
+                const double           slow_,
+                const uint64_t         max_errors_,
+                const Options::Localize localize_,
+                Progress              *progress_,
+                Journal               *journal_)
+{
+  int rv;
+  int error;
+  uint64_t block;
+  uint64_t blocks_done;
+  uint64_t stop_block;
+  unsigned int inflight;
+  std::vector<unsigned int> free_slots;
+  std::vector<uint64_t> slot_block;
+  std::vector<uint64_t> slot_stepping;
+  std::vector<double> slot_time;
+  std::vector<AsyncIO::Completion> completions;
+  const uint64_t lbsize = blkdev.logical_block_size();
+
+  slot_block.resize(aio.depth());
+  slot_stepping.resize(aio.depth());
+  slot_time.resize(aio.depth());
+  for(unsigned int i = aio.depth(); i != 0; i--)
+    free_slots.push_back(i - 1);
+
+  error       = 0;
+  inflight    = 0;
+  blocks_done = 0;
+  stop_block  = ~0ULL;
+  block       = start_block;
+  while((block < end_block) || inflight)
+    {
+      if(signals::signaled_to_exit() || progress_->cancelled())
+        {
+          stop_block = std::min(stop_block,
+                                async_watermark(slot_block,slot_stepping,block));
+          block      = end_block;
+        }
+
+      progress_->set_current(start_block+blocks_done);
+      progress_->set_bad(badblocks);
+
+      if(journal_)
+        journal_->update(std::min(stop_block,
+                                  async_watermark(slot_block,slot_stepping,block)),
+                         badblocks);
+
+      while((block < end_block) && !free_slots.empty())
+        {
+          unsigned int slot;
+          uint64_t stepping;
+
+          stepping = trim_stepping(blkdev,block,end_block,stepping_);
+          if(stepping == 0)
+            {
+              block = end_block;
+              break;
+            }
+
+          slot = free_slots.back();
+          rv = aio.submit(slot,
+                          AsyncIO::READ,
+                          block * lbsize,
+                          &bufs_[slot * buflen_],
+                          stepping * lbsize);
+          if(rv < 0)
+            break;
+
+          free_slots.pop_back();
+          slot_block[slot]    = block;
+          slot_stepping[slot] = stepping;
+          slot_time[slot]     = Time::get_monotonic();
+          block += stepping;
+          inflight++;
+        }
+
+      rv = aio.flush();
+      if(rv < 0)
+        {
+          error      = rv;
+          stop_block = std::min(stop_block,
+                                async_watermark(slot_block,slot_stepping,block));
+          block      = end_block;
+          if(inflight == 0)
+            break;
+        }
+
+      completions.clear();
+      rv = aio.reap(completions,1);
+      if(rv < 0)
+        {
+          error = rv;
+          break;
+        }
+
+      for(size_t i = 0; i < completions.size(); i++)
+        {
+          const unsigned int slot     = completions[i].slot;
+          const int64_t      res      = completions[i].res;
+          const uint64_t     stepping = slot_stepping[slot];
+          const double       seconds  = (Time::get_monotonic() - slot_time[slot]);
+          uint64_t           good;
+          uint64_t           reads;
+
+          inflight--;
+          free_slots.push_back(slot);
+          slot_stepping[slot] = 0;
+          blocks_done += stepping;
+          progress_->add_request(stepping * lbsize,seconds);
+
+          if(res == (int64_t)(stepping * lbsize))
+            {
+              add_weakblocks(slot_block[slot],stepping,seconds,slow_,weakblocks_);
+              continue;
+            }
+          if((res < 0) && !media_error(res))
+            {
+              error      = res;
+              stop_block = std::min(stop_block,slot_block[slot]);
+              stop_block = std::min(stop_block,
+                                    async_watermark(slot_block,slot_stepping,block));
+              block      = end_block;
+              continue;
+            }
+
+          /*
+            A short read returned the leading blocks intact: only the
+            remainder needs rescanning.
+          */
+          good  = ((res > 0) ? ((uint64_t)res / lbsize) : 0);
+          reads = 0;
+          rv = scan_stride_fallback(blkdev,
+                                    localize_,
+                                    slot_block[slot] + good,
+                                    stepping - good,
+                                    &bufs_[slot * buflen_],
+                                    buflen_,
+                                    badblocks,
+                                    reads);
+          progress_->add_retries(reads);
+          if(rv < 0)
+            {
+              error      = rv;
+              stop_block = std::min(stop_block,slot_block[slot]);
+              stop_block = std::min(stop_block,
+                                    async_watermark(slot_block,slot_stepping,block));
+              block      = end_block;
+              continue;
+            }
+
+          if(badblocks.size() > max_errors_)
+            {
+              stop_block = std::min(stop_block,
+                                    async_watermark(slot_block,slot_stepping,block));
+              block      = end_block;
+            }
+        }
+    }
+
+  if(journal_)
+    journal_->checkpoint(std::min(stop_block,block),badblocks);
+
+  progress_->set_current(start_block+blocks_done);
+  progress_->set_bad(badblocks);
+
+  return error;
+}
+
+/*
+  Reads the segments of a --order scan in turn, each split into
+  chunks of ORDER_CHUNK requests. The LBA jumps between segments so
+  progress_ counts blocks scanned over [0,total) instead and is
+  brought up to date after every chunk. Only segments in LBA order,
+  those of a zoned device or --allocated-only, can be journaled.
+*/
+static const uint64_t ORDER_CHUNK = 4096;
+
+static
+int
+scan_ordered(BlkDev                  &blkdev,
+             AsyncIO                 &aio,
+             const bool               async_,
+             const uint64_t           stepping_,
+             const File::BlockVector &segments_,
+             char                    *buf_,
+             const uint64_t           buflen_,
+             std::vector<uint64_t>   &badblocks_,
+             std::vector<uint64_t>   &weakblocks_,
+             const double             slow_,
+             const uint64_t           max_errors_,
+             const Options::Localize  localize_,
+             Progress                *progress_,
+             Journal                 *journal_)
+{
+  int rv;
+  uint64_t done;
+  Progress part;
+  std::vector<const Progress*> parts(1,&part);
+
+  rv   = 0;
+  done = 0;
+  for(uint64_t i = 0, ei = segments_.size(); (i != ei) && (rv >= 0); i++)
+    {
+      uint64_t n;
+      const uint64_t end = (segments_[i].block + segments_[i].length);
+
+      for(uint64_t block = segments_[i].block; block < end; block += n)
+        {
+          if(signals::signaled_to_exit() || progress_->cancelled())
+            return rv;
+
+          n = std::min((stepping_ * ORDER_CHUNK),(end - block));
+          part.set_range(block,block + n,blkdev.logical_block_size());
+          if(async_)
+            rv = scan_loop_async(blkdev,aio,stepping_,block,block + n,
+                                 buf_,buflen_,badblocks_,weakblocks_,
+                                 slow_,max_errors_,localize_,&part,journal_);
+          else
+            rv = scan_loop(blkdev,stepping_,block,block + n,
+                           buf_,buflen_,badblocks_,weakblocks_,
+                           slow_,max_errors_,localize_,NULL,&part,journal_);
+
+          done += (part.current_block() - block);
+          progress_->set_current(done);
+          progress_->set_bad(badblocks_);
+          progress_->sum_requests(parts);
+          if((rv < 0) || (badblocks_.size() > max_errors_))
+            return rv;
+          if(part.current_block() < (block + n))
+            return rv;
+        }
+    }
+
+  return rv;
+}
+
+/*
+  A region of the device scanned by its own thread when --jobs > 1.
+  Bad blocks are collected privately and merged into the shared list
+  once the job has been joined. Progress is how the coordinating
+  thread observes the job and asks it to stop.
+*/
+struct ScanJob
+{
+  BlkDev                *blkdev;
+  const Options         *opts;
+  uint64_t               stepping;
+  uint64_t               max_stepping;
+  uint64_t               start_block;
+  uint64_t               end_block;
+  bool                   async;
+  std::vector<uint64_t>  badblocks;
+  std::vector<uint64_t>  weakblocks;
+  Progress               progress;
+  int                    rv;
+  pthread_t              thread;
+  bool                   started;
+};
+
+static
+int
+scan_job(ScanJob *job_)
+{
+  int rv;
+  char *buf;
+  AsyncIO aio;
+  uint64_t buflen;
+  const Options &opts = *job_->opts;
+  AdaptiveStepping adaptive(job_->stepping,job_->max_stepping);
+
+  buflen = (job_->max_stepping * job_->blkdev->logical_block_size());
+
+  rv = -ENOTSUP;
+  if(job_->async)
+    rv = scan_aio_init(aio,*job_->blkdev,opts);
+
+  buf = (char*)BufPool::get(buflen * std::max(aio.depth(),1U));
+  if(buf == NULL)
+    return -ENOMEM;
+
+  if(rv == 0)
+    rv = scan_loop_async(*job_->blkdev,
+                         aio,
+                         job_->stepping,
+                         job_->start_block,
+                         job_->end_block,
+                         buf,
+                         buflen,
+                         job_->badblocks,
+                         job_->weakblocks,
+                         opts.slow_threshold / 1000.0,
+                         opts.max_errors,
+                         opts.localize,
+                         &job_->progress,
+                         NULL);
+  else
+    rv = scan_loop(*job_->blkdev,
+                   job_->stepping,
+                   job_->start_block,
+                   job_->end_block,
+                   buf,
+                   buflen,
+                   job_->badblocks,
+                   job_->weakblocks,
+                   opts.slow_threshold / 1000.0,
+                   opts.max_errors,
+                   opts.localize,
+                   (opts.adaptive ? &adaptive : NULL),
+                   &job_->progress,
+                   NULL);
+
+  BufPool::put(buf);
+
+  return rv;
+}
+
+static
+void*
+scan_job_main(void *arg_)
+{
+  sigset_t set;
+  ScanJob *job = (ScanJob*)arg_;
+
+  /* leave signal handling to the coordinating thread */
+  sigfillset(&set);
+  pthread_sigmask(SIG_BLOCK,&set,NULL);
+
+  job->rv = scan_job(job);
+  job->progress.finish();
+
+  return NULL;
+}
+
+static
+bool
+scan_jobs_done(const std::vector<ScanJob*> &jobs_)
+{
+  for(size_t i = 0; i < jobs_.size(); i++)
+    if(jobs_[i]->started && !jobs_[i]->progress.done())
+      return false;
+
+  return true;
+}
+
+static
+uint64_t
+scan_jobs_processed(const std::vector<ScanJob*> &jobs_)
+{
+  uint64_t processed;
+
+  processed = 0;
+  for(size_t i = 0; i < jobs_.size(); i++)
+    processed += (jobs_[i]->progress.current_block() -
+                  jobs_[i]->progress.start_block());
+
+  return processed;
+}
+
+/*
+  Splits [start_block,end_block) into opts.jobs regions aligned to
+  the stepping and scans them concurrently against the same device.
+  The calling thread enforces the max error limit over all jobs and
+  renders a single aggregated status line or, when driven by
+  MultiDevice, folds the jobs into the device's Progress.
+*/
+static
+int
+scan_jobs(BlkDev                &blkdev,
+          const Options         &opts,
+          const uint64_t         stepping,
+          const uint64_t         max_stepping,
+          const uint64_t         start_block,
+          const uint64_t         end_block,
+          const bool             async,
+          std::vector<uint64_t> &badblocks,
+          std::vector<uint64_t> &weakblocks,
+          std::ostream          &os,
+          Progress              *progress)
+{
+  int rv;
+  uint64_t block;
+  uint64_t region;
+  std::vector<ScanJob*> jobs;
+  std::vector<const Progress*> parts;
+
+  region = ((end_block - start_block + opts.jobs - 1) / opts.jobs);
+  region = math::round_up(region,max_stepping);
+
+  for(block = start_block; block < end_block; block += region)
+    {
+      ScanJob *job = new ScanJob();
+
+      job->blkdev       = &blkdev;
+      job->opts         = &opts;
+      job->stepping     = stepping;
+      job->max_stepping = max_stepping;
+      job->start_block  = block;
+      job->end_block    = std::min(block + region,end_block);
+      job->async        = async;
+      job->rv           = 0;
+      job->started      = false;
+      job->progress.set_range(job->start_block,
+                              job->end_block,
+                              blkdev.logical_block_size());
+
+      jobs.push_back(job);
+      parts.push_back(&job->progress);
+    }
+
+  os << "jobs: " << jobs.size()
+     << " (region size: " << region << " blocks)"
+     << std::endl;
+
+  rv = 0;
+  for(size_t i = 0; i < jobs.size(); i++)
+    {
+      rv = pthread_create(&jobs[i]->thread,NULL,scan_job_main,jobs[i]);
+      if(rv != 0)
+        {
+          rv = -rv;
+          break;
+        }
+
+      jobs[i]->started = true;
+    }
+
+  while(!scan_jobs_done(jobs))
+    {
+      uint64_t bad;
+
+      bad = badblocks.size();
+      for(size_t i = 0; i < jobs.size(); i++)
+        bad += jobs[i]->progress.bad_blocks();
+
+      if((rv < 0) ||
+         (bad > opts.max_errors) ||
+         progress->cancelled())
+        {
+          for(size_t i = 0; i < jobs.size(); i++)
+            jobs[i]->progress.cancel();
+        }
+
+      progress->set_current(start_block + scan_jobs_processed(jobs));
+      progress->set_bad(bad);
+      progress->sum_requests(parts);
+
+      Time::sleep(0.1);
+    }
+
+  for(size_t i = 0; i < jobs.size(); i++)
+    {
+      if(!jobs[i]->started)
+        continue;
+
+      pthread_join(jobs[i]->thread,NULL);
+      if((jobs[i]->rv < 0) && (rv == 0))
+        rv = jobs[i]->rv;
+    }
+
+  progress->set_current(start_block + scan_jobs_processed(jobs));
+  progress->sum_requests(parts);
+
+  for(size_t i = 0; i < jobs.size(); i++)
+    {
+      badblocks.insert(badblocks.end(),
+                       jobs[i]->badblocks.begin(),
+                       jobs[i]->badblocks.end());
+      weakblocks.insert(weakblocks.end(),
+                        jobs[i]->weakblocks.begin(),
+                        jobs[i]->weakblocks.end());
+      delete jobs[i];
+    }
+
+  progress->set_bad(badblocks);
 
   return rv;
 }
@@ -120,60 +1101,325 @@ scan_loop(BlkDev                &blkdev,
 static
 AppError
 scan(BlkDev                &blkdev,
+
      const Options         &opts,
-     std::vector<uint64_t> &badblocks)
+     std::vector<uint64_t> &badblocks,
+     std::vector<uint64_t> &weakblocks,
+     std::ostream          &os,
+     Progress              *progress,
+     Journal               *journal)
 {
   int rv;
+  bool report;
   char *buf;
+  AsyncIO aio;
   uint64_t buflen;
+  Metrics metrics;
+  Progress local_progress;
+  ProgressReporter reporter;
+  Smart::Snapshot smart_before;
+  Smart::Snapshot smart_after;
   uint64_t start_block;
   uint64_t end_block;
   uint64_t stepping;
+  uint64_t max_stepping;
+  bool sequential;
+  bool ordered;
+  uint64_t ordered_blocks;
+  File::BlockVector segments;
+  SampleStats sample_stats = {0,0,0,0,0,0};
+
+  stepping     = ((opts.stepping == 0) ?
+                  blkdev.block_stepping() :
+                  opts.stepping);
+  max_stepping = (opts.adaptive ?
+                  AdaptiveStepping::limit(stepping,blkdev.logical_block_size()) :
+                  stepping);
+  buflen       = (max_stepping * blkdev.logical_block_size());
+
+  AdaptiveStepping adaptive(stepping,max_stepping);
 
-  stepping    = ((opts.stepping == 0) ?
-                 blkdev.block_stepping() :
-                 opts.stepping);
-  buflen      = (stepping * blkdev.logical_block_size());
   start_block = math::round_down(opts.start_block,stepping);
   end_block   = std::min(opts.end_block,blkdev.logical_block_count());
   end_block   = math::round_up(end_block,stepping);
   end_block   = std::min(end_block,blkdev.logical_block_count());
 
-  std::cout << "start block: "
-            << start_block << std::endl
-            << "end block: "
-            << end_block << std::endl
-            << "stepping: "
-            << stepping << std::endl
-            << "logical block size: "
-            << blkdev.logical_block_size() << std::endl
-            << "physical block size: "
-            << blkdev.physical_block_size() << std::endl
-            << "read size: "
-            << stepping << " blocks / "
-            << stepping * blkdev.logical_block_size() << " bytes"
-            << std::endl;
-
-  signals::alarm(1);
-
-  std::cout << "\r\x1B[2KScanning: "
-            << start_block
-            << " - "
-            << end_block
-            << std::endl;
-
-  buf = new char[buflen];
-  rv = scan_loop(blkdev,
-                 stepping,
-                 start_block,
-                 end_block,
-                 buf,
-                 buflen,
-                 badblocks,
-                 opts.max_errors);
-  delete[] buf;
-
-  std::cout << std::endl;
+  if(journal)
+    journal->set_end(end_block);
+
+  os << "start block: "
+     << start_block << std::endl
+     << "end block: "
+     << end_block << std::endl
+     << "stepping: "
+     << stepping << std::endl
+     << "logical block size: "
+     << blkdev.logical_block_size() << std::endl
+     << "physical block size: "
+     << blkdev.physical_block_size() << std::endl
+     << "read size: "
+     << stepping << " blocks / "
+     << stepping * blkdev.logical_block_size() << " bytes"
+     << std::endl;
+
+  if((opts.rwtype != Options::OS) && blkdev.nvme_nsid())
+    os << "nvme namespace: "
+       << blkdev.nvme_nsid()
+       << std::endl;
+  else if((opts.rwtype != Options::OS) && blkdev.is_scsi())
+    os << "scsi commands: READ(16) / WRITE(16) / VERIFY(16)"
+       << std::endl;
+  else if((opts.rwtype == Options::ATA) && blkdev.has_identity())
+    os << "ata transfer mode: "
+       << sg::xfer_mode_to_string(blkdev.ata_xfer())
+       << std::endl;
+
+  if(opts.adaptive)
+    os << "adaptive stepping: "
+       << stepping << " - " << max_stepping << " blocks"
+       << std::endl;
+
+  if(opts.sample > 0)
+    os << "sample: " << opts.sample << "% of the range" << std::endl;
+
+  sequential     = false;
+  ordered        = false;
+  ordered_blocks = (end_block - start_block);
+  if((opts.order != Options::ORDER_LBA) && (opts.sample == 0))
+    {
+      int64_t first;
+
+      first = ScanOrder::build(blkdev,opts.device,opts.order,stepping,
+                               start_block,end_block,opts.jobs,segments);
+      if(first < 0)
+        os << "Warning: unable to order scan ["
+           << Error::to_string(-first)
+           << "] - scanning in LBA order"
+           << std::endl;
+      else
+        os << "ordered: " << first << " blocks first in "
+           << segments.size() << " segments"
+           << std::endl;
+      ordered = (first > 0);
+    }
+  else if(opts.allocated_only)
+    {
+      int64_t blocks;
+
+      blocks = ScanOrder::allocated_only(blkdev,opts.device,stepping,
+                                         start_block,end_block,opts.jobs,
+                                         segments);
+      if(blocks < 0)
+        return AppError::runtime(-blocks,"unable to find allocated blocks");
+
+      os << "allocated: " << blocks << " of "
+         << (end_block - start_block) << " blocks in "
+         << segments.size() << " segments"
+         << std::endl;
+      ordered_blocks = blocks;
+      sequential     = true;
+      ordered        = true;
+    }
+  else if((opts.order == Options::ORDER_LBA) && (opts.sample == 0))
+    {
+      int zones;
+
+      zones = ScanOrder::zoned(blkdev,start_block,end_block,segments);
+      if(zones < 0)
+        os << "Warning: unable to report zones ["
+           << Error::to_string(-zones)
+           << "] - scanning the whole range"
+           << std::endl;
+
+      ordered_blocks = 0;
+      for(size_t i = 0; i < segments.size(); i++)
+        ordered_blocks += segments[i].length;
+
+      if(zones > 0)
+        os << "zones: " << zones
+           << " (" << ordered_blocks << " of "
+           << (end_block - start_block)
+           << " blocks written)"
+           << std::endl;
+      sequential = (zones > 0);
+      ordered    = sequential;
+    }
+
+  rv = -ENOTSUP;
+  if((opts.sample > 0) && ((opts.queue_depth > 1) || (opts.jobs > 1)))
+    {
+      os << "Warning: queue depth and jobs not supported when sampling"
+         << " - falling back to synchronous reads"
+         << std::endl;
+    }
+  else if((opts.queue_depth > 1) && !opts.adaptive)
+    {
+      rv = scan_aio_init(aio,blkdev,opts);
+      if(rv < 0)
+        os << "Warning: unable to setup async I/O ["
+           << Error::to_string(-rv)
+           << "] - falling back to synchronous reads"
+           << std::endl;
+    }
+  else if((opts.queue_depth > 1) && opts.adaptive)
+    {
+      os << "Warning: queue depth not supported with adaptive stepping"
+         << " - falling back to synchronous reads"
+         << std::endl;
+    }
+
+  if(rv == 0)
+    os << "async engine: "
+       << AsyncIO::backend_to_string(aio.backend())
+       << " (queue depth: " << aio.depth() << ")"
+       << std::endl;
+
+  report = (progress == NULL);
+  if(report)
+    progress = &local_progress;
+  if(ordered)
+    progress->set_range(0,ordered_blocks,blkdev.logical_block_size());
+  else
+    progress->set_range(start_block,end_block,blkdev.logical_block_size());
+  progress->set_bad(badblocks);
+
+  os << "\r\x1B[2KScanning: "
+     << start_block
+     << " - "
+     << end_block
+     << std::endl;
+
+  // with several devices MultiDevice reports for all of them
+  if(report && !opts.metrics_file.empty())
+    {
+      int err;
+
+      err = metrics.open(opts.metrics_file);
+      if(err < 0)
+        os << "Warning: unable to open metrics file "
+           << opts.metrics_file << " ["
+           << Error::to_string(-err)
+           << "]"
+           << std::endl;
+      else
+        metrics.add(opts.device,progress);
+      reporter.set_metrics(&metrics);
+    }
+
+  Smart::snapshot(blkdev,smart_before,progress);
+
+  if(report)
+    reporter.start(os,*progress);
+
+  if((opts.jobs > 1) && (opts.sample == 0) && !ordered)
+    {
+      aio.destroy();
+      rv = scan_jobs(blkdev,
+                     opts,
+                     stepping,
+                     max_stepping,
+                     start_block,
+                     end_block,
+                     (rv == 0),
+                     badblocks,
+                     weakblocks,
+                     os,
+                     progress);
+    }
+  else
+    {
+      buf = (char*)BufPool::get(buflen * std::max(aio.depth(),1U));
+      if(buf == NULL)
+        return AppError::runtime(ENOMEM,"unable to allocate buffer");
+
+      if(opts.sample > 0)
+        rv = scan_sample(blkdev,
+                         stepping,
+                         start_block,
+                         end_block,
+                         opts.sample,
+                         buf,
+                         buflen,
+                         badblocks,
+                         weakblocks,
+                         opts.slow_threshold / 1000.0,
+                         opts.max_errors,
+                         opts.localize,
+                         progress,
+                         sample_stats);
+      else if(ordered)
+        rv = scan_ordered(blkdev,
+                          aio,
+                          (rv == 0),
+                          stepping,
+                          segments,
+                          buf,
+                          buflen,
+                          badblocks,
+                          weakblocks,
+                          opts.slow_threshold / 1000.0,
+                          opts.max_errors,
+                          opts.localize,
+                          progress,
+                          sequential ? journal : NULL);
+      else if(rv == 0)
+        rv = scan_loop_async(blkdev,
+                             aio,
+                             stepping,
+                             start_block,
+                             end_block,
+                             buf,
+                             buflen,
+                             badblocks,
+                             weakblocks,
+                             opts.slow_threshold / 1000.0,
+                             opts.max_errors,
+                             opts.localize,
+                             progress,
+                             journal);
+      else
+        rv = scan_loop(blkdev,
+                       stepping,
+                       start_block,
+                       end_block,
+                       buf,
+                       buflen,
+                       badblocks,
+                       weakblocks,
+                       opts.slow_threshold / 1000.0,
+                       opts.max_errors,
+                       opts.localize,
+                       (opts.adaptive ? &adaptive : NULL),
+                       progress,
+                       journal);
+
+      BufPool::put(buf);
+    }
+
+  Smart::snapshot(blkdev,smart_after,progress);
+
+  if(report)
+    {
+      reporter.stop();
+      os << std::endl;
+    }
+
+  os << std::fixed << std::setprecision(3)
+     << "latency (ms): p50 " << (progress->latency_percentile(0.5) / 1000.0)
+     << "; p99 " << (progress->latency_percentile(0.99) / 1000.0)
+     << "; p99.9 " << (progress->latency_percentile(0.999) / 1000.0)
+     << "; max " << (progress->latency_percentile(1.0) / 1000.0)
+     << std::endl;
+
+  Smart::print(os,smart_before,smart_after);
+
+  if(opts.sample > 0)
+    print_sample_stats(os,sample_stats,stepping,start_block,end_block);
+
+  if(opts.slow_threshold)
+    os << "weak blocks: " << weakblocks.size()
+       << " (reads >= " << opts.slow_threshold << "ms)"
+       << std::endl;
 
   if(rv < 0)
     return AppError::runtime(-rv,"error when scanning drive");
@@ -182,36 +1428,74 @@ scan(BlkDev                &blkdev,
 }
 
 static
-void
-set_blkdev_rwtype(BlkDev                &blkdev,
-                  const Options::RWType  rwtype)
+BadBlockFile::Format
+output_format(const std::string     &filepath,
+              const Options::Format  format)
 {
-  switch(rwtype)
+  switch(format)
     {
-    case Options::ATA:
-      blkdev.set_rw_ata();
-      break;
-    case Options::OS:
-      blkdev.set_rw_os();
+    case Options::FORMAT_TEXT:
+      return BadBlockFile::TEXT;
+    case Options::FORMAT_BINARY:
+      return BadBlockFile::BINARY;
+    case Options::FORMAT_AUTO:
       break;
     }
+
+  return BadBlockFile::output_format(filepath,BadBlockFile::NONE);
+}
+
+/*
+  Paces requests to the device per --max-rate, --max-iops and
+  --latency-target and drops to the idle I/O class with --idle.
+*/
+static
+void
+set_blkdev_throttle(BlkDev        &blkdev,
+                    Throttle      &throttle,
+                    const Options &opts,
+                    std::ostream  &os)
+{
+  if(opts.idle)
+    {
+      int rv;
+
+      rv = Throttle::set_idle_priority();
+      if(rv < 0)
+        os << "Warning: unable to set idle I/O priority ["
+           << Error::to_string(-rv)
+           << "]"
+           << std::endl;
+    }
+
+  if(throttle.enabled())
+    blkdev.set_throttle(&throttle);
 }
 
 static
 AppError
-scan(const Options &opts)
+scan(const Options &opts,
+     std::ostream  &os,
+     Progress      *progress)
 {
   int rv;
   AppError err;
+  Throttle throttle(opts.max_rate * 1024 * 1024,
+                    opts.max_iops,
+                    opts.latency_target / 1000.0);
   BlkDev blkdev;
   std::string input_file;
   std::string output_file;
+  BadBlockSet known;
   std::vector<uint64_t> badblocks;
+  std::vector<uint64_t> weakblocks;
+  Options scan_opts(opts);
+  Journal journal;
 
   input_file  = opts.input_file;
   output_file = opts.output_file;
 
-  rv = blkdev.open_read(opts.device);
+  rv = blkdev.open_read(opts.device,opts.direct);
   if(rv < 0)
     return AppError::opening_device(-rv,opts.device);
 
@@ -221,19 +1505,61 @@ scan(const Options &opts)
   if(input_file.empty())
     input_file = output_file;
 
-  rv = BadBlockFile::read(input_file,badblocks);
+  rv = BadBlockFile::read(input_file,known,blkdev);
   if(rv > 0)
-    std::cout << "Imported bad blocks from " << input_file << std::endl;
+    os << "Imported bad blocks from " << input_file << std::endl;
+
+  BlkDevSetup::rwtype(blkdev,opts.rwtype);
+  BlkDevSetup::recovery(blkdev,opts,os);
+  set_blkdev_throttle(blkdev,throttle,opts,os);
+
+  if((opts.sample > 0) || (opts.order != Options::ORDER_LBA))
+    {
+      if(opts.resume)
+        os << "Warning: journal and resume not supported with --sample or --order" << std::endl;
+    }
+  else if(opts.jobs > 1)
+    {
+      if(opts.resume)
+        os << "Warning: journal and resume not supported with --jobs" << std::endl;
+    }
+  else
+    {
+      journal.begin(output_file,opts.resume,badblocks,scan_opts.start_block,os);
+    }
 
-  set_blkdev_rwtype(blkdev,opts.rwtype);
+  if(opts.stream)
+    journal.set_stream(&std::cout);
 
-  err = scan(blkdev,opts,badblocks);
+  err = scan(blkdev,scan_opts,badblocks,weakblocks,os,progress,&journal);
 
-  rv = BadBlockFile::write(output_file,badblocks);
+  // --jobs, --sample and --order only have their list at the end
+  journal.stream(badblocks);
+
+  known.insert(badblocks);
+  rv = BadBlockFile::write(output_file,
+                           known,
+                           blkdev,
+                           output_format(output_file,opts.format));
   if((rv < 0) && err.succeeded())
     err = AppError::writing_badblocks_file(-rv,output_file);
-  else if(!badblocks.empty())
-    std::cout << "Bad blocks written to " << output_file << std::endl;
+  else if(!known.empty())
+    os << "Bad blocks written to " << output_file << std::endl;
+
+  if((rv == 0) && journal.complete())
+    journal.remove();
+
+  if(!weakblocks.empty() && (output_file != "-"))
+    {
+      const std::string weak_file = (output_file + ".weak");
+
+      std::sort(weakblocks.begin(),weakblocks.end());
+      rv = BadBlockFile::write(weak_file,weakblocks);
+      if((rv < 0) && err.succeeded())
+        err = AppError::writing_badblocks_file(-rv,weak_file);
+      else if(rv == 0)
+        os << "Weak blocks written to " << weak_file << std::endl;
+    }
 
   rv = blkdev.close();
   if((rv < 0) && err.succeeded())
@@ -242,11 +1568,283 @@ scan(const Options &opts)
   return err;
 }
 
+/*
+  `scan` of a file or directory rather than a device. The extents of
+  the file, or of every file below the directory, are merged into
+  stepping aligned ranges of the filesystem's device and only those
+  are read, in LBA order. Bad blocks are reported with the files
+  holding them as whole disk LBAs, as find-files does, and written
+  to --output when given.
+*/
+static
+bool
+scan_target(const std::string &path_)
+{
+  struct stat st;
+
+  if(SimDev::is_sim(path_))
+    return false;
+  if(::stat(path_.c_str(),&st) == -1)
+    return false;
+
+  return (S_ISREG(st.st_mode) || S_ISDIR(st.st_mode));
+}
+
+static
+AppError
+scan_files(const Options &opts,
+           std::ostream  &os)
+{
+  int rv;
+  char *buf;
+  AsyncIO aio;
+  bool async;
+  uint64_t total;
+  uint64_t offset;
+  uint64_t buflen;
+  uint64_t stepping;
+  Throttle throttle(opts.max_rate * 1024 * 1024,
+                    opts.max_iops,
+                    opts.latency_target / 1000.0);
+  BlkDev blkdev;
+  struct stat st;
+  std::string devpath;
+  Progress summary;
+  ProgressReporter reporter;
+  BlockToFileMapper b2fm;
+  File::BlockVector ranges;
+  std::vector<Progress> progress;
+  std::vector<Progress*> parts;
+  std::vector<uint64_t> badblocks;
+  std::vector<uint64_t> weakblocks;
+  std::vector<BlockToFileMapper::Match> matches;
+
+  if(::stat(opts.device.c_str(),&st) == -1)
+    return AppError::opening_file(errno,opts.device);
+
+  devpath = FileToBlkDev::find(opts.device);
+  if(devpath.empty())
+    return AppError::opening_device(ENOENT,opts.device);
+
+  if(S_ISDIR(st.st_mode))
+    {
+      rv = b2fm.scan(opts.device,opts.jobs,opts.cache_file);
+      if(rv < 0)
+        return AppError::opening_file(-rv,opts.device);
+    }
+  else
+    {
+      File::BlockVector blocks;
+      std::vector<BlockToFileMapper::Extent> extents;
+
+      rv = File::blocks(opts.device,blocks);
+      if(rv < 0)
+        return AppError::opening_file(-rv,opts.device);
+
+      for(uint64_t i = 0, ei = blocks.size(); i != ei; i++)
+        {
+          BlockToFileMapper::Extent extent;
+
+          extent.start  = blocks[i].block;
+          extent.length = blocks[i].length;
+          extent.file   = 0;
+          extents.push_back(extent);
+        }
+
+      b2fm.load(std::vector<std::string>(1,opts.device),
+                extents,
+                std::max(File::lba_offset(opts.device),(int64_t)0));
+    }
+
+  rv = blkdev.open_read(devpath,opts.direct);
+  if(rv < 0)
+    return AppError::opening_device(-rv,devpath);
+
+  BlkDevSetup::rwtype(blkdev,opts.rwtype);
+  BlkDevSetup::recovery(blkdev,opts,os);
+  set_blkdev_throttle(blkdev,throttle,opts,os);
+
+  stepping = ((opts.stepping == 0) ? blkdev.block_stepping() : opts.stepping);
+  buflen   = (stepping * blkdev.logical_block_size());
+  offset   = b2fm.offset();
+
+  // the map is sorted by start so merging neighbours is one pass
+  total = 0;
+  for(uint64_t i = 0, ei = b2fm.size(); i != ei; i++)
+    {
+      File::Block range;
+      uint64_t end;
+
+      range.block = math::round_down(b2fm.start(i) - offset,stepping);
+      end         = math::round_up(b2fm.start(i) - offset + b2fm.length(i),stepping);
+      end         = std::min(end,blkdev.logical_block_count());
+      if(end <= range.block)
+        continue;
+
+      if(!ranges.empty() &&
+         (range.block <= (ranges.back().block + ranges.back().length)))
+        {
+          File::Block &last = ranges.back();
+
+          end = std::max(end,(last.block + last.length));
+          total -= last.length;
+          last.length = (end - last.block);
+          total += last.length;
+          continue;
+        }
+
+      range.length = (end - range.block);
+      total += range.length;
+      ranges.push_back(range);
+    }
+
+  os << "device: " << devpath << std::endl
+     << "files: " << opts.device << std::endl
+     << "ranges: " << ranges.size() << std::endl
+     << "blocks: " << total << std::endl
+     << "stepping: " << stepping << std::endl;
+
+  async = false;
+  if(opts.queue_depth > 1)
+    {
+      rv = scan_aio_init(aio,blkdev,opts);
+      if(rv < 0)
+        os << "Warning: unable to setup async I/O ["
+           << Error::to_string(-rv)
+           << "] - falling back to synchronous reads"
+           << std::endl;
+      async = (rv == 0);
+    }
+
+  buf = (char*)BufPool::get(buflen * std::max(aio.depth(),1U));
+  if(buf == NULL)
+    return AppError::runtime(ENOMEM,"unable to allocate buffer");
+
+  progress.resize(ranges.size());
+  for(uint64_t i = 0, ei = ranges.size(); i != ei; i++)
+    {
+      progress[i].set_range(ranges[i].block,
+                            ranges[i].block + ranges[i].length,
+                            blkdev.logical_block_size());
+      parts.push_back(&progress[i]);
+    }
+
+  reporter.start(os,parts,"Ranges");
+
+  rv = 0;
+  for(uint64_t i = 0, ei = ranges.size(); i != ei; i++)
+    {
+      std::vector<uint64_t> bad;
+      const uint64_t start = ranges[i].block;
+      const uint64_t end   = (start + ranges[i].length);
+
+      if(signals::signaled_to_exit())
+        break;
+
+      if(async)
+        rv = scan_loop_async(blkdev,aio,stepping,start,end,buf,buflen,
+                             bad,weakblocks,opts.slow_threshold / 1000.0,
+                             opts.max_errors,opts.localize,&progress[i],NULL);
+      else
+        rv = scan_loop(blkdev,stepping,start,end,buf,buflen,
+                       bad,weakblocks,opts.slow_threshold / 1000.0,
+                       opts.max_errors,opts.localize,NULL,&progress[i],NULL);
+      progress[i].finish();
+
+      badblocks.insert(badblocks.end(),bad.begin(),bad.end());
+      if((rv < 0) || (badblocks.size() > opts.max_errors))
+        break;
+    }
+
+  reporter.stop();
+  os << std::endl;
+
+  BufPool::put(buf);
+
+  summary.sum_requests(std::vector<const Progress*>(parts.begin(),parts.end()));
+  os << std::fixed << std::setprecision(3)
+     << "latency (ms): p50 " << (summary.latency_percentile(0.5) / 1000.0)
+     << "; p99 " << (summary.latency_percentile(0.99) / 1000.0)
+     << "; p99.9 " << (summary.latency_percentile(0.999) / 1000.0)
+     << "; max " << (summary.latency_percentile(1.0) / 1000.0)
+     << std::endl;
+
+  // whole disk LBAs from here on
+  for(uint64_t i = 0, ei = badblocks.size(); i != ei; i++)
+    badblocks[i] += offset;
+  for(uint64_t i = 0, ei = weakblocks.size(); i != ei; i++)
+    weakblocks[i] += offset;
+  std::sort(badblocks.begin(),badblocks.end());
+  badblocks.erase(std::unique(badblocks.begin(),badblocks.end()),badblocks.end());
+  std::sort(weakblocks.begin(),weakblocks.end());
+
+  os << "bad blocks: " << badblocks.size() << std::endl;
+  if(opts.slow_threshold)
+    os << "weak blocks: " << weakblocks.size()
+       << " (reads >= " << opts.slow_threshold << "ms)"
+       << std::endl;
+
+  b2fm.find_all(badblocks,matches);
+  for(uint64_t i = 0, j = 0, ei = badblocks.size(); i != ei; i++)
+    {
+      if((j == matches.size()) || (matches[j].first != badblocks[i]))
+        os << badblocks[i] << " [none]" << std::endl;
+      for(; (j < matches.size()) && (matches[j].first == badblocks[i]); j++)
+        os << badblocks[i] << " " << *matches[j].second << std::endl;
+    }
+
+  if(!opts.output_file.empty())
+    {
+      int err;
+
+      err = BadBlockFile::write(opts.output_file,badblocks);
+      if(err < 0)
+        return AppError::writing_badblocks_file(-err,opts.output_file);
+      os << "Bad blocks written to " << opts.output_file << std::endl;
+
+      if(!weakblocks.empty() && (opts.output_file != "-"))
+        BadBlockFile::write(opts.output_file + ".weak",weakblocks);
+    }
+
+  if(rv < 0)
+    return AppError::runtime(-rv,"error when scanning drive");
+
+  return AppError::success();
+}
+
+static
+AppError
+scan_worker(const Options &opts,
+            std::ostream  &os,
+            Progress      &progress)
+{
+  return ::scan(opts,os,&progress);
+}
+
 namespace bbf
 {
   AppError
   scan(const Options &opts)
   {
-    return ::scan(opts);
+    if(opts.devices.size() > 1)
+      return MultiDevice::run(opts,scan_worker);
+    if(scan_target(opts.device) && opts.stream)
+      return AppError::argument_invalid("stream not supported when scanning files");
+    if(scan_target(opts.device))
+      return scan_files(opts,std::cout);
+
+    // with --stream stdout carries only the bad blocks
+    return ::scan(opts,(opts.stream ? std::cerr : std::cout),NULL);
+  }
+
+  AppError
+  scan(const Options &opts,
+       std::ostream  &os,
+       Progress      &progress)
+  {
+    if(scan_target(opts.device))
+      return scan_files(opts,os);
+
+    return ::scan(opts,os,&progress);
   }
 }
@@ -18,11 +18,19 @@
 
 #pragma once
 
+#include <iosfwd>
+
 class AppError;
 class Options;
+class Progress;
 
 namespace bbf
 {
   AppError
   scan(const Options &opts);
+
+  AppError
+  scan(const Options &opts,
+       std::ostream  &os,
+       Progress      &progress);
 }
@@ -21,13 +21,17 @@
 #include "errors.hpp"
 #include "info.hpp"
 #include "math.hpp"
+#include "multidevice.hpp"
+#include "nvme.hpp"
 #include "options.hpp"
+#include "progress.hpp"
 #include "signals.hpp"
 #include "time.hpp"
 #include "sg.hpp"
 
 #include <cstdlib>
 #include <ctime>
+#include <fstream>
 #include <iomanip>
 #include <iostream>
 #include <string>
@@ -38,8 +42,68 @@
 
 static const uint64_t TIMEOUT_15_SECS = (15 * 1000);
 
+/*
+  Interactively the password is prompted for and the erase confirmed
+  by typing a random string. In batch mode (--password-file or
+  BBF_PASSWORD) both are skipped, the device captchas being the
+  confirmation, so every device given can be erased concurrently.
+
+  NVMe namespaces have no security password: the erase is a Format
+  NVM with User Data Erase, or Cryptographic Erase when enhanced,
+  keeping the namespace's LBA format, and is only confirmed.
+*/
+
 namespace l
 {
+  static const char PASSWORD_ENV[] = "BBF_PASSWORD";
+
+  /* 1 when a batch password was read, 0 if none was given */
+  static
+  int
+  batch_password(const Options &opts_,
+                 std::string   &password_)
+  {
+    const char *env;
+
+    if(!opts_.password_file.empty())
+      {
+        std::ifstream file;
+
+        file.open(opts_.password_file.c_str());
+        if(!file.good())
+          return ((errno != 0) ? -errno : -EIO);
+
+        std::getline(file,password_);
+        if(!password_.empty() && (password_[password_.size()-1] == '\r'))
+          password_.resize(password_.size() - 1);
+      }
+    else
+      {
+        env = ::getenv(PASSWORD_ENV);
+        if(env == NULL)
+          return 0;
+        password_ = env;
+      }
+
+    if(password_.empty() || (password_.size() > 32))
+      return -EINVAL;
+
+    return 1;
+  }
+
+  static
+  AppError
+  batch_password_error(const int            err_,
+                       const Options       &opts_)
+  {
+    if(err_ == 0)
+      return AppError::argument_required("password file or BBF_PASSWORD");
+    if(err_ == -EINVAL)
+      return AppError::argument_invalid("password must be 1 to 32 bytes");
+
+    return AppError::runtime(-err_,"unable to read " + opts_.password_file);
+  }
+
   static
   std::string
   random_str(void)
@@ -80,11 +144,65 @@ namespace l
 
   static
   AppError
-  security_erase(const BlkDev  &blkdev_,
-                 const Options &opts_,
-                 const bool     enhanced_)
+  nvme_format(const BlkDev      &blkdev_,
+              const bool         enhanced_,
+              const std::string &batch_password_,
+              std::ostream      &os_)
+  {
+    int rv;
+    double start;
+    std::string input;
+    std::string captcha;
+    nvme::identity ident;
+
+    rv = nvme::identify(blkdev_.fd(),ident,TIMEOUT_15_SECS);
+    if(rv < 0)
+      return AppError::runtime(-rv,"NVMe identify controller failed");
+    if(!ident.format)
+      return AppError::runtime(ENOTSUP,"format NVM not supported");
+    if(enhanced_ && !ident.format_crypto_erase)
+      return AppError::runtime(ENOTSUP,"cryptographic erase not supported");
+
+    os_ << "Format NVM secure erase: "
+        << (enhanced_ ? "cryptographic erase" : "user data erase")
+        << std::endl;
+
+    if(batch_password_.empty())
+      {
+        captcha = random_str();
+        std::cout << "Enter the following to confirm erase - '" << captcha << "': ";
+        std::getline(std::cin,input);
+        if(input != captcha)
+          return AppError::captcha(input,captcha);
+      }
+
+    os_ << "Security erase starting" << std::endl;
+
+    start = Time::get_monotonic();
+    rv = nvme::format(blkdev_.fd(),
+                      blkdev_.nvme_nsid(),
+                      (enhanced_ ?
+                       nvme::NVME_SES_CRYPTO_ERASE :
+                       nvme::NVME_SES_USER_DATA_ERASE),
+                      l::estimated_time(blkdev_));
+    if(rv < 0)
+      return AppError::runtime(-rv,"format NVM instruction failed");
+    os_ << "Security erase finished in "
+        << (uint64_t)((Time::get_monotonic() - start) / 60) << " minutes"
+        << std::endl;
+
+    return AppError::success();
+  }
+
+  static
+  AppError
+  security_erase(const BlkDev      &blkdev_,
+                 const bool         enhanced_,
+                 const std::string &batch_password_,
+                 std::ostream      &os_)
   {
     int rv;
+    double start;
     uint64_t reported_time;
     uint64_t estimated_time;
     uint64_t erase_time;
@@ -92,19 +210,24 @@ namespace l
     std::string captcha;
     std::string password;
 
+    if(blkdev_.nvme_nsid())
+      return l::nvme_format(blkdev_,enhanced_,batch_password_,os_);
+    if(blkdev_.has_identity() == false)
+      return AppError::runtime(ENOTSUP,"security erase requires an ATA or NVMe device");
     if(blkdev_.identity().security_frozen == true)
       return AppError::runtime(EBUSY,"Security frozen. Unable to continue.");
 
     reported_time  = l::reported_time(blkdev_,enhanced_);
     estimated_time = l::estimated_time(blkdev_);
     erase_time     = std::max(reported_time,estimated_time);
-    std::cout << "Security erase time: ~"
-              << (reported_time / (60 * 1000))
-              << " minutes (reported) & ~"
-              << (estimated_time / (60 * 1000))
-              << " minutes (estimated from 1s/30MB)"
-              << std::endl;
-
+    os_ << "Security erase time: ~"
+        << (reported_time / (60 * 1000))
+        << " minutes (reported) & ~"
+        << (estimated_time / (60 * 1000))
+        << " minutes (estimated from 1s/30MB)"
+        << std::endl;
+
+    password = batch_password_;
     while(password.empty())
       {
         std::cout << "Enter "
@@ -119,11 +242,14 @@ namespace l
 
     password.resize(32,'\0');
 
-    captcha = random_str();
-    std::cout << "Enter the following to confirm erase - '" << captcha << "': ";
-    std::getline(std::cin,input);
-    if(input != captcha)
-      return AppError::captcha(input,captcha);
+    if(batch_password_.empty())
+      {
+        captcha = random_str();
+        std::cout << "Enter the following to confirm erase - '" << captcha << "': ";
+        std::getline(std::cin,input);
+        if(input != captcha)
+          return AppError::captcha(input,captcha);
+      }
 
     if(blkdev_.identity().security_enabled == false)
       {
@@ -133,16 +259,17 @@ namespace l
                                        TIMEOUT_15_SECS);
         if(rv < 0)
           return AppError::runtime(-rv,"failed to set password");
-        std::cout << "Security password set successfully" << std::endl;
+        os_ << "Security password set successfully" << std::endl;
       }
 
     rv = sg::security_erase_prepare(blkdev_.fd(),TIMEOUT_15_SECS);
     if(rv < 0)
       return AppError::runtime(-rv,"security erase prepare instruction failed");
-     std::cout << "Security erase prepare command issued successfully" << std::endl;
+    os_ << "Security erase prepare command issued successfully" << std::endl;
 
-    std::cout << "Security erase starting" << std::endl;
+    os_ << "Security erase starting" << std::endl;
 
+    start = Time::get_monotonic();
     rv = sg::security_erase(blkdev_.fd(),
                             enhanced_ ? sg::SG_ERASE_ENHANCED : sg::SG_ERASE_NORMAL,
                             sg::SG_IDENTIFIER_USER,
@@ -150,20 +277,26 @@ namespace l
                             erase_time);
     if(rv < 0)
       return AppError::runtime(-rv,"security erase instruction failed");
-    std::cout << "Security erase finished" << std::endl;
+    os_ << "Security erase finished in "
+        << (uint64_t)((Time::get_monotonic() - start) / 60) << " minutes"
+        << std::endl;
 
     return AppError::success();
   }
 
   static
   AppError
-  security_erase(const Options &opts_,
-                 const bool     enhanced_)
+  security_erase(const Options     &opts_,
+                 const std::string &batch_password_,
+                 std::ostream      &os_)
   {
     int rv;
+    bool enhanced;
     AppError err;
     BlkDev blkdev;
 
+    enhanced = (opts_.instruction == Options::ENHANCED_SECURITY_ERASE);
+
     rv = blkdev.open_read(opts_.device);
     if(rv < 0)
       return AppError::opening_device(-rv,opts_.device);
@@ -172,7 +305,7 @@ namespace l
     if(opts_.captcha != captcha)
       return AppError::captcha(opts_.captcha,captcha);
 
-    err = l::security_erase(blkdev,opts_,enhanced_);
+    err = l::security_erase(blkdev,enhanced,batch_password_,os_);
 
     rv = blkdev.close();
     if((rv < 0) && err.succeeded())
@@ -180,6 +313,46 @@ namespace l
 
     return err;
   }
+
+  /* workers only run in batch mode so the password is at hand */
+  static
+  AppError
+  security_erase_worker(const Options &opts_,
+                        std::ostream  &os_,
+                        Progress      &progress_)
+  {
+    int rv;
+    AppError err;
+    std::string password;
+
+    rv = l::batch_password(opts_,password);
+    if(rv <= 0)
+      return l::batch_password_error(rv,opts_);
+
+    progress_.set_range(0,1,0);
+    err = l::security_erase(opts_,password,os_);
+    if(err.succeeded())
+      progress_.set_current(1);
+
+    return err;
+  }
+
+  static
+  AppError
+  security_erase(const Options &opts_)
+  {
+    int rv;
+    std::string password;
+
+    rv = l::batch_password(opts_,password);
+    if((rv < 0) || ((rv == 0) && (opts_.devices.size() > 1)))
+      return l::batch_password_error(rv,opts_);
+
+    if(opts_.devices.size() > 1)
+      return MultiDevice::run(opts_,l::security_erase_worker);
+
+    return l::security_erase(opts_,password,std::cout);
+  }
 }
 
 namespace bbf
@@ -187,12 +360,12 @@ namespace bbf
   AppError
   security_erase(const Options &opts_)
   {
-    return l::security_erase(opts_,false);
+    return l::security_erase(opts_);
   }
 
   AppError
   enhanced_security_erase(const Options &opts_)
   {
-    return l::security_erase(opts_,true);
+    return l::security_erase(opts_);
   }
 }
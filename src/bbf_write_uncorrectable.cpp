@@ -17,70 +17,104 @@
 */
 
 #include "badblockfile.hpp"
+#include "badblockset.hpp"
 #include "blkdev.hpp"
 #include "captcha.hpp"
 #include "errors.hpp"
+#include "multidevice.hpp"
 #include "options.hpp"
+#include "progress.hpp"
 
+#include <algorithm>
 #include <iostream>
 #include <utility>
 #include <vector>
 
 #include <stdint.h>
 
+#define MAX_UNC_BLOCKS 65536
+
 namespace l
 {
-  static
-  int
-  write_pseudo_uncorrectable_loop(BlkDev                      &blkdev_,
-                                  const bool                   logging_,
-                                  const std::vector<uint64_t> &badblocks_)
-  {
-    int rv;
-    int error;
-
-    error = 0;
-    for(uint64_t i = 0, ei = badblocks_.size(); i != ei; ++i)
-      {
-        rv = blkdev_.write_pseudo_uncorrectable(badblocks_[i],logging_);
-        if(rv < 0)
-          error = rv;
-      }
-
-    return error;
-  }
+  typedef int (BlkDev::*MarkFunc)(const uint64_t,const uint64_t,const bool);
 
+  /*
+    WRITE UNCORRECTABLE EXT takes a sector count so each run of
+    contiguous bad blocks is marked with one command per 65536
+    sectors rather than one per block.
+  */
   static
   int
-  write_flagged_uncorrectable_loop(BlkDev                      &blkdev_,
-                                   const bool                   logging_,
-                                   const std::vector<uint64_t> &badblocks_)
+  write_uncorrectable_loop(BlkDev            &blkdev_,
+                           const MarkFunc     func_,
+                           const bool         logging_,
+                           const BadBlockSet &badblocks_,
+                           std::ostream      &os_,
+                           Progress          *progress_)
   {
     int rv;
     int error;
-
-    error = 0;
-    for(uint64_t i = 0, ei = badblocks_.size(); i != ei; ++i)
+    uint64_t done;
+    uint64_t total;
+    uint64_t marked;
+    uint64_t commands;
+    const std::vector<BadBlockFile::Run> &runs = badblocks_.runs();
+
+    total = badblocks_.size();
+    if(progress_ != NULL)
+      progress_->set_range(0,total,blkdev_.logical_block_size());
+
+    done     = 0;
+    error    = 0;
+    marked   = 0;
+    commands = 0;
+    for(uint64_t i = 0, ei = runs.size(); i != ei; ++i)
       {
-        rv = blkdev_.write_flagged_uncorrectable(badblocks_[i],logging_);
-        if(rv < 0)
-          error = rv;
+        uint64_t n;
+        const uint64_t end = (runs[i].start + runs[i].length);
+
+        for(uint64_t block = runs[i].start; block < end; block += n)
+          {
+            n  = std::min((uint64_t)MAX_UNC_BLOCKS,(end - block));
+            rv = (blkdev_.*func_)(block,n,logging_);
+            if(rv < 0)
+              {
+                error = rv;
+                os_ << "Marking " << ((n == 1) ? "block " : "blocks ") << block;
+                if(n > 1)
+                  os_ << '-' << (block + n - 1);
+                os_ << " failed [" << Error::to_string(-rv) << "]\n";
+              }
+            else
+              {
+                marked += n;
+              }
+
+            commands++;
+            done += n;
+            if(progress_ != NULL)
+              progress_->set_current(done);
+          }
       }
 
+    os_ << "Marked " << marked << " of " << total << " blocks in "
+        << runs.size() << " runs using "
+        << commands << " commands" << std::endl;
+
     return error;
   }
-}
 
-namespace bbf
-{
+  static
   AppError
-  write_uncorrectable(const Options &opts_)
+  write_uncorrectable(const Options &opts_,
+                      std::ostream  &os_,
+                      Progress      *progress_)
   {
     int rv;
     BlkDev blkdev;
     std::string captcha;
     std::string input_file;
-    std::vector<uint64_t> badblocks;
+    BadBlockSet badblocks;
 
     input_file = opts_.input_file;
 
@@ -95,23 +129,29 @@ namespace bbf
     if(input_file.empty())
       input_file = BadBlockFile::filepath(blkdev);
 
-    rv = BadBlockFile::read(opts_.input_file,badblocks);
+    rv = BadBlockFile::read(input_file,badblocks,blkdev);
     if(rv < 0)
-      return AppError::reading_badblocks_file(-rv,opts_.input_file);
+      return AppError::reading_badblocks_file(-rv,input_file);
 
     switch(opts_.instruction)
       {
       case Options::WRITE_PSEUDO_UNCORRECTABLE_WL:
-        l::write_pseudo_uncorrectable_loop(blkdev,true,badblocks);
+        l::write_uncorrectable_loop(blkdev,&BlkDev::write_pseudo_uncorrectable,
+                                    true,badblocks,os_,progress_);
         break;
       case Options::WRITE_PSEUDO_UNCORRECTABLE_WOL:
-        l::write_pseudo_uncorrectable_loop(blkdev,false,badblocks);
+        l::write_uncorrectable_loop(blkdev,&BlkDev::write_pseudo_uncorrectable,
+                                    false,badblocks,os_,progress_);
         break;
       case Options::WRITE_FLAGGED_UNCORRECTABLE_WL:
-        l::write_flagged_uncorrectable_loop(blkdev,true,badblocks);
+        l::write_uncorrectable_loop(blkdev,&BlkDev::write_flagged_uncorrectable,
+                                    true,badblocks,os_,progress_);
         break;
       case Options::WRITE_FLAGGED_UNCORRECTABLE_WOL:
-        l::write_flagged_uncorrectable_loop(blkdev,false,badblocks);
+        l::write_uncorrectable_loop(blkdev,&BlkDev::write_flagged_uncorrectable,
+                                    false,badblocks,os_,progress_);
+        break;
+      default:
         break;
       }
 
@@ -121,4 +161,25 @@ namespace bbf
 
     return AppError::success();
   }
+
+  static
+  AppError
+  write_uncorrectable_worker(const Options &opts_,
+                             std::ostream  &os_,
+                             Progress      &progress_)
+  {
+    return l::write_uncorrectable(opts_,os_,&progress_);
+  }
+}
+
+namespace bbf
+{
+  AppError
+  write_uncorrectable(const Options &opts_)
+  {
+    if(opts_.devices.size() > 1)
+      return MultiDevice::run(opts_,l::write_uncorrectable_worker);
+
+    return l::write_uncorrectable(opts_,std::cout,NULL);
+  }
 }
@@ -17,7 +17,11 @@
 */
 
 #include "blkdev.hpp"
+#include "devinfocache.hpp"
 #include "ioctl.hpp"
+#include "nvme.hpp"
+#include "scsi.hpp"
+#include "time.hpp"
 
 #include <string>
 
@@ -26,10 +30,14 @@
 #include <stdint.h>
 #include <sys/stat.h>
 #include <sys/types.h>
+#include <sys/uio.h>
 #include <unistd.h>
 
 #define SECONDS(x) ((x) * 1000)
 
+/* a drive which is going to answer IDENTIFY does so in milliseconds */
+#define IDENTIFY_TIMEOUT SECONDS(10)
+
 namespace l
 {
   static
@@ -54,42 +62,62 @@ void
 BlkDev::_reset_data(void)
 {
   _fd                   = -1;
+  _sim                  = NULL;
   _logical_block_size   =  0;
   _physical_block_size  =  0;
   _size_in_bytes        =  0;
   _logical_block_count  =  0;
   _physical_block_count =  0;
   _timeout              =  SECONDS(60);
+  _nvme_nsid            =  0;
   _has_identity         =  false;
+  _identity_probed      =  false;
+  _scsi                 =  false;
+  _ata_xfer             =  SG_PIO;
+  _ata_xfer_verified    =  false;
+  _erc_saved            =  false;
+  _erc_read             =  0;
+  _erc_write            =  0;
 }
 
 BlkDev::BlkDev()
-  : _rw_type(OS)
+  : _rw_type(OS),
+    _throttle(NULL),
+    _fua(false)
 {
+  pthread_mutex_init(&_identity_lock,NULL);
   _reset_data();
 }
 
 BlkDev::~BlkDev()
 {
+  restore_error_recovery();
   if(_fd != -1)
     ::close(_fd);
+  delete _sim;
+  pthread_mutex_destroy(&_identity_lock);
 }
 
 int
-BlkDev::open_read(const std::string &path)
+BlkDev::open_read(const std::string &path,
+                  const bool         direct)
 {
-  const int flags = O_RDONLY|O_NONBLOCK;
+  int flags = O_RDONLY|O_NONBLOCK;
+
+  flags |= (direct ? O_DIRECT : 0);
 
   return open(path,flags);
 }
 
 int
 BlkDev::open_rdwr(const std::string &path,
-                  const bool         excl)
+                  const bool         excl,
+                  const bool         direct)
 {
   int flags = O_RDWR|O_NONBLOCK;
 
   flags |= (excl ? O_EXCL : 0);
+  flags |= (direct ? O_DIRECT : 0);
 
   return open(path,flags);
 }
@@ -100,6 +128,9 @@ BlkDev::open(const std::string &path,
 {
   int64_t rv;
 
+  if(SimDev::is_sim(path))
+    return open_sim(path,flags);
+
   _fd = ::open(path.c_str(),flags);
   if(_fd == -1)
     return -errno;
@@ -108,10 +139,6 @@ BlkDev::open(const std::string &path,
   if(rv < 0)
     goto error;
 
-  rv = sg::identify(_fd,_identity);
-  if(rv == 0)
-    _has_identity = true;
-
   rv = IOCtl::logical_block_size(_fd);
   if(rv < 0)
     goto error;
@@ -130,7 +157,13 @@ BlkDev::open(const std::string &path,
   _logical_block_count  = (_size_in_bytes / _logical_block_size);
   _physical_block_count = (_size_in_bytes / _physical_block_size);
 
-  ::posix_fadvise(_fd,0,_size_in_bytes,POSIX_FADV_DONTNEED);
+  rv = nvme::nsid(_fd);
+  if(rv > 0)
+    _nvme_nsid = rv;
+
+  // O_DIRECT bypasses the page cache so there's nothing to drop
+  if(!(flags & O_DIRECT))
+    ::posix_fadvise(_fd,0,_size_in_bytes,POSIX_FADV_DONTNEED);
 
   return 0;
 
@@ -142,6 +175,89 @@ BlkDev::open(const std::string &path,
   return rv;
 }
 
+/*
+  The image is a regular file so O_EXCL means nothing and O_DIRECT
+  is dropped to keep it off filesystems (tmpfs) which refuse it.
+*/
+int
+BlkDev::open_sim(const std::string &path_,
+                 const int          flags_)
+{
+  int rv;
+  const std::string image = SimDev::image_path(path_);
+
+  _fd = ::open(image.c_str(),(flags_ & ~(O_EXCL|O_DIRECT|O_NONBLOCK)));
+  if(_fd == -1)
+    return -errno;
+
+  _sim = new SimDev();
+  rv   = _sim->load(image,_fd);
+  if(rv < 0)
+    {
+      ::close(_fd);
+      delete _sim;
+      _reset_data();
+      return rv;
+    }
+
+  _logical_block_size   = _sim->logical_block_size();
+  _physical_block_size  = _sim->physical_block_size();
+  _size_in_bytes        = _sim->size_in_bytes();
+  _logical_block_count  = (_size_in_bytes / _logical_block_size);
+  _physical_block_count = (_size_in_bytes / _physical_block_size);
+
+  ::posix_fadvise(_fd,0,_size_in_bytes,POSIX_FADV_DONTNEED);
+
+  return 0;
+}
+
+/*
+  IDENTIFY DEVICE is sent the first time the identity is needed,
+  rather than on open, and its response kept in DevInfoCache so the
+  next run doesn't have to ask again. Commands which never look at
+  the identity, or only do so once the device is known to answer,
+  don't wait on a drive or bridge which doesn't. Simulated and NVMe
+  devices have no ATA identity. A device which doesn't identify but
+  answers INQUIRY as a disk is driven with native SCSI commands.
+*/
+void
+BlkDev::probe_identity(void) const
+{
+  int rv;
+  char buf[512];
+
+  if(__atomic_load_n(&_identity_probed,__ATOMIC_ACQUIRE))
+    return;
+  if(_fd == -1)
+    return;
+
+  pthread_mutex_lock(&_identity_lock);
+  if(!_identity_probed && (_sim == NULL) && (_nvme_nsid == 0))
+    {
+      if(!DevInfoCache::load(_fd,rv,buf))
+        {
+          rv = sg::identify(_fd,buf,IDENTIFY_TIMEOUT);
+          DevInfoCache::store(_fd,rv,buf);
+        }
+
+      if(rv == 0)
+        {
+          sg::buf_to_identity(buf,_identity);
+          _has_identity = true;
+          _ata_xfer     = sg::xfer_mode(_identity);
+        }
+      else
+        {
+          uint8_t type;
+
+          rv = scsi::inquiry(_fd,type,IDENTIFY_TIMEOUT);
+          _scsi = ((rv == 0) && (type == 0x00));
+        }
+    }
+  __atomic_store_n(&_identity_probed,true,__ATOMIC_RELEASE);
+  pthread_mutex_unlock(&_identity_lock);
+}
+
 int
 BlkDev::close(void)
 {
@@ -150,7 +266,10 @@ BlkDev::close(void)
   if(_fd == -1)
     return 0;
 
+  restore_error_recovery();
+
   rv = ::close(_fd);
+  delete _sim;
 
   _reset_data();
 
@@ -161,7 +280,8 @@ int64_t
 BlkDev::os_read(const uint64_t  lba_,
                 const uint64_t  blocks_,
                 void           *buf_,
-                const uint64_t  buflen_)
+                const uint64_t  buflen_,
+                uint64_t       *failed_lba_)
 {
   int64_t rv;
   uint64_t len;
@@ -171,6 +291,9 @@ BlkDev::os_read(const uint64_t  lba_,
   len    = std::min((blocks_ * _logical_block_size),len);
   offset = (lba_ * _logical_block_size);
 
+  if(_sim)
+    return sim_io(false,lba_,(len / _logical_block_size),buf_,failed_lba_);
+
   rv = ::pread(_fd,buf_,len,offset);
   if(rv == -1)
     return -errno;
@@ -192,6 +315,12 @@ BlkDev::os_write(const uint64_t  lba_,
   len    = std::min((blocks_ * _logical_block_size),len);
   offset = (lba_ * _logical_block_size);
 
+  if(_sim)
+    return sim_io(true,lba_,(len / _logical_block_size),(void*)buf_);
+
+  if(_fua)
+    return os_write_fua(buf_,len,offset);
+
   rv = ::pwrite(_fd,buf_,len,offset);
   if(rv == -1)
     return -errno;
@@ -199,20 +328,133 @@ BlkDev::os_write(const uint64_t  lba_,
   return (rv / _logical_block_size);
 }
 
+int64_t
+BlkDev::sim_io(const bool      write_,
+               const uint64_t  lba_,
+               const uint64_t  blocks_,
+               void           *buf_,
+               uint64_t       *failed_lba_)
+{
+  int64_t rv;
+  double delay;
+
+  rv = _sim->io(_fd,write_,lba_,blocks_,buf_,failed_lba_);
+
+  delay = _sim->latency(lba_,blocks_);
+  if(delay > 0)
+    Time::sleep(delay);
+
+  return rv;
+}
+
+/*
+  RWF_DSYNC makes the block layer send the write with FUA when the
+  device supports it and follow it with a cache flush when it doesn't.
+  Kernels without pwritev2 get a plain write and fdatasync.
+*/
+int64_t
+BlkDev::os_write_fua(const void     *buf_,
+                     const uint64_t  len_,
+                     const off_t     offset_)
+{
+  ssize_t rv;
+  struct iovec iov;
+
+  iov.iov_base = (void*)buf_;
+  iov.iov_len  = len_;
+
+  rv = ::pwritev2(_fd,&iov,1,offset_,RWF_DSYNC);
+  if((rv == -1) && ((errno == ENOSYS) || (errno == EOPNOTSUPP)))
+    {
+      rv = ::pwrite(_fd,buf_,len_,offset_);
+      if((rv != -1) && (::fdatasync(_fd) == -1))
+        rv = -1;
+    }
+  if(rv == -1)
+    return -errno;
+
+  return (rv / _logical_block_size);
+}
+
+/*
+  The DMA / NCQ transfer mode picked from IDENTIFY isn't guaranteed to
+  work through every HBA or USB bridge. Until a command in that mode
+  has succeeded once the drive or bridge refusing it steps down (ncq
+  -> dma -> pio) and the request is retried. After that, and for any
+  other error such as a medium error, errors are returned as is.
+*/
+bool
+BlkDev::ata_xfer_downgrade(const int xfer_)
+{
+  int next;
+  int expected;
+
+  if(__atomic_load_n(&_ata_xfer_verified,__ATOMIC_RELAXED))
+    return false;
+
+  switch(xfer_)
+    {
+    case SG_FPDMA:
+      next = SG_DMA;
+      break;
+    case SG_DMA:
+      next = SG_PIO;
+      break;
+    default:
+      return false;
+    }
+
+  expected = xfer_;
+  __atomic_compare_exchange_n(&_ata_xfer,&expected,next,false,
+                              __ATOMIC_RELAXED,__ATOMIC_RELAXED);
+
+  return true;
+}
+
 int64_t
 BlkDev::ata_read(const uint64_t  lba_,
                  const uint64_t  blocks_,
                  void           *buf_,
-                 const uint64_t  buflen_)
+                 const uint64_t  buflen_,
+                 uint64_t       *failed_lba_)
+{
+  int rv;
+  int xfer;
+
+  do
+    {
+      xfer = __atomic_load_n(&_ata_xfer,__ATOMIC_RELAXED);
+      rv   = sg::read_block(_fd,
+                            lba_,
+                            blocks_,
+                            buf_,
+                            buflen_,
+                            _timeout,
+                            xfer,
+                            failed_lba_);
+    }
+  while((rv < 0) && sg::command_refused(rv) && ata_xfer_downgrade(xfer));
+
+  if(rv < 0)
+    return rv;
+
+  __atomic_store_n(&_ata_xfer_verified,true,__ATOMIC_RELAXED);
+
+  return blocks_;
+}
+
+int64_t
+BlkDev::ata_verify(const uint64_t  lba_,
+                   const uint64_t  blocks_,
+                   uint64_t       *failed_lba_)
 {
   int rv;
 
-  rv = sg::read_block(_fd,
-                      lba_,
-                      blocks_,
-                      buf_,
-                      buflen_,
-                      _timeout);
+  rv = sg::verify_block(_fd,
+                        lba_,
+                        blocks_,
+                        _timeout,
+                        failed_lba_);
   if(rv < 0)
     return rv;
 
@@ -226,13 +468,150 @@ BlkDev::ata_write(const uint64_t  lba_,
                   const uint64_t  buflen_)
 {
   int rv;
+  int xfer;
+
+  do
+    {
+      xfer = __atomic_load_n(&_ata_xfer,__ATOMIC_RELAXED);
+      rv   = sg::write_block(_fd,
+                             lba_,
+                             blocks_,
+                             buf_,
+                             buflen_,
+                             _timeout,
+                             xfer,
+                             _fua);
+    }
+  while((rv < 0) && sg::command_refused(rv) && ata_xfer_downgrade(xfer));
 
-  rv = sg::write_block(_fd,
-                       lba_,
-                       blocks_,
-                       buf_,
-                       buflen_,
-                       _timeout);
+  if(rv < 0)
+    return rv;
+
+  if(_fua && (xfer == SG_PIO))
+    {
+      rv = sg::flush_write_cache(_fd,_timeout);
+      if(rv < 0)
+        return rv;
+    }
+
+  __atomic_store_n(&_ata_xfer_verified,true,__ATOMIC_RELAXED);
+
+  return blocks_;
+}
+
+/*
+  An NVMe namespace or SCSI disk has no ATA passthrough so the ATA
+  modes select the equivalent NVMe commands sent through
+  NVME_IOCTL_IO_CMD or READ(16) / WRITE(16) / VERIFY(16).
+*/
+void
+BlkDev::set_rw_ata(void)
+{
+  if(_nvme_nsid)
+    {
+      _rw_type = NVME;
+      return;
+    }
+
+  probe_identity();
+  _rw_type = (_scsi ? SCSI : ATA);
+}
+
+void
+BlkDev::set_rw_verify(void)
+{
+  if(_nvme_nsid)
+    {
+      _rw_type = NVME_VERIFY;
+      return;
+    }
+
+  probe_identity();
+  _rw_type = (_scsi ? SCSI_VERIFY : ATA_VERIFY);
+}
+
+int64_t
+BlkDev::nvme_read(const uint64_t  lba_,
+                  const uint64_t  blocks_,
+                  void           *buf_,
+                  const uint64_t  buflen_)
+{
+  int rv;
+
+  rv = nvme::read(_fd,_nvme_nsid,lba_,blocks_,buf_,buflen_,_timeout);
+  if(rv < 0)
+    return rv;
+
+  return blocks_;
+}
+
+int64_t
+BlkDev::nvme_verify(const uint64_t lba_,
+                    const uint64_t blocks_)
+{
+  int rv;
+
+  rv = nvme::verify(_fd,_nvme_nsid,lba_,blocks_,_timeout);
+  if(rv < 0)
+    return rv;
+
+  return blocks_;
+}
+
+int64_t
+BlkDev::nvme_write(const uint64_t  lba_,
+                   const uint64_t  blocks_,
+                   const void     *buf_,
+                   const uint64_t  buflen_)
+{
+  int rv;
+
+  rv = nvme::write(_fd,_nvme_nsid,lba_,blocks_,buf_,buflen_,_fua,_timeout);
+  if(rv < 0)
+    return rv;
+
+  return blocks_;
+}
+
+int64_t
+BlkDev::scsi_read(const uint64_t  lba_,
+                  const uint64_t  blocks_,
+                  void           *buf_,
+                  const uint64_t  buflen_,
+                  uint64_t       *failed_lba_)
+{
+  int rv;
+
+  rv = scsi::read(_fd,lba_,blocks_,buf_,buflen_,_timeout,failed_lba_);
+  if(rv < 0)
+    return rv;
+
+  return blocks_;
+}
+
+int64_t
+BlkDev::scsi_verify(const uint64_t  lba_,
+                    const uint64_t  blocks_,
+                    uint64_t       *failed_lba_)
+{
+  int rv;
+
+  rv = scsi::verify(_fd,lba_,blocks_,_timeout,failed_lba_);
+  if(rv < 0)
+    return rv;
+
+  return blocks_;
+}
+
+int64_t
+BlkDev::scsi_write(const uint64_t  lba_,
+                   const uint64_t  blocks_,
+                   const void     *buf_,
+                   const uint64_t  buflen_)
+{
+  int rv;
+
+  rv = scsi::write(_fd,lba_,blocks_,buf_,buflen_,_timeout,_fua);
   if(rv < 0)
     return rv;
 
@@ -245,15 +624,31 @@ BlkDev::read(const uint64_t  lba_,
              void           *buf_,
              const uint64_t  buflen_)
 {
-  switch(_rw_type)
-    {
-    case ATA:
-      return ata_read(lba_,blocks_,buf_,buflen_);
-    case OS:
-      return os_read(lba_,blocks_,buf_,buflen_);
-    }
+  uint64_t failed_lba;
 
-  return -ENOTSUP;
+  return read(lba_,blocks_,buf_,buflen_,failed_lba);
+}
+
+int64_t
+BlkDev::read(const uint64_t  lba_,
+             const uint64_t  blocks_,
+             void           *buf_,
+             const uint64_t  buflen_,
+             uint64_t       &failed_lba_)
+{
+  Request req;
+
+  req.lba    = lba_;
+  req.blocks = blocks_;
+  req.buf    = buf_;
+  req.buflen = buflen_;
+  req.op     = READ;
+
+  submit(&req,1);
+
+  failed_lba_ = req.failed_lba;
+
+  return req.rv;
 }
 
 int64_t
@@ -261,16 +656,149 @@ BlkDev::write(const uint64_t  lba_,
               const uint64_t  blocks_,
               const void     *buf_,
               const uint64_t  buflen_)
+{
+  Request req;
+
+  req.lba    = lba_;
+  req.blocks = blocks_;
+  req.buf    = const_cast<void*>(buf_);
+  req.buflen = buflen_;
+  req.op     = WRITE;
+
+  submit(&req,1);
+
+  return req.rv;
+}
+
+/*
+  submit() backends, one per RWType. Verify backends write as their
+  read / write counterpart does.
+*/
+namespace l
+{
+  struct OSRW
+  {
+    static int64_t read(BlkDev &b_, BlkDev::Request &r_)
+    { return b_.os_read(r_.lba,r_.blocks,r_.buf,r_.buflen,&r_.failed_lba); }
+    static int64_t write(BlkDev &b_, BlkDev::Request &r_)
+    { return b_.os_write(r_.lba,r_.blocks,r_.buf,r_.buflen); }
+  };
+
+  struct ATARW
+  {
+    static int64_t read(BlkDev &b_, BlkDev::Request &r_)
+    { return b_.ata_read(r_.lba,r_.blocks,r_.buf,r_.buflen,&r_.failed_lba); }
+    static int64_t write(BlkDev &b_, BlkDev::Request &r_)
+    { return b_.ata_write(r_.lba,r_.blocks,r_.buf,r_.buflen); }
+  };
+
+  struct ATAVerifyRW : public ATARW
+  {
+    static int64_t read(BlkDev &b_, BlkDev::Request &r_)
+    { return b_.ata_verify(r_.lba,r_.blocks,&r_.failed_lba); }
+  };
+
+  struct NVMeRW
+  {
+    static int64_t read(BlkDev &b_, BlkDev::Request &r_)
+    { return b_.nvme_read(r_.lba,r_.blocks,r_.buf,r_.buflen); }
+    static int64_t write(BlkDev &b_, BlkDev::Request &r_)
+    { return b_.nvme_write(r_.lba,r_.blocks,r_.buf,r_.buflen); }
+  };
+
+  struct NVMeVerifyRW : public NVMeRW
+  {
+    static int64_t read(BlkDev &b_, BlkDev::Request &r_)
+    { return b_.nvme_verify(r_.lba,r_.blocks); }
+  };
+
+  struct SCSIRW
+  {
+    static int64_t read(BlkDev &b_, BlkDev::Request &r_)
+    { return b_.scsi_read(r_.lba,r_.blocks,r_.buf,r_.buflen,&r_.failed_lba); }
+    static int64_t write(BlkDev &b_, BlkDev::Request &r_)
+    { return b_.scsi_write(r_.lba,r_.blocks,r_.buf,r_.buflen); }
+  };
+
+  struct SCSIVerifyRW : public SCSIRW
+  {
+    static int64_t read(BlkDev &b_, BlkDev::Request &r_)
+    { return b_.scsi_verify(r_.lba,r_.blocks,&r_.failed_lba); }
+  };
+
+  template<typename RW>
+  static
+  uint64_t
+  submit(BlkDev          &blkdev_,
+         Throttle        *throttle_,
+         BlkDev::Request *reqs_,
+         const uint64_t   count_)
+  {
+    double start;
+    uint64_t failed;
+    const uint64_t lbs = blkdev_.logical_block_size();
+
+    failed = 0;
+    for(uint64_t i = 0; i < count_; i++)
+      {
+        BlkDev::Request &req = reqs_[i];
+
+        req.failed_lba = BlkDev::UNKNOWN_LBA;
+
+        start = 0;
+        if(throttle_ != NULL)
+          {
+            throttle_->wait(req.blocks * lbs);
+            start = Time::get_monotonic();
+          }
+
+        req.rv = ((req.op == BlkDev::READ) ?
+                  RW::read(blkdev_,req) :
+                  RW::write(blkdev_,req));
+
+        if(throttle_ != NULL)
+          throttle_->observe(Time::get_monotonic() - start);
+
+        if(req.rv <= 0)
+          failed++;
+      }
+
+    return failed;
+  }
+}
+
+uint64_t
+BlkDev::submit(Request        *reqs_,
+               const uint64_t  count_)
 {
   switch(_rw_type)
     {
     case ATA:
-      return ata_write(lba_,blocks_,buf_,buflen_);
+      return l::submit<l::ATARW>(*this,_throttle,reqs_,count_);
+    case ATA_VERIFY:
+      return l::submit<l::ATAVerifyRW>(*this,_throttle,reqs_,count_);
+    case NVME:
+      return l::submit<l::NVMeRW>(*this,_throttle,reqs_,count_);
+    case NVME_VERIFY:
+      return l::submit<l::NVMeVerifyRW>(*this,_throttle,reqs_,count_);
+    case SCSI:
+      return l::submit<l::SCSIRW>(*this,_throttle,reqs_,count_);
+    case SCSI_VERIFY:
+      return l::submit<l::SCSIVerifyRW>(*this,_throttle,reqs_,count_);
     case OS:
-      return os_write(lba_,blocks_,buf_,buflen_);
+      break;
     }
 
-  return -ENOTSUP;
+  return l::submit<l::OSRW>(*this,_throttle,reqs_,count_);
+}
+
+uint64_t
+BlkDev::submit(std::vector<Request> &reqs_)
+{
+  if(reqs_.empty())
+    return 0;
+
+  return submit(&reqs_[0],reqs_.size());
 }
 
 uint64_t
@@ -287,6 +815,9 @@ BlkDev::sync(void)
 
   error = 0;
 
+  if(_sim)
+    return ((::fdatasync(_fd) == -1) ? -errno : 0);
+
   rv = ::fsync(_fd);
   if(rv == -1)
     error = -errno;
@@ -302,16 +833,161 @@ BlkDev::sync(void)
   return error;
 }
 
+/*
+  Gets whatever was written out of the drive's write cache and, for OS
+  I/O, the page cache so reads which follow hit the media.
+*/
+int
+BlkDev::flush_write_cache(void)
+{
+  switch(_rw_type)
+    {
+    case ATA:
+    case ATA_VERIFY:
+      return sg::flush_write_cache(_fd,_timeout);
+    case NVME:
+    case NVME_VERIFY:
+      return nvme::flush(_fd,_nvme_nsid,_timeout);
+    case SCSI:
+    case SCSI_VERIFY:
+      return scsi::synchronize_cache(_fd,_timeout);
+    case OS:
+      return sync();
+    }
+
+  return -ENOTSUP;
+}
+
 int
 BlkDev::write_flagged_uncorrectable(const uint64_t lba_,
+                                    const uint64_t blocks_,
                                     const bool     log_)
 {
-  return sg::write_flagged_uncorrectable(_fd,lba_,log_,_timeout);
+  if(_sim)
+    {
+      _sim->mark_bad(lba_,blocks_);
+      return 0;
+    }
+
+  if(_nvme_nsid)
+    return nvme::write_uncorrectable(_fd,_nvme_nsid,lba_,blocks_,_timeout);
+  if(is_scsi())
+    return scsi::write_uncorrectable(_fd,lba_,blocks_,_timeout);
+
+  return sg::write_flagged_uncorrectable(_fd,lba_,blocks_,log_,_timeout);
 }
 
 int
 BlkDev::write_pseudo_uncorrectable(const uint64_t lba_,
+                                   const uint64_t blocks_,
                                    const bool     log_)
 {
-  return sg::write_pseudo_uncorrectable(_fd,lba_,log_,_timeout);
+  if(_sim)
+    {
+      _sim->mark_bad(lba_,blocks_);
+      return 0;
+    }
+
+  /* NVMe and SCSI have only the one, flagged, kind of uncorrectable */
+  if(_nvme_nsid || is_scsi())
+    return -ENOTSUP;
+
+  return sg::write_pseudo_uncorrectable(_fd,lba_,blocks_,log_,_timeout);
+}
+
+/*
+  TRIM through DATA SET MANAGEMENT when using ATA passthrough,
+  otherwise BLKDISCARD which the kernel splits per the queue's
+  discard limits.
+*/
+int
+BlkDev::discard(const uint64_t lba_,
+                const uint64_t blocks_)
+{
+  if(_sim)
+    return _sim->discard(_fd,lba_,blocks_);
+
+  switch(_rw_type)
+    {
+    case ATA:
+    case ATA_VERIFY:
+      if(has_identity() && !_identity.trim_supported)
+        return -ENOTSUP;
+      return sg::dsm_trim(_fd,lba_,blocks_,_timeout);
+    case NVME:
+    case NVME_VERIFY:
+    case SCSI:
+    case SCSI_VERIFY:
+    case OS:
+      break;
+    }
+
+  return IOCtl::discard(_fd,
+                        (lba_ * _logical_block_size),
+                        (blocks_ * _logical_block_size));
+}
+
+/*
+  Whether discarded blocks are guaranteed to read back as zeros: the
+  ATA drive reports Deterministic Read Zeros After TRIM or it's a
+  simulated device which always does.
+*/
+bool
+BlkDev::discard_zeroes(void) const
+{
+  if(_sim)
+    return true;
+
+  return (has_identity() && _identity.trim_zeroes);
+}
+
+/*
+  SCT Error Recovery Control limits, in 100ms units, how long the
+  drive retries a failing read or write before reporting it. The
+  current limits are saved on first use and put back by
+  restore_error_recovery() or when the device is closed so a drive
+  in a RAID or desktop keeps the behaviour it was configured with.
+*/
+int
+BlkDev::set_error_recovery(const uint16_t read_ds_,
+                           const uint16_t write_ds_)
+{
+  int rv;
+
+  if(_sim || !has_identity() || !_identity.sct_erc)
+    return -ENOTSUP;
+
+  if(!_erc_saved)
+    {
+      rv = sg::sct_erc_get(_fd,sg::SG_SCT_ERC_READ,_erc_read,_timeout);
+      if(rv < 0)
+        return rv;
+      rv = sg::sct_erc_get(_fd,sg::SG_SCT_ERC_WRITE,_erc_write,_timeout);
+      if(rv < 0)
+        return rv;
+      _erc_saved = true;
+    }
+
+  rv = sg::sct_erc_set(_fd,sg::SG_SCT_ERC_READ,read_ds_,_timeout);
+  if(rv < 0)
+    return rv;
+
+  return sg::sct_erc_set(_fd,sg::SG_SCT_ERC_WRITE,write_ds_,_timeout);
+}
+
+int
+BlkDev::restore_error_recovery(void)
+{
+  int rv;
+
+  if(!_erc_saved)
+    return 0;
+
+  _erc_saved = false;
+
+  rv = sg::sct_erc_set(_fd,sg::SG_SCT_ERC_READ,_erc_read,_timeout);
+  if(rv < 0)
+    return rv;
+
+  return sg::sct_erc_set(_fd,sg::SG_SCT_ERC_WRITE,_erc_write,_timeout);
 }
@@ -19,11 +19,16 @@
 #pragma once
 
 #include "sg.hpp"
+#include "simdev.hpp"
+#include "throttle.hpp"
 
 #include <string>
+#include <vector>
 
+#include <pthread.h>
 #include <stdlib.h>
 #include <stdint.h>
+#include <sys/types.h>
 
 class BlkDev
 {
@@ -37,60 +42,190 @@ private:
 public:
   int open(const std::string &path,
            const int          flags);
-  int open_read(const std::string &path);
+  int open_read(const std::string &path,
+                const bool         direct = false);
   int open_rdwr(const std::string &path,
-                const bool         excl = true);
+                const bool         excl = true,
+                const bool         direct = false);
   int close(void);
 
+private:
+  int open_sim(const std::string &path,
+               const int          flags);
+
 public:
   int64_t os_read(const uint64_t  lba,
                   const uint64_t  blocks,
                   void           *buf,
-                  const uint64_t  buflen);
+                  const uint64_t  buflen,
+                  uint64_t       *failed_lba = NULL);
 
   int64_t os_write(const uint64_t  lba,
                    const uint64_t  blocks,
                    const void     *buf,
                    const uint64_t  buflen);
 
+private:
+  int64_t sim_io(const bool      write,
+                 const uint64_t  lba,
+                 const uint64_t  blocks,
+                 void           *buf,
+                 uint64_t       *failed_lba = NULL);
+  int64_t os_write_fua(const void     *buf,
+                       const uint64_t  len,
+                       const off_t     offset);
+
+public:
   int64_t ata_read(const uint64_t  lba,
                    const uint64_t  blocks,
                    void           *buf,
-                   const uint64_t  buflen);
+                   const uint64_t  buflen,
+                   uint64_t       *failed_lba = NULL);
+
+  int ata_xfer(void) const { return _ata_xfer; }
+
+private:
+  bool ata_xfer_downgrade(const int xfer);
+
+public:
+  int64_t ata_verify(const uint64_t  lba,
+                     const uint64_t  blocks,
+                     uint64_t       *failed_lba = NULL);
 
   int64_t ata_write(const uint64_t  lba,
                     const uint64_t  blocks,
                     const void     *buf,
                     const uint64_t  buflen);
 
+public:
+  int64_t nvme_read(const uint64_t  lba,
+                    const uint64_t  blocks,
+                    void           *buf,
+                    const uint64_t  buflen);
+  int64_t nvme_verify(const uint64_t lba,
+                      const uint64_t blocks);
+  int64_t nvme_write(const uint64_t  lba,
+                     const uint64_t  blocks,
+                     const void     *buf,
+                     const uint64_t  buflen);
+
+  uint32_t nvme_nsid(void) const { return _nvme_nsid; }
+
+public:
+  int64_t scsi_read(const uint64_t  lba,
+                    const uint64_t  blocks,
+                    void           *buf,
+                    const uint64_t  buflen,
+                    uint64_t       *failed_lba = NULL);
+  int64_t scsi_verify(const uint64_t  lba,
+                      const uint64_t  blocks,
+                      uint64_t       *failed_lba = NULL);
+  int64_t scsi_write(const uint64_t  lba,
+                     const uint64_t  blocks,
+                     const void     *buf,
+                     const uint64_t  buflen);
+
+  bool is_scsi(void) const { probe_identity(); return _scsi; }
+
 private:
   enum RWType
     {
       ATA,
+      ATA_VERIFY,
+      NVME,
+      NVME_VERIFY,
+      SCSI,
+      SCSI_VERIFY,
       OS
     };
 
   RWType _rw_type;
 
 public:
-  void set_rw_ata(void) { _rw_type = ATA; }
-  void set_rw_os(void)  { _rw_type = OS;  }
+  void set_rw_ata(void);
+  void set_rw_verify(void);
+  void set_rw_os(void) { _rw_type = OS; }
   int64_t read(const uint64_t  lba,
                const uint64_t  blocks,
                void           *buf,
                const uint64_t  buflen);
 
+  /*
+    As read() and on a media error sets failed_lba to the first
+    block of the request the device reported unreadable, or to
+    UNKNOWN_LBA when ATA sense data or the simulator didn't say.
+  */
+  int64_t read(const uint64_t  lba,
+               const uint64_t  blocks,
+               void           *buf,
+               const uint64_t  buflen,
+               uint64_t       &failed_lba);
+
+  static const uint64_t UNKNOWN_LBA = UINT64_MAX;
+
+public:
+  enum Op
+    {
+      READ,
+      WRITE
+    };
+
+  /*
+    A request of a batch given to submit(). rv and failed_lba are
+    filled in as read() and write() would return them.
+  */
+  struct Request
+  {
+    uint64_t  lba;
+    uint64_t  blocks;
+    void     *buf;
+    uint64_t  buflen;
+    Op        op;
+    int64_t   rv;
+    uint64_t  failed_lba;
+  };
+
+  /*
+    Carry out a batch of requests in order. The backend is picked
+    once for the batch, not per request, and the loop over it is
+    instantiated per backend; read() and write() are batches of one.
+    Everything has completed on return. Returns the number of
+    requests which failed. Queued I/O is AsyncIO's.
+  */
+  uint64_t submit(Request        *reqs,
+                  const uint64_t  count);
+  uint64_t submit(std::vector<Request> &reqs);
+
   int64_t write(const uint64_t  lba,
                 const uint64_t  blocks,
                 const void     *buf,
                 const uint64_t  buflen);
 
+public:
+  void      set_throttle(Throttle *throttle_) { _throttle = throttle_; }
+  Throttle *throttle(void) const { return _throttle; }
+
+public:
+  void set_fua(const bool fua_) { _fua = fua_; }
+  bool fua(void) const { return _fua; }
+
 public:
   int sync(void);
+  int flush_write_cache(void);
   int write_flagged_uncorrectable(const uint64_t lba_,
+                                  const uint64_t blocks_,
                                   const bool     log_);
   int write_pseudo_uncorrectable(const uint64_t lba_,
+                                 const uint64_t blocks_,
                                  const bool     log_);
+  int discard(const uint64_t lba_,
+              const uint64_t blocks_);
+  bool discard_zeroes(void) const;
+
+public:
+  int set_error_recovery(const uint16_t read_ds_,
+                         const uint16_t write_ds_);
+  int restore_error_recovery(void);
 
 public:
   uint64_t logical_block_size(void) const { return _logical_block_size; }
@@ -101,11 +236,17 @@ public:
   uint64_t block_stepping(void) const;
 
 public:
-  const bool  has_identity(void) const { return _has_identity; }
-  const sg::identity &identity() const { return _identity; }
+  const bool  has_identity(void) const { probe_identity(); return _has_identity; }
+  const sg::identity &identity() const { probe_identity(); return _identity; }
+
+private:
+  void probe_identity(void) const;
 
 public:
   int fd(void) const { return _fd; }
+  int timeout(void) const { return _timeout; }
+  void set_timeout(const int timeout_) { _timeout = timeout_; }
+  SimDev *sim(void) const { return _sim; }
 
 private:
   uint64_t _logical_block_size;
@@ -115,10 +256,26 @@ private:
   uint64_t _physical_block_count;
 
 private:
-  sg::identity _identity;
-  bool         _has_identity;
+  mutable sg::identity    _identity;
+  mutable bool            _has_identity;
+  mutable bool            _identity_probed;
+  mutable bool            _scsi;
+  mutable pthread_mutex_t _identity_lock;
+
+private:
+  SimDev   *_sim;
+  Throttle *_throttle;
+
+private:
+  int  _fd;
+  int  _timeout;
+  uint32_t _nvme_nsid;
+  mutable int _ata_xfer;
+  bool _ata_xfer_verified;
+  bool _fua;
 
 private:
-  int _fd;
-  int _timeout;
+  bool     _erc_saved;
+  uint16_t _erc_read;
+  uint16_t _erc_write;
 };
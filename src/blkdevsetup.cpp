@@ -0,0 +1,72 @@
+/*
+  ISC License
+
+  Copyright (c) 2016, Antonio SJ Musumeci <trapexit@spawn.link>
+
+  Permission to use, copy, modify, and/or distribute this software for any
+  purpose with or without fee is hereby granted, provided that the above
+  copyright notice and this permission notice appear in all copies.
+
+  THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+  WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+  MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+  ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+  WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+  ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+  OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+*/
+
+#include "blkdev.hpp"
+#include "blkdevsetup.hpp"
+#include "errors.hpp"
+#include "options.hpp"
+
+#include <iostream>
+
+namespace BlkDevSetup
+{
+  /* verify is only accepted by the instructions which only read */
+  void
+  rwtype(BlkDev                &blkdev_,
+         const Options::RWType  rwtype_)
+  {
+    switch(rwtype_)
+      {
+      case Options::ATA:
+        blkdev_.set_rw_ata();
+        break;
+      case Options::VERIFY:
+        blkdev_.set_rw_verify();
+        break;
+      case Options::OS:
+        blkdev_.set_rw_os();
+        break;
+      }
+  }
+
+  /*
+    --timeout for ATA passthrough commands and --erc to have the drive
+    give up on a bad sector quickly. The previous ERC limits are put
+    back when the device is closed.
+  */
+  void
+  recovery(BlkDev        &blkdev_,
+           const Options &opts_,
+           std::ostream  &os_)
+  {
+    int rv;
+
+    if(opts_.timeout)
+      blkdev_.set_timeout(opts_.timeout * 1000);
+
+    if(opts_.erc == 0)
+      return;
+
+    rv = blkdev_.set_error_recovery((opts_.erc / 100),(opts_.erc / 100));
+    if(rv < 0)
+      os_ << "Warning: unable to set SCT error recovery control ["
+          << Error::to_string(-rv)
+          << "]"
+          << std::endl;
+  }
+}
@@ -19,24 +19,40 @@
 #include <dirent.h>
 #include <errno.h>
 #include <fcntl.h>
+#include <pthread.h>
+#include <signal.h>
 #include <stdint.h>
 #include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
 #include <sys/types.h>
 #include <unistd.h>
 
+#include <algorithm>
+#include <deque>
+
 #include "blocktofilemapper.hpp"
 #include "fiemap.hpp"
 #include "file.hpp"
 #include "filetoblkdev.hpp"
 #include "ioctl.hpp"
+#include "mapcache.hpp"
+#include "progress.hpp"
+
+typedef BlockToFileMapper::Extent Extent;
+typedef std::vector<Extent>       ExtentVector;
+typedef std::vector<std::string>  PathVector;
 
-namespace iter
+namespace l
 {
-  template<class T>
-  T
-  next(T i)
+  static
+  bool
+  extent_lt(const Extent &a_,
+            const Extent &b_)
   {
-    return ++i;
+    if(a_.start != b_.start)
+      return (a_.start < b_.start);
+    return (a_.file < b_.file);
   }
 }
 
@@ -50,158 +66,889 @@ dot_or_dot_dot(const char *path)
 }
 
 BlockToFileMapper::BlockToFileMapper()
+  : _offset(0)
 {
 
 }
 
+namespace l
+{
+  struct GetBlocks
+  {
+    uint64_t      blocksize;
+    Extent        extent;
+    ExtentVector *extents;
+  };
+
+  static
+  void
+  add_extent(const struct fiemap_extent &fme_,
+             void                       *data_)
+  {
+    GetBlocks *gb = (GetBlocks*)data_;
+
+    gb->extent.start  = (fme_.fe_physical / gb->blocksize);
+    gb->extent.length = (fme_.fe_length   / gb->blocksize);
+
+    gb->extents->push_back(gb->extent);
+  }
+}
+
 static
 int
-get_blocks(const int                    fd,
-           const std::string           &basepath,
-           const char                  *filename,
-           const int                    blocksize,
-           BlockToFileMapper::BlockMap &blockmap)
+get_blocks(const int          fd,
+           const std::string &basepath,
+           const char        *filename,
+           const int          blocksize,
+           FIEMap::Reader    &reader,
+           PathVector        &paths,
+           ExtentVector      &extents)
 {
-  struct fiemap *fm;
+  int rv;
+  l::GetBlocks gb;
 
-  fm = FIEMap::extent_map(fd);
-  if(fm == NULL)
-    return -ENOMEM;
+  gb.blocksize   = blocksize;
+  gb.extent.file = paths.size();
+  gb.extents     = &extents;
 
-  for(int i = 0; i < fm->fm_mapped_extents; i++)
+  rv = reader.read(fd,l::add_extent,&gb);
+  if(rv < 0)
     {
-      uint64_t key;
-      std::pair<uint64_t,std::string> value;
-      const struct fiemap_extent *fme = &fm->fm_extents[i];
-
-      key          = (fme->fe_physical / blocksize);
-      value.first  = (fme->fe_length   / blocksize);
-      value.second = basepath + '/' + filename;
-
-      blockmap.insert(std::make_pair(key,value));
+      // drop any partial batch so the file id is reused cleanly
+      while(!extents.empty() && (extents.back().file == gb.extent.file))
+        extents.pop_back();
+      return rv;
     }
 
-  ::free(fm);
+  if(rv > 0)
+    paths.push_back(basepath + '/' + filename);
 
   return 0;
 }
 
 static
-bool
-scan(const std::string           &basepath,
-     const uint64_t               blocksize,
-     BlockToFileMapper::BlockMap &blockmap)
+void
+get_cached_blocks(const std::string   &basepath,
+                  const MapCache::Dir &dir,
+                  PathVector          &paths,
+                  ExtentVector        &extents)
 {
-  int dfd;
-  DIR *dir;
-  struct dirent *d;
-
-  dir = ::opendir(basepath.c_str());
-  if(dir == NULL)
-    return false;
+  Extent extent;
 
-  dfd = ::dirfd(dir);
-  for(d = ::readdir(dir); d != NULL; d = ::readdir(dir))
+  for(uint64_t i = 0, ei = dir.files.size(); i != ei; i++)
     {
-      switch(d->d_type)
+      const MapCache::File &file = dir.files[i];
+
+      extent.file = paths.size();
+      paths.push_back(basepath + '/' + file.name);
+      for(uint64_t j = 0, ej = file.extents.size(); j != ej; j++)
         {
-        case DT_DIR:
+          extent.start  = file.extents[j].start;
+          extent.length = file.extents[j].length;
+
+          extents.push_back(extent);
+        }
+    }
+}
+
+namespace l
+{
+  struct Walker;
+
+  // the files of a directory are given consecutive ids by the thread
+  // which reads it which is all the cache writer needs to know
+  struct DirRecord
+  {
+    std::string                dirpath;
+    struct timespec            mtime;
+    struct timespec            ctime;
+    BlockToFileMapper::FileID  first;
+    BlockToFileMapper::FileID  last;
+  };
+
+  struct WalkThread
+  {
+    Walker                  *walker;
+    pthread_t                thread;
+    pthread_mutex_t          lock;
+    std::deque<std::string>  queue;
+    FIEMap::Reader           reader;
+    PathVector               paths;
+    ExtentVector             extents;
+    std::vector<DirRecord>   dirs;
+  };
+
+  struct Stream
+  {
+    BlockToFileMapper::Sink  sink;
+    void                    *data;
+    uint64_t                 offset;
+  };
+
+  struct Walker
+  {
+    uint64_t                 blocksize;
+    const MapCache::Dirs    *cache;
+    bool                     record;
+    Progress                *progress;
+    const Stream            *stream;
+    std::vector<WalkThread*> threads;
+    pthread_mutex_t          lock;
+    pthread_cond_t           cond;
+    uint64_t                 queued;
+    uint64_t                 pending;
+  };
+
+  static
+  void
+  push(WalkThread        *wt_,
+       const std::string &dirpath_)
+  {
+    Walker *w = wt_->walker;
+
+    pthread_mutex_lock(&w->lock);
+    w->pending++;
+    w->queued++;
+    pthread_mutex_lock(&wt_->lock);
+    wt_->queue.push_back(dirpath_);
+    pthread_mutex_unlock(&wt_->lock);
+    pthread_cond_signal(&w->cond);
+    pthread_mutex_unlock(&w->lock);
+  }
+
+  static
+  bool
+  pop(WalkThread  *wt_,
+      const bool   back_,
+      std::string &dirpath_)
+  {
+    bool rv;
+
+    pthread_mutex_lock(&wt_->lock);
+    rv = !wt_->queue.empty();
+    if(rv && back_)
+      {
+        dirpath_ = wt_->queue.back();
+        wt_->queue.pop_back();
+      }
+    else if(rv)
+      {
+        dirpath_ = wt_->queue.front();
+        wt_->queue.pop_front();
+      }
+    pthread_mutex_unlock(&wt_->lock);
+
+    return rv;
+  }
+
+  /*
+    Work through our own queue depth first and steal the oldest, and
+    so likely the largest, subtree from another thread when it runs
+    dry.
+  */
+  static
+  bool
+  next_dir(WalkThread  *wt_,
+           std::string &dirpath_)
+  {
+    Walker *w = wt_->walker;
+
+    for(;;)
+      {
+        bool found;
+
+        found = pop(wt_,true,dirpath_);
+        for(size_t i = 0; !found && (i < w->threads.size()); i++)
+          if(w->threads[i] != wt_)
+            found = pop(w->threads[i],false,dirpath_);
+
+        pthread_mutex_lock(&w->lock);
+        if(found)
           {
-            std::string dirpath(basepath);
+            w->queued--;
+            pthread_mutex_unlock(&w->lock);
+            return true;
+          }
 
-            if(dot_or_dot_dot(d->d_name))
-              break;
+        while((w->queued == 0) && (w->pending != 0))
+          pthread_cond_wait(&w->cond,&w->lock);
 
-            dirpath += '/';
-            dirpath += d->d_name;
+        found = (w->pending != 0);
+        pthread_mutex_unlock(&w->lock);
+        if(!found)
+          return false;
+      }
+  }
 
-            scan(dirpath,blocksize,blockmap);
+  static
+  void
+  finished(WalkThread *wt_)
+  {
+    Walker *w = wt_->walker;
+
+    pthread_mutex_lock(&w->lock);
+    w->pending--;
+    if(w->pending == 0)
+      pthread_cond_broadcast(&w->cond);
+    pthread_mutex_unlock(&w->lock);
+  }
+
+  static
+  void
+  compress(ExtentVector &extents_)
+  {
+    uint64_t o;
+
+    if(extents_.empty())
+      return;
+
+    // merge contiguous extents belonging to the same file
+    o = 0;
+    for(uint64_t i = 1, ei = extents_.size(); i != ei; i++)
+      {
+        Extent &curr = extents_[o];
+        const Extent &next = extents_[i];
+
+        if((curr.file == next.file) &&
+           ((curr.start + curr.length) == next.start))
+          {
+            curr.length += next.length;
+            continue;
           }
-          break;
-        case DT_REG:
+
+        extents_[++o] = next;
+      }
+
+    extents_.resize(o + 1);
+  }
+
+  /* hand a directory's extents, in block order, to the sink and drop them */
+  static
+  void
+  flush(WalkThread *wt_)
+  {
+    Walker *w = wt_->walker;
+
+    if(wt_->paths.empty())
+      return;
+
+    std::sort(wt_->extents.begin(),wt_->extents.end(),l::extent_lt);
+    l::compress(wt_->extents);
+    for(uint64_t i = 0, ei = wt_->extents.size(); i != ei; i++)
+      wt_->extents[i].start += w->stream->offset;
+
+    w->stream->sink(wt_->paths,wt_->extents,w->stream->data);
+
+    wt_->paths.clear();
+    wt_->extents.clear();
+  }
+
+  static
+  void
+  scan_dir(WalkThread        *wt_,
+           const std::string &basepath_)
+  {
+    int dfd;
+    DIR *dir;
+    struct stat st;
+    struct dirent *d;
+    DirRecord record;
+    Walker *w = wt_->walker;
+    const MapCache::Dir *cached = NULL;
+
+    dfd = ::open(basepath_.c_str(),O_RDONLY|O_DIRECTORY);
+    if(dfd == -1)
+      return;
+
+    dir = ::fdopendir(dfd);
+    if(dir == NULL)
+      {
+        ::close(dfd);
+        return;
+      }
+
+    if(::fstat(dfd,&st) == -1)
+      ::memset(&st,0,sizeof(st));
+
+    // an unchanged directory still has the same files; take their
+    // extents from the cache and only read it for subdirectories
+    if(w->cache != NULL)
+      {
+        MapCache::Dirs::const_iterator i = w->cache->find(basepath_);
+
+        if((i != w->cache->end()) && MapCache::unchanged(i->second,st))
+          cached = &i->second;
+      }
+
+    record.first = wt_->paths.size();
+    if(cached != NULL)
+      get_cached_blocks(basepath_,*cached,wt_->paths,wt_->extents);
+
+    for(d = ::readdir(dir); d != NULL; d = ::readdir(dir))
+      {
+        switch(d->d_type)
           {
-            int fd;
-            int rv;
+          case DT_DIR:
+            {
+              std::string dirpath(basepath_);
 
-            fd = ::openat(dfd,d->d_name,O_RDONLY|O_NOFOLLOW);
-            if(fd == -1)
-              break;
+              if(dot_or_dot_dot(d->d_name))
+                break;
 
-            rv = get_blocks(fd,basepath,d->d_name,blocksize,blockmap);
+              dirpath += '/';
+              dirpath += d->d_name;
 
-            ::close(fd);
+              push(wt_,dirpath);
+            }
+            break;
+          case DT_REG:
+            {
+              int fd;
+
+              if(cached != NULL)
+                break;
+
+              fd = ::openat(dfd,d->d_name,O_RDONLY|O_NOFOLLOW);
+              if(fd == -1)
+                break;
+
+              get_blocks(fd,
+                         basepath_,
+                         d->d_name,
+                         wt_->walker->blocksize,
+                         wt_->reader,
+                         wt_->paths,
+                         wt_->extents);
+
+              ::close(fd);
+            }
+            break;
+          default:
+            break;
           }
-          break;
-        default:
-          break;
+      }
+
+    ::closedir(dir);
+
+    // one atomic add per directory rather than per file
+    if(w->progress)
+      w->progress->advance(wt_->paths.size() - record.first);
+
+    if(w->record)
+      {
+        record.dirpath = basepath_;
+        record.mtime   = st.st_mtim;
+        record.ctime   = st.st_ctim;
+        record.last    = wt_->paths.size();
+        wt_->dirs.push_back(record);
+      }
+
+    if(w->stream)
+      flush(wt_);
+  }
+
+  static
+  void*
+  walk_main(void *arg_)
+  {
+    std::string dirpath;
+    WalkThread *wt = (WalkThread*)arg_;
+
+    while(next_dir(wt,dirpath))
+      {
+        scan_dir(wt,dirpath);
+        finished(wt);
+      }
+
+    return NULL;
+  }
+
+  static
+  void*
+  walk_thread_main(void *arg_)
+  {
+    sigset_t set;
+
+    /* leave signal handling to the main thread */
+    sigfillset(&set);
+    pthread_sigmask(SIG_BLOCK,&set,NULL);
+
+    return walk_main(arg_);
+  }
+}
+
+static
+int
+scan(const std::string         &basepath,
+     const uint64_t             blocksize,
+     const uint64_t             threads,
+     const MapCache::Dirs      *cache,
+     std::vector<l::DirRecord> *dirs,
+     Progress                  *progress,
+     const l::Stream           *stream,
+     PathVector                &paths,
+     ExtentVector              &extents)
+{
+  int fd;
+  l::Walker w;
+  std::vector<l::WalkThread> wts(threads);
+
+  fd = ::open(basepath.c_str(),O_RDONLY|O_DIRECTORY);
+  if(fd == -1)
+    return -errno;
+  ::close(fd);
+
+  w.blocksize = blocksize;
+  w.cache     = cache;
+  w.record    = (dirs != NULL);
+  w.progress  = progress;
+  w.stream    = stream;
+  w.queued    = 0;
+  w.pending   = 0;
+  pthread_mutex_init(&w.lock,NULL);
+  pthread_cond_init(&w.cond,NULL);
+  for(uint64_t i = 0; i < threads; i++)
+    {
+      wts[i].walker = &w;
+      pthread_mutex_init(&wts[i].lock,NULL);
+      w.threads.push_back(&wts[i]);
+    }
+
+  l::push(&wts[0],basepath);
+
+  for(uint64_t i = 1; i < threads; i++)
+    pthread_create(&wts[i].thread,NULL,l::walk_thread_main,&wts[i]);
+
+  l::walk_main(&wts[0]);
+
+  for(uint64_t i = 1; i < threads; i++)
+    pthread_join(wts[i].thread,NULL);
+
+  // file ids are per thread, rebase them onto the merged path table
+  for(uint64_t i = 0; i < threads; i++)
+    {
+      const BlockToFileMapper::FileID base = paths.size();
+      l::WalkThread &wt = wts[i];
+
+      for(uint64_t j = 0, ej = wt.extents.size(); j != ej; j++)
+        wt.extents[j].file += base;
+      for(uint64_t j = 0, ej = wt.dirs.size(); (dirs != NULL) && (j != ej); j++)
+        {
+          wt.dirs[j].first += base;
+          wt.dirs[j].last  += base;
+          dirs->push_back(wt.dirs[j]);
         }
+
+      paths.insert(paths.end(),wt.paths.begin(),wt.paths.end());
+      extents.insert(extents.end(),wt.extents.begin(),wt.extents.end());
+
+      PathVector().swap(wt.paths);
+      ExtentVector().swap(wt.extents);
+      pthread_mutex_destroy(&wt.lock);
     }
 
-  ::closedir(dir);
+  pthread_cond_destroy(&w.cond);
+  pthread_mutex_destroy(&w.lock);
 
-  return true;
+  return 0;
 }
 
+/*
+  Extents come out of the walk grouped by ascending file id, each
+  thread's block after the previous one's, so one pass finds each
+  file's slice.
+*/
 static
-void
-compress(BlockToFileMapper::BlockMap &blockmap)
+int
+save_cache(const std::string               &cachepath,
+           const std::string               &key,
+           const uint64_t                   blocksize,
+           const std::vector<l::DirRecord> &dirs,
+           const PathVector                &paths,
+           const ExtentVector              &extents)
 {
-  // find contiguous block ranges and merge
-  for(BlockToFileMapper::BlockMap::iterator
-        i = blockmap.begin();
-      i != blockmap.end();
-      ++i)
+  MapCache::Writer writer;
+  std::vector<uint64_t> first(paths.size() + 1,extents.size());
+
+  for(uint64_t i = extents.size(); i-- > 0;)
+    first[extents[i].file] = i;
+  for(uint64_t i = paths.size(); i-- > 0;)
+    first[i] = std::min(first[i],first[i+1]);
+
+  if(writer.open(cachepath,key,blocksize) < 0)
+    return -EACCES;
+
+  for(uint64_t i = 0, ei = dirs.size(); i != ei; i++)
     {
-      BlockToFileMapper::BlockMap::iterator curr = i;
-      BlockToFileMapper::BlockMap::iterator next = iter::next(i);
+      const l::DirRecord &dir = dirs[i];
 
-      while((next != blockmap.end()) && (curr->second.second == next->second.second))
+      writer.dir(dir.dirpath,dir.mtime,dir.ctime,(dir.last - dir.first));
+      for(uint64_t id = dir.first; id != dir.last; id++)
         {
-          if((curr->first + curr->second.first) != next->first)
-            break;
-
-          curr->second.first += next->second.first;
-          blockmap.erase(next);
-          next = iter::next(i);
+          writer.file(paths[id].substr(dir.dirpath.size() + 1),
+                      (first[id+1] - first[id]));
+          for(uint64_t j = first[id]; j != first[id+1]; j++)
+            writer.extent(extents[j].start,extents[j].length);
         }
     }
+
+  return writer.close();
+}
+
+namespace l
+{
+  // below this many extents per thread a plain std::sort wins
+  static const uint64_t MIN_SORT_PER_THREAD = (1 << 16);
+
+  struct SortRange
+  {
+    pthread_t  thread;
+    Extent    *begin;
+    Extent    *middle;
+    Extent    *end;
+  };
+
+  static
+  void*
+  sort_thread_main(void *arg_)
+  {
+    sigset_t set;
+    SortRange *r = (SortRange*)arg_;
+
+    sigfillset(&set);
+    pthread_sigmask(SIG_BLOCK,&set,NULL);
+
+    if(r->middle == NULL)
+      std::sort(r->begin,r->end,l::extent_lt);
+    else
+      std::inplace_merge(r->begin,r->middle,r->end,l::extent_lt);
+
+    return NULL;
+  }
+
+  static
+  void
+  run(std::vector<SortRange> &ranges_)
+  {
+    for(uint64_t i = 1; i < ranges_.size(); i++)
+      pthread_create(&ranges_[i].thread,NULL,sort_thread_main,&ranges_[i]);
+
+    sort_thread_main(&ranges_[0]);
+
+    for(uint64_t i = 1; i < ranges_.size(); i++)
+      pthread_join(ranges_[i].thread,NULL);
+  }
+
+  /*
+    Each thread sorts a slice and the slices are then merged pairwise,
+    each round's merges running in parallel.
+  */
+  static
+  void
+  sort(ExtentVector   &extents_,
+       const uint64_t  threads_)
+  {
+    uint64_t n;
+    std::vector<Extent*> bounds;
+    std::vector<SortRange> ranges;
+
+    n = std::min(threads_,(uint64_t)(extents_.size() / MIN_SORT_PER_THREAD));
+    if(n <= 1)
+      {
+        std::sort(extents_.begin(),extents_.end(),l::extent_lt);
+        return;
+      }
+
+    for(uint64_t i = 0; i <= n; i++)
+      bounds.push_back(&extents_[0] + ((extents_.size() * i) / n));
+
+    ranges.resize(n);
+    for(uint64_t i = 0; i < n; i++)
+      {
+        ranges[i].begin  = bounds[i];
+        ranges[i].middle = NULL;
+        ranges[i].end    = bounds[i+1];
+      }
+    l::run(ranges);
+
+    while(bounds.size() > 2)
+      {
+        std::vector<Extent*> next;
+
+        ranges.clear();
+        for(uint64_t i = 0; (i + 2) < bounds.size(); i += 2)
+          {
+            SortRange r;
+
+            r.begin  = bounds[i];
+            r.middle = bounds[i+1];
+            r.end    = bounds[i+2];
+            ranges.push_back(r);
+            next.push_back(bounds[i]);
+          }
+        if((bounds.size() % 2) == 0)
+          next.push_back(bounds[bounds.size() - 2]);
+        next.push_back(bounds.back());
+
+        l::run(ranges);
+        bounds.swap(next);
+      }
+  }
+}
+
+/*
+  The walk yields each file's extents together and in file order so
+  most merges can be done before sorting, shrinking what is sorted.
+  Merging again afterwards catches the rest.
+*/
+void
+BlockToFileMapper::freeze(ExtentVector   &extents,
+                          const uint64_t  threads)
+{
+  uint64_t max_end;
+
+  l::compress(extents);
+
+  l::sort(extents,threads);
+
+  l::compress(extents);
+
+  _start.resize(extents.size());
+  _length.resize(extents.size());
+  _max_end.resize(extents.size());
+  _file.resize(extents.size());
+
+  // _max_end[i] is the furthest end of any extent in [0,i] which
+  // bounds the backwards walk in find() when extents overlap
+  // (reflinks, shared extents)
+  max_end = 0;
+  for(uint64_t i = 0, ei = extents.size(); i != ei; i++)
+    {
+      const Extent &extent = extents[i];
+
+      _start[i]  = (extent.start + _offset);
+      _length[i] = extent.length;
+      _file[i]   = extent.file;
+
+      max_end     = std::max(max_end,(_start[i] + extent.length));
+      _max_end[i] = max_end;
+    }
 }
 
 int
-BlockToFileMapper::scan(const std::string &basepath)
+BlockToFileMapper::scan(const std::string &basepath,
+                        const uint64_t     threads,
+                        const std::string &cachepath,
+                        Progress          *progress)
 {
   int rv;
-  uint64_t blocksize;
+  int64_t blocksize;
+  std::string key;
+  ExtentVector extents;
 
   blocksize = File::logical_block_size(basepath);
   if(blocksize < 0)
     return blocksize;
 
-  rv = ::scan(basepath,blocksize,_blockmap);
+  // extents are relative to the filesystem's device, index them by
+  // the whole disk's LBAs which is what `scan` of the disk reports
+  _offset = std::max(File::lba_offset(basepath),(int64_t)0);
 
-  ::compress(_blockmap);
+  if(!cachepath.empty())
+    key = MapCache::key(basepath);
+
+  if(key.empty())
+    {
+      rv = ::scan(basepath,blocksize,std::max(threads,(uint64_t)1),
+                  NULL,NULL,progress,NULL,_paths,extents);
+    }
+  else
+    {
+      MapCache::Dirs cache;
+      std::vector<l::DirRecord> dirs;
+
+      MapCache::load(cachepath,key,blocksize,cache);
+
+      rv = ::scan(basepath,blocksize,std::max(threads,(uint64_t)1),
+                  &cache,&dirs,progress,NULL,_paths,extents);
+      if(rv == 0)
+        save_cache(cachepath,key,blocksize,dirs,_paths,extents);
+    }
+
+  freeze(extents,std::max(threads,(uint64_t)1));
 
   return rv;
 }
 
-std::pair<bool,std::string>
-BlockToFileMapper::find(const uint64_t block) const
+/*
+  Walks as scan() does without building the map. Each directory's
+  extents are passed to sink, from the walker threads, as soon as it
+  has been read so memory is bounded by the largest directory. Paths
+  are those of the directory's files and extents, in block order with
+  neighbours merged, index them. Nothing is cached.
+*/
+int
+BlockToFileMapper::stream(const std::string &basepath_,
+                          const uint64_t     threads_,
+                          Sink               sink_,
+                          void              *data_,
+                          Progress          *progress_)
 {
-  BlockMap::const_iterator iter;
+  int64_t blocksize;
+  l::Stream stream;
+  PathVector paths;
+  ExtentVector extents;
 
-  iter = _blockmap.upper_bound(block);
-  if(iter != _blockmap.end())
-    --iter;
+  blocksize = File::logical_block_size(basepath_);
+  if(blocksize < 0)
+    return blocksize;
 
-  if(block < (iter->first + iter->second.first))
-    return std::make_pair(true,iter->second.second);
+  stream.sink   = sink_;
+  stream.data   = data_;
+  stream.offset = std::max(File::lba_offset(basepath_),(int64_t)0);
 
-  return std::make_pair(false,std::string());
+  return ::scan(basepath_,blocksize,std::max(threads_,(uint64_t)1),
+                NULL,NULL,progress_,&stream,paths,extents);
+}
+
+/*
+  Builds the map from extents gathered elsewhere. extent.file indexes
+  paths and LBAs are relative to offset. extents is reordered.
+*/
+void
+BlockToFileMapper::load(const std::vector<std::string> &paths_,
+                        ExtentVector                   &extents_,
+                        const uint64_t                  offset_)
+{
+  _offset = offset_;
+  _paths  = paths_;
+
+  freeze(extents_,1);
+}
+
+uint64_t
+BlockToFileMapper::offset(void) const
+{
+  return _offset;
+}
+
+uint64_t
+BlockToFileMapper::size(void) const
+{
+  return _start.size();
+}
+
+uint64_t
+BlockToFileMapper::start(const uint64_t idx_) const
+{
+  return _start[idx_];
+}
+
+uint64_t
+BlockToFileMapper::length(const uint64_t idx_) const
+{
+  return _length[idx_];
 }
 
 const
-BlockToFileMapper::BlockMap &
-BlockToFileMapper::blockmap(void) const
+std::string &
+BlockToFileMapper::path(const uint64_t idx_) const
 {
-  return _blockmap;
+  return _paths[_file[idx_]];
+}
+
+std::pair<bool,std::string>
+BlockToFileMapper::find(const uint64_t block_) const
+{
+  uint64_t i;
+
+  i = (std::upper_bound(_start.begin(),_start.end(),block_) - _start.begin());
+  while(i-- > 0)
+    {
+      if(_max_end[i] <= block_)
+        break;
+      if(block_ < (_start[i] + _length[i]))
+        return std::make_pair(true,_paths[_file[i]]);
+    }
+
+  return std::make_pair(false,std::string());
+}
+
+void
+BlockToFileMapper::find_all(const uint64_t                   block_,
+                            std::vector<const std::string*> &paths_) const
+{
+  uint64_t i;
+
+  i = (std::upper_bound(_start.begin(),_start.end(),block_) - _start.begin());
+  while(i-- > 0)
+    {
+      if(_max_end[i] <= block_)
+        break;
+      if(block_ < (_start[i] + _length[i]))
+        paths_.push_back(&_paths[_file[i]]);
+    }
+}
+
+namespace l
+{
+  struct EndGreater
+  {
+    const std::vector<uint64_t> *start;
+    const std::vector<uint64_t> *length;
+
+    bool
+    operator()(const uint64_t a_,
+               const uint64_t b_) const
+    {
+      return (((*start)[a_] + (*length)[a_]) >
+              ((*start)[b_] + (*length)[b_]));
+    }
+  };
+}
+
+/*
+  Sort-merge join of ascending blocks against the extent index. The
+  extents covering the current block are kept in a heap on their
+  end so each extent enters and leaves it once. Stretches of blocks
+  no extent reaches are skipped with _max_end rather than walked.
+  matches are appended in block order with every file holding each
+  block; blocks no file holds are absent.
+*/
+void
+BlockToFileMapper::find_all(const std::vector<uint64_t> &blocks_,
+                            std::vector<Match>          &matches_) const
+{
+  uint64_t next;
+  l::EndGreater end_greater;
+  std::vector<uint64_t> active;
+
+  end_greater.start  = &_start;
+  end_greater.length = &_length;
+
+  next = 0;
+  for(uint64_t i = 0, ei = blocks_.size(); i != ei; i++)
+    {
+      const uint64_t block = blocks_[i];
+
+      if(active.empty())
+        next = (std::upper_bound(_max_end.begin() + next,_max_end.end(),block) -
+                _max_end.begin());
+
+      for(; (next < _start.size()) && (_start[next] <= block); next++)
+        {
+          active.push_back(next);
+          std::push_heap(active.begin(),active.end(),end_greater);
+        }
+
+      while(!active.empty() &&
+            ((_start[active.front()] + _length[active.front()]) <= block))
+        {
+          std::pop_heap(active.begin(),active.end(),end_greater);
+          active.pop_back();
+        }
+
+      for(uint64_t j = 0, ej = active.size(); j != ej; j++)
+        matches_.push_back(Match(block,&_paths[_file[active[j]]]));
+    }
 }
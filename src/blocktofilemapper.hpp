@@ -20,24 +20,69 @@
 
 #include <stdint.h>
 #include <string>
-#include <map>
+#include <utility>
+#include <vector>
+
+class Progress;
 
 class BlockToFileMapper
 {
 public:
-  typedef std::map<uint64_t,std::pair<uint64_t,std::string> > BlockMap;
+  typedef uint32_t FileID;
+
+  struct Extent
+  {
+    uint64_t start;
+    uint64_t length;
+    FileID   file;
+  };
 
 public:
   BlockToFileMapper();
 
 public:
-  int scan(const std::string &basepath);
+  int scan(const std::string &basepath,
+           const uint64_t     threads   = 1,
+           const std::string &cachepath = std::string(),
+           Progress          *progress  = NULL);
+  void load(const std::vector<std::string> &paths,
+            std::vector<Extent>            &extents,
+            const uint64_t                  offset = 0);
 
-  const BlockMap &blockmap(void) const;
+  typedef void (*Sink)(const std::vector<std::string> &paths,
+                       const std::vector<Extent>      &extents,
+                       void                           *data);
+  int stream(const std::string &basepath,
+             const uint64_t     threads,
+             Sink               sink,
+             void              *data,
+             Progress          *progress = NULL);
+
+public:
+  uint64_t           offset(void) const;
+  uint64_t           size(void) const;
+  uint64_t           start(const uint64_t idx) const;
+  uint64_t           length(const uint64_t idx) const;
+  const std::string &path(const uint64_t idx) const;
 
 public:
   std::pair<bool,std::string> find(const uint64_t block) const;
+  void find_all(const uint64_t                  block,
+                std::vector<const std::string*> &paths) const;
+
+  typedef std::pair<uint64_t,const std::string*> Match;
+  void find_all(const std::vector<uint64_t> &blocks,
+                std::vector<Match>          &matches) const;
+
+private:
+  void freeze(std::vector<Extent> &extents,
+              const uint64_t       threads);
 
 private:
-  BlockMap _blockmap;
+  uint64_t                 _offset;
+  std::vector<std::string> _paths;
+  std::vector<uint64_t>    _start;
+  std::vector<uint64_t>    _length;
+  std::vector<uint64_t>    _max_end;
+  std::vector<FileID>      _file;
 };
@@ -0,0 +1,197 @@
+/*
+  ISC License
+
+  Copyright (c) 2016, Antonio SJ Musumeci <trapexit@spawn.link>
+
+  Permission to use, copy, modify, and/or distribute this software for any
+  purpose with or without fee is hereby granted, provided that the above
+  copyright notice and this permission notice appear in all copies.
+
+  THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+  WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+  MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+  ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+  WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+  ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+  OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+*/
+
+#include "bufpool.hpp"
+
+#include "topology.hpp"
+
+#include <pthread.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <unistd.h>
+
+#include <map>
+#include <utility>
+
+namespace l
+{
+  struct Entry
+  {
+    size_t len;
+    int    node;
+    bool   mmaped;
+  };
+
+  /* free buffers by NUMA node they were allocated from and size */
+  typedef std::map<void*,Entry> Allocations;
+  typedef std::multimap<std::pair<int,size_t>,void*> FreeList;
+
+  static Allocations     g_allocations;
+  static FreeList        g_freelist;
+  static pthread_mutex_t g_mutex = PTHREAD_MUTEX_INITIALIZER;
+
+  class Guard
+  {
+  public:
+    Guard() { pthread_mutex_lock(&g_mutex); }
+    ~Guard() { pthread_mutex_unlock(&g_mutex); }
+  };
+
+  static
+  size_t
+  page_size(void)
+  {
+    static size_t size = 0;
+
+    if(size == 0)
+      size = ::sysconf(_SC_PAGESIZE);
+
+    return size;
+  }
+
+  static
+  size_t
+  round_up(const size_t len_,
+           const size_t mul_)
+  {
+    return (((len_ + mul_ - 1) / mul_) * mul_);
+  }
+
+  static
+  void*
+  allocate(const size_t len_,
+           bool        &mmaped_)
+  {
+    int rv;
+    void *buf;
+
+    if(len_ >= BufPool::HUGEPAGE_SIZE)
+      {
+        buf = ::mmap(NULL,len_,
+                     PROT_READ|PROT_WRITE,
+                     MAP_PRIVATE|MAP_ANONYMOUS,
+                     -1,0);
+        if(buf != MAP_FAILED)
+          {
+#ifdef MADV_HUGEPAGE
+            ::madvise(buf,len_,MADV_HUGEPAGE);
+#endif
+            mmaped_ = true;
+            return buf;
+          }
+      }
+
+    rv = ::posix_memalign(&buf,l::page_size(),len_);
+    if(rv != 0)
+      return NULL;
+
+    mmaped_ = false;
+
+    return buf;
+  }
+
+  static
+  void
+  deallocate(void        *buf_,
+             const Entry &entry_)
+  {
+    if(entry_.mmaped)
+      ::munmap(buf_,entry_.len);
+    else
+      ::free(buf_);
+  }
+}
+
+namespace BufPool
+{
+  void*
+  get(const size_t len_)
+  {
+    void *buf;
+    size_t len;
+    l::Entry entry;
+    l::FreeList::iterator i;
+    l::Guard guard;
+
+    len = l::round_up((len_ ? len_ : 1),l::page_size());
+    if(len >= HUGEPAGE_SIZE)
+      len = l::round_up(len,HUGEPAGE_SIZE);
+
+    entry.node = Topology::current_node();
+
+    i = l::g_freelist.find(std::make_pair(entry.node,len));
+    if(i != l::g_freelist.end())
+      {
+        buf = i->second;
+        l::g_freelist.erase(i);
+        return buf;
+      }
+
+    buf = l::allocate(len,entry.mmaped);
+    if(buf == NULL)
+      return NULL;
+
+    entry.len = len;
+    l::g_allocations[buf] = entry;
+
+    return buf;
+  }
+
+  void
+  put(void *buf_)
+  {
+    l::Allocations::iterator i;
+
+    if(buf_ == NULL)
+      return;
+
+    l::Guard guard;
+
+    i = l::g_allocations.find(buf_);
+    if(i == l::g_allocations.end())
+      return;
+
+    l::g_freelist.insert(std::make_pair(std::make_pair(i->second.node,
+                                                       i->second.len),
+                                        buf_));
+  }
+
+  void
+  clear(void)
+  {
+    l::Guard guard;
+
+    for(l::FreeList::iterator
+          i = l::g_freelist.begin(), ei = l::g_freelist.end();
+        i != ei;
+        ++i)
+      {
+        l::Allocations::iterator a;
+
+        a = l::g_allocations.find(i->second);
+        if(a == l::g_allocations.end())
+          continue;
+
+        l::deallocate(a->first,a->second);
+        l::g_allocations.erase(a);
+      }
+
+    l::g_freelist.clear();
+  }
+}
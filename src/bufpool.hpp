@@ -0,0 +1,40 @@
+/*
+  ISC License
+
+  Copyright (c) 2016, Antonio SJ Musumeci <trapexit@spawn.link>
+
+  Permission to use, copy, modify, and/or distribute this software for any
+  purpose with or without fee is hereby granted, provided that the above
+  copyright notice and this permission notice appear in all copies.
+
+  THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+  WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+  MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+  ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+  WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+  ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+  OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+*/
+
+#pragma once
+
+#include <stddef.h>
+
+/*
+  Page aligned I/O buffers suitable for O_DIRECT. Buffers of at least
+  HUGEPAGE_SIZE are mmap'ed and advised as transparent huge
+  pages. Released buffers are kept and handed back out for requests of
+  the same size so loops which repeatedly allocate don't churn memory.
+  They are only handed back out on the NUMA node they were allocated
+  from so a thread bound near its device (see Topology) doesn't get
+  another node's memory.
+*/
+
+namespace BufPool
+{
+  static const size_t HUGEPAGE_SIZE = (2 * 1024 * 1024);
+
+  void *get(const size_t len);
+  void  put(void *buf);
+  void  clear(void);
+}
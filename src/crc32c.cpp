@@ -0,0 +1,177 @@
+/*
+  ISC License
+
+  Copyright (c) 2016, Antonio SJ Musumeci <trapexit@spawn.link>
+
+  Permission to use, copy, modify, and/or distribute this software for any
+  purpose with or without fee is hereby granted, provided that the above
+  copyright notice and this permission notice appear in all copies.
+
+  THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+  WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+  MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+  ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+  WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+  ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+  OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+*/
+
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+#if defined(__x86_64__)
+#include <immintrin.h>
+#define CRC32C_X86 1
+#elif defined(__aarch64__)
+#include <arm_acle.h>
+#include <sys/auxv.h>
+#define CRC32C_ARM 1
+#endif
+
+#include "crc32c.hpp"
+
+namespace l
+{
+  typedef uint32_t (*CRCFunc)(const char*,const size_t,uint32_t);
+
+  static const uint32_t POLY = 0x82F63B78;
+
+  struct Table
+  {
+    uint32_t t[256];
+
+    Table()
+    {
+      for(uint32_t i = 0; i < 256; i++)
+        {
+          uint32_t c = i;
+
+          for(int j = 0; j < 8; j++)
+            c = ((c & 1) ? ((c >> 1) ^ POLY) : (c >> 1));
+          t[i] = c;
+        }
+    }
+  };
+
+  static
+  uint32_t
+  crc_scalar(const char   *buf_,
+             const size_t  len_,
+             uint32_t      crc_)
+  {
+    static const Table table;
+
+    for(size_t i = 0; i < len_; i++)
+      crc_ = (table.t[(crc_ ^ (uint8_t)buf_[i]) & 0xFF] ^ (crc_ >> 8));
+
+    return crc_;
+  }
+
+#if defined(CRC32C_X86)
+  __attribute__((target("sse4.2")))
+  static
+  uint32_t
+  crc_sse42(const char   *buf_,
+            const size_t  len_,
+            uint32_t      crc_)
+  {
+    size_t i;
+    uint64_t c = crc_;
+
+    for(i = 0; (i + 8) <= len_; i += 8)
+      {
+        uint64_t v;
+
+        ::memcpy(&v,&buf_[i],sizeof(v));
+        c = _mm_crc32_u64(c,v);
+      }
+
+    for(; i < len_; i++)
+      c = _mm_crc32_u8((uint32_t)c,(uint8_t)buf_[i]);
+
+    return (uint32_t)c;
+  }
+#endif
+
+#if defined(CRC32C_ARM)
+  __attribute__((target("+crc")))
+  static
+  uint32_t
+  crc_armv8(const char   *buf_,
+            const size_t  len_,
+            uint32_t      crc_)
+  {
+    size_t i;
+
+    for(i = 0; (i + 8) <= len_; i += 8)
+      {
+        uint64_t v;
+
+        ::memcpy(&v,&buf_[i],sizeof(v));
+        crc_ = __crc32cd(crc_,v);
+      }
+
+    for(; i < len_; i++)
+      crc_ = __crc32cb(crc_,(uint8_t)buf_[i]);
+
+    return crc_;
+  }
+#endif
+
+  struct Kernel
+  {
+    const char *name;
+    CRCFunc     crc;
+  };
+
+  static
+  Kernel
+  select_kernel(void)
+  {
+    Kernel k = {"scalar",crc_scalar};
+
+#if defined(CRC32C_X86)
+    __builtin_cpu_init();
+    if(__builtin_cpu_supports("sse4.2"))
+      {
+        k.name = "sse4.2";
+        k.crc  = crc_sse42;
+      }
+#elif defined(CRC32C_ARM)
+    if(::getauxval(AT_HWCAP) & HWCAP_CRC32)
+      {
+        k.name = "armv8-crc";
+        k.crc  = crc_armv8;
+      }
+#endif
+
+    return k;
+  }
+
+  static
+  const Kernel &
+  kernel(void)
+  {
+    static const Kernel k = select_kernel();
+
+    return k;
+  }
+}
+
+namespace CRC32C
+{
+  uint32_t
+  calculate(const void     *buf_,
+            const size_t    len_,
+            const uint32_t  crc_)
+  {
+    return ~l::kernel().crc((const char*)buf_,len_,~crc_);
+  }
+
+  const char *
+  isa(void)
+  {
+    return l::kernel().name;
+  }
+}
@@ -0,0 +1,190 @@
+/*
+  ISC License
+
+  Copyright (c) 2016, Antonio SJ Musumeci <trapexit@spawn.link>
+
+  Permission to use, copy, modify, and/or distribute this software for any
+  purpose with or without fee is hereby granted, provided that the above
+  copyright notice and this permission notice appear in all copies.
+
+  THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+  WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+  MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+  ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+  WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+  ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+  OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+*/
+
+#include "devinfocache.hpp"
+#include "ioctl.hpp"
+
+#include <errno.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <sys/sysmacros.h>
+#include <sys/types.h>
+#include <unistd.h>
+
+#include <fstream>
+#include <sstream>
+#include <string>
+
+#define DEVINFOCACHE_DIR     "/run/bbf"
+#define DEVINFOCACHE_MAGIC   "BBFDEVI"
+#define DEVINFOCACHE_VERSION 1
+
+namespace l
+{
+  struct Key
+  {
+    std::string filepath;
+    uint64_t    diskseq;
+    uint64_t    size_in_bytes;
+  };
+
+  static
+  int
+  key(const int  fd_,
+      Key       &key_)
+  {
+    int rv;
+    int64_t seq;
+    int64_t size;
+    struct stat st;
+    std::ostringstream ss;
+
+    rv = ::fstat(fd_,&st);
+    if(rv == -1)
+      return -errno;
+    if(!S_ISBLK(st.st_mode))
+      return -ENOTBLK;
+
+    seq = IOCtl::diskseq(fd_);
+    if(seq < 0)
+      return seq;
+
+    size = IOCtl::size_in_bytes(fd_);
+    if(size < 0)
+      return size;
+
+    ss << DEVINFOCACHE_DIR << "/devinfo."
+       << major(st.st_rdev) << ':' << minor(st.st_rdev);
+
+    key_.filepath      = ss.str();
+    key_.diskseq       = seq;
+    key_.size_in_bytes = size;
+
+    return 0;
+  }
+
+  template<typename T>
+  static
+  bool
+  read(std::istream &is_,
+       T            &v_)
+  {
+    is_.read((char*)&v_,sizeof(v_));
+
+    return is_.good();
+  }
+
+  template<typename T>
+  static
+  void
+  write(std::ostream &os_,
+        const T       v_)
+  {
+    os_.write((const char*)&v_,sizeof(v_));
+  }
+}
+
+namespace DevInfoCache
+{
+  bool
+  load(const int  fd_,
+       int       &result_,
+       char       identify_[512])
+  {
+    int rv;
+    char magic[8];
+    uint32_t version;
+    uint64_t diskseq;
+    uint64_t size_in_bytes;
+    int32_t result;
+    l::Key key;
+    std::ifstream file;
+
+    rv = l::key(fd_,key);
+    if(rv < 0)
+      return false;
+
+    file.open(key.filepath.c_str(),std::ios::in|std::ios::binary);
+    if(!file.is_open())
+      return false;
+
+    file.read(magic,sizeof(magic));
+    if(!file.good() ||
+       (::memcmp(magic,DEVINFOCACHE_MAGIC,sizeof(magic)) != 0) ||
+       !l::read(file,version)       || (version       != DEVINFOCACHE_VERSION) ||
+       !l::read(file,diskseq)       || (diskseq       != key.diskseq) ||
+       !l::read(file,size_in_bytes) || (size_in_bytes != key.size_in_bytes) ||
+       !l::read(file,result))
+      return false;
+
+    file.read(identify_,512);
+    if(!file.good())
+      return false;
+
+    result_ = result;
+
+    return true;
+  }
+
+  void
+  store(const int   fd_,
+        const int   result_,
+        const char  identify_[512])
+  {
+    int rv;
+    l::Key key;
+    std::string tmppath;
+    std::ofstream file;
+    std::ostringstream ss;
+
+    // without privileges the probe fails for reasons of our own
+    if((result_ == -EPERM) || (result_ == -EACCES))
+      return;
+
+    rv = l::key(fd_,key);
+    if(rv < 0)
+      return;
+
+    rv = ::mkdir(DEVINFOCACHE_DIR,0700);
+    if((rv == -1) && (errno != EEXIST))
+      return;
+
+    ss << key.filepath << ".tmp." << ::getpid();
+    tmppath = ss.str();
+
+    file.open(tmppath.c_str(),std::ios::out|std::ios::binary|std::ios::trunc);
+    if(!file.is_open())
+      return;
+
+    file.write(DEVINFOCACHE_MAGIC,sizeof(DEVINFOCACHE_MAGIC));
+    l::write<uint32_t>(file,DEVINFOCACHE_VERSION);
+    l::write<uint64_t>(file,key.diskseq);
+    l::write<uint64_t>(file,key.size_in_bytes);
+    l::write<int32_t>(file,result_);
+    if(result_ == 0)
+      file.write(identify_,512);
+    else
+      file.write(std::string(512,'\0').data(),512);
+
+    file.close();
+    if(file.fail() || (::rename(tmppath.c_str(),key.filepath.c_str()) == -1))
+      ::unlink(tmppath.c_str());
+  }
+}
@@ -0,0 +1,44 @@
+/*
+  ISC License
+
+  Copyright (c) 2016, Antonio SJ Musumeci <trapexit@spawn.link>
+
+  Permission to use, copy, modify, and/or distribute this software for any
+  purpose with or without fee is hereby granted, provided that the above
+  copyright notice and this permission notice appear in all copies.
+
+  THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+  WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+  MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+  ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+  WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+  ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+  OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+*/
+
+#pragma once
+
+/*
+  Per boot cache of each device's IDENTIFY DEVICE response so repeat
+  invocations don't wait on drives, USB bridges or expanders which
+  are slow to answer it or never do. Stored in /run/bbf, which is
+  cleared on reboot, one file per device named by st_rdev:
+
+    "BBFDEVI\0" u32:version u64:diskseq u64:size_in_bytes
+    i32:result u8[512]:identify
+
+  An entry is only trusted while the disk sequence number and size
+  match, so a different drive attached under the same device number
+  is probed again. Failures are remembered as well so a bridge that
+  never answers only costs the timeout once. Nothing is cached for
+  kernels without BLKGETDISKSEQ.
+*/
+namespace DevInfoCache
+{
+  bool load(const int  fd,
+            int       &result,
+            char       identify[512]);
+  void store(const int   fd,
+             const int   result,
+             const char  identify[512]);
+}
@@ -0,0 +1,198 @@
+/*
+  ISC License
+
+  Copyright (c) 2016, Antonio SJ Musumeci <trapexit@spawn.link>
+
+  Permission to use, copy, modify, and/or distribute this software for any
+  purpose with or without fee is hereby granted, provided that the above
+  copyright notice and this permission notice appear in all copies.
+
+  THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+  WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+  MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+  ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+  WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+  ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+  OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+*/
+
+#include "discard.hpp"
+
+#include "bufpool.hpp"
+#include "signals.hpp"
+
+#include <errno.h>
+#include <stdint.h>
+
+#include <algorithm>
+
+namespace l
+{
+  /*
+    Large enough the kernel or drive gets to issue maximal requests,
+    small enough progress moves and a signal is noticed promptly.
+  */
+  static const uint64_t DISCARD_CHUNK_BYTES = (1024ULL * 1024ULL * 1024ULL);
+  static const uint64_t DISCARD_RETRY_BYTES = (1024ULL * 1024ULL);
+
+  /*
+    A drive may fail a discard covering a block it can't map, so a
+    failed chunk is retried in DISCARD_RETRY_BYTES pieces and those
+    still failing are left as is for verification to judge.
+  */
+  static
+  int64_t
+  discard_chunk(BlkDev         &blkdev_,
+                const uint64_t  block_,
+                const uint64_t  blocks_)
+  {
+    int rv;
+    uint64_t n;
+    uint64_t piece;
+    uint64_t skipped;
+
+    rv = blkdev_.discard(block_,blocks_);
+    if(rv != -EIO)
+      return rv;
+
+    piece = std::max(DISCARD_RETRY_BYTES / blkdev_.logical_block_size(),
+                     (uint64_t)1);
+
+    skipped = 0;
+    for(uint64_t i = 0; i < blocks_; i += n)
+      {
+        n  = std::min(piece,(blocks_ - i));
+        rv = blkdev_.discard(block_ + i,n);
+        if(rv == -EIO)
+          skipped += n;
+        else if(rv < 0)
+          return rv;
+      }
+
+    return skipped;
+  }
+
+  static
+  bool
+  zeroed(const char     *buf_,
+         const uint64_t  len_)
+  {
+    const uint64_t *p   = (const uint64_t*)buf_;
+    const uint64_t *end = (const uint64_t*)(buf_ + len_);
+
+    for(; p != end; p++)
+      if(*p != 0)
+        return false;
+
+    return true;
+  }
+}
+
+namespace Discard
+{
+  /*
+    Returns the number of blocks the device refused to discard or
+    -errno if discard isn't supported or interrupted.
+  */
+  int64_t
+  range(BlkDev         &blkdev_,
+        const uint64_t  start_block_,
+        const uint64_t  end_block_,
+        Progress       *progress_)
+  {
+    int64_t rv;
+    uint64_t n;
+    uint64_t chunk;
+    uint64_t skipped;
+
+    chunk = std::max(l::DISCARD_CHUNK_BYTES / blkdev_.logical_block_size(),
+                     (uint64_t)1);
+
+    skipped = 0;
+    for(uint64_t block = start_block_; block < end_block_; block += n)
+      {
+        if(signals::signaled_to_exit())
+          return -EINTR;
+
+        n  = std::min(chunk,(end_block_ - block));
+        rv = l::discard_chunk(blkdev_,block,n);
+        if(rv < 0)
+          return rv;
+
+        skipped += rv;
+        if(progress_)
+          progress_->set_current(block + n);
+      }
+
+    return skipped;
+  }
+
+  /*
+    Blocks of a failed request are read individually so only those
+    which fail are added to badblocks_. Returns -EINTR if interrupted.
+  */
+  int
+  verify_zero(BlkDev                &blkdev_,
+              const uint64_t         start_block_,
+              const uint64_t         end_block_,
+              const uint64_t         stepping_,
+              std::vector<uint64_t> &badblocks_,
+              uint64_t              &nonzero_,
+              Progress              *progress_)
+  {
+    int rv;
+    char *buf;
+    bool strict;
+    uint64_t n;
+    uint64_t lbs;
+    uint64_t buflen;
+
+    lbs    = blkdev_.logical_block_size();
+    buflen = (stepping_ * lbs);
+    buf    = (char*)BufPool::get(buflen);
+    if(buf == NULL)
+      return -ENOMEM;
+
+    rv       = 0;
+    strict   = blkdev_.discard_zeroes();
+    nonzero_ = 0;
+    for(uint64_t block = start_block_; block < end_block_; block += n)
+      {
+        if(signals::signaled_to_exit())
+          {
+            rv = -EINTR;
+            break;
+          }
+
+        n = std::min(stepping_,(end_block_ - block));
+        if((blkdev_.read(block,n,buf,buflen) >= 0) && l::zeroed(buf,n * lbs))
+          {
+            if(progress_)
+              progress_->set_current(block + n);
+            continue;
+          }
+
+        for(uint64_t i = 0; i < n; i++)
+          {
+            if(blkdev_.read(block + i,1,buf,buflen) < 0)
+              badblocks_.push_back(block + i);
+            else if(!l::zeroed(buf,lbs))
+              {
+                nonzero_++;
+                if(strict)
+                  badblocks_.push_back(block + i);
+              }
+          }
+
+        if(progress_)
+          {
+            progress_->set_current(block + n);
+            progress_->set_bad(badblocks_);
+          }
+      }
+
+    BufPool::put(buf);
+
+    return rv;
+  }
+}
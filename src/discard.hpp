@@ -0,0 +1,52 @@
+/*
+  ISC License
+
+  Copyright (c) 2016, Antonio SJ Musumeci <trapexit@spawn.link>
+
+  Permission to use, copy, modify, and/or distribute this software for any
+  purpose with or without fee is hereby granted, provided that the above
+  copyright notice and this permission notice appear in all copies.
+
+  THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+  WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+  MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+  ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+  WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+  ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+  OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+*/
+
+#pragma once
+
+#include "blkdev.hpp"
+#include "progress.hpp"
+
+#include <stdint.h>
+
+#include <vector>
+
+/*
+  Discard (TRIM) support for SSDs. Discarding a range drops the
+  drive's mapping for it so a following destructive pass writes to
+  freshly erased flash and, if the drive is left discarded afterwards,
+  it starts its next life without stale mappings. verify_zero reads
+  the range back expecting zeros: read failures are bad blocks while
+  non-zero blocks only count as bad when the drive promises
+  deterministic zeros after TRIM.
+*/
+
+namespace Discard
+{
+  int64_t range(BlkDev         &blkdev,
+                const uint64_t  start_block,
+                const uint64_t  end_block,
+                Progress       *progress);
+
+  int verify_zero(BlkDev                &blkdev,
+                  const uint64_t         start_block,
+                  const uint64_t         end_block,
+                  const uint64_t         stepping,
+                  std::vector<uint64_t> &badblocks,
+                  uint64_t              &nonzero,
+                  Progress              *progress);
+}
@@ -16,11 +16,14 @@
   OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
 */
 
+#include <errno.h>
 #include <linux/fiemap.h>
 #include <linux/fs.h>
 #include <stdlib.h>
 #include <sys/ioctl.h>
 
+#include "fiemap.hpp"
+
 namespace FIEMap
 {
   int
@@ -68,4 +71,57 @@ namespace FIEMap
 
     return fm;
   }
+
+  Reader::Reader()
+  {
+    _fm = (struct fiemap*)::calloc(1,(sizeof(struct fiemap) +
+                                      (sizeof(struct fiemap_extent) * EXTENTS)));
+  }
+
+  Reader::~Reader()
+  {
+    ::free(_fm);
+  }
+
+  int
+  Reader::read(const int  fd_,
+               Callback   cb_,
+               void      *data_)
+  {
+    int rv;
+    uint64_t count;
+
+    if(_fm == NULL)
+      return -ENOMEM;
+
+    count = 0;
+    _fm->fm_start = 0;
+    for(;;)
+      {
+        const struct fiemap_extent *last;
+
+        _fm->fm_length         = (FIEMAP_MAX_OFFSET - _fm->fm_start);
+        _fm->fm_flags          = 0;
+        _fm->fm_mapped_extents = 0;
+        _fm->fm_extent_count   = EXTENTS;
+
+        rv = ::ioctl(fd_,FS_IOC_FIEMAP,_fm);
+        if(rv == -1)
+          return -errno;
+        if(_fm->fm_mapped_extents == 0)
+          break;
+
+        for(uint32_t i = 0; i < _fm->fm_mapped_extents; i++)
+          cb_(_fm->fm_extents[i],data_);
+        count += _fm->fm_mapped_extents;
+
+        last = &_fm->fm_extents[_fm->fm_mapped_extents - 1];
+        if(last->fe_flags & FIEMAP_EXTENT_LAST)
+          break;
+
+        _fm->fm_start = (last->fe_logical + last->fe_length);
+      }
+
+    return count;
+  }
 }
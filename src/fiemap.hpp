@@ -20,11 +20,42 @@
 #define __FIEMAP_HPP__
 
 #include <linux/fiemap.h>
+#include <stdint.h>
 
 namespace FIEMap
 {
   int            extent_map_count(const int fd);
   struct fiemap *extent_map(const int fd);
+
+  typedef void (*Callback)(const struct fiemap_extent &extent,
+                           void                       *data);
+
+  /*
+    Streams a file's extents through a fixed size buffer, reissuing
+    FS_IOC_FIEMAP from the end of the last batch until the final
+    extent is seen. One Reader can be reused for any number of files.
+  */
+  class Reader
+  {
+  public:
+    static const uint32_t EXTENTS = 512;
+
+  public:
+    Reader();
+    ~Reader();
+
+  public:
+    int read(const int  fd,
+             Callback   cb,
+             void      *data);
+
+  private:
+    Reader(const Reader &);
+    Reader &operator=(const Reader &);
+
+  private:
+    struct fiemap *_fm;
+  };
 }
 
 #endif
@@ -25,6 +25,7 @@
 #include <unistd.h>
 
 #include <string>
+#include <utility>
 #include <vector>
 
 #include "fiemap.hpp"
@@ -38,31 +39,34 @@ namespace File
 }
 
 static
-int
-blocks(const int          fd,
-       const int64_t      blocksize,
-       File::BlockVector &blockvector)
+void
+add_block(const struct fiemap_extent &fme_,
+          void                       *data_)
 {
-  struct fiemap *fm;
+  File::Block block;
+  std::pair<int64_t,File::BlockVector*> *data;
 
-  fm = FIEMap::extent_map(fd);
-  if(fm == NULL)
-    return -ENOMEM;
+  data = (std::pair<int64_t,File::BlockVector*>*)data_;
 
-  for(int i = 0; i < fm->fm_mapped_extents; i++)
-    {
-      File::Block block;
-      const struct fiemap_extent *fme = &fm->fm_extents[i];
+  block.block  = (fme_.fe_physical / data->first);
+  block.length = (fme_.fe_length   / data->first);
 
-      block.block  = (fme->fe_physical / blocksize);
-      block.length = (fme->fe_length   / blocksize);
+  data->second->push_back(block);
+}
 
-      blockvector.push_back(block);
-    }
+static
+int
+blocks(const int          fd,
+       const int64_t      blocksize,
+       File::BlockVector &blockvector)
+{
+  int rv;
+  FIEMap::Reader reader;
+  std::pair<int64_t,File::BlockVector*> data(blocksize,&blockvector);
 
-  ::free(fm);
+  rv = reader.read(fd,add_block,&data);
 
-  return 0;
+  return ((rv < 0) ? rv : 0);
 }
 
 namespace File
@@ -89,6 +93,39 @@ namespace File
     return logical_block_size;
   }
 
+  /*
+    Offset, in logical blocks of the whole disk, to add to a block
+    relative to the filesystem's device holding filepath to get the
+    LBA `scan` of the whole disk reports.
+  */
+  int64_t
+  lba_offset(const std::string &filepath)
+  {
+    int rv;
+    int fd;
+    int64_t logical_block_size;
+    FileToBlkDev::Disk disk;
+
+    rv = FileToBlkDev::disk(filepath,disk);
+    if(rv < 0)
+      return rv;
+    if(disk.start == 0)
+      return 0;
+
+    fd = ::open(disk.disk.c_str(),O_RDONLY|O_NONBLOCK);
+    if(fd == -1)
+      return -errno;
+
+    logical_block_size = IOCtl::logical_block_size(fd);
+
+    ::close(fd);
+
+    if(logical_block_size <= 0)
+      return ((logical_block_size < 0) ? logical_block_size : -EINVAL);
+
+    return ((disk.start * 512) / logical_block_size);
+  }
+
   int
   blocks(const std::string &filepath,
          BlockVector       &blockvector)
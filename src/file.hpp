@@ -32,6 +32,9 @@ namespace File
   int64_t
   logical_block_size(const std::string &filepath);
 
+  int64_t
+  lba_offset(const std::string &filepath);
+
   int
   blocks(const std::string &filepath,
          BlockVector       &blockvector);
@@ -16,12 +16,24 @@
   OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
 */
 
+#include "filetoblkdev.hpp"
+
 #include <dirent.h>
+#include <errno.h>
+#include <limits.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
 #include <sys/stat.h>
+#include <sys/sysmacros.h>
 #include <sys/types.h>
 #include <unistd.h>
 
+#include <algorithm>
+#include <fstream>
+#include <sstream>
 #include <string>
+#include <vector>
 
 namespace FileToBlkDev
 {
@@ -49,9 +61,81 @@ namespace FileToBlkDev
     return ((rv == -1) ? -1 : st.st_rdev);
   }
 
+  static
+  bool
+  is_blkdev(const std::string &devpath,
+            const dev_t        device)
+  {
+    int rv;
+    struct stat st;
+
+    rv = ::lstat(devpath.c_str(),&st);
+    if(rv == -1)
+      return false;
+
+    return (S_ISBLK(st.st_mode) && (st.st_rdev == device));
+  }
+
+  /*
+    The kernel's name for the device from its uevent, which is what
+    udev and devtmpfs name the node in /dev.
+  */
   static
   std::string
-  find(const dev_t device)
+  find_sysfs(const dev_t device)
+  {
+    std::string line;
+    std::ifstream file;
+    char sysfs[PATH_MAX];
+
+    ::snprintf(sysfs,sizeof(sysfs),"/sys/dev/block/%u:%u/uevent",
+               major(device),minor(device));
+
+    file.open(sysfs);
+    if(!file.is_open())
+      return std::string();
+
+    while(std::getline(file,line))
+      {
+        std::string devpath;
+
+        if(line.compare(0,8,"DEVNAME=") != 0)
+          continue;
+
+        devpath = "/dev/" + line.substr(8);
+        if(is_blkdev(devpath,device))
+          return devpath;
+        break;
+      }
+
+    return std::string();
+  }
+
+  /* udev's /dev/block/<major>:<minor> link to the node */
+  static
+  std::string
+  find_udev(const dev_t device)
+  {
+    char *realpath;
+    std::string devpath;
+    char link[PATH_MAX];
+
+    ::snprintf(link,sizeof(link),"/dev/block/%u:%u",
+               major(device),minor(device));
+
+    realpath = ::realpath(link,NULL);
+    if(realpath == NULL)
+      return std::string();
+
+    devpath = realpath;
+    ::free(realpath);
+
+    return (is_blkdev(devpath,device) ? devpath : std::string());
+  }
+
+  static
+  std::string
+  find_dev(const dev_t device)
   {
     DIR *dir;
     std::string devpath;
@@ -80,6 +164,29 @@ namespace FileToBlkDev
     return std::string();
   }
 
+  /*
+    Looking the node up by its number in sysfs, or udev's link to it,
+    is a couple of reads. Walking /dev is kept for systems without
+    either and stats every node, thousands on hosts with many
+    multipath, NVMe or loop devices.
+  */
+  static
+  std::string
+  find(const dev_t device)
+  {
+    std::string devpath;
+
+    devpath = find_sysfs(device);
+    if(!devpath.empty())
+      return devpath;
+
+    devpath = find_udev(device);
+    if(!devpath.empty())
+      return devpath;
+
+    return find_dev(device);
+  }
+
   std::string
   find(const std::string &filepath)
   {
@@ -89,4 +196,181 @@ namespace FileToBlkDev
 
     return FileToBlkDev::find(device);
   }
+
+  /*
+    The device holding filepath's filesystem and, when it's a
+    partition, the whole disk it's on and its start there in 512 byte
+    sectors as sysfs reports it regardless of the logical block size.
+    A filesystem not on a partition is its own disk with start 0.
+  */
+  int
+  disk(const std::string &filepath,
+       Disk              &disk)
+  {
+    dev_t device;
+    uint64_t start;
+    unsigned int dmajor;
+    unsigned int dminor;
+    std::string parent;
+    std::ifstream file;
+    char sysfs[PATH_MAX];
+
+    device = st_dev(filepath);
+    if(device == (dev_t)-1)
+      return -errno;
+
+    disk.partition = FileToBlkDev::find(device);
+    if(disk.partition.empty())
+      return -ENOENT;
+    disk.disk  = disk.partition;
+    disk.start = 0;
+
+    ::snprintf(sysfs,sizeof(sysfs),"/sys/dev/block/%u:%u/start",
+               major(device),minor(device));
+    file.open(sysfs);
+    if(!file.is_open())
+      return 0;
+    file >> start;
+    if(file.fail())
+      return 0;
+    file.close();
+    disk.start = start;
+
+    ::snprintf(sysfs,sizeof(sysfs),"/sys/dev/block/%u:%u/../dev",
+               major(device),minor(device));
+    file.clear();
+    file.open(sysfs);
+    if(!file.is_open())
+      return 0;
+    file >> parent;
+    if(::sscanf(parent.c_str(),"%u:%u",&dmajor,&dminor) != 2)
+      return 0;
+
+    parent = FileToBlkDev::find(makedev(dmajor,dminor));
+    if(!parent.empty())
+      disk.disk = parent;
+
+    return 0;
+  }
+
+  /* /proc/self/mounts escapes whitespace and backslashes as \ooo */
+  static
+  std::string
+  unescape(const std::string &str_)
+  {
+    std::string rv;
+
+    for(size_t i = 0; i < str_.size(); i++)
+      {
+        if((str_[i] == '\\') && ((i + 3) < str_.size()))
+          {
+            rv.push_back((char)::strtol(str_.substr(i + 1,3).c_str(),NULL,8));
+            i += 3;
+            continue;
+          }
+
+        rv.push_back(str_[i]);
+      }
+
+    return rv;
+  }
+
+  /*
+    The start in 512 byte sectors on the device `disk` of the
+    filesystem on `device`: 0 when they're the same, the partition
+    start when device is one of disk's partitions, else -1.
+  */
+  static
+  int64_t
+  start_on(const dev_t device,
+           const dev_t disk)
+  {
+    char sysfs[PATH_MAX];
+    std::string parent;
+    std::ifstream file;
+    std::ostringstream expected;
+    uint64_t start;
+
+    if(device == disk)
+      return 0;
+
+    ::snprintf(sysfs,sizeof(sysfs),"/sys/dev/block/%u:%u/../dev",
+               major(device),minor(device));
+    file.open(sysfs);
+    if(!file.is_open())
+      return -1;
+    file >> parent;
+    file.close();
+
+    expected << major(disk) << ':' << minor(disk);
+    if(parent != expected.str())
+      return -1;
+
+    ::snprintf(sysfs,sizeof(sysfs),"/sys/dev/block/%u:%u/start",
+               major(device),minor(device));
+    file.clear();
+    file.open(sysfs);
+    if(!file.is_open())
+      return -1;
+    file >> start;
+    if(file.fail())
+      return -1;
+
+    return start;
+  }
+
+  /*
+    Mounted filesystems living on devpath or one of its partitions,
+    one entry per filesystem regardless of how often it's mounted.
+  */
+  int
+  mounts(const std::string  &devpath_,
+         std::vector<Mount> &mounts_)
+  {
+    int rv;
+    struct stat st;
+    std::string line;
+    std::ifstream file;
+    std::vector<dev_t> seen;
+
+    rv = ::stat(devpath_.c_str(),&st);
+    if(rv == -1)
+      return -errno;
+    if(!S_ISBLK(st.st_mode))
+      return -ENOTBLK;
+
+    file.open("/proc/self/mounts");
+    if(!file.is_open())
+      return -ENOENT;
+
+    while(std::getline(file,line))
+      {
+        dev_t device;
+        int64_t start;
+        Mount mount;
+        std::string source;
+        std::istringstream is(line);
+
+        is >> source >> mount.path;
+        if(is.fail())
+          continue;
+
+        mount.path = unescape(mount.path);
+        device     = st_dev(mount.path);
+        if(device == (dev_t)-1)
+          continue;
+        if(std::find(seen.begin(),seen.end(),device) != seen.end())
+          continue;
+
+        start = start_on(device,st.st_rdev);
+        if(start < 0)
+          continue;
+
+        seen.push_back(device);
+        mount.start = start;
+        mounts_.push_back(mount);
+      }
+
+    return mounts_.size();
+  }
 }
@@ -19,12 +19,36 @@
 #ifndef __FILETOBLKDEV_HPP__
 #define __FILETOBLKDEV_HPP__
 
+#include <stdint.h>
+
 #include <string>
+#include <vector>
 
 namespace FileToBlkDev
 {
+  struct Mount
+  {
+    std::string path;
+    uint64_t    start;
+  };
+
+  struct Disk
+  {
+    std::string partition;
+    std::string disk;
+    uint64_t    start;
+  };
+
   std::string
   find(const std::string &filepath);
+
+  int
+  disk(const std::string &filepath,
+       Disk              &disk);
+
+  int
+  mounts(const std::string  &devpath,
+         std::vector<Mount> &mounts);
 }
 
 #endif
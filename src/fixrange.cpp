@@ -0,0 +1,267 @@
+/*
+  ISC License
+
+  Copyright (c) 2016, Antonio SJ Musumeci <trapexit@spawn.link>
+
+  Permission to use, copy, modify, and/or distribute this software for any
+  purpose with or without fee is hereby granted, provided that the above
+  copyright notice and this permission notice appear in all copies.
+
+  THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+  WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+  MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+  ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+  WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+  ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+  OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+*/
+
+#include <errno.h>
+#include <stdint.h>
+#include <string.h>
+
+#include <algorithm>
+#include <ostream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "blkdev.hpp"
+#include "errors.hpp"
+#include "fixrange.hpp"
+#include "signals.hpp"
+
+#define DEFAULT_FIX_BYTES (1024 * 1024)
+
+namespace l
+{
+  static
+  int64_t
+  read(BlkDev             &blkdev_,
+       const uint64_t      block_,
+       const uint64_t      count_,
+       char               *buf_,
+       const unsigned int  retries_,
+       uint64_t           &attempts_)
+  {
+    int64_t rv;
+    const uint64_t buflen = (count_ * blkdev_.logical_block_size());
+
+    rv = -1;
+    for(attempts_ = 0; ((attempts_ <= retries_) && (rv < 0)); attempts_++)
+      rv = blkdev_.read(block_,count_,buf_,buflen);
+
+    return rv;
+  }
+
+  static
+  int64_t
+  write(BlkDev             &blkdev_,
+        const uint64_t      block_,
+        const uint64_t      count_,
+        const char         *buf_,
+        const unsigned int  retries_,
+        uint64_t           &attempts_)
+  {
+    int64_t rv;
+    const uint64_t buflen = (count_ * blkdev_.logical_block_size());
+
+    rv = -1;
+    for(attempts_ = 0; ((attempts_ <= retries_) && (rv < 0)); attempts_++)
+      rv = blkdev_.write(block_,count_,buf_,buflen);
+
+    return rv;
+  }
+
+  /*
+    Carry out reqs_ as one batch and resubmit those which failed, each
+    at most retries_ more times. attempts_ receives the number of
+    tries per request.
+  */
+  static
+  void
+  submit(BlkDev                       &blkdev_,
+         std::vector<BlkDev::Request> &reqs_,
+         const unsigned int            retries_,
+         std::vector<uint64_t>        &attempts_)
+  {
+    std::vector<size_t> idx;
+    std::vector<BlkDev::Request> retry;
+
+    attempts_.assign(reqs_.size(),1);
+    blkdev_.submit(reqs_);
+    for(unsigned int r = 0; r < retries_; r++)
+      {
+        idx.clear();
+        retry.clear();
+        for(size_t i = 0; i < reqs_.size(); i++)
+          {
+            if(reqs_[i].rv >= 0)
+              continue;
+            idx.push_back(i);
+            retry.push_back(reqs_[i]);
+          }
+
+        if(retry.empty())
+          break;
+
+        blkdev_.submit(retry);
+        for(size_t i = 0; i < idx.size(); i++)
+          {
+            reqs_[idx[i]] = retry[i];
+            attempts_[idx[i]]++;
+          }
+      }
+  }
+
+  /*
+    One request per block of [block_,block_+count_) over buf_.
+  */
+  static
+  void
+  per_block(BlkDev                       &blkdev_,
+            const BlkDev::Op              op_,
+            const uint64_t                block_,
+            const uint64_t                count_,
+            char                         *buf_,
+            std::vector<BlkDev::Request> &reqs_)
+  {
+    const uint64_t lbs = blkdev_.logical_block_size();
+
+    reqs_.resize(count_);
+    for(uint64_t i = 0; i < count_; i++)
+      {
+        reqs_[i].lba    = (block_ + i);
+        reqs_[i].blocks = 1;
+        reqs_[i].buf    = (buf_ + (i * lbs));
+        reqs_[i].buflen = lbs;
+        reqs_[i].op     = op_;
+      }
+  }
+
+  static
+  void
+  report(std::ostream   &os_,
+         const char     *op_,
+         const uint64_t  block_,
+         const uint64_t  count_,
+         const int64_t   rv_,
+         const uint64_t  attempts_,
+         const char     *on_failure_)
+  {
+    std::ostringstream line;
+
+    // clears any status line drawn by a ProgressReporter and is
+    // written in one go so it isn't interleaved with one
+    line << "\r\x1B[2K" << op_ << ((count_ == 1) ? " block " : " blocks ") << block_;
+    if(count_ > 1)
+      line << '-' << (block_ + count_ - 1);
+
+    if(rv_ < 0)
+      line << " failed [" << Error::to_string(-rv_) << "]" << on_failure_;
+    else
+      line << " succeeded";
+    line << " (" << attempts_ << " attempts)\n";
+
+    const std::string str = line.str();
+
+    os_.write(str.data(),str.size());
+    os_.flush();
+  }
+}
+
+namespace FixRange
+{
+  /*
+    Default to ~1MiB requests but never less than a physical block so
+    a reallocation always covers whole physical sectors.
+  */
+  uint64_t
+  stepping(const BlkDev   &blkdev_,
+           const uint64_t  stepping_)
+  {
+    if(stepping_ != 0)
+      return stepping_;
+
+    return std::max(blkdev_.block_stepping(),
+                    (DEFAULT_FIX_BYTES / blkdev_.logical_block_size()));
+  }
+
+  /*
+    Rewrite [block,block+count) in requests of up to `stepping` blocks,
+    buf must hold that many. Each request is read whole and only when
+    that fails reread block by block as one batch, zeroing the
+    unreadable ones. The request is then written back whole, again
+    dropping to a batch of single blocks only if that fails.
+  */
+  int
+  fix(BlkDev             &blkdev_,
+      const uint64_t      block_,
+      const uint64_t      count_,
+      const uint64_t      stepping_,
+      const unsigned int  retries_,
+      char               *buf_,
+      const bool          verbose_,
+      std::ostream       &os_)
+  {
+    int64_t rv;
+    uint64_t n;
+    uint64_t attempts;
+    std::vector<uint64_t> tries;
+    std::vector<BlkDev::Request> reqs;
+    const uint64_t end = (block_ + count_);
+    const uint64_t lbs = blkdev_.logical_block_size();
+
+    for(uint64_t block = block_; block < end; block += n)
+      {
+        if(signals::signaled_to_exit())
+          return -EINTR;
+
+        n = std::min(stepping_,(end - block));
+
+        rv = l::read(blkdev_,block,n,buf_,retries_,attempts);
+        if((rv < 0) && (n > 1))
+          {
+            l::report(os_,"Reading",block,n,rv,attempts," - reading blocks individually");
+            l::per_block(blkdev_,BlkDev::READ,block,n,buf_,reqs);
+            l::submit(blkdev_,reqs,retries_,tries);
+            for(uint64_t i = 0; i < n; i++)
+              {
+                rv = reqs[i].rv;
+                if((rv < 0) || verbose_)
+                  l::report(os_,"Reading",block+i,1,rv,tries[i]," - using zeros");
+                if(rv < 0)
+                  ::memset(reqs[i].buf,0,lbs);
+              }
+          }
+        else if((rv < 0) || verbose_)
+          {
+            l::report(os_,"Reading",block,n,rv,attempts," - using zeros");
+            if(rv < 0)
+              ::memset(buf_,0,(n * lbs));
+          }
+
+        rv = l::write(blkdev_,block,n,buf_,retries_,attempts);
+        if((rv < 0) && (n > 1))
+          {
+            l::report(os_,"Writing",block,n,rv,attempts," - writing blocks individually");
+            l::per_block(blkdev_,BlkDev::WRITE,block,n,buf_,reqs);
+            l::submit(blkdev_,reqs,retries_,tries);
+            for(uint64_t i = 0; i < n; i++)
+              {
+                rv = reqs[i].rv;
+                if((rv < 0) || verbose_)
+                  l::report(os_,"Writing",block+i,1,rv,tries[i],"");
+              }
+          }
+        else if((rv < 0) || verbose_)
+          {
+            l::report(os_,"Writing",block,n,rv,attempts,"");
+          }
+
+        os_.flush();
+      }
+
+    return 0;
+  }
+}
@@ -0,0 +1,319 @@
+/*
+  ISC License
+
+  Copyright (c) 2016, Antonio SJ Musumeci <trapexit@spawn.link>
+
+  Permission to use, copy, modify, and/or distribute this software for any
+  purpose with or without fee is hereby granted, provided that the above
+  copyright notice and this permission notice appear in all copies.
+
+  THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+  WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+  MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+  ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+  WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+  ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+  OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+*/
+
+#include <dirent.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <linux/fsmap.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <sys/ioctl.h>
+#include <sys/stat.h>
+#include <sys/types.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <string>
+#include <vector>
+
+#include "fsmap.hpp"
+
+namespace l
+{
+  static const uint32_t RECORDS = 256;
+
+  static
+  bool
+  dot_or_dot_dot(const char *path_)
+  {
+    return ((path_[0]                     == '.')  &&
+            ((path_[1] == '.' && path_[2] == '\0') ||
+             (path_[1]                    == '\0')));
+  }
+
+  static
+  void
+  set_keys(struct fsmap_head *head_,
+           const uint64_t     physical_lo_,
+           const uint64_t     physical_hi_)
+  {
+    struct fsmap *lo = &head_->fmh_keys[0];
+    struct fsmap *hi = &head_->fmh_keys[1];
+
+    *lo = fsmap();
+    lo->fmr_physical = physical_lo_;
+
+    *hi = fsmap();
+    hi->fmr_device   = UINT32_MAX;
+    hi->fmr_physical = physical_hi_;
+    hi->fmr_owner    = UINT64_MAX;
+    hi->fmr_offset   = UINT64_MAX;
+    hi->fmr_flags    = UINT32_MAX;
+  }
+
+  /*
+    Query one run of blocks [start,end) and attribute each record to
+    the bad blocks it covers.
+  */
+  static
+  int
+  query_run(const int           fd_,
+            struct fsmap_head  *head_,
+            const dev_t         device_,
+            const uint64_t      blocksize_,
+            const uint64_t     *begin_,
+            const uint64_t     *end_,
+            FSMap::BlockOwners &owners_)
+  {
+    int rv;
+
+    set_keys(head_,
+             (*begin_ * blocksize_),
+             ((*(end_ - 1) + 1) * blocksize_) - 1);
+
+    for(;;)
+      {
+        head_->fmh_iflags  = 0;
+        head_->fmh_oflags  = 0;
+        head_->fmh_count   = RECORDS;
+        head_->fmh_entries = 0;
+
+        rv = ::ioctl(fd_,FS_IOC_GETFSMAP,head_);
+        if(rv == -1)
+          return -errno;
+        if(head_->fmh_entries == 0)
+          break;
+
+        for(uint32_t i = 0; i < head_->fmh_entries; i++)
+          {
+            const uint64_t *b;
+            const uint64_t *e;
+            const struct fsmap *rec = &head_->fmh_recs[i];
+
+            // skip extents on other devices of the filesystem
+            // (external log, realtime)
+            if((head_->fmh_oflags & FMH_OF_DEV_T) &&
+               (rec->fmr_device != (uint32_t)device_))
+              continue;
+
+            if(rec->fmr_flags & FMR_OF_SPECIAL_OWNER)
+              {
+                if(rec->fmr_owner == FMR_OWN_UNKNOWN)
+                  return -EOPNOTSUPP;
+                continue;
+              }
+
+            b = std::lower_bound(begin_,end_,(rec->fmr_physical / blocksize_));
+            e = std::lower_bound(b,end_,((rec->fmr_physical + rec->fmr_length +
+                                          blocksize_ - 1) / blocksize_));
+            for(; b != e; ++b)
+              owners_[*b].push_back(rec->fmr_owner);
+          }
+
+        if(head_->fmh_recs[head_->fmh_entries - 1].fmr_flags & FMR_OF_LAST)
+          break;
+
+        fsmap_advance(head_);
+      }
+
+    return 0;
+  }
+
+  static
+  void
+  inode_paths(const std::string        &basepath_,
+              const std::set<uint64_t> &inodes_,
+              FSMap::InodePaths        &paths_)
+  {
+    DIR *dir;
+    struct dirent *d;
+
+    dir = ::opendir(basepath_.c_str());
+    if(dir == NULL)
+      return;
+
+    for(d = ::readdir(dir); d != NULL; d = ::readdir(dir))
+      {
+        std::string path;
+
+        if(dot_or_dot_dot(d->d_name))
+          continue;
+
+        path  = basepath_;
+        path += '/';
+        path += d->d_name;
+
+        if(inodes_.count(d->d_ino))
+          paths_[d->d_ino].push_back(path);
+
+        if(d->d_type == DT_DIR)
+          inode_paths(path,inodes_,paths_);
+      }
+
+    ::closedir(dir);
+  }
+}
+
+namespace FSMap
+{
+  int
+  owners(const std::string           &basepath_,
+         const uint64_t               blocksize_,
+         const std::vector<uint64_t> &blocks_,
+         BlockOwners                 &owners_)
+  {
+    int fd;
+    int rv;
+    struct stat st;
+    struct fsmap_head *head;
+    std::vector<uint64_t> blocks(blocks_);
+
+    std::sort(blocks.begin(),blocks.end());
+    blocks.erase(std::unique(blocks.begin(),blocks.end()),blocks.end());
+    if(blocks.empty())
+      return 0;
+
+    fd = ::open(basepath_.c_str(),O_RDONLY|O_DIRECTORY);
+    if(fd == -1)
+      return -errno;
+
+    head = (struct fsmap_head*)::calloc(1,fsmap_sizeof(l::RECORDS));
+    if(head == NULL)
+      {
+        ::close(fd);
+        return -ENOMEM;
+      }
+
+    if(::fstat(fd,&st) == -1)
+      st.st_dev = 0;
+
+    // query each run of consecutive blocks once
+    rv = 0;
+    for(uint64_t i = 0, j = 1, ei = blocks.size(); (rv == 0) && (i != ei); i = j++)
+      {
+        while((j != ei) && (blocks[j] == (blocks[j-1] + 1)))
+          j++;
+
+        rv = l::query_run(fd,
+                          head,
+                          st.st_dev,
+                          blocksize_,
+                          &blocks[i],
+                          &blocks[0] + j,
+                          owners_);
+      }
+
+    ::free(head);
+    ::close(fd);
+
+    return rv;
+  }
+
+  int
+  inode_paths(const std::string        &basepath_,
+              const std::set<uint64_t> &inodes_,
+              InodePaths               &paths_)
+  {
+    struct stat st;
+
+    if(::stat(basepath_.c_str(),&st) == -1)
+      return -errno;
+
+    if(inodes_.count(st.st_ino))
+      paths_[st.st_ino].push_back(basepath_);
+
+    l::inode_paths(basepath_,inodes_,paths_);
+
+    return 0;
+  }
+
+  int
+  allocated(const std::string   &basepath_,
+            std::vector<Extent> &extents_)
+  {
+    int fd;
+    int rv;
+    struct stat st;
+    struct fsmap_head *head;
+
+    fd = ::open(basepath_.c_str(),O_RDONLY|O_DIRECTORY);
+    if(fd == -1)
+      return -errno;
+
+    head = (struct fsmap_head*)::calloc(1,fsmap_sizeof(l::RECORDS));
+    if(head == NULL)
+      {
+        ::close(fd);
+        return -ENOMEM;
+      }
+
+    if(::fstat(fd,&st) == -1)
+      st.st_dev = 0;
+
+    l::set_keys(head,0,UINT64_MAX);
+
+    rv = 0;
+    for(;;)
+      {
+        head->fmh_iflags  = 0;
+        head->fmh_oflags  = 0;
+        head->fmh_count   = l::RECORDS;
+        head->fmh_entries = 0;
+
+        rv = ::ioctl(fd,FS_IOC_GETFSMAP,head);
+        if(rv == -1)
+          {
+            rv = -errno;
+            break;
+          }
+        if(head->fmh_entries == 0)
+          break;
+
+        for(uint32_t i = 0; i < head->fmh_entries; i++)
+          {
+            Extent extent;
+            const struct fsmap *rec = &head->fmh_recs[i];
+
+            if((head->fmh_oflags & FMH_OF_DEV_T) &&
+               (rec->fmr_device != (uint32_t)st.st_dev))
+              continue;
+            if((rec->fmr_flags & FMR_OF_SPECIAL_OWNER) &&
+               (rec->fmr_owner == FMR_OWN_FREE))
+              continue;
+
+            extent.start  = rec->fmr_physical;
+            extent.length = rec->fmr_length;
+            if(!extents_.empty() &&
+               ((extents_.back().start + extents_.back().length) == extent.start))
+              extents_.back().length += extent.length;
+            else
+              extents_.push_back(extent);
+          }
+
+        if(head->fmh_recs[head->fmh_entries - 1].fmr_flags & FMR_OF_LAST)
+          break;
+
+        fsmap_advance(head);
+      }
+
+    ::free(head);
+    ::close(fd);
+
+    return rv;
+  }
+}
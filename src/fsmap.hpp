@@ -0,0 +1,62 @@
+/*
+  ISC License
+
+  Copyright (c) 2016, Antonio SJ Musumeci <trapexit@spawn.link>
+
+  Permission to use, copy, modify, and/or distribute this software for any
+  purpose with or without fee is hereby granted, provided that the above
+  copyright notice and this permission notice appear in all copies.
+
+  THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+  WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+  MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+  ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+  WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+  ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+  OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+*/
+
+#pragma once
+
+#include <stdint.h>
+
+#include <map>
+#include <set>
+#include <string>
+#include <vector>
+
+/*
+  Reverse block lookups through FS_IOC_GETFSMAP. Only filesystems
+  which track extent ownership (XFS with rmapbt) can answer these; the
+  others report unknown owners and the caller should fall back to
+  walking the whole tree. Which blocks are in use is answered by ext4
+  as well.
+*/
+namespace FSMap
+{
+  typedef std::map<uint64_t,std::vector<uint64_t> > BlockOwners;
+  typedef std::map<uint64_t,std::vector<std::string> > InodePaths;
+
+  int owners(const std::string           &basepath,
+             const uint64_t               blocksize,
+             const std::vector<uint64_t> &blocks,
+             BlockOwners                 &owners);
+
+  int inode_paths(const std::string        &basepath,
+                  const std::set<uint64_t> &inodes,
+                  InodePaths               &paths);
+
+  struct Extent
+  {
+    uint64_t start;
+    uint64_t length;
+  };
+
+  /*
+    Byte ranges of the filesystem in use: everything but free space,
+    including metadata and extents of unknown owner, which is how
+    ext4 reports file data.
+  */
+  int allocated(const std::string   &basepath,
+                std::vector<Extent> &extents);
+}
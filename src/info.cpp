@@ -16,33 +16,59 @@
   OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
 */
 
+#include <algorithm>
 #include <iostream>
 #include <iomanip>
 #include <vector>
 
 #include <stdint.h>
 
+#include "progress.hpp"
+
 using namespace std;
 
 namespace Info
 {
+  /*
+    The status line for a Progress. Without a block range only the
+    count of items processed and the rate is shown.
+  */
   void
-  print(ostream                &os,
-        const double            start_time,
-        const double            current_time,
-        const size_t            start_block,
-        const size_t            end_block,
-        const size_t            current_block,
-        const vector<uint64_t> &badblocks)
+  print(ostream        &os,
+        const double    start_time,
+        const double    current_time,
+        const Progress &progress,
+        const char     *label)
   {
-    const size_t badcount          = badblocks.size();
-    const size_t processed_blocks  = (current_block - start_block);
-    const size_t total_blocks      = (end_block - start_block);
-    const size_t blocks_left       = (end_block - processed_blocks);
-    const double percentage        = (((double)processed_blocks / total_blocks) * 100.0);
-    const double time_passed       = (current_time - start_time);
-    const double blocks_per_second = ((double)processed_blocks / time_passed);
-    const size_t time_left         = ((double)blocks_left / blocks_per_second);
+    const uint64_t start_block      = progress.start_block();
+    const uint64_t end_block        = progress.end_block();
+    const uint64_t current_block    = progress.current_block();
+    const uint64_t badcount         = progress.bad_blocks();
+    const double   time_passed      = (current_time - start_time);
+    const uint64_t processed_blocks = (current_block - start_block);
+
+    if(end_block <= start_block)
+      {
+        os << "\r\x1B[2K" << label << ": " << current_block
+           << std::fixed
+           << std::setprecision(2)
+           << "; per second: "
+           << ((time_passed > 0) ? ((double)current_block / time_passed) : 0.0);
+        if(badcount)
+          os << "; errors: " << badcount;
+        os << std::flush;
+        return;
+      }
+
+    const uint64_t total_blocks      = (end_block - start_block);
+    const uint64_t blocks_left       = (total_blocks - std::min(processed_blocks,total_blocks));
+    const double   percentage        = (((double)processed_blocks / total_blocks) * 100.0);
+    const double   blocks_per_second = ((time_passed > 0) ?
+                                        ((double)processed_blocks / time_passed) :
+                                        0.0);
+    const size_t   time_left         = ((blocks_per_second > 0) ?
+                                        ((double)blocks_left / blocks_per_second) :
+                                        0);
 
     os << "\r\x1B[2KCurrent: " << current_block << " ("
        << std::fixed
@@ -58,7 +84,67 @@ namespace Info
        << (time_left%60)
        << "; bad: " << badcount;
     if(badcount)
-      os << "; last: " << badblocks[badcount-1];
+      os << "; last: " << progress.last_bad();
     os << std::flush;
   }
+
+  void
+  print(ostream                 &os,
+        const double             start_time,
+        const double             current_time,
+        const vector<Progress*> &progress,
+        const char              *label)
+  {
+    size_t done;
+    size_t badcount;
+    uint64_t bytes;
+    uint64_t processed_blocks;
+    uint64_t total_blocks;
+
+    done             = 0;
+    badcount         = 0;
+    bytes            = 0;
+    processed_blocks = 0;
+    total_blocks     = 0;
+    for(size_t i = 0; i < progress.size(); i++)
+      {
+        const Progress *p = progress[i];
+        const uint64_t  s = p->start_block();
+        const uint64_t  c = p->current_block();
+
+        done             += p->done();
+        badcount         += p->bad_blocks();
+        total_blocks     += (p->end_block() - s);
+        processed_blocks += (c - s);
+        bytes            += ((c - s) * p->block_size());
+      }
+
+    const uint64_t blocks_left       = (total_blocks - processed_blocks);
+    const double   percentage        = (total_blocks ?
+                                        (((double)processed_blocks / total_blocks) * 100.0) :
+                                        0.0);
+    const double   time_passed       = (current_time - start_time);
+    const double   blocks_per_second = ((double)processed_blocks / time_passed);
+    const double   mb_per_second     = (((double)bytes / time_passed) / (1024 * 1024));
+    const size_t   time_left         = ((blocks_per_second > 0) ?
+                                        ((double)blocks_left / blocks_per_second) :
+                                        0);
+
+    os << "\r\x1B[2K" << label << ": " << done << '/' << progress.size()
+       << "; Processed: " << processed_blocks << " ("
+       << std::fixed
+       << std::setprecision(2)
+       << percentage
+       << "%); bps: " << blocks_per_second
+       << "; MB/s: " << mb_per_second
+       << "; eta: "
+       << std::setfill('0') << std::setw(2)
+       << (time_left/(60*60)) << ':'
+       << std::setfill('0') << std::setw(2)
+       << ((time_left/60)%60)  << ':'
+       << std::setfill('0') << std::setw(2)
+       << (time_left%60)
+       << "; bad: " << badcount
+       << std::flush;
+  }
 }
@@ -24,16 +24,23 @@
 
 #include <stdint.h>
 
+class Progress;
+
 namespace Info
 {
   void
-  print(std::ostream                &os,
-        const double                 start_time,
-        const double                 current_time,
-        const size_t                 start_block,
-        const size_t                 end_block,
-        const size_t                 current_block,
-        const std::vector<uint64_t> &badblocks);
+  print(std::ostream   &os,
+        const double    start_time,
+        const double    current_time,
+        const Progress &progress,
+        const char     *label = "Processed");
+
+  void
+  print(std::ostream                  &os,
+        const double                   start_time,
+        const double                   current_time,
+        const std::vector<Progress*>  &progress,
+        const char                    *label = "Devices");
 }
 
 #endif
@@ -17,8 +17,11 @@
 */
 
 
+#include "ioctl.hpp"
+
 #include <errno.h>
 #include <inttypes.h>
+#include <linux/blkzoned.h>
 #include <linux/fiemap.h>
 #include <linux/fs.h>
 #include <stdlib.h>
@@ -113,6 +116,27 @@ namespace IOCtl
     return (size_in_bytes / physical_block_size);
   }
 
+  /*
+    Disk sequence number: unique within a boot and bumped whenever a
+    disk is attached or its media changes. Linux 5.15 and later.
+  */
+  int64_t
+  diskseq(const int fd)
+  {
+#ifdef BLKGETDISKSEQ
+    int rv;
+    uint64_t seq;
+
+    rv = ::ioctl(fd,BLKGETDISKSEQ,&seq);
+    if(rv == -1)
+      return -errno;
+
+    return seq;
+#else
+    return -ENOTSUP;
+#endif
+  }
+
   int
   block_flush(const int fd)
   {
@@ -122,4 +146,104 @@ namespace IOCtl
 
     return ((rv == -1) ? -errno : rv);
   }
+
+  int
+  discard(const int      fd,
+          const uint64_t offset,
+          const uint64_t length)
+  {
+    int rv;
+    uint64_t range[2];
+
+    range[0] = offset;
+    range[1] = length;
+
+    rv = ::ioctl(fd,BLKDISCARD,range);
+
+    return ((rv == -1) ? -errno : rv);
+  }
+
+  /*
+    Reports every zone of a zoned block device. Returns the number of
+    zones, 0 for a device which isn't zoned.
+  */
+  int
+  report_zones(const int          fd,
+               std::vector<Zone> &zones)
+  {
+    int rv;
+    uint32_t count;
+    uint64_t sector;
+    struct blk_zone_report *report;
+    static const uint32_t BATCH = 4096;
+
+    rv = ::ioctl(fd,BLKGETNRZONES,&count);
+    if(rv == -1)
+      return -errno;
+    if(count == 0)
+      return 0;
+
+    report = (struct blk_zone_report*)::calloc(1,(sizeof(struct blk_zone_report) +
+                                                  (BATCH * sizeof(struct blk_zone))));
+    if(report == NULL)
+      return -ENOMEM;
+
+    sector = 0;
+    while(zones.size() < count)
+      {
+        report->sector   = sector;
+        report->nr_zones = BATCH;
+
+        rv = ::ioctl(fd,BLKREPORTZONE,report);
+        if(rv == -1)
+          {
+            rv = -errno;
+            ::free(report);
+            return rv;
+          }
+        if(report->nr_zones == 0)
+          break;
+
+        for(uint32_t i = 0; i < report->nr_zones; i++)
+          {
+            Zone zone;
+            const struct blk_zone &z = report->zones[i];
+
+            zone.start    = z.start;
+            zone.length   = z.len;
+            zone.capacity = ((report->flags & BLK_ZONE_REP_CAPACITY) ?
+                             z.capacity : z.len);
+            zone.wp       = z.wp;
+            zone.type     = z.type;
+            zone.cond     = z.cond;
+            zones.push_back(zone);
+
+            sector = (z.start + z.len);
+          }
+      }
+
+    ::free(report);
+
+    return zones.size();
+  }
+
+  /*
+    Rewinds the write pointer of the zones in [sector,sector+nr_sectors)
+    to their start, discarding what was written to them.
+  */
+  int
+  reset_zone(const int      fd,
+             const uint64_t sector,
+             const uint64_t nr_sectors)
+  {
+    int rv;
+    struct blk_zone_range range;
+
+    range.sector     = sector;
+    range.nr_sectors = nr_sectors;
+
+    rv = ::ioctl(fd,BLKRESETZONE,&range);
+
+    return ((rv == -1) ? -errno : rv);
+  }
 }
@@ -22,12 +22,26 @@
 #include <stdint.h>
 #include <linux/fiemap.h>
 
+#include <vector>
+
 namespace IOCtl
 {
+  /* zone geometry in 512 byte sectors as BLKREPORTZONE returns it */
+  struct Zone
+  {
+    uint64_t start;
+    uint64_t length;
+    uint64_t capacity;
+    uint64_t wp;
+    uint8_t  type;
+    uint8_t  cond;
+  };
+
   int      logical_block_size(const int fd);
   int      physical_block_size(const int fd);
 
   int64_t size_in_bytes(const int fd);
+  int64_t diskseq(const int fd);
   int64_t logical_block_count(const int fd);
   int64_t physical_block_count(const int fd);
 
@@ -35,6 +49,15 @@ namespace IOCtl
   struct fiemap *extent_map(const int fd);
 
   int block_flush(const int fd);
+  int discard(const int      fd,
+              const uint64_t offset,
+              const uint64_t length);
+
+  int report_zones(const int          fd,
+                   std::vector<Zone> &zones);
+  int reset_zone(const int      fd,
+                 const uint64_t sector,
+                 const uint64_t nr_sectors);
 }
 
 #endif
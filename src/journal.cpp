@@ -0,0 +1,270 @@
+/*
+  ISC License
+
+  Copyright (c) 2016, Antonio SJ Musumeci <trapexit@spawn.link>
+
+  Permission to use, copy, modify, and/or distribute this software for any
+  purpose with or without fee is hereby granted, provided that the above
+  copyright notice and this permission notice appear in all copies.
+
+  THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+  WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+  MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+  ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+  WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+  ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+  OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+*/
+
+#include "journal.hpp"
+
+#include "time.hpp"
+
+#include <errno.h>
+#include <fcntl.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+const double Journal::INTERVAL = 10.0;
+
+Journal::Journal()
+  : _fd(-1),
+    _path(),
+    _bad_index(0),
+    _stream(NULL),
+    _stream_index(0),
+    _checkpoint(0),
+    _end(~0ULL),
+    _last_time(0)
+{
+}
+
+Journal::~Journal()
+{
+  close();
+}
+
+std::string
+Journal::path(const std::string &output_file_)
+{
+  return (output_file_ + ".journal");
+}
+
+int
+Journal::load(const std::string     &path_,
+              uint64_t              &checkpoint_,
+              std::vector<uint64_t> &badblocks_)
+{
+  bool found;
+  std::string line;
+  std::ifstream file;
+
+  file.open(path_.c_str());
+  if(!file.is_open())
+    return -ENOENT;
+
+  found = false;
+  while(std::getline(file,line))
+    {
+      char type;
+      uint64_t block;
+      std::istringstream is(line);
+
+      /* a crash may leave the last line incomplete */
+      if(file.eof())
+        break;
+
+      is >> type >> block;
+      if(is.fail())
+        continue;
+
+      switch(type)
+        {
+        case 'b':
+          badblocks_.push_back(block);
+          break;
+        case 'c':
+          checkpoint_ = block;
+          found       = true;
+          break;
+        }
+    }
+
+  return (found ? 0 : -ENODATA);
+}
+
+/*
+  Opens the journal belonging to `output_file`. When resuming the
+  journaled bad blocks are merged into `badblocks` and `start_block`
+  is moved up to the last checkpoint. Failing to journal only warns.
+*/
+void
+Journal::begin(const std::string     &output_file_,
+               const bool             resume_,
+               std::vector<uint64_t> &badblocks_,
+               uint64_t              &start_block_,
+               std::ostream          &os_)
+{
+  int rv;
+  bool append;
+  uint64_t checkpoint;
+  std::string journal_path;
+
+  if(output_file_ == "-")
+    return;
+
+  append       = false;
+  journal_path = Journal::path(output_file_);
+  if(resume_)
+    {
+      std::vector<uint64_t> resumed;
+
+      rv = Journal::load(journal_path,checkpoint,resumed);
+      if(rv < 0)
+        {
+          os_ << "Warning: no journal to resume from at "
+              << journal_path << std::endl;
+        }
+      else
+        {
+          badblocks_.insert(badblocks_.end(),resumed.begin(),resumed.end());
+          std::sort(badblocks_.begin(),badblocks_.end());
+          badblocks_.erase(std::unique(badblocks_.begin(),badblocks_.end()),
+                           badblocks_.end());
+
+          start_block_ = std::max(start_block_,checkpoint);
+          append       = true;
+
+          os_ << "Resuming from block " << checkpoint
+              << " (" << resumed.size() << " bad blocks journaled)"
+              << std::endl;
+        }
+    }
+
+  rv = open(journal_path,append,badblocks_.size());
+  if(rv < 0)
+    os_ << "Warning: unable to open journal "
+        << journal_path << std::endl;
+}
+
+/*
+  `bad_index` is the number of entries in the bad block list already
+  accounted for elsewhere (imported or resumed) and not to be
+  journaled again.
+*/
+int
+Journal::open(const std::string &path_,
+              const bool         append_,
+              const size_t       bad_index_)
+{
+  int flags;
+
+  close();
+
+  flags = (O_WRONLY|O_CREAT|O_APPEND|O_CLOEXEC);
+  if(!append_)
+    flags |= O_TRUNC;
+
+  _fd = ::open(path_.c_str(),flags,0644);
+  if(_fd == -1)
+    return -errno;
+
+  _path       = path_;
+  _bad_index  = bad_index_;
+  _checkpoint = 0;
+  _end        = ~0ULL;
+  _last_time  = Time::get_monotonic();
+
+  return 0;
+}
+
+int
+Journal::update(const uint64_t               block_,
+                const std::vector<uint64_t> &badblocks_)
+{
+  double now;
+
+  stream(badblocks_);
+
+  if(_fd == -1)
+    return 0;
+
+  now = Time::get_monotonic();
+  if((now - _last_time) < INTERVAL)
+    return 0;
+
+  return checkpoint(block_,badblocks_);
+}
+
+int
+Journal::checkpoint(const uint64_t               block_,
+                    const std::vector<uint64_t> &badblocks_)
+{
+  int rv;
+  std::ostringstream os;
+  std::string buf;
+
+  stream(badblocks_);
+
+  if(_fd == -1)
+    return 0;
+
+  for(; _bad_index < badblocks_.size(); _bad_index++)
+    os << "b " << badblocks_[_bad_index] << '\n';
+  os << "c " << block_ << '\n';
+
+  buf = os.str();
+  rv  = ::write(_fd,buf.data(),buf.size());
+  if(rv == -1)
+    return -errno;
+
+  ::fdatasync(_fd);
+
+  _checkpoint = block_;
+  _last_time  = Time::get_monotonic();
+
+  return 0;
+}
+
+void
+Journal::stream(const std::vector<uint64_t> &badblocks_)
+{
+  if((_stream == NULL) || (_stream_index >= badblocks_.size()))
+    return;
+
+  for(; _stream_index < badblocks_.size(); _stream_index++)
+    *_stream << badblocks_[_stream_index] << '\n';
+  _stream->flush();
+}
+
+void
+Journal::close(void)
+{
+  if(_fd != -1)
+    ::close(_fd);
+
+  _fd = -1;
+}
+
+int
+Journal::remove(void)
+{
+  int rv;
+
+  close();
+  if(_path.empty())
+    return 0;
+
+  rv = ::unlink(_path.c_str());
+  if((rv == -1) && (errno != ENOENT))
+    return -errno;
+
+  return 0;
+}
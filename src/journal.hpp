@@ -0,0 +1,95 @@
+/*
+  ISC License
+
+  Copyright (c) 2016, Antonio SJ Musumeci <trapexit@spawn.link>
+
+  Permission to use, copy, modify, and/or distribute this software for any
+  purpose with or without fee is hereby granted, provided that the above
+  copyright notice and this permission notice appear in all copies.
+
+  THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+  WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+  MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+  ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+  WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+  ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+  OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+*/
+
+#pragma once
+
+#include <stdint.h>
+
+#include <iostream>
+#include <string>
+#include <vector>
+
+/*
+  Append only record of a scan or burnin in progress so an
+  interrupted run can be resumed. Newly found bad blocks and the
+  current block are appended as text lines and fdatasync'd at most
+  every INTERVAL seconds:
+
+    b <lba>     bad block
+    c <lba>     every block before lba has been processed
+
+  A truncated last line from a crash is ignored on load.
+
+  With set_stream() every bad block in the list is also written to
+  the stream, one decimal LBA per line as in a text bad block file,
+  the first time update() or checkpoint() sees it, whether or not a
+  journal file is open, so a consumer downstream can act on it while
+  the scan continues.
+*/
+
+class Journal
+{
+public:
+  static const double INTERVAL;
+
+public:
+  Journal();
+  ~Journal();
+
+public:
+  static std::string path(const std::string &output_file);
+  static int load(const std::string     &path,
+                  uint64_t              &checkpoint,
+                  std::vector<uint64_t> &badblocks);
+
+public:
+  void begin(const std::string     &output_file,
+             const bool             resume,
+             std::vector<uint64_t> &badblocks,
+             uint64_t              &start_block,
+             std::ostream          &os);
+  int  open(const std::string &path,
+            const bool         append,
+            const size_t       bad_index);
+  int  update(const uint64_t               block,
+              const std::vector<uint64_t> &badblocks);
+  int  checkpoint(const uint64_t               block,
+                  const std::vector<uint64_t> &badblocks);
+  void close(void);
+  int  remove(void);
+
+public:
+  void set_stream(std::ostream *stream) { _stream = stream; _stream_index = 0; }
+  void stream(const std::vector<uint64_t> &badblocks);
+
+public:
+  void     set_end(const uint64_t end) { _end = end; }
+  bool     is_open(void) const { return (_fd != -1); }
+  bool     complete(void) const { return (is_open() && (_checkpoint >= _end)); }
+  uint64_t last_checkpoint(void) const { return _checkpoint; }
+
+private:
+  int         _fd;
+  std::string _path;
+  size_t      _bad_index;
+  std::ostream *_stream;
+  size_t      _stream_index;
+  uint64_t    _checkpoint;
+  uint64_t    _end;
+  double      _last_time;
+};
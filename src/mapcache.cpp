@@ -0,0 +1,305 @@
+/*
+  ISC License
+
+  Copyright (c) 2016, Antonio SJ Musumeci <trapexit@spawn.link>
+
+  Permission to use, copy, modify, and/or distribute this software for any
+  purpose with or without fee is hereby granted, provided that the above
+  copyright notice and this permission notice appear in all copies.
+
+  THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+  WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+  MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+  ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+  WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+  ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+  OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+*/
+
+#include <errno.h>
+#include <limits.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <sys/statfs.h>
+#include <unistd.h>
+
+#include <fstream>
+#include <sstream>
+#include <string>
+
+#include "blkdev.hpp"
+#include "captcha.hpp"
+#include "filetoblkdev.hpp"
+#include "mapcache.hpp"
+
+#define MAPCACHE_MAGIC   "BBFMAPC"
+#define MAPCACHE_VERSION 1
+
+namespace l
+{
+  template<typename T>
+  static
+  bool
+  read(std::istream &is_,
+       T            &v_)
+  {
+    is_.read((char*)&v_,sizeof(v_));
+
+    return is_.good();
+  }
+
+  static
+  bool
+  read_str(std::istream &is_,
+           std::string  &str_)
+  {
+    uint32_t len;
+
+    if(!l::read(is_,len) || (len > PATH_MAX))
+      return false;
+
+    str_.resize(len);
+    if(len)
+      is_.read(&str_[0],len);
+
+    return is_.good();
+  }
+
+  static
+  bool
+  read_time(std::istream    &is_,
+            struct timespec &ts_)
+  {
+    int64_t sec;
+    int64_t nsec;
+
+    if(!l::read(is_,sec) || !l::read(is_,nsec))
+      return false;
+
+    ts_.tv_sec  = sec;
+    ts_.tv_nsec = nsec;
+
+    return true;
+  }
+
+  template<typename T>
+  static
+  void
+  write(std::ostream &os_,
+        const T       v_)
+  {
+    os_.write((const char*)&v_,sizeof(v_));
+  }
+
+  static
+  void
+  write_time(std::ostream          &os_,
+             const struct timespec &ts_)
+  {
+    l::write<int64_t>(os_,ts_.tv_sec);
+    l::write<int64_t>(os_,ts_.tv_nsec);
+  }
+
+  static
+  bool
+  equal(const struct timespec &a_,
+        const struct timespec &b_)
+  {
+    return ((a_.tv_sec == b_.tv_sec) && (a_.tv_nsec == b_.tv_nsec));
+  }
+}
+
+namespace MapCache
+{
+  std::string
+  key(const std::string &basepath_)
+  {
+    int rv;
+    char *realpath;
+    BlkDev blkdev;
+    struct statfs st;
+    std::string devpath;
+    std::ostringstream ss;
+
+    devpath = FileToBlkDev::find(basepath_);
+    if(devpath.empty())
+      return std::string();
+
+    rv = blkdev.open_read(devpath);
+    if(rv < 0)
+      return std::string();
+
+    rv = ::statfs(basepath_.c_str(),&st);
+    if(rv == -1)
+      return std::string();
+
+    realpath = ::realpath(basepath_.c_str(),NULL);
+    if(realpath == NULL)
+      return std::string();
+
+    ss << captcha::calculate(blkdev)
+       << ':' << std::hex << st.f_fsid.__val[0] << st.f_fsid.__val[1]
+       << ':' << realpath;
+
+    ::free(realpath);
+
+    return ss.str();
+  }
+
+  bool
+  unchanged(const Dir         &dir_,
+            const struct stat &st_)
+  {
+    return (l::equal(dir_.mtime,st_.st_mtim) &&
+            l::equal(dir_.ctime,st_.st_ctim));
+  }
+
+  int
+  load(const std::string &filepath_,
+       const std::string &key_,
+       const uint32_t     blocksize_,
+       Dirs              &dirs_)
+  {
+    char magic[8];
+    uint32_t version;
+    uint32_t blocksize;
+    std::string key;
+    std::ifstream file;
+
+    file.open(filepath_.c_str(),std::ios::in|std::ios::binary);
+    if(!file.is_open())
+      return -ENOENT;
+
+    file.read(magic,sizeof(magic));
+    if(!file.good() ||
+       (::memcmp(magic,MAPCACHE_MAGIC,sizeof(magic)) != 0) ||
+       !l::read(file,version)   || (version   != MAPCACHE_VERSION) ||
+       !l::read(file,blocksize) || (blocksize != blocksize_) ||
+       !l::read_str(file,key)   || (key       != key_))
+      return -EINVAL;
+
+    for(;;)
+      {
+        uint32_t count;
+        std::string dirpath;
+
+        if(!l::read_str(file,dirpath))
+          break;
+        if(dirpath.empty())
+          return 0;
+
+        Dir &dir = dirs_[dirpath];
+
+        if(!l::read_time(file,dir.mtime) ||
+           !l::read_time(file,dir.ctime) ||
+           !l::read(file,count))
+          break;
+
+        dir.files.resize(count);
+        for(uint32_t i = 0; i < count; i++)
+          {
+            uint32_t extent_count;
+            File &f = dir.files[i];
+
+            if(!l::read_str(file,f.name) ||
+               !l::read(file,extent_count))
+              break;
+
+            f.extents.resize(extent_count);
+            if(extent_count)
+              file.read((char*)&f.extents[0],extent_count * sizeof(Extent));
+          }
+
+        if(!file.good())
+          break;
+      }
+
+    // truncated or corrupt, don't trust any of it
+    dirs_.clear();
+
+    return -EINVAL;
+  }
+
+  int
+  Writer::open(const std::string &filepath_,
+               const std::string &key_,
+               const uint32_t     blocksize_)
+  {
+    _filepath = filepath_;
+    _tmppath  = filepath_ + ".tmp";
+
+    _file.open(_tmppath.c_str(),std::ios::out|std::ios::binary|std::ios::trunc);
+    if(!_file.is_open())
+      return -EACCES;
+
+    _file.write(MAPCACHE_MAGIC,sizeof(MAPCACHE_MAGIC));
+    l::write<uint32_t>(_file,MAPCACHE_VERSION);
+    l::write<uint32_t>(_file,blocksize_);
+    write_str(key_);
+
+    return 0;
+  }
+
+  int
+  Writer::close(void)
+  {
+    int rv;
+
+    l::write<uint32_t>(_file,0);
+
+    _file.close();
+    if(_file.fail())
+      {
+        ::unlink(_tmppath.c_str());
+        return -EIO;
+      }
+
+    rv = ::rename(_tmppath.c_str(),_filepath.c_str());
+    if(rv == -1)
+      {
+        rv = -errno;
+        ::unlink(_tmppath.c_str());
+        return rv;
+      }
+
+    return 0;
+  }
+
+  void
+  Writer::dir(const std::string     &dirpath_,
+              const struct timespec &mtime_,
+              const struct timespec &ctime_,
+              const uint32_t         file_count_)
+  {
+    write_str(dirpath_);
+    l::write_time(_file,mtime_);
+    l::write_time(_file,ctime_);
+    l::write<uint32_t>(_file,file_count_);
+  }
+
+  void
+  Writer::file(const std::string &name_,
+               const uint32_t     extent_count_)
+  {
+    write_str(name_);
+    l::write<uint32_t>(_file,extent_count_);
+  }
+
+  void
+  Writer::extent(const uint64_t start_,
+                 const uint64_t length_)
+  {
+    l::write<uint64_t>(_file,start_);
+    l::write<uint64_t>(_file,length_);
+  }
+
+  void
+  Writer::write_str(const std::string &str_)
+  {
+    l::write<uint32_t>(_file,str_.size());
+    _file.write(str_.data(),str_.size());
+  }
+}
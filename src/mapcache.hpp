@@ -0,0 +1,103 @@
+/*
+  ISC License
+
+  Copyright (c) 2016, Antonio SJ Musumeci <trapexit@spawn.link>
+
+  Permission to use, copy, modify, and/or distribute this software for any
+  purpose with or without fee is hereby granted, provided that the above
+  copyright notice and this permission notice appear in all copies.
+
+  THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+  WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+  MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+  ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+  WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+  ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+  OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+*/
+
+#pragma once
+
+#include <stdint.h>
+#include <sys/stat.h>
+
+#include <fstream>
+#include <map>
+#include <string>
+#include <vector>
+
+/*
+  On disk cache of a BlockToFileMapper walk. Every directory is stored
+  with its mtime and ctime and the extents of the regular files
+  directly within it:
+
+    "BBFMAPC\0" u32:version u32:blocksize str:key
+    { str:dirpath i64:mtime_sec i64:mtime_nsec i64:ctime_sec
+      i64:ctime_nsec u32:file_count
+      { str:name u32:extent_count { u64:start u64:length }... }... }...
+    u32:0
+
+  Strings are a u32 length followed by the bytes. The key identifies
+  the device (captcha), filesystem (fsid) and walked path; a cache with
+  a different key or block size is ignored.
+*/
+namespace MapCache
+{
+  struct Extent
+  {
+    uint64_t start;
+    uint64_t length;
+  };
+
+  struct File
+  {
+    std::string         name;
+    std::vector<Extent> extents;
+  };
+
+  struct Dir
+  {
+    struct timespec   mtime;
+    struct timespec   ctime;
+    std::vector<File> files;
+  };
+
+  typedef std::map<std::string,Dir> Dirs;
+
+  std::string key(const std::string &basepath);
+
+  bool unchanged(const Dir         &dir,
+                 const struct stat &st);
+
+  int load(const std::string &filepath,
+           const std::string &key,
+           const uint32_t     blocksize,
+           Dirs              &dirs);
+
+  class Writer
+  {
+  public:
+    int open(const std::string &filepath,
+             const std::string &key,
+             const uint32_t     blocksize);
+    int close(void);
+
+  public:
+    void dir(const std::string     &dirpath,
+             const struct timespec &mtime,
+             const struct timespec &ctime,
+             const uint32_t         file_count);
+    void file(const std::string &name,
+              const uint32_t     extent_count);
+    void extent(const uint64_t start,
+                const uint64_t length);
+
+  private:
+    void write_str(const std::string &str);
+
+  private:
+    std::string   _filepath;
+    std::string   _tmppath;
+    std::ofstream _file;
+  };
+}
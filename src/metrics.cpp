@@ -0,0 +1,385 @@
+/*
+  ISC License
+
+  Copyright (c) 2016, Antonio SJ Musumeci <trapexit@spawn.link>
+
+  Permission to use, copy, modify, and/or distribute this software for any
+  purpose with or without fee is hereby granted, provided that the above
+  copyright notice and this permission notice appear in all copies.
+
+  THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+  WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+  MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+  ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+  WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+  ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+  OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+*/
+
+#include "metrics.hpp"
+
+#include "progress.hpp"
+#include "time.hpp"
+
+#include <errno.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <time.h>
+#include <unistd.h>
+
+#include <iomanip>
+#include <ostream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+namespace l
+{
+  struct Sample
+  {
+    std::string device;
+    uint64_t    start_block;
+    uint64_t    end_block;
+    uint64_t    current_block;
+    uint64_t    bad_blocks;
+    uint64_t    bytes;
+    uint64_t    requests;
+    uint64_t    retries;
+    uint64_t    reallocated;
+    uint64_t    pending;
+    double      elapsed;
+    double      blocks_per_second;
+    double      bytes_per_second;
+    uint64_t    latency[4];
+  };
+
+  static const double QUANTILES[4] = {0.5,0.9,0.99,0.999};
+  static const char  *QUANTILE_NAMES[4] = {"p50","p90","p99","p999"};
+  static const char  *QUANTILE_LABELS[4] = {"0.5","0.9","0.99","0.999"};
+
+  static
+  bool
+  ends_with(const std::string &str_,
+            const std::string &suffix_)
+  {
+    return ((str_.size() >= suffix_.size()) &&
+            (str_.compare(str_.size() - suffix_.size(),
+                          suffix_.size(),
+                          suffix_) == 0));
+  }
+
+  static
+  double
+  get_realtime(void)
+  {
+    struct timespec now;
+
+    clock_gettime(CLOCK_REALTIME,&now);
+
+    return ((double)now.tv_sec + ((double)now.tv_nsec / 1000000000.0));
+  }
+
+  /*
+    Device paths are the only strings written. Anything which would
+    need escaping in JSON or a Prometheus label is replaced.
+  */
+  static
+  std::string
+  quote(const std::string &str_)
+  {
+    std::string rv;
+
+    rv += '"';
+    for(size_t i = 0; i < str_.size(); i++)
+      {
+        const char c = str_[i];
+
+        if((c == '"') || (c == '\\') || ((unsigned char)c < 0x20))
+          rv += '_';
+        else
+          rv += c;
+      }
+    rv += '"';
+
+    return rv;
+  }
+
+  static
+  void
+  percentiles(const Progress &progress_,
+              uint64_t        latency_[4])
+  {
+    for(int q = 0; q < 4; q++)
+      latency_[q] = progress_.latency_percentile(QUANTILES[q]);
+  }
+
+  static
+  void
+  write_json(std::ostream &os_,
+             const Sample &s_,
+             const double  wall_)
+  {
+    os_ << std::fixed << std::setprecision(3)
+        << "{\"time\":" << wall_
+        << ",\"device\":" << quote(s_.device)
+        << ",\"elapsed\":" << s_.elapsed
+        << ",\"start_block\":" << s_.start_block
+        << ",\"end_block\":" << s_.end_block
+        << ",\"current_block\":" << s_.current_block
+        << std::setprecision(2)
+        << ",\"blocks_per_second\":" << s_.blocks_per_second
+        << ",\"mb_per_second\":" << (s_.bytes_per_second / (1024.0 * 1024.0))
+        << ",\"bytes\":" << s_.bytes
+        << ",\"requests\":" << s_.requests
+        << ",\"bad_blocks\":" << s_.bad_blocks
+        << ",\"retries\":" << s_.retries;
+    if(s_.reallocated != UINT64_MAX)
+      os_ << ",\"reallocated_sectors\":" << s_.reallocated;
+    if(s_.pending != UINT64_MAX)
+      os_ << ",\"pending_sectors\":" << s_.pending;
+    os_ << ",\"latency_usec\":{";
+    for(int q = 0; q < 4; q++)
+      os_ << (q ? "," : "")
+          << '"' << QUANTILE_NAMES[q] << "\":" << s_.latency[q];
+    os_ << "}}\n";
+  }
+
+  static
+  void
+  write_metric(std::ostream              &os_,
+               const std::vector<Sample> &samples_,
+               const char                *name_,
+               const char                *type_,
+               const char                *help_,
+               uint64_t Sample::*         member_)
+  {
+    os_ << "# HELP bbf_" << name_ << ' ' << help_ << '\n'
+        << "# TYPE bbf_" << name_ << ' ' << type_ << '\n';
+    for(size_t i = 0; i < samples_.size(); i++)
+      {
+        // SMART counters the device doesn't report
+        if(samples_[i].*member_ == UINT64_MAX)
+          continue;
+        os_ << "bbf_" << name_ << "{device=" << quote(samples_[i].device) << "} "
+            << samples_[i].*member_ << '\n';
+      }
+  }
+
+  static
+  void
+  write_metric(std::ostream              &os_,
+               const std::vector<Sample> &samples_,
+               const char                *name_,
+               const char                *help_,
+               double Sample::*           member_)
+  {
+    os_ << "# HELP bbf_" << name_ << ' ' << help_ << '\n'
+        << "# TYPE bbf_" << name_ << " gauge\n";
+    for(size_t i = 0; i < samples_.size(); i++)
+      os_ << "bbf_" << name_ << "{device=" << quote(samples_[i].device) << "} "
+          << std::fixed << std::setprecision(2)
+          << samples_[i].*member_ << '\n';
+  }
+
+  static
+  void
+  write_prometheus(std::ostream              &os_,
+                   const std::vector<Sample> &samples_)
+  {
+    write_metric(os_,samples_,"start_block","gauge",
+                 "First block of the range being processed.",
+                 &Sample::start_block);
+    write_metric(os_,samples_,"end_block","gauge",
+                 "Block the range being processed ends at.",
+                 &Sample::end_block);
+    write_metric(os_,samples_,"current_block","gauge",
+                 "Every block before this one has been processed.",
+                 &Sample::current_block);
+    write_metric(os_,samples_,"bad_blocks","gauge",
+                 "Bad blocks found so far.",
+                 &Sample::bad_blocks);
+    write_metric(os_,samples_,"bytes_total","counter",
+                 "Bytes transferred by the main requests.",
+                 &Sample::bytes);
+    write_metric(os_,samples_,"requests_total","counter",
+                 "Main requests completed.",
+                 &Sample::requests);
+    write_metric(os_,samples_,"retries_total","counter",
+                 "Requests reissued to localize or retry a failure.",
+                 &Sample::retries);
+    write_metric(os_,samples_,"reallocated_sectors","gauge",
+                 "Reallocated sectors as the device's SMART data reports.",
+                 &Sample::reallocated);
+    write_metric(os_,samples_,"pending_sectors","gauge",
+                 "Sectors pending reallocation as the device's SMART data reports.",
+                 &Sample::pending);
+    write_metric(os_,samples_,"blocks_per_second",
+                 "Blocks processed per second since the last update.",
+                 &Sample::blocks_per_second);
+    write_metric(os_,samples_,"bytes_per_second",
+                 "Bytes transferred per second since the last update.",
+                 &Sample::bytes_per_second);
+
+    os_ << "# HELP bbf_request_latency_seconds Latency of the main requests"
+           " (upper bound of the histogram bucket).\n"
+        << "# TYPE bbf_request_latency_seconds summary\n";
+    for(size_t i = 0; i < samples_.size(); i++)
+      {
+        for(int q = 0; q < 4; q++)
+          os_ << "bbf_request_latency_seconds{device=" << quote(samples_[i].device)
+              << ",quantile=\"" << QUANTILE_LABELS[q] << "\"} "
+              << std::fixed << std::setprecision(6)
+              << (samples_[i].latency[q] / 1000000.0) << '\n';
+        os_ << "bbf_request_latency_seconds_count{device=" << quote(samples_[i].device)
+            << "} " << samples_[i].requests << '\n';
+      }
+  }
+}
+
+Metrics::Metrics()
+  : _path(),
+    _format(JSON),
+    _file(),
+    _start_time(0),
+    _sources()
+{
+}
+
+Metrics::~Metrics()
+{
+  close();
+}
+
+int
+Metrics::open(const std::string &path_)
+{
+  close();
+
+  _format = (l::ends_with(path_,".prom") ? PROMETHEUS : JSON);
+  if(_format == JSON)
+    {
+      _file.open(path_.c_str(),std::ios::out|std::ios::app);
+      if(!_file.is_open())
+        return -EACCES;
+    }
+
+  _path       = path_;
+  _start_time = Time::get_monotonic();
+
+  return 0;
+}
+
+void
+Metrics::add(const std::string &device_,
+             const Progress    *progress_)
+{
+  Source source;
+
+  source.device     = device_;
+  source.progress   = progress_;
+  source.last_block = progress_->current_block();
+  source.last_bytes = progress_->bytes();
+  source.last_time  = Time::get_monotonic();
+
+  _sources.push_back(source);
+}
+
+int
+Metrics::write(void)
+{
+  int rv;
+  double now;
+  std::vector<l::Sample> samples;
+
+  if(_path.empty())
+    return 0;
+
+  now = Time::get_monotonic();
+  for(size_t i = 0; i < _sources.size(); i++)
+    {
+      l::Sample s;
+      Source &src = _sources[i];
+      const Progress &p = *src.progress;
+      const double interval = (now - src.last_time);
+
+      s.device        = src.device;
+      s.start_block   = p.start_block();
+      s.end_block     = p.end_block();
+      s.current_block = p.current_block();
+      s.bad_blocks    = p.bad_blocks();
+      s.bytes         = p.bytes();
+      s.requests      = p.requests();
+      s.retries       = p.retries();
+      s.reallocated   = p.reallocated();
+      s.pending       = p.pending();
+      s.elapsed       = (now - _start_time);
+
+      s.blocks_per_second = 0;
+      s.bytes_per_second  = 0;
+      if(interval > 0)
+        {
+          // a resumed or restarted range can move current backwards
+          if(s.current_block >= src.last_block)
+            s.blocks_per_second = ((s.current_block - src.last_block) / interval);
+          s.bytes_per_second = ((s.bytes - src.last_bytes) / interval);
+        }
+
+      l::percentiles(p,s.latency);
+
+      src.last_block = s.current_block;
+      src.last_bytes = s.bytes;
+      src.last_time  = now;
+
+      samples.push_back(s);
+    }
+
+  if(_format == JSON)
+    {
+      const double wall = l::get_realtime();
+
+      for(size_t i = 0; i < samples.size(); i++)
+        l::write_json(_file,samples[i],wall);
+      _file.flush();
+
+      return (_file.fail() ? -EIO : 0);
+    }
+
+  /*
+    The textfile collector may read at any moment so the file is
+    replaced whole rather than rewritten in place.
+  */
+  std::ofstream file;
+  const std::string tmppath = (_path + ".tmp");
+
+  file.open(tmppath.c_str(),std::ios::out|std::ios::trunc);
+  if(!file.is_open())
+    return -EACCES;
+
+  l::write_prometheus(file,samples);
+
+  file.close();
+  if(file.fail())
+    {
+      ::unlink(tmppath.c_str());
+      return -EIO;
+    }
+
+  rv = ::rename(tmppath.c_str(),_path.c_str());
+  if(rv == -1)
+    {
+      rv = -errno;
+      ::unlink(tmppath.c_str());
+      return rv;
+    }
+
+  return 0;
+}
+
+void
+Metrics::close(void)
+{
+  if(_file.is_open())
+    _file.close();
+  _path.clear();
+  _sources.clear();
+}
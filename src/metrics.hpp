@@ -0,0 +1,88 @@
+/*
+  ISC License
+
+  Copyright (c) 2016, Antonio SJ Musumeci <trapexit@spawn.link>
+
+  Permission to use, copy, modify, and/or distribute this software for any
+  purpose with or without fee is hereby granted, provided that the above
+  copyright notice and this permission notice appear in all copies.
+
+  THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+  WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+  MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+  ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+  WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+  ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+  OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+*/
+
+#pragma once
+
+#include <stdint.h>
+
+#include <fstream>
+#include <string>
+#include <vector>
+
+class Progress;
+
+/*
+  Periodic machine readable snapshot of one or more Progress objects
+  for monitoring. A path ending in ".prom" is rewritten each time as a
+  Prometheus textfile (as read by node_exporter's textfile collector),
+  anything else has one JSON object per device appended per write:
+
+    {"time":...,"device":"/dev/sda","current_block":...,
+     "blocks_per_second":...,"mb_per_second":...,"bad_blocks":...,
+     "retries":...,"reallocated_sectors":...,"pending_sectors":...,
+     "latency_usec":{"p50":...,"p90":...,...}}
+
+  The SMART sector counts are left out while the device hasn't
+  reported them.
+
+  Rates are over the time since the previous write. Latency
+  percentiles are the upper bound of the histogram bucket they fall
+  in so are accurate to within 25%.
+*/
+
+class Metrics
+{
+public:
+  enum Format
+    {
+      JSON,
+      PROMETHEUS
+    };
+
+public:
+  Metrics();
+  ~Metrics();
+
+public:
+  int  open(const std::string &path);
+  void add(const std::string &device,
+           const Progress    *progress);
+  int  write(void);
+  void close(void);
+
+public:
+  bool   is_open(void) const { return !_path.empty(); }
+  Format format(void) const { return _format; }
+
+private:
+  struct Source
+  {
+    std::string     device;
+    const Progress *progress;
+    uint64_t        last_block;
+    uint64_t        last_bytes;
+    double          last_time;
+  };
+
+private:
+  std::string         _path;
+  Format              _format;
+  std::ofstream       _file;
+  double              _start_time;
+  std::vector<Source> _sources;
+};
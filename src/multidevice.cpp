@@ -0,0 +1,216 @@
+/*
+  ISC License
+
+  Copyright (c) 2016, Antonio SJ Musumeci <trapexit@spawn.link>
+
+  Permission to use, copy, modify, and/or distribute this software for any
+  purpose with or without fee is hereby granted, provided that the above
+  copyright notice and this permission notice appear in all copies.
+
+  THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+  WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+  MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+  ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+  WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+  ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+  OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+*/
+
+#include "multidevice.hpp"
+
+#include "errors.hpp"
+#include "metrics.hpp"
+#include "options.hpp"
+#include "progress.hpp"
+#include "progressreporter.hpp"
+#include "signals.hpp"
+#include "time.hpp"
+#include "topology.hpp"
+
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include <errno.h>
+#include <pthread.h>
+#include <signal.h>
+
+namespace l
+{
+  struct Worker
+  {
+    Options               opts;
+    MultiDevice::Func     func;
+    std::ostringstream    os;
+    Progress              progress;
+    AppError              err;
+    int                   node;
+    pthread_t             thread;
+    bool                  started;
+  };
+
+  static
+  void*
+  worker_main(void *arg_)
+  {
+    sigset_t set;
+    Worker *worker = (Worker*)arg_;
+
+    /* leave signal handling to the main thread */
+    sigfillset(&set);
+    pthread_sigmask(SIG_BLOCK,&set,NULL);
+
+    /* before anything is allocated so the buffers are node local */
+    if(worker->node >= 0)
+      {
+        int rv;
+
+        rv = Topology::bind(worker->node);
+        if(rv < 0)
+          worker->os << "Warning: unable to bind to numa node "
+                     << worker->node << " ["
+                     << Error::to_string(-rv)
+                     << "]"
+                     << std::endl;
+        else
+          worker->os << "numa node: " << worker->node
+                     << " (cpus: " << Topology::cpulist(worker->node) << ")"
+                     << std::endl;
+      }
+
+    worker->err = worker->func(worker->opts,worker->os,worker->progress);
+    worker->progress.finish();
+
+    return NULL;
+  }
+
+  static
+  bool
+  all_done(const std::vector<Worker*> &workers_)
+  {
+    for(size_t i = 0; i < workers_.size(); i++)
+      if(workers_[i]->started && !workers_[i]->progress.done())
+        return false;
+
+    return true;
+  }
+
+  static
+  std::vector<std::string>
+  split(const std::string &str_,
+        const char         delim_)
+  {
+    std::string token;
+    std::istringstream is(str_);
+    std::vector<std::string> rv;
+
+    while(std::getline(is,token,delim_))
+      rv.push_back(token);
+
+    return rv;
+  }
+}
+
+namespace MultiDevice
+{
+  AppError
+  run(const Options &opts_,
+      const Func     func_)
+  {
+    int rv;
+    AppError err;
+    Metrics metrics;
+    ProgressReporter reporter;
+    std::vector<l::Worker*> workers;
+    std::vector<Progress*> progress;
+    std::vector<std::string> captchas;
+
+    if(!opts_.output_file.empty() || !opts_.input_file.empty())
+      return AppError::argument_invalid("input and output files can not be used"
+                                        " with multiple devices");
+    captchas = l::split(opts_.captcha,',');
+    if((captchas.size() > 1) &&
+       (captchas.size() != opts_.devices.size()))
+      return AppError::argument_invalid("number of captchas does not match"
+                                        " number of devices");
+
+    for(size_t i = 0; i < opts_.devices.size(); i++)
+      {
+        l::Worker *worker = new l::Worker();
+
+        worker->opts         = opts_;
+        worker->opts.device  = opts_.devices[i];
+        worker->opts.devices = std::vector<std::string>(1,opts_.devices[i]);
+        if(captchas.size() > 1)
+          worker->opts.captcha = captchas[i];
+        worker->func    = func_;
+        worker->node    = ((Topology::nodes() > 1) ?
+                           Topology::device_node(opts_.devices[i]) :
+                           -1);
+        worker->started = false;
+
+        workers.push_back(worker);
+        progress.push_back(&worker->progress);
+      }
+
+    std::cout << "Devices: " << workers.size() << std::endl;
+
+    if(!opts_.metrics_file.empty())
+      {
+        rv = metrics.open(opts_.metrics_file);
+        if(rv < 0)
+          std::cout << "Warning: unable to open metrics file "
+                    << opts_.metrics_file << " ["
+                    << Error::to_string(-rv)
+                    << "]"
+                    << std::endl;
+        for(size_t i = 0; i < workers.size(); i++)
+          metrics.add(workers[i]->opts.device,&workers[i]->progress);
+        reporter.set_metrics(&metrics);
+      }
+
+    reporter.start(std::cout,progress,"Devices");
+    for(size_t i = 0; i < workers.size(); i++)
+      {
+        rv = pthread_create(&workers[i]->thread,NULL,l::worker_main,workers[i]);
+        if(rv != 0)
+          {
+            workers[i]->err = AppError::runtime(rv,"unable to create worker thread");
+            workers[i]->progress.finish();
+            continue;
+          }
+
+        workers[i]->started = true;
+      }
+
+    while(!l::all_done(workers))
+      Time::sleep(0.1);
+
+    for(size_t i = 0; i < workers.size(); i++)
+      if(workers[i]->started)
+        pthread_join(workers[i]->thread,NULL);
+
+    reporter.stop();
+    std::cout << std::endl;
+
+    for(size_t i = 0; i < workers.size(); i++)
+      {
+        l::Worker *worker = workers[i];
+
+        std::cout << std::endl
+                  << worker->opts.device << ":" << std::endl
+                  << worker->os.str();
+        if(!worker->err.succeeded())
+          {
+            std::cout << worker->err.to_string() << std::endl;
+            if(err.succeeded())
+              err = worker->err;
+          }
+
+        delete worker;
+      }
+
+    return err;
+  }
+}
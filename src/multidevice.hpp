@@ -0,0 +1,46 @@
+/*
+  ISC License
+
+  Copyright (c) 2016, Antonio SJ Musumeci <trapexit@spawn.link>
+
+  Permission to use, copy, modify, and/or distribute this software for any
+  purpose with or without fee is hereby granted, provided that the above
+  copyright notice and this permission notice appear in all copies.
+
+  THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+  WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+  MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+  ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+  WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+  ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+  OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+*/
+
+#pragma once
+
+#include "errors.hpp"
+#include "options.hpp"
+#include "progress.hpp"
+
+#include <iostream>
+
+/*
+  Runs an instruction against every device in Options::devices
+  concurrently with one worker thread per device. Each worker gets a
+  copy of the options with `device` and `captcha` set for its device,
+  writes its report to a private buffer and publishes progress through
+  a Progress object. The calling thread renders a combined status line
+  and prints each device's report once all workers are done. On NUMA
+  machines each worker is bound to the node its device's controller
+  is attached to.
+*/
+
+namespace MultiDevice
+{
+  typedef AppError (*Func)(const Options &opts,
+                           std::ostream  &os,
+                           Progress      &progress);
+
+  AppError run(const Options &opts,
+               const Func     func);
+}
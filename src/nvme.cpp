@@ -0,0 +1,518 @@
+/*
+  ISC License
+
+  Copyright (c) 2016, Antonio SJ Musumeci <trapexit@spawn.link>
+
+  Permission to use, copy, modify, and/or distribute this software for any
+  purpose with or without fee is hereby granted, provided that the above
+  copyright notice and this permission notice appear in all copies.
+
+  THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+  WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+  MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+  ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+  WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+  ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+  OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+*/
+
+#include "nvme.hpp"
+
+#include <errno.h>
+#include <limits.h>
+#include <linux/nvme_ioctl.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include <sys/ioctl.h>
+#include <sys/stat.h>
+#include <sys/sysmacros.h>
+#include <sys/types.h>
+
+#include <algorithm>
+#include <fstream>
+#include <string>
+
+/* Number of Logical Blocks is a 0's based 16 bit field */
+#define NVME_MAX_BLOCKS 65536
+
+namespace l
+{
+  static
+  uint16_t
+  le16(const uint8_t *buf_)
+  {
+    return (buf_[0] | (buf_[1] << 8));
+  }
+
+  static
+  uint32_t
+  le32(const uint8_t *buf_)
+  {
+    return (le16(buf_) | ((uint32_t)le16(buf_ + 2) << 16));
+  }
+
+  /* identify strings are space padded ASCII */
+  static
+  void
+  copy_str(char          *dst_,
+           const uint8_t *src_,
+           const size_t   len_)
+  {
+    size_t len;
+
+    ::memcpy(dst_,src_,len_);
+    len = len_;
+    while((len > 0) && ((dst_[len-1] == ' ') || (dst_[len-1] == '\0')))
+      len--;
+    dst_[len] = '\0';
+  }
+
+  static
+  int
+  exec(const int                  fd_,
+       const unsigned long        request_,
+       struct nvme_passthru_cmd  &cmd_)
+  {
+    int rv;
+
+    rv = ::ioctl(fd_,request_,&cmd_);
+    if(rv == -1)
+      return -errno;
+
+    return nvme::status_to_errno(rv);
+  }
+
+  static
+  void
+  init(struct nvme_passthru_cmd &cmd_,
+       const uint8_t             opcode_,
+       const uint32_t            nsid_,
+       const int                 timeout_)
+  {
+    ::memset(&cmd_,0,sizeof(cmd_));
+    cmd_.opcode     = opcode_;
+    cmd_.nsid       = nsid_;
+    cmd_.timeout_ms = timeout_;
+  }
+
+  static
+  void
+  set_range(struct nvme_passthru_cmd &cmd_,
+            const uint64_t            lba_,
+            const uint64_t            blocks_)
+  {
+    cmd_.cdw10 = (uint32_t)lba_;
+    cmd_.cdw11 = (uint32_t)(lba_ >> 32);
+    cmd_.cdw12 = (uint32_t)(blocks_ - 1);
+  }
+
+  /*
+    The commands without data are split at the 16 bit block count,
+    those with data are limited by the controller's maximum transfer
+    size anyway which the caller's request size must respect.
+  */
+  static
+  int
+  no_data(const int      fd_,
+          const uint8_t  opcode_,
+          const uint32_t nsid_,
+          const uint64_t lba_,
+          const uint64_t blocks_,
+          const int      timeout_)
+  {
+    int rv;
+    uint64_t lba;
+    uint64_t left;
+    struct nvme_passthru_cmd cmd;
+
+    rv   = 0;
+    lba  = lba_;
+    left = blocks_;
+    while(left)
+      {
+        const uint64_t n = std::min(left,(uint64_t)NVME_MAX_BLOCKS);
+
+        l::init(cmd,opcode_,nsid_,timeout_);
+        l::set_range(cmd,lba,n);
+
+        rv = l::exec(fd_,NVME_IOCTL_IO_CMD,cmd);
+        if(rv < 0)
+          return rv;
+
+        lba  += n;
+        left -= n;
+      }
+
+    return rv;
+  }
+
+  static
+  int
+  get_log_page(const int       fd_,
+               const uint8_t   lid_,
+               void           *buf_,
+               const uint32_t  len_,
+               const int       timeout_)
+  {
+    struct nvme_passthru_cmd cmd;
+    const uint32_t numd = ((len_ / 4) - 1);
+
+    l::init(cmd,nvme::NVME_ADMIN_GET_LOG_PAGE,0xFFFFFFFF,timeout_);
+    cmd.addr     = (uint64_t)buf_;
+    cmd.data_len = len_;
+    cmd.cdw10    = (lid_ | ((numd & 0xFFFF) << 16));
+    cmd.cdw11    = (numd >> 16);
+
+    return l::exec(fd_,NVME_IOCTL_ADMIN_CMD,cmd);
+  }
+}
+
+namespace nvme
+{
+  /* the namespace ID the block device is for, -ENOTTY if not NVMe */
+  int
+  nsid(const int fd_)
+  {
+    int rv;
+
+    rv = ::ioctl(fd_,NVME_IOCTL_ID);
+    if(rv == -1)
+      return -errno;
+    if(rv == 0)
+      return -ENOTTY;
+
+    return rv;
+  }
+
+  /*
+    io_uring passthrough is only offered by the generic character
+    device the kernel creates next to each namespace: nvme0n1 has
+    ng0n1.
+  */
+  std::string
+  generic_path(const int fd_)
+  {
+    int rv;
+    struct stat st;
+    std::string line;
+    std::string path;
+    std::ifstream file;
+    char sysfs[PATH_MAX];
+
+    rv = ::fstat(fd_,&st);
+    if((rv == -1) || !S_ISBLK(st.st_mode))
+      return std::string();
+
+    ::snprintf(sysfs,sizeof(sysfs),"/sys/dev/block/%u:%u/uevent",
+               major(st.st_rdev),minor(st.st_rdev));
+    file.open(sysfs);
+    while(std::getline(file,line))
+      {
+        if(line.compare(0,12,"DEVNAME=nvme") != 0)
+          continue;
+        path = ("/dev/ng" + line.substr(12));
+        break;
+      }
+
+    if(path.empty())
+      return std::string();
+
+    rv = ::stat(path.c_str(),&st);
+    if((rv == -1) || !S_ISCHR(st.st_mode))
+      return std::string();
+
+    return path;
+  }
+
+  /*
+    Status as the ioctls return it: Status Code in bits 7:0, Status
+    Code Type in 10:8.
+  */
+  int
+  status_to_errno(const int status_)
+  {
+    const int sc  = (status_ & 0xFF);
+    const int sct = ((status_ >> 8) & 0x7);
+
+    if(status_ <= 0)
+      return status_;
+
+    switch(sct)
+      {
+      case 0x0:
+        switch(sc)
+          {
+          case 0x01:
+            return -ENOTSUP;
+          case 0x02:
+          case 0x0B:
+            return -EINVAL;
+          case 0x1D:
+            return -EBUSY;
+          case 0x80:
+            return -ERANGE;
+          }
+        break;
+      case 0x1:
+        switch(sc)
+          {
+          case 0x0A:
+            return -EINVAL;
+          case 0x23:
+            return -EBUSY;
+          }
+        break;
+      case 0x2:
+        return -EIO;
+      }
+
+    return -EIO;
+  }
+
+  /*
+    Identify Controller: strings at 4, 24 & 64, OACS at 256, SANICAP
+    at 328, ONCS at 520 and FNA at 524.
+  */
+  int
+  identify(const int       fd_,
+           nvme::identity &ident_,
+           const int       timeout_)
+  {
+    int rv;
+    uint16_t oacs;
+    uint16_t oncs;
+    uint32_t sanicap;
+    uint8_t buf[4096];
+    struct nvme_passthru_cmd cmd;
+
+    l::init(cmd,NVME_ADMIN_IDENTIFY,0,timeout_);
+    cmd.addr     = (uint64_t)buf;
+    cmd.data_len = sizeof(buf);
+    cmd.cdw10    = 0x01;
+
+    rv = l::exec(fd_,NVME_IOCTL_ADMIN_CMD,cmd);
+    if(rv < 0)
+      return rv;
+
+    ::memset(&ident_,0,sizeof(ident_));
+    l::copy_str(ident_.serial_number,&buf[4],20);
+    l::copy_str(ident_.model_number,&buf[24],40);
+    l::copy_str(ident_.firmware_revision,&buf[64],8);
+
+    oacs    = l::le16(&buf[256]);
+    sanicap = l::le32(&buf[328]);
+    oncs    = l::le16(&buf[520]);
+
+    ident_.format                = !!(oacs & 0x0002);
+    ident_.format_crypto_erase   = !!(buf[524] & 0x04);
+    ident_.write_uncorrectable   = !!(oncs & 0x0002);
+    ident_.write_zeroes          = !!(oncs & 0x0008);
+    ident_.verify                = !!(oncs & 0x0080);
+    ident_.sanitize_crypto_erase = !!(sanicap & 0x1);
+    ident_.sanitize_block_erase  = !!(sanicap & 0x2);
+    ident_.sanitize_overwrite    = !!(sanicap & 0x4);
+
+    return 0;
+  }
+
+  int
+  read(const int       fd_,
+       const uint32_t  nsid_,
+       const uint64_t  lba_,
+       const uint64_t  blocks_,
+       void           *buf_,
+       const uint64_t  buflen_,
+       const int       timeout_)
+  {
+    struct nvme_passthru_cmd cmd;
+
+    if((blocks_ == 0) || (blocks_ > NVME_MAX_BLOCKS))
+      return -EINVAL;
+
+    l::init(cmd,NVME_CMD_READ,nsid_,timeout_);
+    l::set_range(cmd,lba_,blocks_);
+    cmd.addr     = (uint64_t)buf_;
+    cmd.data_len = buflen_;
+
+    return l::exec(fd_,NVME_IOCTL_IO_CMD,cmd);
+  }
+
+  /* checks the blocks can be read without transferring them */
+  int
+  verify(const int      fd_,
+         const uint32_t nsid_,
+         const uint64_t lba_,
+         const uint64_t blocks_,
+         const int      timeout_)
+  {
+    return l::no_data(fd_,NVME_CMD_VERIFY,nsid_,lba_,blocks_,timeout_);
+  }
+
+  /* FUA is bit 30 of CDW12 */
+  int
+  write(const int       fd_,
+        const uint32_t  nsid_,
+        const uint64_t  lba_,
+        const uint64_t  blocks_,
+        const void     *buf_,
+        const uint64_t  buflen_,
+        const bool      fua_,
+        const int       timeout_)
+  {
+    struct nvme_passthru_cmd cmd;
+
+    if((blocks_ == 0) || (blocks_ > NVME_MAX_BLOCKS))
+      return -EINVAL;
+
+    l::init(cmd,NVME_CMD_WRITE,nsid_,timeout_);
+    l::set_range(cmd,lba_,blocks_);
+    cmd.addr      = (uint64_t)buf_;
+    cmd.data_len  = buflen_;
+    cmd.cdw12    |= (fua_ ? (1U << 30) : 0);
+
+    return l::exec(fd_,NVME_IOCTL_IO_CMD,cmd);
+  }
+
+  /* reads of the blocks fail until they are written */
+  int
+  write_uncorrectable(const int      fd_,
+                      const uint32_t nsid_,
+                      const uint64_t lba_,
+                      const uint64_t blocks_,
+                      const int      timeout_)
+  {
+    return l::no_data(fd_,NVME_CMD_WRITE_UNCORRECTABLE,nsid_,lba_,blocks_,timeout_);
+  }
+
+  int
+  write_zeroes(const int      fd_,
+               const uint32_t nsid_,
+               const uint64_t lba_,
+               const uint64_t blocks_,
+               const int      timeout_)
+  {
+    return l::no_data(fd_,NVME_CMD_WRITE_ZEROES,nsid_,lba_,blocks_,timeout_);
+  }
+
+  int
+  flush(const int      fd_,
+        const uint32_t nsid_,
+        const int      timeout_)
+  {
+    struct nvme_passthru_cmd cmd;
+
+    l::init(cmd,NVME_CMD_FLUSH,nsid_,timeout_);
+
+    return l::exec(fd_,NVME_IOCTL_IO_CMD,cmd);
+  }
+
+  /*
+    Format NVM keeping the namespace as it is: the current LBA format
+    and metadata setting (FLBAS, byte 26 of Identify Namespace) and
+    protection information (DPS, byte 29) are passed back unchanged
+    so only the Secure Erase Setting has an effect.
+  */
+  int
+  format(const int      fd_,
+         const uint32_t nsid_,
+         const int      ses_,
+         const int      timeout_)
+  {
+    int rv;
+    uint8_t flbas;
+    uint8_t dps;
+    uint8_t buf[4096];
+    struct nvme_passthru_cmd cmd;
+
+    l::init(cmd,NVME_ADMIN_IDENTIFY,nsid_,timeout_);
+    cmd.addr     = (uint64_t)buf;
+    cmd.data_len = sizeof(buf);
+    cmd.cdw10    = 0x00;
+
+    rv = l::exec(fd_,NVME_IOCTL_ADMIN_CMD,cmd);
+    if(rv < 0)
+      return rv;
+
+    flbas = buf[26];
+    dps   = buf[29];
+
+    l::init(cmd,NVME_ADMIN_FORMAT_NVM,nsid_,timeout_);
+    cmd.cdw10 = ((flbas & 0x0F)              |
+                 (((flbas >> 4) & 0x1) << 4) |
+                 ((dps & 0x7) << 5)          |
+                 (((dps >> 3) & 0x1) << 8)   |
+                 ((ses_ & 0x7) << 9)         |
+                 (((flbas >> 5) & 0x3) << 12));
+
+    return l::exec(fd_,NVME_IOCTL_ADMIN_CMD,cmd);
+  }
+
+  /*
+    Sanitize returns once started and runs in the background; an
+    overwrite is one pass of zeros.
+  */
+  int
+  sanitize(const int fd_,
+           const int sanact_,
+           const int timeout_)
+  {
+    struct nvme_passthru_cmd cmd;
+
+    l::init(cmd,NVME_ADMIN_SANITIZE,0,timeout_);
+    cmd.cdw10 = (sanact_ & 0x7);
+    if(sanact_ == NVME_SANACT_OVERWRITE)
+      cmd.cdw10 |= (1 << 4);
+
+    return l::exec(fd_,NVME_IOCTL_ADMIN_CMD,cmd);
+  }
+
+  /*
+    Sanitize Status log (0x81): SPROG, progress in 1/65536ths, then
+    SSTAT whose low 3 bits are 1 or 4 for success, 2 in progress and
+    3 failed.
+  */
+  int
+  get_sanitize_status(const int              fd_,
+                      nvme::sanitize_status &status_,
+                      const int              timeout_)
+  {
+    int rv;
+    uint8_t buf[512];
+    uint8_t sstat;
+
+    rv = l::get_log_page(fd_,0x81,buf,sizeof(buf),timeout_);
+    if(rv < 0)
+      return rv;
+
+    sstat = (l::le16(&buf[2]) & 0x7);
+
+    status_.progress    = l::le16(&buf[0]);
+    status_.completed   = ((sstat == 1) || (sstat == 4));
+    status_.in_progress = (sstat == 2);
+    status_.failed      = (sstat == 3);
+
+    return 0;
+  }
+
+  void
+  prepare_rw(struct nvme_uring_cmd &cmd_,
+             const uint8_t          opcode_,
+             const uint32_t         nsid_,
+             const uint64_t         lba_,
+             const uint64_t         blocks_,
+             void                  *buf_,
+             const uint64_t         buflen_,
+             const int              timeout_)
+  {
+    ::memset(&cmd_,0,sizeof(cmd_));
+    cmd_.opcode     = opcode_;
+    cmd_.nsid       = nsid_;
+    cmd_.addr       = (uint64_t)buf_;
+    cmd_.data_len   = buflen_;
+    cmd_.cdw10      = (uint32_t)lba_;
+    cmd_.cdw11      = (uint32_t)(lba_ >> 32);
+    cmd_.cdw12      = (uint32_t)(blocks_ - 1);
+    cmd_.timeout_ms = timeout_;
+  }
+}
@@ -0,0 +1,174 @@
+/*
+  ISC License
+
+  Copyright (c) 2016, Antonio SJ Musumeci <trapexit@spawn.link>
+
+  Permission to use, copy, modify, and/or distribute this software for any
+  purpose with or without fee is hereby granted, provided that the above
+  copyright notice and this permission notice appear in all copies.
+
+  THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+  WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+  MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+  ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+  WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+  ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+  OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+*/
+
+#pragma once
+
+#include <stdint.h>
+
+#include <string>
+
+struct nvme_uring_cmd;
+
+/*
+  NVMe commands sent with the kernel's passthrough ioctls on the
+  namespace's block device, or prepared for io_uring passthrough on
+  its generic character device (/dev/ngXnY). Like sg, errors are
+  negative errno: NVMe media errors are -EIO, an opcode the
+  controller doesn't implement -ENOTSUP.
+*/
+namespace nvme
+{
+  /* NVM command set opcodes */
+  enum
+    {
+      NVME_CMD_FLUSH               = 0x00,
+      NVME_CMD_WRITE               = 0x01,
+      NVME_CMD_READ                = 0x02,
+      NVME_CMD_WRITE_UNCORRECTABLE = 0x04,
+      NVME_CMD_WRITE_ZEROES        = 0x08,
+      NVME_CMD_VERIFY              = 0x0C
+    };
+
+  /* admin opcodes */
+  enum
+    {
+      NVME_ADMIN_GET_LOG_PAGE = 0x02,
+      NVME_ADMIN_IDENTIFY     = 0x06,
+      NVME_ADMIN_FORMAT_NVM   = 0x80,
+      NVME_ADMIN_SANITIZE     = 0x84
+    };
+
+  /* Format NVM Secure Erase Settings */
+  enum
+    {
+      NVME_SES_NONE            = 0,
+      NVME_SES_USER_DATA_ERASE = 1,
+      NVME_SES_CRYPTO_ERASE    = 2
+    };
+
+  /* Sanitize Action */
+  enum
+    {
+      NVME_SANACT_EXIT_FAILURE = 1,
+      NVME_SANACT_BLOCK_ERASE  = 2,
+      NVME_SANACT_OVERWRITE    = 3,
+      NVME_SANACT_CRYPTO_ERASE = 4
+    };
+
+  struct identity
+  {
+    uint32_t format:1;
+    uint32_t format_crypto_erase:1;
+    uint32_t write_uncorrectable:1;
+    uint32_t write_zeroes:1;
+    uint32_t verify:1;
+    uint32_t sanitize_crypto_erase:1;
+    uint32_t sanitize_block_erase:1;
+    uint32_t sanitize_overwrite:1;
+
+    char serial_number[20+1];
+    char firmware_revision[8+1];
+    char model_number[40+1];
+  };
+
+  struct sanitize_status
+  {
+    uint16_t progress;
+    uint8_t  completed:1;
+    uint8_t  in_progress:1;
+    uint8_t  failed:1;
+  };
+
+  int
+  nsid(const int fd);
+
+  std::string
+  generic_path(const int fd);
+
+  int
+  status_to_errno(const int status);
+
+  int
+  identify(const int       fd,
+           nvme::identity &ident,
+           const int       timeout);
+
+  int
+  read(const int       fd,
+       const uint32_t  nsid,
+       const uint64_t  lba,
+       const uint64_t  blocks,
+       void           *buf,
+       const uint64_t  buflen,
+       const int       timeout);
+  int
+  verify(const int      fd,
+         const uint32_t nsid,
+         const uint64_t lba,
+         const uint64_t blocks,
+         const int      timeout);
+  int
+  write(const int       fd,
+        const uint32_t  nsid,
+        const uint64_t  lba,
+        const uint64_t  blocks,
+        const void     *buf,
+        const uint64_t  buflen,
+        const bool      fua,
+        const int       timeout);
+  int
+  write_uncorrectable(const int      fd,
+                      const uint32_t nsid,
+                      const uint64_t lba,
+                      const uint64_t blocks,
+                      const int      timeout);
+  int
+  write_zeroes(const int      fd,
+               const uint32_t nsid,
+               const uint64_t lba,
+               const uint64_t blocks,
+               const int      timeout);
+  int
+  flush(const int      fd,
+        const uint32_t nsid,
+        const int      timeout);
+
+  int
+  format(const int      fd,
+         const uint32_t nsid,
+         const int      ses,
+         const int      timeout);
+  int
+  sanitize(const int fd,
+           const int sanact,
+           const int timeout);
+  int
+  get_sanitize_status(const int              fd,
+                      nvme::sanitize_status &status,
+                      const int              timeout);
+
+  void
+  prepare_rw(struct nvme_uring_cmd &cmd,
+             const uint8_t          opcode,
+             const uint32_t         nsid,
+             const uint64_t         lba,
+             const uint64_t         blocks,
+             void                  *buf,
+             const uint64_t         buflen,
+             const int              timeout);
+}
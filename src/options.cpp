@@ -36,21 +36,41 @@ void
 usage(std::ostream &os)
 {
   os <<
-    "usage: bbf [options] <instruction> <path>\n"
+    "usage: bbf [options] <instruction> <path> [<path> ...]\n"
     "\n"
     "  instruction\n"
     "    * info                : print out details of the device\n"
     "    * captcha             : print captcha for device\n"
     "    * scan                : perform scan for bad blocks by reading\n"
+    "                            - given a file or directory only the blocks\n"
+    "                              of its files, reporting those affected\n"
+    "    * rescan              : reread only the blocks of the bad block list\n"
+    "                            (and --radius around them), retry failures\n"
+    "                            with backoff & drop blocks which now read\n"
+    "    * rescue              : copy readable data to --output (image file or\n"
+    "                            device, which then needs its --captcha)\n"
+    "                            - skip bad regions first, then split and\n"
+    "                              retry them, resumable with --resume\n"
     "    * fix                 : attempt to force drive to reallocate block\n"
     "                            - on successful read of block, write it back\n"
     "                            - on unsuccessful read of block, write zeros\n"
     "    * fix-file            : same behavior as 'fix' but specifically to a file's\n"
     "                            blocks\n"
+    "                            - with --input only those on the list\n"
+    "                            - otherwise those of requests which fail to read\n"
     "    * burnin              : attempts a non-destructive write, read, & verify\n"
-    "                            - read block, write block of 0x00, 0x55, 0xAA, 0xFF\n"
+    "                            - read block, write & verify each --patterns\n"
     "                            - write back original block if was successfully read\n"
-    "                            - only if the last write,read,verify fails is it bad\n"
+    "                            - blocks failing any write,read,verify are bad\n"
+    "                            - restored blocks are read back and checked\n"
+    "                              against a CRC32C of the original\n"
+    "    * discard             : discard (TRIM) the range and read it back\n"
+    "                            expecting zeros. Blocks failing to read are\n"
+    "                            bad as are non-zero ones if the drive\n"
+    "                            guarantees zeros after TRIM\n"
+    "    * bench               : time sequential & random reads (and with\n"
+    "                            --destructive writes) with each engine,\n"
+    "                            request size & queue depth\n"
     "    * find-files          : given a list of bad blocks try to find affected files\n"
     "    * dump-files          : dump list of block ranges and files assocated with them\n"
     "    * file-blocks         : dump a list of individual blocks a file uses\n"
@@ -66,23 +86,161 @@ usage(std::ostream &os)
     "                            erase overwrites all users data with zeros and\n"
     "                            enhanced overwrites all data (including relocated)\n"
     "                            with vendor specific patterns.\n"
+    "    * sanitize\n"
+    "    * sanitize-crypto-scramble\n"
+    "    * sanitize-block-erase\n"
+    "    * sanitize-overwrite\n"
+    "                          : ATA SANITIZE. Without a method the fastest\n"
+    "                            supported is used: crypto scramble, block\n"
+    "                            erase then overwrite. Runs in the background\n"
+    "                            on the drive and is polled for progress\n"
+    "    * daemon              : listen on the Unix socket given as path and\n"
+    "                            run scan, burnin, fix & find-files jobs\n"
+    "                            submitted to it, one at a time per device\n"
     "  path                    : block device|directory|file to act on\n"
+    "                            scan, burnin, sanitize-*, *security-erase &\n"
+    "                            write-*-uncorrectable accept\n"
+    "                            multiple devices which are processed\n"
+    "                            concurrently\n"
     "\n"
     "  -f, --force             : normally destructive behavior fail if the device\n"
     "                            is mounted. This overrides this check.\n"
-    "  -t, --rwtype <os|ata>   : use OS or ATA reads and writes (default: os)\n"
+    "  -t, --rwtype <os|ata|verify>\n"
+    "                          : use OS or ATA reads and writes (default: os)\n"
+    "                            - verify: scan only, ATA READ VERIFY EXT which\n"
+    "                              checks the media without transferring data\n"
+    "                            NVMe namespaces use NVMe Read / Write / Verify\n"
+    "  -D, --direct            : open device with O_DIRECT to bypass the page\n"
+    "                            cache for OS reads and writes\n"
     "  -q, --quiet             : redirects stdout to /dev/null\n"
     "  -s, --start-block <lba> : block to start from (default: 0)\n"
     "  -e, --end-block <lba>   : block to stop at (default: last block)\n"
+    "                            zoned burnin: only zones entirely within\n"
+    "                            the range are burned\n"
     "  -S, --stepping <n>      : number of logical blocks to read at a time\n"
     "                            (default: physical / logical)\n"
+    "                            rescue: size of the copying reads\n"
+    "                            (default: 1MiB)\n"
+    "  -a, --adaptive          : scan & burnin: grow the request size while\n"
+    "                            requests succeed and throughput improves and\n"
+    "                            drop back to --stepping near errors\n"
+    "  -R, --resume            : scan & burnin: continue from the last checkpoint\n"
+    "                            in <output>.journal left by an interrupted run\n"
+    "                            rescue: continue from the map\n"
     "  -o, --output <file>     : file to write bad block list to\n"
     "                            defaults to ${HOME}/badblocks.<captcha>\n"
     "  -i, --input <file>      : file to read bad block list from\n"
     "                            defaults to ${HOME}/badblocks.<captcha>\n"
+    "  -F, --format <text|binary>\n"
+    "                          : format of the bad block list written\n"
+    "                            - text: one block per line\n"
+    "                            - binary: sorted runs with device header\n"
+    "                            (default: that of the existing file or text)\n"
     "  -r, --retries <count>   : number of retries on certain reads & writes\n"
+    "                          : rescan: backoff rounds for failing blocks\n"
+    "                            (default: 3)\n"
     "  -c, --captcha <captcha> : needed when performing destructive operations\n"
+    "                            comma separated list when given multiple devices\n"
     "  -M, --max-errors <n>    : max r/w errors before exiting (default: 1024)\n"
+    "  -Q, --queue-depth <n>   : number of reads kept in flight when scanning\n"
+    "                            using io_uring or libaio, or the sg driver\n"
+    "                            for rwtype ata|verify (max 16), NVMe io_uring\n"
+    "                            passthrough for NVMe devices (default: 1)\n"
+    "                          : burnin: number of stripes pipelined through\n"
+    "                            write, read back & compare at once\n"
+    "  -l, --localize <linear|bisect>\n"
+    "                          : how to find the bad blocks within a failed read\n"
+    "                            - linear: reread each block individually\n"
+    "                            - bisect: split the range and only recurse\n"
+    "                              into failing halves\n"
+    "                            (default: linear)\n"
+    "                            scan skips this when the drive reports the\n"
+    "                            first unreadable block in its sense data\n"
+    "  -C, --cache <file>      : dump-files, find-files: reuse the block to file\n"
+    "                            map stored in file for directories unchanged\n"
+    "                            since it was written and update it\n"
+    "  -u, --unsorted          : dump-files: print each directory's extents as\n"
+    "                            soon as it is read rather than building and\n"
+    "                            sorting the whole map first. Memory stays\n"
+    "                            bounded. Ignores --cache\n"
+    "  -m, --metrics <file>    : scan: write throughput, current block, bad\n"
+    "                            block & retry counts and latency percentiles\n"
+    "                            every second. As a Prometheus textfile if\n"
+    "                            file ends in .prom else appended JSON lines\n"
+    "  -T, --slow-threshold <ms>\n"
+    "                          : scan: blocks of reads which succeed but take\n"
+    "                            at least ms milliseconds are written to\n"
+    "                            <output>.weak\n"
+    "  -N, --radius <n>        : rescan: also read n blocks either side of each\n"
+    "                            run of bad blocks (default: 0)\n"
+    "  -P, --sample <percent>  : scan: read a random stepping sized stripe from\n"
+    "                            each equal slice of the range so that percent\n"
+    "                            of it is read, every slice around a failure\n"
+    "                            in full, and estimate the bad stripe rate\n"
+    "  -O, --order <lba|allocated|recent|zones>\n"
+    "                          : scan: blocks to read first before filling in\n"
+    "                            the rest of the range in LBA order\n"
+    "                            - lba: none, sweep the range (default)\n"
+    "                            - allocated: extents of files on filesystems\n"
+    "                              mounted from the device\n"
+    "                            - recent: as allocated, most recently\n"
+    "                              modified files first\n"
+    "                            - zones: written part of each zone\n"
+    "  -b, --max-rate <MB/s>   : scan, burnin: limit throughput to MB/s\n"
+    "  -I, --max-iops <n>      : scan, burnin: limit requests per second to n\n"
+    "  -L, --latency-target <ms>\n"
+    "                          : scan, burnin: back off while requests take\n"
+    "                            longer than ms, a sign of competing I/O\n"
+    "  -z, --timeout <seconds> : scan, burnin, rescan: ATA passthrough command\n"
+    "                            timeout (default: 60)\n"
+    "  -E, --erc <ms>          : scan, burnin, rescan: limit drive read & write\n"
+    "                            error recovery to ms with SCT ERC, restored\n"
+    "                            afterwards\n"
+    "  -n, --idle              : scan, burnin: use the idle I/O scheduling\n"
+    "                            class\n"
+    "  -B, --stream            : scan: print each bad block to stdout as soon\n"
+    "                            as it is found, other output goes to stderr\n"
+    "                          : find-files: read the input as a stream and\n"
+    "                            report each block as it arrives\n"
+    "  -A, --allocated-only    : scan: read only the blocks in use by\n"
+    "                            filesystems mounted from the device\n"
+    "  -k, --password-file <file>\n"
+    "                          : *security-erase: read the drive password\n"
+    "                            from the first line of file (or set\n"
+    "                            BBF_PASSWORD) and skip the confirmation\n"
+    "                            prompt. Required with multiple devices\n"
+    "  -j, --jobs <n>          : scan: split the range into n aligned regions\n"
+    "                            scanned concurrently (default: 1)\n"
+    "                          : burnin: zones of a zoned device burned\n"
+    "                            concurrently (default: 4, at most the\n"
+    "                            open zone limit)\n"
+    "                          : daemon: jobs running at once (default: no\n"
+    "                            limit beyond one per device)\n"
+    "                          : dump-files, find-files: walk the directory\n"
+    "                            tree with n threads (default: 1)\n"
+    "  -p, --patterns <list>   : burnin: comma separated patterns to write\n"
+    "                            - 0x00..0xff: every byte set to the value\n"
+    "                            - lba: each 8 byte word holds the block's LBA\n"
+    "                            - random: pseudo-random stream per block\n"
+    "                            (default: 0x00,0x55,0xaa,0xff)\n"
+    "  -W, --window <n>        : burnin: write each pattern over n blocks and\n"
+    "                            then verify them rather than per stripe\n"
+    "                            (n blocks of original data are held in memory)\n"
+    "  -d, --destructive       : burnin: don't save or restore the original\n"
+    "                            data. Pattern major over the whole range\n"
+    "                            unless --window is given\n"
+    "                          : bench: also time writes, overwriting the\n"
+    "                            range with zeros\n"
+    "  -x, --discard           : burnin: with --destructive discard (TRIM) the\n"
+    "                            range and verify it reads as zeros before\n"
+    "                            writing patterns and discard it again after\n"
+    "                            so an SSD is left with no stale mappings\n"
+    "  -w, --write-cache <flush|fua>\n"
+    "                          : burnin: make sure patterns are read back from\n"
+    "                            the media rather than the drive's cache\n"
+    "                            - flush: flush the cache once per window pass\n"
+    "                            - fua: write with force unit access\n"
+    "                            pattern major (default --window 64MiB worth)\n"
     "\n";
 }
 
@@ -96,6 +254,101 @@ Options::process_arg(const int          argc,
     case 'f':
       force = true;
       break;
+    case 'D':
+      direct = true;
+      break;
+    case 'a':
+      adaptive = true;
+      break;
+    case 'R':
+      resume = true;
+      break;
+    case 'd':
+      destructive = true;
+      break;
+    case 'x':
+      discard = true;
+      break;
+    case 'u':
+      unsorted = true;
+      break;
+    case 'n':
+      idle = true;
+      break;
+    case 'B':
+      stream = true;
+      break;
+    case 'A':
+      allocated_only = true;
+      break;
+    case 'b':
+      errno = 0;
+      max_rate = ::strtoull(optarg,NULL,BASE10);
+      if((max_rate == ULLONG_MAX) && (errno == ERANGE))
+        return AppError::argument_invalid("max rate value is invalid");
+      if(max_rate < 1)
+        return AppError::argument_invalid("max rate must be >= 1");
+      break;
+    case 'I':
+      errno = 0;
+      max_iops = ::strtoull(optarg,NULL,BASE10);
+      if((max_iops == ULLONG_MAX) && (errno == ERANGE))
+        return AppError::argument_invalid("max iops value is invalid");
+      if(max_iops < 1)
+        return AppError::argument_invalid("max iops must be >= 1");
+      break;
+    case 'L':
+      errno = 0;
+      latency_target = ::strtoull(optarg,NULL,BASE10);
+      if((latency_target == ULLONG_MAX) && (errno == ERANGE))
+        return AppError::argument_invalid("latency target value is invalid");
+      if(latency_target < 1)
+        return AppError::argument_invalid("latency target must be >= 1");
+      break;
+    case 'z':
+      errno = 0;
+      timeout = ::strtoull(optarg,NULL,BASE10);
+      if((timeout == ULLONG_MAX) && (errno == ERANGE))
+        return AppError::argument_invalid("timeout value is invalid");
+      if((timeout < 1) || (timeout > (INT_MAX / 1000)))
+        return AppError::argument_invalid("timeout must be >= 1 and <= 2147483");
+      break;
+    case 'E':
+      errno = 0;
+      erc = ::strtoull(optarg,NULL,BASE10);
+      if((erc == ULLONG_MAX) && (errno == ERANGE))
+        return AppError::argument_invalid("erc value is invalid");
+      if((erc < 100) || (erc > (0xFFFFULL * 100)))
+        return AppError::argument_invalid("erc must be >= 100 and <= 6553500");
+      break;
+    case 'W':
+      errno = 0;
+      window = ::strtoull(optarg,NULL,BASE10);
+      if((window == ULLONG_MAX) && (errno == ERANGE))
+        return AppError::argument_invalid("window value is invalid");
+      if(window < 1)
+        return AppError::argument_invalid("window must be >= 1");
+      break;
+    case 'N':
+      errno = 0;
+      radius = ::strtoull(optarg,NULL,BASE10);
+      if((radius == ULLONG_MAX) && (errno == ERANGE))
+        return AppError::argument_invalid("radius value is invalid");
+      break;
+    case 'P':
+      errno = 0;
+      sample = ::strtod(optarg,NULL);
+      if((errno == ERANGE) || !(sample > 0) || (sample > 100))
+        return AppError::argument_invalid("sample must be > 0 && <= 100");
+      break;
+    case 'T':
+      errno = 0;
+      slow_threshold = ::strtoull(optarg,NULL,BASE10);
+      if((slow_threshold == ULLONG_MAX) && (errno == ERANGE))
+        return AppError::argument_invalid("slow threshold value is invalid");
+      if(slow_threshold < 1)
+        return AppError::argument_invalid("slow threshold must be >= 1");
+      break;
     case 'q':
       quiet++;
       break;
@@ -122,7 +375,7 @@ Options::process_arg(const int          argc,
       stepping = ::strtoull(optarg,NULL,BASE10);
       if((stepping == ULLONG_MAX) && (errno == ERANGE))
         return AppError::argument_invalid("invalid stepping");
-      if((stepping > 65536) || (stepping <= 1))
+      if((stepping > 65536) || (stepping < 1))
         return AppError::argument_invalid("stepping must be >= 1 && <= 65536");
       break;
     case 'M':
@@ -131,12 +384,70 @@ Options::process_arg(const int          argc,
       if((max_errors == ULLONG_MAX) && (errno == ERANGE))
         return AppError::argument_invalid("max errors value is invalid");
       break;
+    case 'Q':
+      errno = 0;
+      queue_depth = ::strtoull(optarg,NULL,BASE10);
+      if((queue_depth == ULLONG_MAX) && (errno == ERANGE))
+        return AppError::argument_invalid("queue depth value is invalid");
+      if((queue_depth < 1) || (queue_depth > 1024))
+        return AppError::argument_invalid("queue depth must be >= 1 && <= 1024");
+      break;
+    case 'w':
+      if(!strcmp(optarg,"flush"))
+        write_cache = WRITE_CACHE_FLUSH;
+      else if(!strcmp(optarg,"fua"))
+        write_cache = WRITE_CACHE_FUA;
+      else
+        return AppError::argument_invalid("write cache must be 'flush' or 'fua'");
+      break;
+    case 'F':
+      if(!strcmp(optarg,"text"))
+        format = FORMAT_TEXT;
+      else if(!strcmp(optarg,"binary"))
+        format = FORMAT_BINARY;
+      else
+        return AppError::argument_invalid("format must be 'text' or 'binary'");
+      break;
+    case 'O':
+      if(!strcmp(optarg,"lba"))
+        order = ORDER_LBA;
+      else if(!strcmp(optarg,"allocated"))
+        order = ORDER_ALLOCATED;
+      else if(!strcmp(optarg,"recent"))
+        order = ORDER_RECENT;
+      else if(!strcmp(optarg,"zones"))
+        order = ORDER_ZONES;
+      else
+        return AppError::argument_invalid("order must be 'lba', 'allocated', 'recent' or 'zones'");
+      break;
+    case 'j':
+      errno = 0;
+      jobs = ::strtoull(optarg,NULL,BASE10);
+      if((jobs == ULLONG_MAX) && (errno == ERANGE))
+        return AppError::argument_invalid("jobs value is invalid");
+      if((jobs < 1) || (jobs > 256))
+        return AppError::argument_invalid("jobs must be >= 1 && <= 256");
+      break;
     case 'o':
       output_file = optarg;
       break;
     case 'i':
       input_file = optarg;
       break;
+    case 'C':
+      cache_file = optarg;
+      break;
+    case 'k':
+      password_file = optarg;
+      break;
+    case 'm':
+      metrics_file = optarg;
+      break;
+    case 'p':
+      if(Pattern::parse(optarg,patterns) < 0)
+        return AppError::argument_invalid("patterns must be a comma separated list"
+                                          " of byte values, 'lba' or 'random'");
+      break;
     case 'c':
       captcha = optarg;
       break;
@@ -145,9 +456,19 @@ Options::process_arg(const int          argc,
         rwtype = OS;
       else if(!strcmp(optarg,"ata"))
         rwtype = ATA;
+      else if(!strcmp(optarg,"verify"))
+        rwtype = VERIFY;
       else
         return AppError::argument_invalid("valid rwtype values are 'os' or 'ata'");
       break;
+    case 'l':
+      if(!strcmp(optarg,"linear"))
+        localize = LINEAR;
+      else if(!strcmp(optarg,"bisect"))
+        localize = BISECT;
+      else
+        return AppError::argument_invalid("valid localize values are 'linear' or 'bisect'");
+      break;
     case 'h':
       usage(std::cout);
       return AppError::success();
@@ -167,14 +488,24 @@ Options::instr_from_string(const std::string str)
     return Options::CAPTCHA;
   if(str == "scan")
     return Options::SCAN;
+  if(str == "rescan")
+    return Options::RESCAN;
+  if(str == "rescue")
+    return Options::RESCUE;
   if(str == "fix")
     return Options::FIX;
   if(str == "fix-file")
     return Options::FIX_FILE;
   if(str == "burnin")
     return Options::BURNIN;
+  if(str == "bench")
+    return Options::BENCH;
   if(str == "find-files")
     return Options::FIND_FILES;
+  if(str == "daemon")
+    return Options::DAEMON;
+  if(str == "discard")
+    return Options::DISCARD;
   if(str == "dump-files")
     return Options::DUMP_FILES;
   if(str == "file-blocks")
@@ -191,6 +522,14 @@ Options::instr_from_string(const std::string str)
     return Options::SECURITY_ERASE;
   if(str == "enhanced-security-erase")
     return Options::ENHANCED_SECURITY_ERASE;
+  if(str == "sanitize")
+    return Options::SANITIZE;
+  if(str == "sanitize-crypto-scramble")
+    return Options::SANITIZE_CRYPTO_SCRAMBLE;
+  if(str == "sanitize-block-erase")
+    return Options::SANITIZE_BLOCK_ERASE;
+  if(str == "sanitize-overwrite")
+    return Options::SANITIZE_OVERWRITE;
 
   return Options::_INVALID;
 }
@@ -199,12 +538,18 @@ AppError
 Options::parse(const int argc,
                char * const argv[])
 {
-  static const char short_options[] = "hqft:r:s:S:e:o:i:c:";
+  static const char short_options[] = "hqfDaRdunxBAt:r:s:S:e:o:i:C:c:M:Q:l:j:F:p:W:w:m:T:N:P:O:b:I:L:k:z:E:";
   static const struct option long_options[] =
     {
       {"help",              no_argument, NULL, 'h'},
       {"quiet",             no_argument, NULL, 'q'},
       {"force",             no_argument, NULL, 'f'},
+      {"direct",            no_argument, NULL, 'D'},
+      {"adaptive",          no_argument, NULL, 'a'},
+      {"resume",            no_argument, NULL, 'R'},
+      {"destructive",       no_argument, NULL, 'd'},
+      {"unsorted",          no_argument, NULL, 'u'},
+      {"discard",           no_argument, NULL, 'x'},
       {"rwtype",      required_argument, NULL, 't'},
       {"retries",     required_argument, NULL, 'r'},
       {"start-block", required_argument, NULL, 's'},
@@ -212,8 +557,30 @@ Options::parse(const int argc,
       {"stepping",    required_argument, NULL, 'S'},
       {"output",      required_argument, NULL, 'o'},
       {"input",       required_argument, NULL, 'i'},
+      {"cache",       required_argument, NULL, 'C'},
       {"captcha",     required_argument, NULL, 'c'},
       {"max-errors",  required_argument, NULL, 'M'},
+      {"queue-depth", required_argument, NULL, 'Q'},
+      {"localize",    required_argument, NULL, 'l'},
+      {"jobs",        required_argument, NULL, 'j'},
+      {"format",      required_argument, NULL, 'F'},
+      {"patterns",    required_argument, NULL, 'p'},
+      {"window",      required_argument, NULL, 'W'},
+      {"write-cache", required_argument, NULL, 'w'},
+      {"metrics",     required_argument, NULL, 'm'},
+      {"password-file", required_argument, NULL, 'k'},
+      {"slow-threshold", required_argument, NULL, 'T'},
+      {"radius",      required_argument, NULL, 'N'},
+      {"sample",      required_argument, NULL, 'P'},
+      {"order",       required_argument, NULL, 'O'},
+      {"max-rate",    required_argument, NULL, 'b'},
+      {"max-iops",    required_argument, NULL, 'I'},
+      {"latency-target", required_argument, NULL, 'L'},
+      {"timeout",     required_argument, NULL, 'z'},
+      {"erc",         required_argument, NULL, 'E'},
+      {"idle",        no_argument,       NULL, 'n'},
+      {"stream",      no_argument,       NULL, 'B'},
+      {"allocated-only", no_argument,       NULL, 'A'},
       {NULL,                          0, NULL,   0}
     };
 
@@ -245,6 +612,12 @@ Options::parse(const int argc,
 
   instruction = instr_from_string(argv[optind]);
   device      = argv[optind+1];
+  for(int i = (optind + 1); i < argc; i++)
+    devices.push_back(argv[i]);
+
+  // unset --jobs is one job except for daemon where it means no limit
+  if((jobs == 0) && (instruction != Options::DAEMON))
+    jobs = 1;
 
   return validate();
 }
@@ -260,24 +633,55 @@ Options::validate(void) const
       if(captcha.empty())
         return AppError::argument_required("captcha");
     case Options::SCAN:
+    case Options::RESCAN:
+      break;
+    case Options::DISCARD:
+    case Options::SANITIZE:
+    case Options::SANITIZE_CRYPTO_SCRAMBLE:
+    case Options::SANITIZE_BLOCK_ERASE:
+    case Options::SANITIZE_OVERWRITE:
+      if(captcha.empty())
+        return AppError::argument_required("captcha");
       break;
-    case Options::FIX:
-    case Options::FIX_FILE:
-    case Options::SECURITY_ERASE:
-    case Options::ENHANCED_SECURITY_ERASE:
     case Options::WRITE_PSEUDO_UNCORRECTABLE_WL:
     case Options::WRITE_PSEUDO_UNCORRECTABLE_WOL:
     case Options::WRITE_FLAGGED_UNCORRECTABLE_WL:
     case Options::WRITE_FLAGGED_UNCORRECTABLE_WOL:
+      /* input defaults to ${HOME}/badblocks.<captcha> */
+      if(captcha.empty())
+        return AppError::argument_required("captcha");
+      break;
+    case Options::FIX_FILE:
+      /* without an input the file is read and failures rewritten */
+      if(captcha.empty())
+        return AppError::argument_required("captcha");
+      break;
+    case Options::SECURITY_ERASE:
+    case Options::ENHANCED_SECURITY_ERASE:
+      if(captcha.empty())
+        return AppError::argument_required("captcha");
+      break;
+    case Options::FIX:
       if(captcha.empty())
         return AppError::argument_required("captcha");
     case Options::FIND_FILES:
-      if(input_file.empty())
+      /* a stream defaults to stdin */
+      if(input_file.empty() && !stream)
         return AppError::argument_required("input file");
       break;
+    case Options::BENCH:
+      if(destructive && captcha.empty())
+        return AppError::argument_required("captcha");
+      break;
+    case Options::RESCUE:
+      /* captcha of the destination is checked once it is opened */
+      if(output_file.empty())
+        return AppError::argument_required("output file");
+      break;
     case Options::DUMP_FILES:
     case Options::INFO:
     case Options::CAPTCHA:
+    case Options::DAEMON:
       break;
     default:
       break;
@@ -285,6 +689,48 @@ Options::validate(void) const
 
   if(start_block >= end_block)
     return AppError::argument_invalid("start block >= end block");
+  if(allocated_only && (instruction != Options::SCAN))
+    return AppError::argument_invalid("allocated-only only supported by scan");
+  if(allocated_only && ((order != ORDER_LBA) || (sample > 0)))
+    return AppError::argument_invalid("allocated-only can not be used with order or sample");
+  if(discard && (instruction == Options::BURNIN) && !destructive)
+    return AppError::argument_invalid("discard requires destructive");
+  if(stream &&
+     (instruction != Options::SCAN) &&
+     (instruction != Options::FIND_FILES))
+    return AppError::argument_invalid("stream only supported by scan and find-files");
+  if(stream && (instruction == Options::SCAN) && (output_file == "-"))
+    return AppError::argument_invalid("stream and output - both write to stdout");
+  if(stream && (devices.size() > 1))
+    return AppError::argument_invalid("stream not supported with multiple devices");
+  if((rwtype == Options::VERIFY) &&
+     (instruction != Options::SCAN) &&
+     (instruction != Options::RESCAN))
+    return AppError::argument_invalid("rwtype verify only supported by scan and rescan");
+  if(devices.size() > 1)
+    {
+      switch(instruction)
+        {
+        case Options::SCAN:
+        case Options::BURNIN:
+        case Options::WRITE_PSEUDO_UNCORRECTABLE_WL:
+        case Options::WRITE_PSEUDO_UNCORRECTABLE_WOL:
+        case Options::WRITE_FLAGGED_UNCORRECTABLE_WL:
+        case Options::WRITE_FLAGGED_UNCORRECTABLE_WOL:
+        case Options::SANITIZE:
+        case Options::SANITIZE_CRYPTO_SCRAMBLE:
+        case Options::SANITIZE_BLOCK_ERASE:
+        case Options::SANITIZE_OVERWRITE:
+        case Options::SECURITY_ERASE:
+        case Options::ENHANCED_SECURITY_ERASE:
+          break;
+        default:
+          return AppError::argument_invalid("multiple paths only supported by"
+                                            " scan, burnin, sanitize-*,"
+                                            " *security-erase and"
+                                            " write-*-uncorrectable");
+        }
+    }
 
   return AppError::success();
 }
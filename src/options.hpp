@@ -18,9 +18,12 @@
 
 #pragma once
 
+#include "pattern.hpp"
+
 #include <stdint.h>
 
 #include <string>
+#include <vector>
 
 struct Options
 {
@@ -28,14 +31,23 @@ public:
   enum Instruction
     {
       _INVALID = -1,
+      BENCH,
       BURNIN,
       CAPTCHA,
+      DAEMON,
+      DISCARD,
       DUMP_FILES,
       FILE_BLOCKS,
       FIND_FILES,
       FIX,
       FIX_FILE,
       INFO,
+      RESCAN,
+      RESCUE,
+      SANITIZE,
+      SANITIZE_CRYPTO_SCRAMBLE,
+      SANITIZE_BLOCK_ERASE,
+      SANITIZE_OVERWRITE,
       SCAN,
       SECURITY_ERASE,
       ENHANCED_SECURITY_ERASE,
@@ -49,23 +61,82 @@ public:
   enum RWType
     {
       ATA,
+      VERIFY,
       OS
     };
 
+  enum Localize
+    {
+      LINEAR,
+      BISECT
+    };
+
+  enum Format
+    {
+      FORMAT_AUTO,
+      FORMAT_TEXT,
+      FORMAT_BINARY
+    };
+
+  enum Order
+    {
+      ORDER_LBA,
+      ORDER_ALLOCATED,
+      ORDER_RECENT,
+      ORDER_ZONES
+    };
+
+  enum WriteCache
+    {
+      WRITE_CACHE_DEFAULT,
+      WRITE_CACHE_FLUSH,
+      WRITE_CACHE_FUA
+    };
+
 public:
   Options() :
+    instruction(_INVALID),
+    rwtype(OS),
+    localize(LINEAR),
+    format(FORMAT_AUTO),
+    order(ORDER_LBA),
+    write_cache(WRITE_CACHE_DEFAULT),
+    device(),
+    devices(),
     quiet(0),
     retries(0),
     start_block(0),
     end_block(~0ULL),
     stepping(0),
     max_errors(1024),
+    queue_depth(1),
+    jobs(0),
     output_file(),
     input_file(),
-    instruction(_INVALID),
-    device(),
-    rwtype(OS),
-    force(false)
+    cache_file(),
+    metrics_file(),
+    password_file(),
+    patterns(Pattern::defaults()),
+    window(0),
+    slow_threshold(0),
+    radius(0),
+    sample(0),
+    max_rate(0),
+    max_iops(0),
+    latency_target(0),
+    timeout(0),
+    erc(0),
+    captcha(),
+    force(false),
+    direct(false),
+    adaptive(false),
+    resume(false),
+    destructive(false),
+    unsorted(false),
+    idle(false),
+    discard(false),
+    stream(false),
+    allocated_only(false)
   {}
 
 public:
@@ -81,7 +152,12 @@ private:
 public:
   Instruction instruction;
   RWType      rwtype;
+  Localize    localize;
+  Format      format;
+  Order       order;
+  WriteCache  write_cache;
   std::string device;
+  std::vector<std::string> devices;
 
   int         quiet;
   long        retries;
@@ -89,8 +165,32 @@ public:
   uint64_t    end_block;
   uint64_t    stepping;
   uint64_t    max_errors;
+  uint64_t    queue_depth;
+  uint64_t    jobs;
   std::string output_file;
   std::string input_file;
+  std::string cache_file;
+  std::string metrics_file;
+  std::string password_file;
+  Pattern::Patterns patterns;
+  uint64_t    window;
+  uint64_t    slow_threshold;
+  uint64_t    radius;
+  double      sample;
+  uint64_t    max_rate;
+  uint64_t    max_iops;
+  uint64_t    latency_target;
+  uint64_t    timeout;
+  uint64_t    erc;
   std::string captcha;
   bool        force;
+  bool        direct;
+  bool        adaptive;
+  bool        resume;
+  bool        destructive;
+  bool        unsorted;
+  bool        idle;
+  bool        discard;
+  bool        stream;
+  bool        allocated_only;
 };
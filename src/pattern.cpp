@@ -0,0 +1,473 @@
+/*
+  ISC License
+
+  Copyright (c) 2016, Antonio SJ Musumeci <trapexit@spawn.link>
+
+  Permission to use, copy, modify, and/or distribute this software for any
+  purpose with or without fee is hereby granted, provided that the above
+  copyright notice and this permission notice appear in all copies.
+
+  THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+  WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+  MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+  ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+  WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+  ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+  OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+*/
+
+#include <errno.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include <iomanip>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define PATTERN_X86 1
+#elif defined(__aarch64__)
+#include <arm_neon.h>
+#define PATTERN_NEON 1
+#endif
+
+#include "pattern.hpp"
+
+namespace l
+{
+  typedef void   (*FillFunc)(char*,const size_t,const uint64_t);
+  typedef size_t (*CmpFunc)(const char*,const size_t,const uint64_t);
+
+  /*
+    Offset of the first byte in the 8 byte word at buf which differs
+    from word. Words are stored little endian.
+  */
+  static
+  size_t
+  first_byte(const char     *buf_,
+             const uint64_t  word_)
+  {
+    uint64_t v;
+
+    ::memcpy(&v,buf_,sizeof(v));
+
+    return (__builtin_ctzll(v ^ word_) / 8);
+  }
+
+  static
+  void
+  fill_scalar(char           *buf_,
+              const size_t    len_,
+              const uint64_t  word_)
+  {
+    for(size_t i = 0; i < len_; i += sizeof(word_))
+      ::memcpy(&buf_[i],&word_,sizeof(word_));
+  }
+
+  static
+  size_t
+  cmp_scalar(const char     *buf_,
+             const size_t    len_,
+             const uint64_t  word_)
+  {
+    for(size_t i = 0; i < len_; i += sizeof(word_))
+      {
+        uint64_t v;
+
+        ::memcpy(&v,&buf_[i],sizeof(v));
+        if(v != word_)
+          return (i + first_byte(&buf_[i],word_));
+      }
+
+    return len_;
+  }
+
+#if defined(PATTERN_X86)
+  __attribute__((target("sse2")))
+  static
+  void
+  fill_sse2(char           *buf_,
+            const size_t    len_,
+            const uint64_t  word_)
+  {
+    size_t i;
+    const __m128i v = _mm_set1_epi64x(word_);
+
+    for(i = 0; (i + 16) <= len_; i += 16)
+      _mm_storeu_si128((__m128i*)&buf_[i],v);
+
+    fill_scalar(&buf_[i],(len_ - i),word_);
+  }
+
+  __attribute__((target("sse2")))
+  static
+  size_t
+  cmp_sse2(const char     *buf_,
+           const size_t    len_,
+           const uint64_t  word_)
+  {
+    size_t i;
+    const __m128i v = _mm_set1_epi64x(word_);
+
+    for(i = 0; (i + 16) <= len_; i += 16)
+      {
+        int mask;
+        __m128i d;
+
+        d    = _mm_loadu_si128((const __m128i*)&buf_[i]);
+        mask = _mm_movemask_epi8(_mm_cmpeq_epi8(d,v));
+        if(mask != 0xFFFF)
+          return (i + __builtin_ctz(~mask));
+      }
+
+    return (i + cmp_scalar(&buf_[i],(len_ - i),word_));
+  }
+
+  __attribute__((target("avx2")))
+  static
+  void
+  fill_avx2(char           *buf_,
+            const size_t    len_,
+            const uint64_t  word_)
+  {
+    size_t i;
+    const __m256i v = _mm256_set1_epi64x(word_);
+
+    for(i = 0; (i + 32) <= len_; i += 32)
+      _mm256_storeu_si256((__m256i*)&buf_[i],v);
+
+    fill_scalar(&buf_[i],(len_ - i),word_);
+  }
+
+  __attribute__((target("avx2")))
+  static
+  size_t
+  cmp_avx2(const char     *buf_,
+           const size_t    len_,
+           const uint64_t  word_)
+  {
+    size_t i;
+    const __m256i v = _mm256_set1_epi64x(word_);
+
+    for(i = 0; (i + 32) <= len_; i += 32)
+      {
+        uint32_t mask;
+        __m256i d;
+
+        d    = _mm256_loadu_si256((const __m256i*)&buf_[i]);
+        mask = _mm256_movemask_epi8(_mm256_cmpeq_epi8(d,v));
+        if(mask != 0xFFFFFFFF)
+          return (i + __builtin_ctz(~mask));
+      }
+
+    return (i + cmp_scalar(&buf_[i],(len_ - i),word_));
+  }
+#endif
+
+#if defined(PATTERN_NEON)
+  static
+  void
+  fill_neon(char           *buf_,
+            const size_t    len_,
+            const uint64_t  word_)
+  {
+    size_t i;
+    const uint8x16_t v = vreinterpretq_u8_u64(vdupq_n_u64(word_));
+
+    for(i = 0; (i + 16) <= len_; i += 16)
+      vst1q_u8((uint8_t*)&buf_[i],v);
+
+    fill_scalar(&buf_[i],(len_ - i),word_);
+  }
+
+  static
+  size_t
+  cmp_neon(const char     *buf_,
+           const size_t    len_,
+           const uint64_t  word_)
+  {
+    size_t i;
+    const uint8x16_t v = vreinterpretq_u8_u64(vdupq_n_u64(word_));
+
+    for(i = 0; (i + 16) <= len_; i += 16)
+      {
+        uint8x16_t d;
+
+        d = vld1q_u8((const uint8_t*)&buf_[i]);
+        if(vminvq_u8(vceqq_u8(d,v)) != 0xFF)
+          return (i + cmp_scalar(&buf_[i],16,word_));
+      }
+
+    return (i + cmp_scalar(&buf_[i],(len_ - i),word_));
+  }
+#endif
+
+  struct Kernels
+  {
+    const char *name;
+    FillFunc    fill;
+    CmpFunc     cmp;
+  };
+
+  static
+  Kernels
+  select_kernels(void)
+  {
+    Kernels k = {"scalar",fill_scalar,cmp_scalar};
+
+#if defined(PATTERN_X86)
+    __builtin_cpu_init();
+    if(__builtin_cpu_supports("avx2"))
+      {
+        k.name = "avx2";
+        k.fill = fill_avx2;
+        k.cmp  = cmp_avx2;
+      }
+    else if(__builtin_cpu_supports("sse2"))
+      {
+        k.name = "sse2";
+        k.fill = fill_sse2;
+        k.cmp  = cmp_sse2;
+      }
+#elif defined(PATTERN_NEON)
+    k.name = "neon";
+    k.fill = fill_neon;
+    k.cmp  = cmp_neon;
+#endif
+
+    return k;
+  }
+
+  static
+  const Kernels &
+  kernels(void)
+  {
+    static const Kernels k = select_kernels();
+
+    return k;
+  }
+
+  static
+  uint64_t
+  splitmix64(uint64_t x_)
+  {
+    x_ += 0x9E3779B97F4A7C15ULL;
+    x_  = ((x_ ^ (x_ >> 30)) * 0xBF58476D1CE4E5B9ULL);
+    x_  = ((x_ ^ (x_ >> 27)) * 0x94D049BB133111EBULL);
+
+    return (x_ ^ (x_ >> 31));
+  }
+
+  static
+  uint64_t
+  xorshift64(uint64_t &state_)
+  {
+    state_ ^= (state_ << 13);
+    state_ ^= (state_ >>  7);
+    state_ ^= (state_ << 17);
+
+    return state_;
+  }
+
+  static
+  uint64_t
+  random_state(const uint64_t seed_,
+               const uint64_t lba_)
+  {
+    uint64_t state;
+
+    state = splitmix64(seed_ ^ splitmix64(lba_));
+
+    return ((state == 0) ? 1 : state);
+  }
+
+  static
+  uint64_t
+  block_word(const Pattern::Pattern &pattern_,
+             const uint64_t          lba_)
+  {
+    if(pattern_.type == Pattern::LBA)
+      return lba_;
+
+    return (pattern_.value * 0x0101010101010101ULL);
+  }
+}
+
+namespace Pattern
+{
+  Patterns
+  defaults(void)
+  {
+    Patterns patterns;
+    const uint8_t values[] = {0x00,0x55,0xAA,0xFF};
+
+    for(size_t i = 0; i < (sizeof(values) / sizeof(values[0])); i++)
+      {
+        Pattern p;
+
+        p.type  = CONSTANT;
+        p.value = values[i];
+
+        patterns.push_back(p);
+      }
+
+    return patterns;
+  }
+
+  int
+  parse(const std::string &str_,
+        Patterns          &patterns_)
+  {
+    std::string token;
+    std::istringstream is(str_);
+
+    patterns_.clear();
+    while(std::getline(is,token,','))
+      {
+        Pattern p;
+
+        if(token == "lba")
+          {
+            p.type  = LBA;
+            p.value = 0;
+          }
+        else if(token == "random")
+          {
+            p.type  = RANDOM;
+            p.value = l::splitmix64(::time(NULL) + patterns_.size());
+          }
+        else
+          {
+            char *end;
+
+            p.type  = CONSTANT;
+            p.value = ::strtoul(token.c_str(),&end,0);
+            if(token.empty() || (*end != '\0') || (p.value > 0xFF))
+              return -EINVAL;
+          }
+
+        patterns_.push_back(p);
+      }
+
+    return (patterns_.empty() ? -EINVAL : 0);
+  }
+
+  std::string
+  to_string(const Patterns &patterns_)
+  {
+    std::ostringstream os;
+
+    for(size_t i = 0; i < patterns_.size(); i++)
+      {
+        if(i)
+          os << ',';
+
+        switch(patterns_[i].type)
+          {
+          case CONSTANT:
+            os << "0x"
+               << std::hex << std::setw(2) << std::setfill('0')
+               << patterns_[i].value
+               << std::dec;
+            break;
+          case LBA:
+            os << "lba";
+            break;
+          case RANDOM:
+            os << "random";
+            break;
+          }
+      }
+
+    return os.str();
+  }
+
+  const char *
+  isa(void)
+  {
+    return l::kernels().name;
+  }
+
+  void
+  fill(const Pattern  &pattern_,
+       char           *buf_,
+       const uint64_t  lba_,
+       const uint64_t  blocks_,
+       const uint64_t  block_size_)
+  {
+    const l::Kernels &k = l::kernels();
+
+    if(pattern_.type == CONSTANT)
+      {
+        k.fill(buf_,(blocks_ * block_size_),l::block_word(pattern_,lba_));
+        return;
+      }
+
+    for(uint64_t i = 0; i < blocks_; i++)
+      {
+        char *buf = &buf_[i * block_size_];
+
+        if(pattern_.type == LBA)
+          {
+            k.fill(buf,block_size_,l::block_word(pattern_,lba_ + i));
+            continue;
+          }
+
+        uint64_t state = l::random_state(pattern_.value,lba_ + i);
+        for(uint64_t j = 0; j < block_size_; j += sizeof(uint64_t))
+          {
+            const uint64_t v = l::xorshift64(state);
+
+            ::memcpy(&buf[j],&v,sizeof(v));
+          }
+      }
+  }
+
+  int64_t
+  verify(const Pattern  &pattern_,
+         const char     *buf_,
+         const uint64_t  lba_,
+         const uint64_t  blocks_,
+         const uint64_t  block_size_)
+  {
+    size_t off;
+    const l::Kernels &k = l::kernels();
+
+    if(pattern_.type == CONSTANT)
+      {
+        off = k.cmp(buf_,(blocks_ * block_size_),l::block_word(pattern_,lba_));
+
+        return ((off == (blocks_ * block_size_)) ? -1 : (int64_t)off);
+      }
+
+    for(uint64_t i = 0; i < blocks_; i++)
+      {
+        const char *buf = &buf_[i * block_size_];
+
+        if(pattern_.type == LBA)
+          {
+            off = k.cmp(buf,block_size_,l::block_word(pattern_,lba_ + i));
+            if(off != block_size_)
+              return ((i * block_size_) + off);
+            continue;
+          }
+
+        uint64_t state = l::random_state(pattern_.value,lba_ + i);
+        for(uint64_t j = 0; j < block_size_; j += sizeof(uint64_t))
+          {
+            uint64_t v;
+            const uint64_t expected = l::xorshift64(state);
+
+            ::memcpy(&v,&buf[j],sizeof(v));
+            if(v != expected)
+              return ((i * block_size_) + j + l::first_byte(&buf[j],expected));
+          }
+      }
+
+    return -1;
+  }
+}
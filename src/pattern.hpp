@@ -0,0 +1,72 @@
+/*
+  ISC License
+
+  Copyright (c) 2016, Antonio SJ Musumeci <trapexit@spawn.link>
+
+  Permission to use, copy, modify, and/or distribute this software for any
+  purpose with or without fee is hereby granted, provided that the above
+  copyright notice and this permission notice appear in all copies.
+
+  THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+  WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+  MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+  ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+  WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+  ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+  OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+*/
+
+#pragma once
+
+#include <stdint.h>
+
+#include <string>
+#include <vector>
+
+/*
+  Burnin test patterns generated on the fly for a range of blocks
+  rather than kept in full size buffers:
+
+    constant : every byte is the same value (0x00, 0x55, ...)
+    lba      : every 8 byte word of a block holds the block's LBA
+    random   : xorshift stream seeded from the pattern's seed and the
+               block's LBA so any block can be regenerated alone
+
+  fill() and verify() use SSE2 / AVX2 / NEON kernels when the CPU has
+  them, chosen at runtime. verify() returns the byte offset of the
+  first mismatch so callers can tell exactly which block failed.
+*/
+namespace Pattern
+{
+  enum Type
+    {
+      CONSTANT,
+      LBA,
+      RANDOM
+    };
+
+  struct Pattern
+  {
+    Type     type;
+    uint64_t value;
+  };
+
+  typedef std::vector<Pattern> Patterns;
+
+  Patterns    defaults(void);
+  int         parse(const std::string &str,
+                    Patterns          &patterns);
+  std::string to_string(const Patterns &patterns);
+  const char *isa(void);
+
+  void    fill(const Pattern  &pattern,
+               char           *buf,
+               const uint64_t  lba,
+               const uint64_t  blocks,
+               const uint64_t  block_size);
+  int64_t verify(const Pattern  &pattern,
+                 const char     *buf,
+                 const uint64_t  lba,
+                 const uint64_t  blocks,
+                 const uint64_t  block_size);
+}
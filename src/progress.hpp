@@ -0,0 +1,276 @@
+/*
+  ISC License
+
+  Copyright (c) 2016, Antonio SJ Musumeci <trapexit@spawn.link>
+
+  Permission to use, copy, modify, and/or distribute this software for any
+  purpose with or without fee is hereby granted, provided that the above
+  copyright notice and this permission notice appear in all copies.
+
+  THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+  WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+  MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+  ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+  WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+  ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+  OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+*/
+
+#pragma once
+
+#include <stdint.h>
+
+#include <vector>
+
+/*
+  Counters describing how far along a scan, burnin, fix or directory
+  walk is. Written by the threads doing the work and read by whoever
+  renders the status line (see ProgressReporter) so all access is
+  atomic and nothing here blocks. The reader may ask the workers to
+  stop early with cancel().
+
+  An instruction without a block range (end_block == start_block)
+  only counts items with advance().
+
+  Retries counts requests reissued after a failure, including those
+  made localizing bad blocks within a failed request.
+
+  Reallocated and pending sectors are the device's own counts from
+  its SMART data, UINT64_MAX while unknown.
+
+  Request latencies in microseconds are kept in an HDR style log
+  linear histogram: each power of two is split into
+  2^LATENCY_SUB_BITS equal buckets so any bucket's bounds are within
+  25% of each other, from 1 usec up to ~2 hours.
+*/
+
+class Progress
+{
+public:
+  enum
+    {
+      LATENCY_SUB_BITS = 2,
+      LATENCY_SUB      = (1 << LATENCY_SUB_BITS),
+      LATENCY_BUCKETS  = 128
+    };
+
+public:
+  Progress()
+    : _start_block(0),
+      _end_block(0),
+      _block_size(0),
+      _current_block(0),
+      _bad_blocks(0),
+      _last_bad(0),
+      _bytes(0),
+      _requests(0),
+      _retries(0),
+      _reallocated(UINT64_MAX),
+      _pending(UINT64_MAX),
+      _done(0),
+      _cancelled(0)
+  {
+    for(int i = 0; i < LATENCY_BUCKETS; i++)
+      _latency[i] = 0;
+  }
+
+public:
+  void
+  set_range(const uint64_t start_block_,
+            const uint64_t end_block_,
+            const uint64_t block_size_)
+  {
+    __atomic_store_n(&_start_block,start_block_,__ATOMIC_RELAXED);
+    __atomic_store_n(&_end_block,end_block_,__ATOMIC_RELAXED);
+    __atomic_store_n(&_block_size,block_size_,__ATOMIC_RELAXED);
+    __atomic_store_n(&_current_block,start_block_,__ATOMIC_RELEASE);
+  }
+
+  void
+  set_current(const uint64_t block_)
+  {
+    __atomic_store_n(&_current_block,block_,__ATOMIC_RELAXED);
+  }
+
+  void
+  advance(const uint64_t count_)
+  {
+    __atomic_add_fetch(&_current_block,count_,__ATOMIC_RELAXED);
+  }
+
+  void
+  set_bad(const uint64_t count_)
+  {
+    __atomic_store_n(&_bad_blocks,count_,__ATOMIC_RELAXED);
+  }
+
+  void
+  set_bad(const std::vector<uint64_t> &badblocks_)
+  {
+    if(badblocks_.empty())
+      return;
+
+    __atomic_store_n(&_last_bad,badblocks_.back(),__ATOMIC_RELAXED);
+    __atomic_store_n(&_bad_blocks,badblocks_.size(),__ATOMIC_RELAXED);
+  }
+
+  static
+  int
+  latency_bucket(const uint64_t usec_)
+  {
+    int bucket;
+    int exponent;
+
+    if(usec_ < LATENCY_SUB)
+      return (int)usec_;
+
+    exponent = (63 - __builtin_clzll(usec_));
+    bucket   = (((exponent - LATENCY_SUB_BITS + 1) * LATENCY_SUB) +
+                (int)((usec_ >> (exponent - LATENCY_SUB_BITS)) & (LATENCY_SUB - 1)));
+
+    return ((bucket < LATENCY_BUCKETS) ? bucket : (LATENCY_BUCKETS - 1));
+  }
+
+  /* exclusive upper bound in usec of bucket i */
+  static
+  uint64_t
+  latency_bound(const int i_)
+  {
+    int shift;
+
+    if(i_ < LATENCY_SUB)
+      return (uint64_t)(i_ + 1);
+
+    shift = ((i_ / LATENCY_SUB) - 1);
+
+    return ((uint64_t)(LATENCY_SUB + (i_ % LATENCY_SUB) + 1) << shift);
+  }
+
+  void
+  add_request(const uint64_t bytes_,
+              const double   seconds_)
+  {
+    const int bucket = latency_bucket((uint64_t)(seconds_ * 1000000.0));
+
+    __atomic_add_fetch(&_bytes,bytes_,__ATOMIC_RELAXED);
+    __atomic_add_fetch(&_requests,1,__ATOMIC_RELAXED);
+    __atomic_add_fetch(&_latency[bucket],1,__ATOMIC_RELAXED);
+  }
+
+  void
+  add_retries(const uint64_t count_)
+  {
+    __atomic_add_fetch(&_retries,count_,__ATOMIC_RELAXED);
+  }
+
+  void
+  set_smart(const uint64_t reallocated_,
+            const uint64_t pending_)
+  {
+    __atomic_store_n(&_reallocated,reallocated_,__ATOMIC_RELAXED);
+    __atomic_store_n(&_pending,pending_,__ATOMIC_RELAXED);
+  }
+
+  /*
+    Replaces the request counters with the sum of those of parts_,
+    for a range split between several separately counted workers.
+  */
+  void
+  sum_requests(const std::vector<const Progress*> &parts_)
+  {
+    uint64_t bytes    = 0;
+    uint64_t requests = 0;
+    uint64_t retries  = 0;
+    uint64_t latency[LATENCY_BUCKETS] = {0};
+
+    for(size_t i = 0; i < parts_.size(); i++)
+      {
+        bytes    += parts_[i]->bytes();
+        requests += parts_[i]->requests();
+        retries  += parts_[i]->retries();
+        for(int j = 0; j < LATENCY_BUCKETS; j++)
+          latency[j] += parts_[i]->latency(j);
+      }
+
+    __atomic_store_n(&_bytes,bytes,__ATOMIC_RELAXED);
+    __atomic_store_n(&_requests,requests,__ATOMIC_RELAXED);
+    __atomic_store_n(&_retries,retries,__ATOMIC_RELAXED);
+    for(int j = 0; j < LATENCY_BUCKETS; j++)
+      __atomic_store_n(&_latency[j],latency[j],__ATOMIC_RELAXED);
+  }
+
+  void
+  finish(void)
+  {
+    __atomic_store_n(&_done,1,__ATOMIC_RELEASE);
+  }
+
+  void
+  cancel(void)
+  {
+    __atomic_store_n(&_cancelled,1,__ATOMIC_RELAXED);
+  }
+
+public:
+  /* bound of the bucket the q'th quantile falls in, 0 if none */
+  uint64_t
+  latency_percentile(const double q_) const
+  {
+    uint64_t total;
+    uint64_t count;
+    uint64_t buckets[LATENCY_BUCKETS];
+
+    total = 0;
+    for(int i = 0; i < LATENCY_BUCKETS; i++)
+      {
+        buckets[i] = latency(i);
+        total     += buckets[i];
+      }
+
+    if(total == 0)
+      return 0;
+
+    count = 0;
+    for(int i = 0; i < LATENCY_BUCKETS; i++)
+      {
+        count += buckets[i];
+        if(count && ((double)count >= (q_ * total)))
+          return latency_bound(i);
+      }
+
+    return latency_bound(LATENCY_BUCKETS - 1);
+  }
+
+
+public:
+  uint64_t start_block(void) const { return __atomic_load_n(&_start_block,__ATOMIC_RELAXED); }
+  uint64_t end_block(void) const { return __atomic_load_n(&_end_block,__ATOMIC_RELAXED); }
+  uint64_t block_size(void) const { return __atomic_load_n(&_block_size,__ATOMIC_RELAXED); }
+  uint64_t current_block(void) const { return __atomic_load_n(&_current_block,__ATOMIC_ACQUIRE); }
+  uint64_t bad_blocks(void) const { return __atomic_load_n(&_bad_blocks,__ATOMIC_RELAXED); }
+  uint64_t last_bad(void) const { return __atomic_load_n(&_last_bad,__ATOMIC_RELAXED); }
+  uint64_t bytes(void) const { return __atomic_load_n(&_bytes,__ATOMIC_RELAXED); }
+  uint64_t requests(void) const { return __atomic_load_n(&_requests,__ATOMIC_RELAXED); }
+  uint64_t retries(void) const { return __atomic_load_n(&_retries,__ATOMIC_RELAXED); }
+  uint64_t reallocated(void) const { return __atomic_load_n(&_reallocated,__ATOMIC_RELAXED); }
+  uint64_t pending(void) const { return __atomic_load_n(&_pending,__ATOMIC_RELAXED); }
+  uint64_t latency(const int i) const { return __atomic_load_n(&_latency[i],__ATOMIC_RELAXED); }
+  bool     done(void) const { return __atomic_load_n(&_done,__ATOMIC_ACQUIRE); }
+  bool     cancelled(void) const { return __atomic_load_n(&_cancelled,__ATOMIC_RELAXED); }
+
+private:
+  uint64_t _start_block;
+  uint64_t _end_block;
+  uint64_t _block_size;
+  uint64_t _current_block;
+  uint64_t _bad_blocks;
+  uint64_t _last_bad;
+  uint64_t _bytes;
+  uint64_t _requests;
+  uint64_t _retries;
+  uint64_t _reallocated;
+  uint64_t _pending;
+  uint64_t _latency[LATENCY_BUCKETS];
+  int      _done;
+  int      _cancelled;
+};
@@ -0,0 +1,185 @@
+/*
+  ISC License
+
+  Copyright (c) 2016, Antonio SJ Musumeci <trapexit@spawn.link>
+
+  Permission to use, copy, modify, and/or distribute this software for any
+  purpose with or without fee is hereby granted, provided that the above
+  copyright notice and this permission notice appear in all copies.
+
+  THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+  WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+  MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+  ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+  WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+  ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+  OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+*/
+
+#include "progressreporter.hpp"
+
+#include "info.hpp"
+#include "metrics.hpp"
+#include "progress.hpp"
+#include "time.hpp"
+
+#include <errno.h>
+#include <signal.h>
+#include <time.h>
+
+#include <sstream>
+#include <string>
+
+const double ProgressReporter::INTERVAL = 1.0;
+
+ProgressReporter::ProgressReporter()
+  : _os(NULL),
+    _progress(NULL),
+    _progresses(),
+    _label(NULL),
+    _metrics(NULL),
+    _start_time(0),
+    _running(false),
+    _stop(false)
+{
+  pthread_condattr_t attr;
+
+  pthread_condattr_init(&attr);
+  pthread_condattr_setclock(&attr,CLOCK_MONOTONIC);
+  pthread_cond_init(&_cond,&attr);
+  pthread_condattr_destroy(&attr);
+  pthread_mutex_init(&_mutex,NULL);
+}
+
+ProgressReporter::~ProgressReporter()
+{
+  stop();
+
+  pthread_cond_destroy(&_cond);
+  pthread_mutex_destroy(&_mutex);
+}
+
+int
+ProgressReporter::start(std::ostream   &os_,
+                        const Progress &progress_,
+                        const char     *label_)
+{
+  _progress = &progress_;
+  _progresses.clear();
+
+  return start(os_,label_);
+}
+
+int
+ProgressReporter::start(std::ostream                 &os_,
+                        const std::vector<Progress*> &progress_,
+                        const char                   *label_)
+{
+  _progress   = NULL;
+  _progresses = progress_;
+
+  return start(os_,label_);
+}
+
+int
+ProgressReporter::start(std::ostream &os_,
+                        const char   *label_)
+{
+  int rv;
+  sigset_t set;
+  sigset_t old;
+
+  if(_running)
+    return -EBUSY;
+
+  _os         = &os_;
+  _label      = label_;
+  _stop       = false;
+  _start_time = Time::get_monotonic();
+
+  render();
+
+  /* leave signal handling to the thread which started us */
+  sigfillset(&set);
+  pthread_sigmask(SIG_BLOCK,&set,&old);
+  rv = pthread_create(&_thread,NULL,ProgressReporter::main,this);
+  pthread_sigmask(SIG_SETMASK,&old,NULL);
+  if(rv != 0)
+    return -rv;
+
+  _running = true;
+
+  return 0;
+}
+
+void
+ProgressReporter::stop(void)
+{
+  if(!_running)
+    return;
+
+  pthread_mutex_lock(&_mutex);
+  _stop = true;
+  pthread_cond_signal(&_cond);
+  pthread_mutex_unlock(&_mutex);
+
+  pthread_join(_thread,NULL);
+  _running = false;
+
+  render();
+}
+
+void
+ProgressReporter::set_metrics(Metrics *metrics_)
+{
+  _metrics = metrics_;
+}
+
+/*
+  The line is built separately and written with one call so output
+  from other threads can't land in the middle of it.
+*/
+void
+ProgressReporter::render(void)
+{
+  std::ostringstream line;
+  const double now = Time::get_monotonic();
+
+  if(_progress)
+    Info::print(line,_start_time,now,*_progress,_label);
+  else
+    Info::print(line,_start_time,now,_progresses,_label);
+
+  const std::string str = line.str();
+
+  _os->write(str.data(),str.size());
+  _os->flush();
+
+  if(_metrics)
+    _metrics->write();
+}
+
+void*
+ProgressReporter::main(void *arg_)
+{
+  struct timespec ts;
+  ProgressReporter *reporter = (ProgressReporter*)arg_;
+
+  pthread_mutex_lock(&reporter->_mutex);
+  while(!reporter->_stop)
+    {
+      clock_gettime(CLOCK_MONOTONIC,&ts);
+      ts.tv_sec += (time_t)INTERVAL;
+
+      pthread_cond_timedwait(&reporter->_cond,&reporter->_mutex,&ts);
+      if(reporter->_stop)
+        break;
+
+      pthread_mutex_unlock(&reporter->_mutex);
+      reporter->render();
+      pthread_mutex_lock(&reporter->_mutex);
+    }
+  pthread_mutex_unlock(&reporter->_mutex);
+
+  return NULL;
+}
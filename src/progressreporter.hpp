@@ -0,0 +1,73 @@
+/*
+  ISC License
+
+  Copyright (c) 2016, Antonio SJ Musumeci <trapexit@spawn.link>
+
+  Permission to use, copy, modify, and/or distribute this software for any
+  purpose with or without fee is hereby granted, provided that the above
+  copyright notice and this permission notice appear in all copies.
+
+  THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+  WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+  MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+  ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+  WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+  ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+  OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+*/
+
+#pragma once
+
+#include <pthread.h>
+
+#include <iostream>
+#include <vector>
+
+class Metrics;
+class Progress;
+
+/*
+  Renders the status line for one or more Progress objects from its
+  own thread every INTERVAL seconds so the threads doing the I/O only
+  ever touch atomic counters. stop() draws the line a final time.
+  An attached Metrics is written on the same schedule.
+*/
+
+class ProgressReporter
+{
+public:
+  static const double INTERVAL;
+
+public:
+  ProgressReporter();
+  ~ProgressReporter();
+
+public:
+  int  start(std::ostream   &os,
+             const Progress &progress,
+             const char     *label = "Processed");
+  int  start(std::ostream                 &os,
+             const std::vector<Progress*> &progress,
+             const char                   *label);
+  void stop(void);
+  void set_metrics(Metrics *metrics);
+
+private:
+  int   start(std::ostream &os,
+              const char   *label);
+  void  render(void);
+  static void *main(void *arg);
+
+private:
+  std::ostream           *_os;
+  const Progress         *_progress;
+  std::vector<Progress*>  _progresses;
+  const char             *_label;
+  Metrics                *_metrics;
+  double                  _start_time;
+  bool                    _running;
+  bool                    _stop;
+  pthread_t               _thread;
+  pthread_mutex_t         _mutex;
+  pthread_cond_t          _cond;
+};
@@ -0,0 +1,251 @@
+/*
+  ISC License
+
+  Copyright (c) 2016, Antonio SJ Musumeci <trapexit@spawn.link>
+
+  Permission to use, copy, modify, and/or distribute this software for any
+  purpose with or without fee is hereby granted, provided that the above
+  copyright notice and this permission notice appear in all copies.
+
+  THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+  WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+  MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+  ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+  WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+  ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+  OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+*/
+
+#include "rescuemap.hpp"
+
+#include <algorithm>
+#include <errno.h>
+#include <stdio.h>
+#include <unistd.h>
+
+#include <fstream>
+#include <sstream>
+#include <string>
+
+RescueMap::RescueMap()
+  : pass(0),
+    pos(0),
+    _start(0),
+    _end(0)
+{
+
+}
+
+void
+RescueMap::reset(const uint64_t start_,
+                 const uint64_t end_)
+{
+  Region region;
+
+  _start = start_;
+  _end   = end_;
+  pass   = 0;
+  pos    = start_;
+
+  _regions.clear();
+  if(end_ <= start_)
+    return;
+
+  region.end    = end_;
+  region.status = NONTRIED;
+  _regions[start_] = region;
+}
+
+/*
+  Makes block_ the start of a region unless it's outside the range or
+  already is one.
+*/
+void
+RescueMap::split(const uint64_t block_)
+{
+  Regions::iterator i;
+
+  if((block_ <= _start) || (block_ >= _end))
+    return;
+
+  i = _regions.upper_bound(block_);
+  --i;
+  if(i->first == block_)
+    return;
+
+  _regions[block_] = i->second;
+  i->second.end    = block_;
+}
+
+void
+RescueMap::set(const uint64_t start_,
+               const uint64_t length_,
+               const Status   status_)
+{
+  uint64_t end;
+  uint64_t start;
+  Region region;
+  Regions::iterator i;
+  Regions::iterator j;
+
+  start = std::max(start_,_start);
+  end   = std::min((start_ + length_),_end);
+  if(end <= start)
+    return;
+
+  split(start);
+  split(end);
+
+  i = _regions.find(start);
+  j = _regions.lower_bound(end);
+  _regions.erase(i,j);
+
+  region.end    = end;
+  region.status = status_;
+  i = _regions.insert(std::make_pair(start,region)).first;
+
+  // merge with neighbours of the same status
+  j = i;
+  ++j;
+  if((j != _regions.end()) && (j->second.status == status_))
+    {
+      i->second.end = j->second.end;
+      _regions.erase(j);
+    }
+  if(i != _regions.begin())
+    {
+      j = i;
+      --j;
+      if(j->second.status == status_)
+        {
+          j->second.end = i->second.end;
+          _regions.erase(i);
+        }
+    }
+}
+
+/*
+  The first part at or after from_ of a region with status_.
+*/
+bool
+RescueMap::next(const Status   status_,
+                const uint64_t from_,
+                uint64_t      &start_,
+                uint64_t      &length_) const
+{
+  Regions::const_iterator i;
+
+  i = _regions.upper_bound(from_);
+  if(i != _regions.begin())
+    --i;
+
+  for(; i != _regions.end(); ++i)
+    {
+      if(i->second.status != status_)
+        continue;
+      if(i->second.end <= from_)
+        continue;
+
+      start_  = std::max(i->first,from_);
+      length_ = (i->second.end - start_);
+
+      return true;
+    }
+
+  return false;
+}
+
+uint64_t
+RescueMap::count(const Status status_) const
+{
+  uint64_t rv;
+
+  rv = 0;
+  for(Regions::const_iterator
+        i = _regions.begin(), ei = _regions.end(); i != ei; ++i)
+    if(i->second.status == status_)
+      rv += (i->second.end - i->first);
+
+  return rv;
+}
+
+int
+RescueMap::load(const std::string &path_)
+{
+  char status;
+  uint64_t start;
+  uint64_t length;
+  std::string line;
+  std::ifstream file;
+  RescueMap map;
+
+  file.open(path_.c_str());
+  if(!file.is_open())
+    return -ENOENT;
+
+  map._start = ~0ULL;
+  while(std::getline(file,line))
+    {
+      std::istringstream is(line);
+
+      if(line.empty() || (line[0] == '#'))
+        continue;
+
+      if(line.compare(0,5,"pass ") == 0)
+        {
+          std::string word;
+
+          is >> word >> map.pass >> map.pos;
+          continue;
+        }
+
+      if(!(is >> start >> length >> status))
+        return -EINVAL;
+      if((status != NONTRIED) && (status != SKIPPED) &&
+         (status != BAD) && (status != FINISHED))
+        return -EINVAL;
+      if(!map._regions.empty() && (start != map._end))
+        return -EINVAL;
+
+      map._start = std::min(map._start,start);
+      map._end   = (start + length);
+      map._regions[start].end    = map._end;
+      map._regions[start].status = (Status)status;
+    }
+
+  if(map._regions.empty())
+    return -EINVAL;
+
+  *this = map;
+
+  return 0;
+}
+
+int
+RescueMap::save(const std::string &path_) const
+{
+  int rv;
+  std::string tmp;
+  std::ofstream file;
+
+  tmp = (path_ + ".tmp");
+  file.open(tmp.c_str(),std::ios::out|std::ios::trunc);
+  if(!file.is_open())
+    return -errno;
+
+  file << "# bbf rescue map\n"
+       << "pass " << pass << ' ' << pos << '\n';
+  for(Regions::const_iterator
+        i = _regions.begin(), ei = _regions.end(); i != ei; ++i)
+    file << i->first << ' '
+         << (i->second.end - i->first) << ' '
+         << (char)i->second.status << '\n';
+
+  file.close();
+  if(file.fail())
+    return -EIO;
+
+  rv = ::rename(tmp.c_str(),path_.c_str());
+
+  return ((rv == -1) ? -errno : 0);
+}
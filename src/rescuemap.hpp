@@ -0,0 +1,103 @@
+/*
+  ISC License
+
+  Copyright (c) 2016, Antonio SJ Musumeci <trapexit@spawn.link>
+
+  Permission to use, copy, modify, and/or distribute this software for any
+  purpose with or without fee is hereby granted, provided that the above
+  copyright notice and this permission notice appear in all copies.
+
+  THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+  WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+  MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+  ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+  WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+  ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+  OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+*/
+
+#pragma once
+
+#include <stdint.h>
+
+#include <map>
+#include <string>
+
+/*
+  Which parts of a device `rescue` has copied, in the spirit of a
+  ddrescue mapfile. The range is covered by contiguous regions each
+  with a status:
+
+    ?  not tried yet
+    *  skipped over after an error on the copy pass, to be split
+    -  unreadable so far
+    +  copied
+
+  Saved as text, the header giving the pass and position to resume
+  from and then one "<start> <length> <status>" line per region in
+  logical blocks:
+
+    # bbf rescue map
+    pass <n> <block>
+    0 2048 +
+    2048 128 *
+
+  It is written to a temporary file and renamed into place so an
+  interruption never leaves half a map.
+*/
+
+class RescueMap
+{
+public:
+  enum Status
+    {
+      NONTRIED = '?',
+      SKIPPED  = '*',
+      BAD      = '-',
+      FINISHED = '+'
+    };
+
+public:
+  RescueMap();
+
+public:
+  void reset(const uint64_t start,
+             const uint64_t end);
+  void set(const uint64_t start,
+           const uint64_t length,
+           const Status   status);
+  bool next(const Status  status,
+            const uint64_t from,
+            uint64_t      &start,
+            uint64_t      &length) const;
+  uint64_t count(const Status status) const;
+
+public:
+  int load(const std::string &path);
+  int save(const std::string &path) const;
+
+public:
+  uint64_t start(void) const { return _start; }
+  uint64_t end(void) const { return _end; }
+
+public:
+  int      pass;
+  uint64_t pos;
+
+private:
+  struct Region
+  {
+    uint64_t end;
+    Status   status;
+  };
+
+  typedef std::map<uint64_t,Region> Regions;
+
+private:
+  void split(const uint64_t block);
+
+private:
+  uint64_t _start;
+  uint64_t _end;
+  Regions  _regions;
+};
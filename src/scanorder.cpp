@@ -0,0 +1,458 @@
+/*
+  ISC License
+
+  Copyright (c) 2016, Antonio SJ Musumeci <trapexit@spawn.link>
+
+  Permission to use, copy, modify, and/or distribute this software for any
+  purpose with or without fee is hereby granted, provided that the above
+  copyright notice and this permission notice appear in all copies.
+
+  THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+  WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+  MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+  ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+  WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+  ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+  OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+*/
+
+#include "scanorder.hpp"
+
+#include "badblockset.hpp"
+#include "blocktofilemapper.hpp"
+#include "filetoblkdev.hpp"
+#include "fsmap.hpp"
+#include "math.hpp"
+#include "zoned.hpp"
+
+#include <errno.h>
+#include <sys/stat.h>
+
+#include <algorithm>
+#include <map>
+#include <vector>
+
+namespace l
+{
+  /* free space smaller than this is read through to keep reads large */
+  static const uint64_t GAP_BYTES = (1024 * 1024);
+
+  struct Region
+  {
+    int64_t  mtime;
+    uint64_t file;
+    uint64_t start;
+    uint64_t length;
+  };
+
+  static
+  bool
+  newer(const Region &a_,
+        const Region &b_)
+  {
+    if(a_.mtime != b_.mtime)
+      return (a_.mtime > b_.mtime);
+    if(a_.file != b_.file)
+      return (a_.file < b_.file);
+
+    return (a_.start < b_.start);
+  }
+
+  static
+  bool
+  run_end_le(const BadBlockFile::Run &run_,
+             const uint64_t           block_)
+  {
+    return ((run_.start + run_.length) <= block_);
+  }
+
+  static
+  void
+  append(File::BlockVector &segments_,
+         const uint64_t     start_,
+         const uint64_t     end_)
+  {
+    File::Block segment;
+
+    if(!segments_.empty() &&
+       ((segments_.back().block + segments_.back().length) == start_))
+      {
+        segments_.back().length += (end_ - start_);
+        return;
+      }
+
+    segment.block  = start_;
+    segment.length = (end_ - start_);
+    segments_.push_back(segment);
+  }
+
+  /*
+    Appends the parts of [start,end) not already claimed and marks all
+    of it claimed. `claimed` is only used as a set of block runs.
+  */
+  static
+  void
+  claim(BadBlockSet       &claimed_,
+        const uint64_t     start_,
+        const uint64_t     end_,
+        File::BlockVector &segments_)
+  {
+    uint64_t pos;
+    std::vector<BadBlockFile::Run>::const_iterator i;
+    const std::vector<BadBlockFile::Run> &runs = claimed_.runs();
+
+    if(end_ <= start_)
+      return;
+
+    pos = start_;
+    i   = std::lower_bound(runs.begin(),runs.end(),start_,run_end_le);
+    for(; (pos < end_) && (i != runs.end()) && (i->start < end_); ++i)
+      {
+        if(i->start > pos)
+          append(segments_,pos,i->start);
+        pos = std::max(pos,(i->start + i->length));
+      }
+    if(pos < end_)
+      append(segments_,pos,end_);
+
+    claimed_.insert(start_,(end_ - start_));
+  }
+
+  static
+  int64_t
+  mtime(const std::string &path_)
+  {
+    int rv;
+    struct stat st;
+
+    rv = ::lstat(path_.c_str(),&st);
+    if(rv == -1)
+      return 0;
+
+    return st.st_mtime;
+  }
+
+  /*
+    Extents of every file on the filesystems mounted from devpath, as
+    stepping aligned device blocks clipped to [start,end).
+  */
+  static
+  int
+  allocated(const BlkDev        &blkdev_,
+            const std::string   &devpath_,
+            const bool           recent_,
+            const uint64_t       stepping_,
+            const uint64_t       start_,
+            const uint64_t       end_,
+            const uint64_t       threads_,
+            std::vector<Region> &regions_)
+  {
+    int rv;
+    std::vector<FileToBlkDev::Mount> mounts;
+    const uint64_t lbsize = blkdev_.logical_block_size();
+
+    rv = FileToBlkDev::mounts(devpath_,mounts);
+    if(rv <= 0)
+      return ((rv == 0) ? -ENOENT : rv);
+
+    for(size_t m = 0; m < mounts.size(); m++)
+      {
+        BlockToFileMapper b2fm;
+        std::map<const std::string*,int64_t> mtimes;
+        const uint64_t base = ((mounts[m].start * 512) / lbsize);
+
+        rv = b2fm.scan(mounts[m].path,threads_);
+        if(rv < 0)
+          return rv;
+
+        for(uint64_t i = 0, ei = b2fm.size(); i != ei; i++)
+          {
+            Region region;
+            uint64_t end;
+            const std::string *path = &b2fm.path(i);
+
+            region.start = (b2fm.start(i) - b2fm.offset() + base);
+            end          = (region.start + b2fm.length(i));
+            region.start = std::max(math::round_down(region.start,stepping_),start_);
+            end          = std::min(math::round_up(end,stepping_),end_);
+            if(end <= region.start)
+              continue;
+
+            region.length = (end - region.start);
+            region.mtime  = 0;
+            region.file   = 0;
+            if(recent_)
+              {
+                std::map<const std::string*,int64_t>::iterator t;
+
+                t = mtimes.find(path);
+                if(t == mtimes.end())
+                  t = mtimes.insert(std::make_pair(path,l::mtime(*path))).first;
+
+                region.mtime = t->second;
+                region.file  = ((m << 32) | (uint64_t)(path - &b2fm.path(0)));
+              }
+
+            regions_.push_back(region);
+          }
+      }
+
+    return 0;
+  }
+
+  static
+  bool
+  lower_start(const Region &a_,
+              const Region &b_)
+  {
+    return (a_.start < b_.start);
+  }
+
+  /*
+    In use parts of the filesystems mounted from devpath per GETFSMAP,
+    as stepping aligned device blocks clipped to [start,end).
+    Filesystems which can't say fail and their files are walked
+    instead.
+  */
+  static
+  int
+  in_use(const BlkDev        &blkdev_,
+         const std::string   &devpath_,
+         const uint64_t       stepping_,
+         const uint64_t       start_,
+         const uint64_t       end_,
+         std::vector<Region> &regions_)
+  {
+    int rv;
+    std::vector<FileToBlkDev::Mount> mounts;
+    const uint64_t lbsize = blkdev_.logical_block_size();
+
+    rv = FileToBlkDev::mounts(devpath_,mounts);
+    if(rv <= 0)
+      return ((rv == 0) ? -ENOENT : rv);
+
+    for(size_t m = 0; m < mounts.size(); m++)
+      {
+        std::vector<FSMap::Extent> extents;
+        const uint64_t base = ((mounts[m].start * 512) / lbsize);
+
+        rv = FSMap::allocated(mounts[m].path,extents);
+        if(rv < 0)
+          return rv;
+
+        for(size_t i = 0; i < extents.size(); i++)
+          {
+            Region region;
+            uint64_t end;
+
+            region.start = ((extents[i].start / lbsize) + base);
+            end          = (((extents[i].start + extents[i].length + lbsize - 1) / lbsize) + base);
+            region.start = std::max(math::round_down(region.start,stepping_),start_);
+            end          = std::min(math::round_up(end,stepping_),end_);
+            if(end <= region.start)
+              continue;
+
+            region.length = (end - region.start);
+            region.mtime  = 0;
+            region.file   = 0;
+            regions_.push_back(region);
+          }
+      }
+
+    return 0;
+  }
+
+  /*
+    Written part of each sequential zone: from its start to the write
+    pointer or all of it when full. Conventional zones have no write
+    pointer and are left to the LBA ordered fill.
+  */
+  static
+  int
+  zones(const BlkDev        &blkdev_,
+        const uint64_t       stepping_,
+        const uint64_t       start_,
+        const uint64_t       end_,
+        std::vector<Region> &regions_)
+  {
+    int rv;
+    std::vector<Zoned::Zone> zones;
+
+    rv = Zoned::report(blkdev_,zones);
+    if(rv <= 0)
+      return ((rv == 0) ? -ENOTSUP : rv);
+
+    for(size_t i = 0; i < zones.size(); i++)
+      {
+        Region region;
+        uint64_t end;
+
+        if(!zones[i].sequential)
+          continue;
+        end = (zones[i].start + Zoned::written(zones[i]));
+        if(end <= zones[i].start)
+          continue;
+
+        region.start  = std::max(math::round_down(zones[i].start,stepping_),start_);
+        end           = std::min(math::round_up(end,stepping_),end_);
+        if(end <= region.start)
+          continue;
+
+        region.length = (end - region.start);
+        region.mtime  = 0;
+        region.file   = 0;
+        regions_.push_back(region);
+      }
+
+    return 0;
+  }
+}
+
+/*
+  Returns the number of blocks read ahead of the LBA ordered fill or
+  a negative errno when the order can't be applied to the device, in
+  which case segments is the whole range.
+*/
+int64_t
+ScanOrder::build(const BlkDev         &blkdev_,
+                 const std::string    &devpath_,
+                 const Options::Order  order_,
+                 const uint64_t        stepping_,
+                 const uint64_t        start_block_,
+                 const uint64_t        end_block_,
+                 const uint64_t        threads_,
+                 File::BlockVector    &segments_)
+{
+  int rv;
+  uint64_t prioritized;
+  BadBlockSet claimed;
+  std::vector<l::Region> regions;
+
+  switch(order_)
+    {
+    case Options::ORDER_ALLOCATED:
+    case Options::ORDER_RECENT:
+      rv = l::allocated(blkdev_,devpath_,(order_ == Options::ORDER_RECENT),
+                        stepping_,start_block_,end_block_,threads_,regions);
+      break;
+    case Options::ORDER_ZONES:
+      rv = l::zones(blkdev_,stepping_,start_block_,end_block_,regions);
+      break;
+    default:
+      rv = 0;
+      break;
+    }
+
+  if(order_ == Options::ORDER_RECENT)
+    std::stable_sort(regions.begin(),regions.end(),l::newer);
+
+  if(rv == 0)
+    for(size_t i = 0; i < regions.size(); i++)
+      l::claim(claimed,
+               regions[i].start,
+               (regions[i].start + regions[i].length),
+               segments_);
+
+  prioritized = claimed.size();
+  l::claim(claimed,start_block_,end_block_,segments_);
+  if(rv < 0)
+    return rv;
+
+  return prioritized;
+}
+
+/*
+  The readable part of [start_block,end_block) of a zoned device in
+  LBA order, zone by zone: conventional zones whole and sequential
+  zones up to their write pointer. Returns the number of zones, 0 and
+  no segments for a device which isn't zoned.
+*/
+int
+ScanOrder::zoned(const BlkDev      &blkdev_,
+                 const uint64_t     start_block_,
+                 const uint64_t     end_block_,
+                 File::BlockVector &segments_)
+{
+  int rv;
+  std::vector<Zoned::Zone> zones;
+
+  rv = Zoned::report(blkdev_,zones);
+  if(rv <= 0)
+    return rv;
+
+  for(size_t i = 0; i < zones.size(); i++)
+    {
+      uint64_t start;
+      uint64_t end;
+
+      start = std::max(zones[i].start,start_block_);
+      end   = std::min((zones[i].start + Zoned::written(zones[i])),end_block_);
+      if(end <= start)
+        continue;
+
+      l::append(segments_,start,end);
+    }
+
+  return rv;
+}
+
+/*
+  Only the blocks in use by the filesystems mounted from devpath, in
+  LBA order, with gaps under GAP_BYTES read through so requests stay
+  large and sequential. GETFSMAP (ext4, XFS) covers metadata too;
+  otherwise the extents of every file are used. Returns the number of
+  blocks in segments or a negative errno, -ENOENT when nothing is
+  mounted from the device.
+*/
+int64_t
+ScanOrder::allocated_only(const BlkDev      &blkdev_,
+                          const std::string &devpath_,
+                          const uint64_t     stepping_,
+                          const uint64_t     start_block_,
+                          const uint64_t     end_block_,
+                          const uint64_t     threads_,
+                          File::BlockVector &segments_)
+{
+  int rv;
+  int64_t total;
+  uint64_t gap;
+  std::vector<l::Region> regions;
+
+  rv = l::in_use(blkdev_,devpath_,stepping_,start_block_,end_block_,regions);
+  if((rv < 0) && (rv != -ENOENT))
+    {
+      regions.clear();
+      rv = l::allocated(blkdev_,devpath_,false,stepping_,
+                        start_block_,end_block_,threads_,regions);
+    }
+  if(rv < 0)
+    return rv;
+
+  std::sort(regions.begin(),regions.end(),l::lower_start);
+
+  gap = math::round_up((l::GAP_BYTES / blkdev_.logical_block_size()),stepping_);
+  for(size_t i = 0; i < regions.size(); i++)
+    {
+      File::Block segment;
+      const uint64_t end = (regions[i].start + regions[i].length);
+
+      if(!segments_.empty() &&
+         (regions[i].start <= (segments_.back().block + segments_.back().length + gap)))
+        {
+          segments_.back().length = std::max((segments_.back().block +
+                                              segments_.back().length),
+                                             end) - segments_.back().block;
+          continue;
+        }
+
+      segment.block  = regions[i].start;
+      segment.length = regions[i].length;
+      segments_.push_back(segment);
+    }
+
+  total = 0;
+  for(size_t i = 0; i < segments_.size(); i++)
+    total += segments_[i].length;
+
+  return total;
+}
@@ -0,0 +1,66 @@
+/*
+  ISC License
+
+  Copyright (c) 2016, Antonio SJ Musumeci <trapexit@spawn.link>
+
+  Permission to use, copy, modify, and/or distribute this software for any
+  purpose with or without fee is hereby granted, provided that the above
+  copyright notice and this permission notice appear in all copies.
+
+  THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+  WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+  MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+  ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+  WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+  ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+  OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+*/
+
+#pragma once
+
+#include "blkdev.hpp"
+#include "errors.hpp"
+#include "file.hpp"
+#include "options.hpp"
+
+#include <stdint.h>
+
+#include <string>
+
+/*
+  Orders a scan so the regions most likely to matter are read first:
+  the extents of files on filesystems mounted from the device, the
+  same grouped by file most recently modified first, or the written
+  part of each zone of a zoned device. The rest of the range follows
+  in LBA order. Every segment is aligned to stepping and no block
+  appears twice so reading them in turn covers the range exactly once.
+
+  zoned() instead drops what can't be read from a zoned device: the
+  parts of sequential zones past their write pointer. allocated_only()
+  drops what no filesystem mounted from the device is using.
+*/
+
+namespace ScanOrder
+{
+  int64_t build(const BlkDev              &blkdev,
+                const std::string         &devpath,
+                const Options::Order       order,
+                const uint64_t             stepping,
+                const uint64_t             start_block,
+                const uint64_t             end_block,
+                const uint64_t             threads,
+                File::BlockVector         &segments);
+
+  int     zoned(const BlkDev      &blkdev,
+                const uint64_t     start_block,
+                const uint64_t     end_block,
+                File::BlockVector &segments);
+
+  int64_t allocated_only(const BlkDev      &blkdev,
+                         const std::string &devpath,
+                         const uint64_t     stepping,
+                         const uint64_t     start_block,
+                         const uint64_t     end_block,
+                         const uint64_t     threads,
+                         File::BlockVector &segments);
+}
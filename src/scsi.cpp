@@ -0,0 +1,334 @@
+/*
+  ISC License
+
+  Copyright (c) 2016, Antonio SJ Musumeci <trapexit@spawn.link>
+
+  Permission to use, copy, modify, and/or distribute this software for any
+  purpose with or without fee is hereby granted, provided that the above
+  copyright notice and this permission notice appear in all copies.
+
+  THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+  WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+  MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+  ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+  WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+  ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+  OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+*/
+
+#include "scsi.hpp"
+#include "sensedata.hpp"
+#include "sg.hpp"
+
+#include <errno.h>
+#include <stdint.h>
+#include <string.h>
+#include <sys/ioctl.h>
+
+#include <algorithm>
+
+/* WRITE LONG(16) byte 1 */
+#define SCSI_WR_UNCOR (1 << 6)
+/* READ(16) / WRITE(16) byte 1 */
+#define SCSI_FUA      (1 << 3)
+
+namespace l
+{
+  static
+  void
+  put_be(uint8_t        *p_,
+         const uint64_t  v_,
+         const int       len_)
+  {
+    for(int i = 0; i < len_; i++)
+      p_[i] = (v_ >> (8 * (len_ - 1 - i)));
+  }
+
+  static
+  void
+  prepare(sg_io_hdr_t    &io_hdr_,
+          uint8_t         cdb_[SCSI_CDB_LEN],
+          uint8_t         sb_[32],
+          const int       cdb_len_,
+          const int       rw_,
+          void           *buf_,
+          const size_t    buflen_,
+          const uint64_t  lba_,
+          const int       timeout_)
+  {
+    ::memset(&io_hdr_,0,sizeof(io_hdr_));
+    ::memset(sb_,0,32);
+
+    io_hdr_.interface_id    = 'S';
+    io_hdr_.dxfer_direction = ((buf_ == NULL) ? SG_DXFER_NONE :
+                               (rw_ == SG_WRITE) ? SG_DXFER_TO_DEV :
+                               SG_DXFER_FROM_DEV);
+    io_hdr_.dxferp          = buf_;
+    io_hdr_.dxfer_len       = ((buf_ == NULL) ? 0 : buflen_);
+    io_hdr_.cmdp            = cdb_;
+    io_hdr_.cmd_len         = cdb_len_;
+    io_hdr_.sbp             = sb_;
+    io_hdr_.mx_sb_len       = 32;
+    io_hdr_.pack_id         = lba_;
+    io_hdr_.timeout         = (timeout_ ? timeout_ : 1000);
+  }
+
+  /* READ(16), WRITE(16) and VERIFY(16) share the layout */
+  static
+  void
+  cdb16(uint8_t        cdb_[SCSI_CDB_LEN],
+        const uint8_t  opcode_,
+        const uint8_t  byte1_,
+        const uint64_t lba_,
+        const uint64_t blocks_)
+  {
+    ::memset(cdb_,0,SCSI_CDB_LEN);
+    cdb_[0] = opcode_;
+    cdb_[1] = byte1_;
+    l::put_be(&cdb_[2],lba_,8);
+    l::put_be(&cdb_[10],blocks_,4);
+  }
+
+  static
+  int
+  exec(const int    fd_,
+       sg_io_hdr_t &io_hdr_)
+  {
+    int rv;
+
+    rv = ::ioctl(fd_,SG_IO,&io_hdr_);
+    if(rv == -1)
+      return -errno;
+
+    return scsi::io_hdr_to_errno(io_hdr_);
+  }
+
+  /* the INFORMATION field of a medium error is the failing block */
+  static
+  void
+  failed_lba(const sg_io_hdr_t &io_hdr_,
+             const uint64_t     lba_,
+             const uint64_t     blocks_,
+             uint64_t          *failed_lba_)
+  {
+    SenseData::Decoded sense;
+
+    *failed_lba_ = UINT64_MAX;
+
+    if(SenseData::decode(io_hdr_.sbp,io_hdr_.sb_len_wr,sense) < 0)
+      return;
+    if(!sense.info_valid)
+      return;
+
+    if((sense.info >= lba_) && (sense.info < (lba_ + blocks_)))
+      *failed_lba_ = sense.info;
+  }
+}
+
+namespace scsi
+{
+  /*
+    As sg::io_hdr_to_errno but the sense data is decoded first: SCSI
+    devices commonly answer in fixed format, which keeps the key and
+    ASC / ASCQ at different offsets than descriptor format.
+  */
+  int
+  io_hdr_to_errno(const sg_io_hdr_t &io_hdr_)
+  {
+    SenseData::Decoded sense;
+
+    if(io_hdr_.status && (io_hdr_.status != StatusCode::CHECK_CONDITION))
+      return -EBADE;
+    if(io_hdr_.host_status)
+      return -HostCode::to_errno(io_hdr_.host_status);
+    if(io_hdr_.driver_status &&
+       ((DriverCode::to_errno(io_hdr_.driver_status) != DriverCode::SENSE)))
+      return -DriverCode::to_errno(io_hdr_.driver_status);
+    if(SenseData::decode(io_hdr_.sbp,io_hdr_.sb_len_wr,sense) < 0)
+      return ((io_hdr_.status == StatusCode::CHECK_CONDITION) ? -EIO : 0);
+    if((sense.key != SenseData::SenseKey::NO_SENSE) &&
+       (sense.key != SenseData::SenseKey::RECOVERED_ERROR))
+      return -SenseData::asc_ascq_to_errno(sense.asc,sense.ascq);
+
+    return 0;
+  }
+
+  /* standard INQUIRY: the peripheral device type is byte 0 bits 4:0 */
+  int
+  inquiry(const int  fd_,
+          uint8_t   &device_type_,
+          const int  timeout_)
+  {
+    int rv;
+    uint8_t buf[36];
+    uint8_t sb[32];
+    uint8_t cdb[SCSI_CDB_LEN];
+    sg_io_hdr_t io_hdr;
+
+    ::memset(cdb,0,sizeof(cdb));
+    ::memset(buf,0,sizeof(buf));
+    cdb[0] = SCSI_OP_INQUIRY;
+    cdb[4] = sizeof(buf);
+
+    l::prepare(io_hdr,cdb,sb,6,SG_READ,buf,sizeof(buf),0,timeout_);
+    rv = l::exec(fd_,io_hdr);
+    if(rv < 0)
+      return rv;
+
+    device_type_ = (buf[0] & 0x1F);
+
+    return 0;
+  }
+
+  void
+  prepare_rw(sg_io_hdr_t    &io_hdr_,
+             uint8_t         cdb_[SCSI_CDB_LEN],
+             uint8_t         sb_[32],
+             const int       rw_,
+             const uint64_t  lba_,
+             const uint64_t  blocks_,
+             void           *buf_,
+             const size_t    buflen_,
+             const int       timeout_)
+  {
+    l::cdb16(cdb_,
+             ((rw_ == SG_WRITE) ? SCSI_OP_WRITE_16 : SCSI_OP_READ_16),
+             0,
+             lba_,
+             blocks_);
+    l::prepare(io_hdr_,cdb_,sb_,16,rw_,buf_,buflen_,lba_,timeout_);
+  }
+
+  /* BYTCHK 0: the device checks the media, nothing is transferred */
+  void
+  prepare_verify(sg_io_hdr_t    &io_hdr_,
+                 uint8_t         cdb_[SCSI_CDB_LEN],
+                 uint8_t         sb_[32],
+                 const uint64_t  lba_,
+                 const uint64_t  blocks_,
+                 const int       timeout_)
+  {
+    l::cdb16(cdb_,SCSI_OP_VERIFY_16,0,lba_,blocks_);
+    l::prepare(io_hdr_,cdb_,sb_,16,SG_READ,NULL,0,lba_,timeout_);
+  }
+
+  /*
+    The 32 bit TRANSFER LENGTH of the 16 byte commands means requests
+    aren't split at 65536 blocks as ATA ones are.
+  */
+  int
+  read(const int       fd_,
+       const uint64_t  lba_,
+       const uint64_t  blocks_,
+       void           *buf_,
+       const size_t    buflen_,
+       const int       timeout_,
+       uint64_t       *failed_lba_)
+  {
+    int rv;
+    uint8_t sb[32];
+    uint8_t cdb[SCSI_CDB_LEN];
+    sg_io_hdr_t io_hdr;
+
+    scsi::prepare_rw(io_hdr,cdb,sb,SG_READ,lba_,blocks_,buf_,buflen_,timeout_);
+    rv = l::exec(fd_,io_hdr);
+    if((rv < 0) && failed_lba_)
+      l::failed_lba(io_hdr,lba_,blocks_,failed_lba_);
+
+    return rv;
+  }
+
+  int
+  verify(const int       fd_,
+         const uint64_t  lba_,
+         const uint64_t  blocks_,
+         const int       timeout_,
+         uint64_t       *failed_lba_)
+  {
+    int rv;
+    uint8_t sb[32];
+    uint8_t cdb[SCSI_CDB_LEN];
+    sg_io_hdr_t io_hdr;
+
+    scsi::prepare_verify(io_hdr,cdb,sb,lba_,blocks_,timeout_);
+    rv = l::exec(fd_,io_hdr);
+    if((rv < 0) && failed_lba_)
+      l::failed_lba(io_hdr,lba_,blocks_,failed_lba_);
+
+    return rv;
+  }
+
+  int
+  write(const int       fd_,
+        const uint64_t  lba_,
+        const uint64_t  blocks_,
+        const void     *buf_,
+        const size_t    buflen_,
+        const int       timeout_,
+        const bool      fua_)
+  {
+    uint8_t sb[32];
+    uint8_t cdb[SCSI_CDB_LEN];
+    sg_io_hdr_t io_hdr;
+
+    scsi::prepare_rw(io_hdr,cdb,sb,SG_WRITE,lba_,blocks_,(void*)buf_,buflen_,timeout_);
+    if(fua_)
+      cdb[1] |= SCSI_FUA;
+
+    return l::exec(fd_,io_hdr);
+  }
+
+  /* a range of 0 / 0 is the whole device */
+  int
+  synchronize_cache(const int fd_,
+                    const int timeout_)
+  {
+    int rv;
+    uint8_t sb[32];
+    uint8_t cdb[SCSI_CDB_LEN];
+    sg_io_hdr_t io_hdr;
+
+    l::cdb16(cdb,SCSI_OP_SYNCHRONIZE_CACHE_16,0,0,0);
+    l::prepare(io_hdr,cdb,sb,16,SG_READ,NULL,0,0,timeout_);
+    rv = l::exec(fd_,io_hdr);
+    if(rv == 0)
+      return 0;
+
+    ::memset(cdb,0,sizeof(cdb));
+    cdb[0] = SCSI_OP_SYNCHRONIZE_CACHE_10;
+    l::prepare(io_hdr,cdb,sb,10,SG_READ,NULL,0,0,timeout_);
+
+    return l::exec(fd_,io_hdr);
+  }
+
+  /*
+    WRITE LONG(16) with WR_UNCOR marks one logical block so reads of
+    it fail until it is written again. No data is transferred.
+  */
+  int
+  write_uncorrectable(const int      fd_,
+                      const uint64_t lba_,
+                      const uint64_t blocks_,
+                      const int      timeout_)
+  {
+    int rv;
+    uint8_t sb[32];
+    uint8_t cdb[SCSI_CDB_LEN];
+    sg_io_hdr_t io_hdr;
+
+    for(uint64_t lba = lba_, ei = (lba_ + blocks_); lba < ei; lba++)
+      {
+        ::memset(cdb,0,sizeof(cdb));
+        cdb[0] = SCSI_OP_SERVICE_ACTION_OUT_16;
+        cdb[1] = (SCSI_WR_UNCOR | SCSI_SA_WRITE_LONG_16);
+        l::put_be(&cdb[2],lba,8);
+
+        l::prepare(io_hdr,cdb,sb,16,SG_WRITE,NULL,0,lba,timeout_);
+        rv = l::exec(fd_,io_hdr);
+        if(rv < 0)
+          return rv;
+      }
+
+    return 0;
+  }
+}
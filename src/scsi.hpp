@@ -0,0 +1,109 @@
+/*
+  ISC License
+
+  Copyright (c) 2016, Antonio SJ Musumeci <trapexit@spawn.link>
+
+  Permission to use, copy, modify, and/or distribute this software for any
+  purpose with or without fee is hereby granted, provided that the above
+  copyright notice and this permission notice appear in all copies.
+
+  THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+  WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+  MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+  ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+  WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+  ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+  OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+*/
+
+#pragma once
+
+#include <scsi/sg.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#define SCSI_CDB_LEN 16
+
+/*
+  Native SCSI block commands for SAS and other SCSI disks which don't
+  accept ATA PASS-THROUGH. They go through the same SG_IO / sg_io_hdr
+  path as sg's ATA commands and errors are the same negative errno or
+  encoded ASC/ASCQ from SenseData.
+*/
+namespace scsi
+{
+  enum
+    {
+      SCSI_OP_INQUIRY               = 0x12,
+      SCSI_OP_SYNCHRONIZE_CACHE_10  = 0x35,
+      SCSI_OP_READ_16               = 0x88,
+      SCSI_OP_WRITE_16              = 0x8A,
+      SCSI_OP_VERIFY_16             = 0x8F,
+      SCSI_OP_SYNCHRONIZE_CACHE_16  = 0x91,
+      SCSI_OP_SERVICE_ACTION_OUT_16 = 0x9F
+    };
+
+  enum
+    {
+      SCSI_SA_WRITE_LONG_16 = 0x11
+    };
+
+  int
+  io_hdr_to_errno(const struct sg_io_hdr &io_hdr);
+
+  int
+  inquiry(const int  fd,
+          uint8_t   &device_type,
+          const int  timeout);
+
+  int
+  read(const int       fd,
+       const uint64_t  lba,
+       const uint64_t  blocks,
+       void           *buf,
+       const size_t    buflen,
+       const int       timeout,
+       uint64_t       *failed_lba = NULL);
+  int
+  verify(const int       fd,
+         const uint64_t  lba,
+         const uint64_t  blocks,
+         const int       timeout,
+         uint64_t       *failed_lba = NULL);
+  int
+  write(const int       fd,
+        const uint64_t  lba,
+        const uint64_t  blocks,
+        const void     *buf,
+        const size_t    buflen,
+        const int       timeout,
+        const bool      fua = false);
+
+  int
+  synchronize_cache(const int fd,
+                    const int timeout);
+
+  int
+  write_uncorrectable(const int      fd,
+                      const uint64_t lba,
+                      const uint64_t blocks,
+                      const int      timeout);
+
+  void
+  prepare_rw(struct sg_io_hdr &io_hdr,
+             uint8_t           cdb[SCSI_CDB_LEN],
+             uint8_t           sb[32],
+             const int         rw,
+             const uint64_t    lba,
+             const uint64_t    blocks,
+             void             *buf,
+             const size_t      buflen,
+             const int         timeout);
+  void
+  prepare_verify(struct sg_io_hdr &io_hdr,
+                 uint8_t           cdb[SCSI_CDB_LEN],
+                 uint8_t           sb[32],
+                 const uint64_t    lba,
+                 const uint64_t    blocks,
+                 const int         timeout);
+}
@@ -46,6 +46,51 @@ namespace SenseData
       };
   }
 
+  namespace ResponseCode
+  {
+    enum ResponseCode
+      {
+        FIXED_CURRENT       = 0x70,
+        FIXED_DEFERRED      = 0x71,
+        DESCRIPTOR_CURRENT  = 0x72,
+        DESCRIPTOR_DEFERRED = 0x73,
+        VENDOR_SPECIFIC     = 0x7F
+      };
+  }
+
+  struct Decoded
+  {
+    Decoded()
+      : response_code(0),
+        key(0),
+        asc(0),
+        ascq(0),
+        info_valid(0),
+        ata_valid(0),
+        ata_error(0),
+        ata_status(0),
+        ata_count(0),
+        info(0),
+        ata_lba(0)
+    {}
+
+    uint8_t  response_code;
+    uint8_t  key;
+    uint8_t  asc;
+    uint8_t  ascq;
+    uint8_t  info_valid;
+    uint8_t  ata_valid;
+    uint8_t  ata_error;
+    uint8_t  ata_status;
+    uint16_t ata_count;
+    uint64_t info;
+    uint64_t ata_lba;
+  };
+
+  int decode(const uint8_t * const  sb,
+             const unsigned int     len,
+             Decoded               &decoded);
+
   uint8_t response_code(const uint8_t * const sb);
   uint8_t sense_key(const uint8_t * const sb);
   uint8_t additional_sense_code(const uint8_t * const sb);
@@ -19,7 +19,10 @@
 #include "sensedata.hpp"
 #include "sg.hpp"
 
+#include <dirent.h>
+#include <endian.h>
 #include <errno.h>
+#include <limits.h>
 #include <linux/hdreg.h>
 #include <stddef.h>
 #include <scsi/sg.h>
@@ -27,8 +30,12 @@
 #include <stdio.h>
 #include <string.h>
 #include <sys/ioctl.h>
+#include <sys/stat.h>
+#include <sys/sysmacros.h>
 #include <unistd.h>
 
+#include <algorithm>
+
 static
 inline
 uint64_t
@@ -140,13 +147,17 @@ namespace sg
       case ATA_OP_DSM:
       case ATA_OP_READ_PIO_EXT:
       case ATA_OP_READ_DMA_EXT:
+      case ATA_OP_READ_FPDMA:
       case ATA_OP_WRITE_PIO_EXT:
       case ATA_OP_WRITE_DMA_EXT:
+      case ATA_OP_WRITE_FPDMA:
       case ATA_OP_READ_VERIFY_EXT:
       case ATA_OP_WRITE_UNC_EXT:
       case ATA_OP_READ_NATIVE_MAX_EXT:
       case ATA_OP_SET_MAX_EXT:
       case ATA_OP_FLUSHCACHE_EXT:
+      case ATA_OP_SANITIZE:
+      case ATA_OP_READ_LOG_EXT:
         return true;
       case ATA_OP_SECURITY_ERASE_PREPARE:
       case ATA_OP_SECURITY_ERASE_UNIT:
@@ -241,6 +252,8 @@ namespace sg
                  const int   rw,
                  const void *data)
   {
+    if((dma == SG_FPDMA) && data)
+      return SG_ATA_PROTO_FPDMA;
     if(dma && data)
       return SG_ATA_PROTO_DMA;
     if(dma && !data)
@@ -256,9 +269,15 @@ namespace sg
 
   static
   char
-  calculate_cdb2(const int   rw,
+  calculate_cdb2(const int   dma,
+                 const int   rw,
                  const void *data)
   {
+    /* NCQ commands carry the sector count in the FEATURE field */
+    if((dma == SG_FPDMA) && data && rw)
+      return (SG_CDB2_TLEN_FEAT | SG_CDB2_TLEN_SECTORS | SG_CDB2_TDIR_TO_DEV);
+    if((dma == SG_FPDMA) && data && !rw)
+      return (SG_CDB2_TLEN_FEAT | SG_CDB2_TLEN_SECTORS | SG_CDB2_TDIR_FROM_DEV);
     if(data && rw)
       return (SG_CDB2_TLEN_NSECT | SG_CDB2_TLEN_SECTORS | SG_CDB2_TDIR_TO_DEV);
     if(data && !rw)
@@ -354,17 +373,50 @@ namespace sg
     io_hdr->timeout         = (timeout ? timeout : 1000);
   }
 
+  /*
+    The drive's ERROR and STATUS registers come back in the ATA Status
+    Return descriptor or, in fixed format, the INFORMATION field. ABRT
+    without UNC or IDNF is the drive refusing the command. libata
+    reports it as ABORTED COMMAND with ASC / ASCQ 0/0 which would
+    otherwise map to success.
+  */
   static
-  int
-  exec_core(const int    fd,
-            sg_io_hdr_t &io_hdr)
+  bool
+  ata_abrt(const sg_io_hdr_t &io_hdr_)
   {
-    int rv;
+    uint8_t error;
+    uint8_t status;
+    SenseData::Decoded sense;
 
-    rv = ::ioctl(fd,SG_IO,&io_hdr);
-    if(rv == -1)
-      return -errno;
+    if(SenseData::decode(io_hdr_.sbp,io_hdr_.sb_len_wr,sense) < 0)
+      return false;
 
+    if(sense.ata_valid)
+      {
+        error  = sense.ata_error;
+        status = sense.ata_status;
+      }
+    else if((sense.key == SenseData::SenseKey::ABORTED_COMMAND) &&
+            ((sense.response_code == SenseData::ResponseCode::FIXED_CURRENT) ||
+             (sense.response_code == SenseData::ResponseCode::FIXED_DEFERRED)))
+      {
+        error  = io_hdr_.sbp[3];
+        status = io_hdr_.sbp[4];
+      }
+    else
+      {
+        return false;
+      }
+
+    if(!(status & ATA_STAT_ERR))
+      return false;
+
+    return ((error & (ATA_ERROR_ABRT|ATA_ERROR_UNC|ATA_ERROR_IDNF)) == ATA_ERROR_ABRT);
+  }
+
+  int
+  io_hdr_to_errno(const sg_io_hdr_t &io_hdr)
+  {
     if(io_hdr.status && (io_hdr.status != StatusCode::CHECK_CONDITION))
       return -EBADE;
     if(io_hdr.host_status)
@@ -374,11 +426,62 @@ namespace sg
       return -DriverCode::to_errno(io_hdr.driver_status);
     if((SenseData::sense_key(io_hdr.sbp) != SenseData::SenseKey::NO_SENSE) &&
        (SenseData::sense_key(io_hdr.sbp) != SenseData::SenseKey::RECOVERED_ERROR))
-      return -SenseData::asc_ascq_to_errno(io_hdr.sbp);
+      {
+        if(ata_abrt(io_hdr))
+          return -ECANCELED;
+        return -SenseData::asc_ascq_to_errno(io_hdr.sbp);
+      }
 
     return 0;
   }
 
+  bool
+  command_refused(const int err_)
+  {
+    return ((err_ == -ECANCELED) ||
+            (err_ == -SenseData::asc_ascq_to_errno(0x20,0x00)) ||
+            (err_ == -SenseData::asc_ascq_to_errno(0x24,0x00)));
+  }
+
+  static
+  int
+  exec_core(const int    fd,
+            sg_io_hdr_t &io_hdr)
+  {
+    int rv;
+
+    rv = ::ioctl(fd,SG_IO,&io_hdr);
+    if(rv == -1)
+      return -errno;
+
+    return sg::io_hdr_to_errno(io_hdr);
+  }
+
+  static
+  void
+  prepare(sg_io_hdr_t         &io_hdr,
+          uint8_t              cdb[SG_ATA_16_LEN],
+          uint8_t              sb[32],
+          const int            rw,
+          const int            dma,
+          const struct ata_tf *tf,
+          void                *data,
+          const unsigned int   data_bytes,
+          const unsigned int   timeout)
+  {
+    ::memset(&io_hdr,0,sizeof(io_hdr));
+    ::memset(cdb,0,SG_ATA_16_LEN);
+    ::memset(sb,0,32);
+
+    if(data && data_bytes && !rw)
+      memset(data,0,data_bytes);
+
+    cdb[1]         = calculate_cdb1(dma,rw,data);
+    cdb[2]         = calculate_cdb2(dma,rw,data);
+    io_hdr.cmd_len = populate_cdb_from_tf(cdb,tf);
+    populate_io_hdr(&io_hdr,cdb,sb,tf,data,data_bytes,rw,timeout);
+  }
+
   int
   exec(const int            fd,
        const int            rw,
@@ -388,18 +491,11 @@ namespace sg
        const unsigned int   data_bytes,
        const unsigned int   timeout)
   {
-    int rv;
-    uint8_t cdb[SG_ATA_16_LEN] = {0};
-    uint8_t sb[32]             = {0};
-    sg_io_hdr_t io_hdr         = {0};
+    uint8_t cdb[SG_ATA_16_LEN];
+    uint8_t sb[32];
+    sg_io_hdr_t io_hdr;
 
-    if(data && data_bytes && !rw)
-      memset(data,0,data_bytes);
-
-    cdb[1]         = calculate_cdb1(dma,rw,data);
-    cdb[2]         = calculate_cdb2(rw,data);
-    io_hdr.cmd_len = populate_cdb_from_tf(cdb,tf);
-    populate_io_hdr(&io_hdr,cdb,sb,tf,data,data_bytes,rw,timeout);
+    prepare(io_hdr,cdb,sb,rw,dma,tf,data,data_bytes,timeout);
 
     return sg::exec_core(fd,io_hdr);
   }
@@ -417,9 +513,17 @@ namespace sg
 
     ident.rpm = buf16[217];
     ident.trim_supported = !!(buf16[169] & 0x0001);
+    ident.sct_erc        = ((buf16[206] & 0x0009) == 0x0009);
+    ident.trim_deterministic = (ident.trim_supported && !!(buf16[69] & 0x4000));
+    ident.trim_zeroes        = (ident.trim_deterministic && !!(buf16[69] & 0x0020));
+    ident.dma_supported  = !!(buf16[49] & 0x0100);
+    ident.ncq_supported  = ((buf16[76] != 0x0000) &&
+                            (buf16[76] != 0xFFFF) &&
+                            !!(buf16[76] & 0x0100));
     ident.form_factor    = (buf16[168] & 0x0003);
     ident.smart_supported    = (((buf16[83] & 0xC000) == 0x4000) && (buf16[82] & 0x0001));
     ident.smart_enabled      = (((buf16[87] & 0xC000) == 0x4000) && (buf16[85] & 0x0001));
+    ident.gpl_supported      = (((buf16[84] & 0xC000) == 0x4000) && (buf16[84] & 0x0020));
     ident.security_supported = (((buf16[83] & 0xC000) == 0x4000) && (buf16[82] & 0x0002));
     ident.security_enabled   = (((buf16[87] & 0xC000) == 0x4000) && (buf16[85] & 0x0002));
     ident.security_locked                   = !!(buf16[128] & 0x0004);
@@ -456,45 +560,280 @@ namespace sg
     sscanf((char*)&tmpbuf[27],"%40c",ident.model_number);
   }
 
+  int
+  identify(const int  fd,
+           char       buf[256*2],
+           const int  timeout)
+  {
+    struct ata_tf tf;
+
+    tf_init(&tf,ATA_OP_IDENTIFY,0,1);
+
+    return exec(fd,SG_READ,SG_PIO,&tf,buf,512,timeout);
+  }
+
   int
   identify(const int     fd,
            sg::identity &ident)
   {
     int rv;
-    int timeout;
     char buf[512];
-    int buflen = sizeof(buf);
-    struct ata_tf tf;
-
-    tf_init(&tf,ATA_OP_IDENTIFY,0,1);
 
-    timeout = 60000;
-    rv = exec(fd,SG_READ,SG_PIO,&tf,buf,buflen,timeout);
+    rv = identify(fd,buf,60000);
     if(rv == 0)
       buf_to_identity(buf,ident);
 
     return rv;
   }
 
+  int
+  xfer_mode(const sg::identity &ident_)
+  {
+    if(ident_.ncq_supported)
+      return SG_FPDMA;
+    if(ident_.dma_supported)
+      return SG_DMA;
+
+    return SG_PIO;
+  }
+
+  const
+  char*
+  xfer_mode_to_string(const int xfer_)
+  {
+    switch(xfer_)
+      {
+      case SG_FPDMA:
+        return "ncq";
+      case SG_DMA:
+        return "dma";
+      case SG_PIO:
+        return "pio";
+      }
+
+    return "unknown";
+  }
+
+  static
+  void
+  tf_init_rw(struct ata_tf  *tf_,
+             const int       rw_,
+             const int       xfer_,
+             const uint64_t  lba_,
+             const uint64_t  blocks_,
+             const bool      fua_ = false)
+  {
+    int blocks;
+    int instruction;
+
+    blocks = blocks_;
+    if(blocks >= 65536)
+      blocks = 0;
+
+    switch(xfer_)
+      {
+      case SG_FPDMA:
+        instruction = (rw_ ? ATA_OP_WRITE_FPDMA : ATA_OP_READ_FPDMA);
+        break;
+      case SG_DMA:
+        instruction = (rw_ ?
+                       (fua_ ? ATA_OP_WRITE_DMA_FUA_EXT : ATA_OP_WRITE_DMA_EXT) :
+                       ATA_OP_READ_DMA_EXT);
+        break;
+      default:
+        instruction = (rw_ ? ATA_OP_WRITE_PIO_EXT : ATA_OP_READ_PIO_EXT);
+        break;
+      }
+
+    tf_init(tf_,instruction,lba_,blocks);
+
+    /*
+      READ/WRITE FPDMA QUEUED: sector count moves to FEATURE and
+      COUNT holds the NCQ tag. The kernel assigns the real tag.
+    */
+    if(xfer_ == SG_FPDMA)
+      {
+        tf_->lob.feat  = (blocks & 0xFF);
+        tf_->hob.feat  = (blocks >> 8);
+        tf_->lob.nsect = 0;
+        tf_->hob.nsect = 0;
+        tf_->dev       = ATA_USING_LBA;
+        if(rw_ && fua_)
+          tf_->dev |= ATA_FPDMA_FUA;
+      }
+  }
+
+  /*
+    On a read error the drive reports the first sector it couldn't
+    read in the LBA registers (returned by the SATL in the ATA Status
+    Return descriptor) or the SATL does in the INFORMATION field.
+    Anything outside the request is ignored.
+  */
+  static
+  void
+  failed_lba(const sg_io_hdr_t &io_hdr_,
+             const uint64_t     lba_,
+             const uint64_t     blocks_,
+             uint64_t          *failed_lba_)
+  {
+    uint64_t lba;
+    SenseData::Decoded sense;
+
+    *failed_lba_ = UINT64_MAX;
+
+    if(SenseData::decode(io_hdr_.sbp,io_hdr_.sb_len_wr,sense) < 0)
+      return;
+
+    if(sense.ata_valid && (sense.ata_error & ATA_ERROR_UNC))
+      lba = sense.ata_lba;
+    else if(sense.info_valid)
+      lba = sense.info;
+    else
+      return;
+
+    if((lba >= lba_) && (lba < (lba_ + blocks_)))
+      *failed_lba_ = lba;
+  }
+
   int
   read_block(const int       fd_,
+             const uint64_t  lba_,
+             const uint64_t  blocks_,
+             void           *buf_,
+             const size_t    buflen_,
+             const int       timeout_,
+             const int       xfer_,
+             uint64_t       *failed_lba_)
+  {
+    int rv;
+    uint8_t cdb[SG_ATA_16_LEN];
+    uint8_t sb[32];
+    sg_io_hdr_t io_hdr;
+    struct ata_tf tf;
+
+    tf_init_rw(&tf,SG_READ,xfer_,lba_,blocks_);
+
+    prepare(io_hdr,cdb,sb,SG_READ,xfer_,&tf,buf_,buflen_,timeout_);
+    rv = sg::exec_core(fd_,io_hdr);
+    if((rv < 0) && failed_lba_)
+      failed_lba(io_hdr,lba_,blocks_,failed_lba_);
+
+    return rv;
+  }
+
+  /*
+    READ VERIFY SECTORS EXT has the drive read and check the sectors
+    internally without returning any data. A failure is reported the
+    same way as a failed read.
+  */
+  int
+  verify_block(const int       fd_,
+               const uint64_t  lba_,
+               const uint64_t  blocks_,
+               const int       timeout_,
+               uint64_t       *failed_lba_)
+  {
+    int rv;
+    int blocks;
+    uint8_t cdb[SG_ATA_16_LEN];
+    uint8_t sb[32];
+    sg_io_hdr_t io_hdr;
+    struct ata_tf tf;
+
+    blocks = blocks_;
+    if(blocks >= 65536)
+      blocks = 0;
+    tf_init(&tf,ATA_OP_READ_VERIFY_EXT,lba_,blocks);
+
+    prepare(io_hdr,cdb,sb,SG_READ,SG_PIO,&tf,NULL,0,timeout_);
+    rv = sg::exec_core(fd_,io_hdr);
+    if((rv < 0) && failed_lba_)
+      failed_lba(io_hdr,lba_,blocks_,failed_lba_);
+
+    return rv;
+  }
+
+  void
+  prepare_rw(sg_io_hdr_t    &io_hdr_,
+             uint8_t         cdb_[SG_ATA_16_LEN],
+             uint8_t         sb_[32],
+             const int       rw_,
+             const int       xfer_,
              const uint64_t  lba_,
              const uint64_t  blocks_,
              void           *buf_,
              const size_t    buflen_,
              const int       timeout_)
+  {
+    struct ata_tf tf;
+
+    tf_init_rw(&tf,rw_,xfer_,lba_,blocks_);
+
+    prepare(io_hdr_,cdb_,sb_,rw_,xfer_,&tf,buf_,buflen_,timeout_);
+  }
+
+  void
+  prepare_verify(sg_io_hdr_t    &io_hdr_,
+                 uint8_t         cdb_[SG_ATA_16_LEN],
+                 uint8_t         sb_[32],
+                 const uint64_t  lba_,
+                 const uint64_t  blocks_,
+                 const int       timeout_)
   {
     int blocks;
-    int instruction;
     struct ata_tf tf;
 
     blocks = blocks_;
     if(blocks >= 65536)
       blocks = 0;
-    instruction = ATA_OP_READ_PIO_EXT;
-    tf_init(&tf,instruction,lba_,blocks);
+    tf_init(&tf,ATA_OP_READ_VERIFY_EXT,lba_,blocks);
 
-    return exec(fd_,SG_READ,SG_PIO,&tf,buf_,buflen_,timeout_);
+    prepare(io_hdr_,cdb_,sb_,SG_READ,SG_PIO,&tf,NULL,0,timeout_);
+  }
+
+  /*
+    The sg character device (/dev/sgN) behind a block device. Unlike
+    the block device it accepts sg_io_hdr via write() / read() which
+    allows several commands to be outstanding at once.
+  */
+  std::string
+  generic_path(const int fd_)
+  {
+    int rv;
+    DIR *dir;
+    struct stat st;
+    struct dirent *d;
+    std::string path;
+    char sysfs[PATH_MAX];
+    const char *fmt[] = {"/sys/dev/block/%u:%u/device/scsi_generic",
+                         "/sys/dev/block/%u:%u/../device/scsi_generic"};
+
+    rv = ::fstat(fd_,&st);
+    if((rv == -1) || !S_ISBLK(st.st_mode))
+      return std::string();
+
+    dir = NULL;
+    for(size_t i = 0; (i < (sizeof(fmt) / sizeof(fmt[0]))) && (dir == NULL); i++)
+      {
+        ::snprintf(sysfs,sizeof(sysfs),fmt[i],major(st.st_rdev),minor(st.st_rdev));
+        dir = ::opendir(sysfs);
+      }
+
+    if(dir == NULL)
+      return std::string();
+
+    while((d = ::readdir(dir)) != NULL)
+      {
+        if(d->d_name[0] == '.')
+          continue;
+
+        path = std::string("/dev/") + d->d_name;
+        break;
+      }
+
+    ::closedir(dir);
+
+    return path;
   }
 
   int
@@ -503,19 +842,16 @@ namespace sg
               const uint64_t  blocks_,
               const void     *buf_,
               const size_t    buflen_,
-              const int       timeout_)
+              const int       timeout_,
+              const int       xfer_,
+              const bool      fua_)
   {
-    int blocks;
-    int instruction;
     struct ata_tf tf;
 
-    blocks = blocks_;
-    if(blocks >= 65536)
-      blocks = 0;
-    instruction = ATA_OP_WRITE_PIO_EXT;
-    tf_init(&tf,instruction,lba_,blocks);
+    /* PIO has no FUA write so callers have to flush themselves */
+    tf_init_rw(&tf,SG_WRITE,xfer_,lba_,blocks_,fua_);
 
-    return exec(fd_,SG_WRITE,SG_PIO,&tf,(void*)buf_,buflen_,timeout_);
+    return exec(fd_,SG_WRITE,xfer_,&tf,(void*)buf_,buflen_,timeout_);
   }
 
   int
@@ -541,13 +877,15 @@ namespace sg
   int
   write_uncorrectable(const int      fd_,
                       const uint64_t lba_,
+                      const uint64_t blocks_,
                       const uint8_t  type_,
                       const int      timeout_)
   {
     int rv;
     struct ata_tf tf;
 
-    tf_init(&tf,ATA_OP_WRITE_UNC_EXT,lba_,1);
+    /* a count of 0 means 65536 sectors */
+    tf_init(&tf,ATA_OP_WRITE_UNC_EXT,lba_,(blocks_ & 0xFFFF));
     tf.lob.feat = type_;
     tf.is_lba48 = 1;
 
@@ -556,9 +894,64 @@ namespace sg
       {
         char buf[520];
 
-        tf_init(&tf,ATA_OP_WRITE_LONG_ONCE,lba_,1);
+        /* WRITE LONG only covers a single sector */
         memset(buf,0xA5,sizeof(buf));
-        rv = exec(fd_,SG_WRITE,SG_PIO,&tf,buf,sizeof(buf),timeout_);
+        for(uint64_t i = 0; i < blocks_; i++)
+          {
+            tf_init(&tf,ATA_OP_WRITE_LONG_ONCE,lba_+i,1);
+            rv = exec(fd_,SG_WRITE,SG_PIO,&tf,buf,sizeof(buf),timeout_);
+            if(rv < 0)
+              break;
+          }
+      }
+
+    return rv;
+  }
+
+  /*
+    DATA SET MANAGEMENT with the TRIM bit. The payload is 512 byte
+    blocks of 64 little endian range entries, each a 48 bit LBA and a
+    16 bit count, so one command of DSM_PAYLOAD_BLOCKS covers up to
+    DSM_PAYLOAD_BLOCKS * 64 * 65535 sectors.
+  */
+  int
+  dsm_trim(const int      fd_,
+           const uint64_t lba_,
+           const uint64_t blocks_,
+           const int      timeout_)
+  {
+    int rv;
+    uint64_t lba;
+    uint64_t left;
+    struct ata_tf tf;
+    static const unsigned DSM_PAYLOAD_BLOCKS = 8;
+    static const unsigned DSM_ENTRIES        = (DSM_PAYLOAD_BLOCKS * 64);
+    uint64_t payload[DSM_ENTRIES];
+
+    rv   = 0;
+    lba  = lba_;
+    left = blocks_;
+    while(left > 0)
+      {
+        unsigned entries;
+
+        memset(payload,0,sizeof(payload));
+        for(entries = 0; (entries < DSM_ENTRIES) && (left > 0); entries++)
+          {
+            const uint64_t n = std::min(left,(uint64_t)0xFFFF);
+
+            payload[entries] = htole64((lba & 0xFFFFFFFFFFFFULL) | (n << 48));
+            lba  += n;
+            left -= n;
+          }
+
+        tf_init(&tf,ATA_OP_DSM,0,((entries + 63) / 64));
+        tf.lob.feat = 0x01;
+
+        rv = exec(fd_,SG_WRITE,SG_DMA,&tf,payload,
+                  (((entries + 63) / 64) * 512),timeout_);
+        if(rv < 0)
+          break;
       }
 
     return rv;
@@ -567,6 +960,7 @@ namespace sg
   int
   write_flagged_uncorrectable(const int      fd_,
                               const uint64_t lba_,
+                              const uint64_t blocks_,
                               const bool     log_,
                               const int      timeout_)
   {
@@ -576,12 +970,13 @@ namespace sg
              sg::ATA_WRITE_UNCORRECTABLE_EXT_FLAGGED_W_LOGGING :
              sg::ATA_WRITE_UNCORRECTABLE_EXT_FLAGGED_WO_LOGGING);
 
-    return write_uncorrectable(fd_,lba_,instr,timeout_);
+    return write_uncorrectable(fd_,lba_,blocks_,instr,timeout_);
   }
 
   int
   write_pseudo_uncorrectable(const int      fd_,
                              const uint64_t lba_,
+                             const uint64_t blocks_,
                              const bool     log_,
                              const int      timeout_)
   {
@@ -591,7 +986,185 @@ namespace sg
              sg::ATA_WRITE_UNCORRECTABLE_EXT_PSEUDO_W_LOGGING :
              sg::ATA_WRITE_UNCORRECTABLE_EXT_PSEUDO_WO_LOGGING);
 
-    return write_uncorrectable(fd_,lba_,instr,timeout_);
+    return write_uncorrectable(fd_,lba_,blocks_,instr,timeout_);
+  }
+
+  /* SMART READ DATA: the 512 byte attribute table */
+  int
+  smart_read_data(const int  fd_,
+                  uint8_t    buf_[512],
+                  const int  timeout_)
+  {
+    struct ata_tf tf;
+
+    tf_init(&tf,ATA_OP_SMART,0xC24F00,1);
+    tf.lob.feat = 0xD0;
+
+    return exec(fd_,SG_READ,SG_PIO,&tf,buf_,512,timeout_);
+  }
+
+  /*
+    READ LOG EXT of pages_ 512 byte pages of general purpose log log_
+    starting at page_, whose high byte goes in LBA(39:32).
+  */
+  int
+  read_log_ext(const int       fd_,
+               const uint8_t   log_,
+               const uint16_t  page_,
+               uint8_t        *buf_,
+               const uint16_t  pages_,
+               const int       timeout_)
+  {
+    uint64_t lba;
+    struct ata_tf tf;
+
+    lba = (log_ | ((uint64_t)(page_ & 0xFF) << 8) | ((uint64_t)(page_ >> 8) << 32));
+    tf_init(&tf,ATA_OP_READ_LOG_EXT,lba,pages_);
+
+    return exec(fd_,SG_READ,SG_PIO,&tf,buf_,(pages_ * 512),timeout_);
+  }
+
+  /*
+    SCT commands are a 512 byte key page written with SMART WRITE LOG
+    to log 0xE0. Error Recovery Control limits, in 100ms units, how
+    long the drive retries a failing read or write before reporting
+    it; 0 disables the limit. A Get returns the limit in the COUNT and
+    LBA low registers so CK_COND is set to have them returned.
+  */
+  static
+  int
+  sct_erc(const int      fd_,
+          const uint16_t function_,
+          const int      selection_,
+          const uint16_t value_,
+          uint16_t      *out_,
+          const int      timeout_)
+  {
+    int rv;
+    uint8_t cdb[SG_ATA_16_LEN];
+    uint8_t sb[32];
+    uint16_t data[256];
+    sg_io_hdr_t io_hdr;
+    struct ata_tf tf;
+    SenseData::Decoded sense;
+
+    ::memset(data,0,sizeof(data));
+    data[0] = htole16(0x0003);
+    data[1] = htole16(function_);
+    data[2] = htole16(selection_);
+    data[3] = htole16(value_);
+
+    tf_init(&tf,ATA_OP_SMART,0xC24FE0,1);
+    tf.lob.feat = 0xD6;
+
+    prepare(io_hdr,cdb,sb,SG_WRITE,SG_PIO,&tf,data,sizeof(data),timeout_);
+    cdb[2] |= SG_CDB2_CHECK_COND;
+    rv = sg::exec_core(fd_,io_hdr);
+    if(rv < 0)
+      return rv;
+    if(out_ == NULL)
+      return 0;
+
+    rv = SenseData::decode(sb,io_hdr.sb_len_wr,sense);
+    if(rv < 0)
+      return rv;
+    if(!sense.ata_valid)
+      return -ENODATA;
+
+    *out_ = ((sense.ata_count & 0xFF) | ((sense.ata_lba & 0xFF) << 8));
+
+    return 0;
+  }
+
+  int
+  sct_erc_get(const int  fd_,
+              const int  selection_,
+              uint16_t  &deciseconds_,
+              const int  timeout_)
+  {
+    return sct_erc(fd_,0x0002,selection_,0,&deciseconds_,timeout_);
+  }
+
+  int
+  sct_erc_set(const int      fd_,
+              const int      selection_,
+              const uint16_t deciseconds_,
+              const int      timeout_)
+  {
+    return sct_erc(fd_,0x0001,selection_,deciseconds_,NULL,timeout_);
+  }
+
+  /*
+    Crypto scramble and block erase take the feature's signature in
+    the LBA field, overwrite its own plus the 32bit pattern (zeros, one
+    pass). The command completes as soon as the operation has started.
+  */
+  int
+  sanitize(const int fd_,
+           const int method_,
+           const int timeout_)
+  {
+    uint64_t lba;
+    struct ata_tf tf;
+
+    switch(method_)
+      {
+      case SG_SANITIZE_CRYPTO_SCRAMBLE:
+        lba = 0x43727970ULL;
+        break;
+      case SG_SANITIZE_BLOCK_ERASE:
+        lba = 0x426B4572ULL;
+        break;
+      case SG_SANITIZE_OVERWRITE:
+        lba = (0x4F57ULL << 32);
+        break;
+      default:
+        return -EINVAL;
+      }
+
+    tf_init(&tf,ATA_OP_SANITIZE,lba,((method_ == SG_SANITIZE_OVERWRITE) ? 1 : 0));
+    tf.lob.feat = method_;
+
+    return exec(fd_,SG_READ,SG_PIO,&tf,NULL,0,timeout_);
+  }
+
+  int
+  sanitize_status_ext(const int        fd_,
+                      sanitize_status &status_,
+                      const int        timeout_)
+  {
+    int rv;
+    uint8_t cdb[SG_ATA_16_LEN];
+    uint8_t sb[32];
+    uint16_t count;
+    sg_io_hdr_t io_hdr;
+    struct ata_tf tf;
+    SenseData::Decoded sense;
+
+    tf_init(&tf,ATA_OP_SANITIZE,0,0);
+    tf.lob.feat = SG_SANITIZE_STATUS;
+
+    /* non-data commands set CK_COND so the registers come back as sense */
+    prepare(io_hdr,cdb,sb,SG_READ,SG_PIO,&tf,NULL,0,timeout_);
+    rv = sg::exec_core(fd_,io_hdr);
+    if(rv < 0)
+      return rv;
+
+    rv = SenseData::decode(sb,io_hdr.sb_len_wr,sense);
+    if(rv < 0)
+      return rv;
+    if(!sense.ata_valid)
+      return -ENODATA;
+
+    count = sense.ata_count;
+
+    status_.progress    = (sense.ata_lba & 0xFFFF);
+    status_.completed   = !!(count & 0x8000);
+    status_.in_progress = !!(count & 0x4000);
+    status_.frozen      = !!(count & 0x2000);
+    status_.antifreeze  = !!(count & 0x1000);
+
+    return 0;
   }
 
   int
@@ -22,13 +22,18 @@
 #include <stdint.h>
 #include <string.h>
 
+#include <string>
+
+struct sg_io_hdr;
+
 #define LBA28_LIMIT ((uint64_t)(1<<28)-1)
 
 #define SG_READ  0
 #define SG_WRITE 1
 
-#define SG_PIO 0
-#define SG_DMA 1
+#define SG_PIO   0
+#define SG_DMA   1
+#define SG_FPDMA 2
 
 #define SG_ATA_12		0xa1
 #define SG_ATA_12_LEN		12
@@ -39,6 +44,7 @@
 #define SG_ATA_PROTO_PIO_IN	(4 << 1)
 #define SG_ATA_PROTO_PIO_OUT	(5 << 1)
 #define SG_ATA_PROTO_DMA	(6 << 1)
+#define SG_ATA_PROTO_FPDMA	(12 << 1)
 
 #define SG_CHECK_CONDITION 0x02
 
@@ -99,9 +105,13 @@ namespace sg
 {
   enum
     {
-      ATA_USING_LBA = (1 << 6),
-      ATA_STAT_DRQ  = (1 << 3),
-      ATA_STAT_ERR  = (1 << 0)
+      ATA_FPDMA_FUA  = (1 << 7),
+      ATA_USING_LBA  = (1 << 6),
+      ATA_STAT_DRQ   = (1 << 3),
+      ATA_STAT_ERR   = (1 << 0),
+      ATA_ERROR_UNC  = (1 << 6),
+      ATA_ERROR_IDNF = (1 << 4),
+      ATA_ERROR_ABRT = (1 << 2)
     };
 
   /*
@@ -163,6 +173,7 @@ namespace sg
       ATA_OP_WRITE_LONG_ONCE        = 0x33,
       ATA_OP_WRITE_PIO_EXT          = 0x34,
       ATA_OP_WRITE_DMA_EXT          = 0x35,
+      ATA_OP_WRITE_DMA_FUA_EXT      = 0x3d,
       ATA_OP_WRITE_FPDMA            = 0x61,
       ATA_OP_READ_VERIFY            = 0x40,
       ATA_OP_READ_VERIFY_ONCE       = 0x41,
@@ -177,6 +188,7 @@ namespace sg
       ATA_OP_READ_NATIVE_MAX        = 0xf8,
       ATA_OP_READ_NATIVE_MAX_EXT    = 0x27,
       ATA_OP_SMART                  = 0xb0,
+      ATA_OP_SANITIZE               = 0xb4,
       ATA_OP_DCO                    = 0xb1,
       ATA_OP_ERASE_SECTORS          = 0xc0,
       ATA_OP_READ_DMA               = 0xc8,
@@ -228,6 +240,22 @@ namespace sg
       SG_ERASE_ENHANCED = 1
     };
 
+  /* SCT Error Recovery Control selection code */
+  enum
+    {
+      SG_SCT_ERC_READ  = 0x0001,
+      SG_SCT_ERC_WRITE = 0x0002
+    };
+
+  /* SANITIZE DEVICE feature field */
+  enum
+    {
+      SG_SANITIZE_STATUS          = 0x0000,
+      SG_SANITIZE_CRYPTO_SCRAMBLE = 0x0011,
+      SG_SANITIZE_BLOCK_ERASE     = 0x0012,
+      SG_SANITIZE_OVERWRITE       = 0x0014
+    };
+
   enum
     {
       FORM_FACTOR_UNKNOWN = 0x00,
@@ -258,11 +286,21 @@ namespace sg
     struct ata_lba_regs hob;
   };
 
+  struct sanitize_status
+  {
+    uint16_t progress;
+    uint8_t  completed:1;
+    uint8_t  in_progress:1;
+    uint8_t  frozen:1;
+    uint8_t  antifreeze:1;
+  };
+
   struct identity
   {
     uint64_t write_uncorrectable:1;
     uint64_t smart_supported:1;
     uint64_t smart_enabled:1;
+    uint64_t gpl_supported:1;
     uint64_t security_supported:1;
     uint64_t security_enabled:1;
     uint64_t security_locked:1;
@@ -273,10 +311,15 @@ namespace sg
     uint64_t overwrite:1;
     uint64_t crypto_scramble:1;
     uint64_t sanitize:1;
+    uint64_t sct_erc:1;
     uint64_t supports_sata_gen1:1;
     uint64_t supports_sata_gen2:1;
     uint64_t supports_sata_gen3:1;
     uint64_t trim_supported:1;
+    uint64_t trim_deterministic:1;
+    uint64_t trim_zeroes:1;
+    uint64_t dma_supported:1;
+    uint64_t ncq_supported:1;
 
     uint8_t  form_factor;
     uint32_t rpm;
@@ -298,20 +341,78 @@ namespace sg
        const unsigned int   timeout);
 
   int
+  io_hdr_to_errno(const struct sg_io_hdr &io_hdr);
+
+  /*
+    True when err is the command being refused rather than failing to
+    be carried out: a bare ATA ABRT, which io_hdr_to_errno() returns
+    as -ECANCELED, or the SATL's ILLEGAL REQUEST with INVALID COMMAND
+    OPERATION CODE or INVALID FIELD IN CDB.
+  */
+  bool
+  command_refused(const int err);
+
+  void
+  prepare_rw(struct sg_io_hdr &io_hdr,
+             uint8_t           cdb[SG_ATA_16_LEN],
+             uint8_t           sb[32],
+             const int         rw,
+             const int         xfer,
+             const uint64_t    lba,
+             const uint64_t    blocks,
+             void             *buf,
+             const size_t      buflen,
+             const int         timeout);
+
+  void
+  prepare_verify(struct sg_io_hdr &io_hdr,
+                 uint8_t           cdb[SG_ATA_16_LEN],
+                 uint8_t           sb[32],
+                 const uint64_t    lba,
+                 const uint64_t    blocks,
+                 const int         timeout);
+
+  std::string
+  generic_path(const int fd);
+
+  int
+  identify(const int  fd,
+           char       buf[256*2],
+           const int  timeout);
+  int
   identify(const int     fd,
            sg::identity &ident);
 
+  void
+  buf_to_identity(const char    buf[256*2],
+                  sg::identity &ident);
+
   int
   flush_write_cache(const int fd,
                     const int timeout);
 
+  int
+  xfer_mode(const sg::identity &ident);
+
+  const char*
+  xfer_mode_to_string(const int xfer);
+
   int
   read_block(const int       fd,
              const uint64_t  lba,
              const uint64_t  blocks,
              void           *buf,
              const size_t    buflen,
-             const int       timeout);
+             const int       timeout,
+             const int       xfer       = SG_PIO,
+             uint64_t       *failed_lba = NULL);
+
+  int
+  verify_block(const int       fd,
+               const uint64_t  lba,
+               const uint64_t  blocks,
+               const int       timeout,
+               uint64_t       *failed_lba = NULL);
 
   int
   write_block(const int       fd,
@@ -319,25 +420,68 @@ namespace sg
               const uint64_t  blocks,
               const void     *buf,
               const size_t    buflen,
-              const int       timeout);
+              const int       timeout,
+              const int       xfer = SG_PIO,
+              const bool      fua = false);
 
   int
   write_uncorrectable(const int      fd,
                       const uint64_t lba,
+                      const uint64_t blocks,
                       const uint8_t  type,
                       const int      timeout);
 
   int
   write_flagged_uncorrectable(const int      fd_,
                               const uint64_t lba_,
+                              const uint64_t blocks_,
                               const bool     log_,
                               const int      timeout_);
   int
   write_pseudo_uncorrectable(const int      fd_,
                              const uint64_t lba_,
+                             const uint64_t blocks_,
                              const bool     log_,
                              const int      timeout_);
 
+  int
+  dsm_trim(const int      fd,
+           const uint64_t lba,
+           const uint64_t blocks,
+           const int      timeout);
+
+  int
+  smart_read_data(const int  fd,
+                  uint8_t    buf[512],
+                  const int  timeout);
+  int
+  read_log_ext(const int       fd,
+               const uint8_t   log,
+               const uint16_t  page,
+               uint8_t        *buf,
+               const uint16_t  pages,
+               const int       timeout);
+
+  int
+  sct_erc_get(const int  fd,
+              const int  selection,
+              uint16_t  &deciseconds,
+              const int  timeout);
+  int
+  sct_erc_set(const int      fd,
+              const int      selection,
+              const uint16_t deciseconds,
+              const int      timeout);
+
+  int
+  sanitize(const int fd,
+           const int method,
+           const int timeout);
+  int
+  sanitize_status_ext(const int        fd,
+                      sanitize_status &status,
+                      const int        timeout);
+
   int
   security_set_password(const int  fd,
                         const int  identifier,
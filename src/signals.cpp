@@ -72,17 +72,10 @@ namespace signals
     sa.sa_handler = signals::handler;
 
     sigaction(SIGHUP,&sa,NULL);
-    sigaction(SIGALRM,&sa,NULL);
     sigaction(SIGTERM,&sa,NULL);
     sigaction(SIGINT,&sa,NULL);
     sigaction(SIGQUIT,&sa,NULL);
     sigaction(SIGUSR1,&sa,NULL);
     sigaction(SIGUSR2,&sa,NULL);
   }
-
-  unsigned int
-  alarm(const unsigned int secs)
-  {
-    return ::alarm(secs);
-  }
 }
@@ -33,8 +33,6 @@ namespace signals
 
   void handler(const int sig);
   void setup_handlers(void);
-
-  unsigned int alarm(const unsigned int secs);
 }
 
 #endif
@@ -0,0 +1,454 @@
+/*
+  ISC License
+
+  Copyright (c) 2016, Antonio SJ Musumeci <trapexit@spawn.link>
+
+  Permission to use, copy, modify, and/or distribute this software for any
+  purpose with or without fee is hereby granted, provided that the above
+  copyright notice and this permission notice appear in all copies.
+
+  THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+  WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+  MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+  ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+  WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+  ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+  OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+*/
+
+#include "simdev.hpp"
+
+#include <errno.h>
+#include <fcntl.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <sys/types.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <fstream>
+#include <sstream>
+#include <string>
+
+const char SimDev::PREFIX[] = "sim:";
+
+namespace l
+{
+  typedef std::map<uint64_t,uint64_t> Ranges;
+
+  static
+  bool
+  parse_range(const std::string &str_,
+              uint64_t          &start_,
+              uint64_t          &end_)
+  {
+    char *endptr;
+    const char *s = str_.c_str();
+
+    errno  = 0;
+    start_ = ::strtoull(s,&endptr,10);
+    if((errno != 0) || (endptr == s))
+      return false;
+
+    end_ = start_;
+    if(*endptr == '-')
+      {
+        s    = (endptr + 1);
+        end_ = ::strtoull(s,&endptr,10);
+        if((errno != 0) || (endptr == s))
+          return false;
+      }
+
+    return ((*endptr == '\0') && (start_ <= end_));
+  }
+
+  /* ranges are kept disjoint so the one starting last at or below a
+     block is the only one which can hold it */
+  static
+  void
+  add(Ranges         &ranges_,
+      uint64_t        start_,
+      uint64_t        end_)
+  {
+    Ranges::iterator i;
+
+    i = ranges_.upper_bound(start_);
+    if(i != ranges_.begin())
+      {
+        --i;
+        if(i->second >= start_)
+          {
+            start_ = i->first;
+            end_   = std::max(end_,i->second);
+            ranges_.erase(i++);
+          }
+        else
+          {
+            ++i;
+          }
+      }
+
+    while((i != ranges_.end()) && (i->first <= end_))
+      {
+        end_ = std::max(end_,i->second);
+        ranges_.erase(i++);
+      }
+
+    ranges_[start_] = end_;
+  }
+
+  static
+  void
+  remove(Ranges         &ranges_,
+         const uint64_t  start_,
+         const uint64_t  end_)
+  {
+    Ranges::iterator i;
+
+    i = ranges_.upper_bound(start_);
+    if(i != ranges_.begin())
+      --i;
+
+    while((i != ranges_.end()) && (i->first <= end_))
+      {
+        const uint64_t first = i->first;
+        const uint64_t last  = i->second;
+
+        if(last < start_)
+          {
+            ++i;
+            continue;
+          }
+
+        ranges_.erase(i++);
+        if(first < start_)
+          ranges_[first] = (start_ - 1);
+        if(last > end_)
+          ranges_[end_ + 1] = last;
+      }
+  }
+
+  static
+  bool
+  overlaps(const Ranges   &ranges_,
+           const uint64_t  start_,
+           const uint64_t  end_)
+  {
+    Ranges::const_iterator i;
+
+    i = ranges_.upper_bound(end_);
+    if(i == ranges_.begin())
+      return false;
+    --i;
+
+    return (i->second >= start_);
+  }
+
+  /* the first block of [start,end] within a range or UINT64_MAX */
+  static
+  uint64_t
+  first_overlap(const Ranges   &ranges_,
+                const uint64_t  start_,
+                const uint64_t  end_)
+  {
+    Ranges::const_iterator i;
+
+    i = ranges_.upper_bound(start_);
+    if(i != ranges_.begin())
+      {
+        Ranges::const_iterator prev = i;
+
+        --prev;
+        if(prev->second >= start_)
+          return start_;
+      }
+
+    if((i != ranges_.end()) && (i->first <= end_))
+      return i->first;
+
+    return UINT64_MAX;
+  }
+}
+
+SimDev::SimDev()
+  : _logical_block_size(512),
+    _physical_block_size(4096),
+    _size_in_bytes(0),
+    _latency(0),
+    _bandwidth(0),
+    _reap_error(0),
+    _reaps(0)
+{
+  pthread_mutex_init(&_lock,NULL);
+}
+
+SimDev::~SimDev()
+{
+  pthread_mutex_destroy(&_lock);
+}
+
+bool
+SimDev::is_sim(const std::string &path_)
+{
+  return (path_.compare(0,sizeof(PREFIX) - 1,PREFIX) == 0);
+}
+
+std::string
+SimDev::image_path(const std::string &path_)
+{
+  if(!is_sim(path_))
+    return path_;
+
+  return path_.substr(sizeof(PREFIX) - 1);
+}
+
+int
+SimDev::parse(const std::string &path_)
+{
+  uint64_t lineno;
+  std::string line;
+  std::ifstream file;
+
+  file.open(path_.c_str());
+  if(!file.is_open())
+    return 0;
+
+  lineno = 0;
+  while(std::getline(file,line))
+    {
+      uint64_t start;
+      uint64_t end;
+      std::string key;
+      std::string arg;
+      std::istringstream is(line.substr(0,line.find('#')));
+
+      lineno++;
+      if(!(is >> key))
+        continue;
+      if(!(is >> arg))
+        return -EINVAL;
+
+      if(key == "size")
+        _size_in_bytes = ::strtoull(arg.c_str(),NULL,10);
+      else if(key == "logical_block_size")
+        _logical_block_size = ::strtoull(arg.c_str(),NULL,10);
+      else if(key == "physical_block_size")
+        _physical_block_size = ::strtoull(arg.c_str(),NULL,10);
+      else if(key == "latency")
+        _latency = (::strtod(arg.c_str(),NULL) / 1000000.0);
+      else if(key == "bandwidth")
+        _bandwidth = (::strtod(arg.c_str(),NULL) * 1024.0 * 1024.0);
+      else if(key == "reap_error")
+        _reap_error = ::strtoull(arg.c_str(),NULL,10);
+      else if(!l::parse_range(arg,start,end))
+        return -EINVAL;
+      else if(key == "bad")
+        l::add(_bad,start,end);
+      else if(key == "hard")
+        l::add(_hard,start,end);
+      else if(key == "corrupt")
+        l::add(_corrupt,start,end);
+      else if(key == "slow")
+        {
+          Slow slow;
+
+          if(!(is >> arg))
+            return -EINVAL;
+
+          slow.start   = start;
+          slow.end     = end;
+          slow.seconds = (::strtod(arg.c_str(),NULL) / 1000000.0);
+
+          _slow.push_back(slow);
+        }
+      else
+        return -EINVAL;
+    }
+
+  if((_logical_block_size == 0) ||
+     (_physical_block_size < _logical_block_size) ||
+     (_physical_block_size % _logical_block_size))
+    return -EINVAL;
+
+  return 0;
+}
+
+/*
+  Geometry comes from the config with the image grown sparse to the
+  configured size. By path as fd may be read only. Without a size the image's own is used.
+*/
+int
+SimDev::load(const std::string &image_,
+             const int          fd_)
+{
+  int rv;
+  struct stat st;
+
+  rv = parse(image_ + ".sim");
+  if(rv < 0)
+    return rv;
+
+  rv = ::fstat(fd_,&st);
+  if(rv == -1)
+    return -errno;
+  if(!S_ISREG(st.st_mode))
+    return -EINVAL;
+
+  if((uint64_t)st.st_size < _size_in_bytes)
+    {
+      rv = ::truncate(image_.c_str(),_size_in_bytes);
+      if(rv == -1)
+        return -errno;
+    }
+
+  if(_size_in_bytes == 0)
+    _size_in_bytes = st.st_size;
+
+  _size_in_bytes -= (_size_in_bytes % _logical_block_size);
+  if(_size_in_bytes == 0)
+    return -EINVAL;
+
+  return 0;
+}
+
+/*
+  Returns blocks transferred like BlkDev::os_read / os_write. A
+  failing request transfers nothing, as with a real medium error.
+*/
+int64_t
+SimDev::io(const int       fd_,
+           const bool      write_,
+           const uint64_t  lba_,
+           const uint64_t  blocks_,
+           void           *buf_,
+           uint64_t       *failed_lba_)
+{
+  int64_t rv;
+  uint64_t end;
+  const uint64_t lbs = _logical_block_size;
+
+  if(blocks_ == 0)
+    return 0;
+
+  end = (lba_ + blocks_ - 1);
+
+  pthread_mutex_lock(&_lock);
+  rv = 0;
+  if(l::overlaps(_hard,lba_,end))
+    rv = -EIO;
+  else if(!write_ && l::overlaps(_bad,lba_,end))
+    rv = -EIO;
+  else if(write_)
+    l::remove(_bad,lba_,end);
+  if((rv < 0) && failed_lba_)
+    *failed_lba_ = std::min(l::first_overlap(_hard,lba_,end),
+                            (write_ ? UINT64_MAX : l::first_overlap(_bad,lba_,end)));
+  pthread_mutex_unlock(&_lock);
+  if(rv < 0)
+    return rv;
+
+  if(write_)
+    rv = ::pwrite(fd_,buf_,blocks_ * lbs,lba_ * lbs);
+  else
+    rv = ::pread(fd_,buf_,blocks_ * lbs,lba_ * lbs);
+  if(rv == -1)
+    return -errno;
+
+  rv /= lbs;
+  if(write_ || _corrupt.empty())
+    return rv;
+
+  // flip the first byte of every block in a corrupt range
+  l::Ranges::const_iterator i;
+
+  i = _corrupt.upper_bound(lba_);
+  if(i != _corrupt.begin())
+    --i;
+  for(; (i != _corrupt.end()) && (i->first <= end); ++i)
+    {
+      const uint64_t first = std::max(i->first,lba_);
+      const uint64_t last  = std::min(i->second,(uint64_t)(lba_ + rv - 1));
+
+      for(uint64_t b = first; (b <= last) && (rv > 0); b++)
+        ((char*)buf_)[(b - lba_) * lbs] ^= 0xFF;
+    }
+
+  return rv;
+}
+
+int
+SimDev::discard(const int      fd_,
+                const uint64_t lba_,
+                const uint64_t blocks_)
+{
+  int rv;
+  uint64_t end;
+  const uint64_t lbs = _logical_block_size;
+
+  if(blocks_ == 0)
+    return 0;
+
+  end = (lba_ + blocks_ - 1);
+
+  pthread_mutex_lock(&_lock);
+  rv = 0;
+  if(l::overlaps(_hard,lba_,end))
+    rv = -EIO;
+  else
+    l::remove(_bad,lba_,end);
+  pthread_mutex_unlock(&_lock);
+  if(rv < 0)
+    return rv;
+
+  rv = ::fallocate(fd_,
+                   (FALLOC_FL_PUNCH_HOLE|FALLOC_FL_KEEP_SIZE),
+                   (lba_ * lbs),
+                   (blocks_ * lbs));
+
+  return ((rv == -1) ? -errno : 0);
+}
+
+double
+SimDev::latency(const uint64_t lba_,
+                const uint64_t blocks_) const
+{
+  double rv;
+  const uint64_t end = (lba_ + blocks_ - 1);
+
+  rv = _latency;
+  if(_bandwidth > 0)
+    rv += ((blocks_ * _logical_block_size) / _bandwidth);
+
+  for(size_t i = 0; i < _slow.size(); i++)
+    if((_slow[i].start <= end) && (_slow[i].end >= lba_))
+      rv += _slow[i].seconds;
+
+  return rv;
+}
+
+void
+SimDev::mark_bad(const uint64_t lba_,
+                 const uint64_t blocks_)
+{
+  if(blocks_ == 0)
+    return;
+
+  pthread_mutex_lock(&_lock);
+  l::add(_bad,lba_,lba_ + blocks_ - 1);
+  pthread_mutex_unlock(&_lock);
+}
+
+int
+SimDev::reap(void)
+{
+  int rv;
+
+  pthread_mutex_lock(&_lock);
+  _reaps++;
+  rv = ((_reaps == _reap_error) ? -EIO : 0);
+  pthread_mutex_unlock(&_lock);
+
+  return rv;
+}
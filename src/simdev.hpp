@@ -0,0 +1,123 @@
+/*
+  ISC License
+
+  Copyright (c) 2016, Antonio SJ Musumeci <trapexit@spawn.link>
+
+  Permission to use, copy, modify, and/or distribute this software for any
+  purpose with or without fee is hereby granted, provided that the above
+  copyright notice and this permission notice appear in all copies.
+
+  THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+  WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+  MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+  ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+  WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+  ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+  OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+*/
+
+#pragma once
+
+#include <pthread.h>
+#include <stdint.h>
+
+#include <map>
+#include <string>
+#include <vector>
+
+/*
+  A simulated disk for testing and benchmarking without failing
+  hardware. `sim:<image>` opens the regular (usually sparse) file
+  image as a device and reads its behaviour from <image>.sim if
+  present, one directive per line:
+
+    size <bytes>                  grow the image to bytes (sparse)
+    logical_block_size <n>        default 512
+    physical_block_size <n>       default 4096
+    latency <usec>                added to every request
+    bandwidth <MB/s>              transfer time added per byte
+    bad <lba>[-<lba>]             reads fail with EIO until written
+    hard <lba>[-<lba>]            reads and writes fail with EIO
+    corrupt <lba>[-<lba>]         reads succeed with the data altered
+    slow <lba>[-<lba>] <usec>     added to requests touching the range
+    reap_error <n>                the nth AsyncIO reap fails with EIO
+
+  Ranges are inclusive and `#` starts a comment. Rewriting a `bad`
+  range clears it for the rest of the run as a drive reallocating
+  a pending sector would.
+
+  io() does the transfer and applies faults, reporting the first
+  failing block like a drive's sense data would; latency() is what that
+  request should take so the synchronous path sleeps for it and
+  AsyncIO completes it that much later. discard() punches a hole in
+  the image so the range reads back as zeros and, as a write would,
+  clears `bad` blocks within it. reap() is called by AsyncIO on each
+  reap so a test can have the pipeline fail with requests in flight.
+*/
+
+class SimDev
+{
+public:
+  static const char PREFIX[];
+
+public:
+  SimDev();
+  ~SimDev();
+
+public:
+  static bool        is_sim(const std::string &path);
+  static std::string image_path(const std::string &path);
+
+public:
+  int load(const std::string &image,
+           const int          fd);
+
+public:
+  int64_t io(const int       fd,
+             const bool      write,
+             const uint64_t  lba,
+             const uint64_t  blocks,
+             void           *buf,
+             uint64_t       *failed_lba = NULL);
+  int     discard(const int      fd,
+                  const uint64_t lba,
+                  const uint64_t blocks);
+  double  latency(const uint64_t lba,
+                  const uint64_t blocks) const;
+  void    mark_bad(const uint64_t lba,
+                   const uint64_t blocks);
+  int     reap(void);
+
+public:
+  uint64_t logical_block_size(void) const { return _logical_block_size; }
+  uint64_t physical_block_size(void) const { return _physical_block_size; }
+  uint64_t size_in_bytes(void) const { return _size_in_bytes; }
+
+private:
+  struct Slow
+  {
+    uint64_t start;
+    uint64_t end;
+    double   seconds;
+  };
+
+  // inclusive [first,second] keyed by first
+  typedef std::map<uint64_t,uint64_t> Ranges;
+
+private:
+  int parse(const std::string &path);
+
+private:
+  uint64_t          _logical_block_size;
+  uint64_t          _physical_block_size;
+  uint64_t          _size_in_bytes;
+  double            _latency;
+  double            _bandwidth;
+  Ranges            _bad;
+  Ranges            _hard;
+  Ranges            _corrupt;
+  std::vector<Slow> _slow;
+  uint64_t          _reap_error;
+  uint64_t          _reaps;
+  pthread_mutex_t   _lock;
+};
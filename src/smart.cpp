@@ -0,0 +1,256 @@
+/*
+  ISC License
+
+  Copyright (c) 2016, Antonio SJ Musumeci <trapexit@spawn.link>
+
+  Permission to use, copy, modify, and/or distribute this software for any
+  purpose with or without fee is hereby granted, provided that the above
+  copyright notice and this permission notice appear in all copies.
+
+  THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+  WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+  MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+  ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+  WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+  ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+  OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+*/
+
+#include "smart.hpp"
+
+#include "blkdev.hpp"
+#include "progress.hpp"
+#include "sg.hpp"
+
+#include <errno.h>
+#include <stdint.h>
+#include <string.h>
+
+#include <algorithm>
+#include <ostream>
+
+namespace l
+{
+  /*
+    Where each counter lives: its SMART attribute ID and, if it has
+    one, its Device Statistics page and byte offset.
+  */
+  struct Source
+  {
+    const char *name;
+    uint8_t     attribute;
+    uint8_t     page;
+    uint16_t    offset;
+  };
+
+  static const Source SOURCES[Smart::COUNTERS] =
+    {
+      {"reallocated sectors",    5,   0x03, 0x20},
+      {"pending sectors",        197, 0x03, 0x38},
+      {"offline uncorrectable",  198, 0x00, 0x00},
+      {"reported uncorrectable", 187, 0x04, 0x08},
+      {"reallocation events",    196, 0x00, 0x00},
+      {"interface CRC errors",   199, 0x06, 0x18}
+    };
+
+  static const uint8_t DEVICE_STATISTICS_LOG = 0x04;
+
+  static
+  uint64_t
+  le_to_u64(const uint8_t *buf_,
+            const int      bytes_)
+  {
+    uint64_t rv;
+
+    rv = 0;
+    for(int i = (bytes_ - 1); i >= 0; i--)
+      rv = ((rv << 8) | buf_[i]);
+
+    return rv;
+  }
+
+  /*
+    30 twelve byte entries from offset 2: ID, flags (2), current,
+    worst and a 48 bit raw value. Vendors pack other things in the
+    upper raw bytes of some attributes but not of these.
+  */
+  static
+  int
+  attributes(const BlkDev    &blkdev_,
+             const int        timeout_,
+             Smart::Snapshot &snapshot_)
+  {
+    int rv;
+    uint8_t buf[512];
+
+    rv = sg::smart_read_data(blkdev_.fd(),buf,timeout_);
+    if(rv < 0)
+      return rv;
+
+    for(int i = 0; i < 30; i++)
+      {
+        const uint8_t *entry = &buf[2 + (i * 12)];
+
+        if(entry[0] == 0)
+          continue;
+
+        for(int c = 0; c < Smart::COUNTERS; c++)
+          if(SOURCES[c].attribute == entry[0])
+            snapshot_.value[c] = le_to_u64(&entry[5],6);
+      }
+
+    return 0;
+  }
+
+  /*
+    Every statistic is a 64 bit little endian word: bit 63 supported,
+    bit 62 valid, the value in the low 48 bits. The first word of a
+    page holds its revision and page number.
+  */
+  static
+  int
+  device_statistics(const BlkDev    &blkdev_,
+                    const int        timeout_,
+                    const uint8_t    page_,
+                    Smart::Snapshot &snapshot_)
+  {
+    int rv;
+    uint8_t buf[512];
+
+    rv = sg::read_log_ext(blkdev_.fd(),DEVICE_STATISTICS_LOG,page_,buf,1,timeout_);
+    if(rv < 0)
+      return rv;
+    if(buf[2] != page_)
+      return -ENODATA;
+
+    for(int c = 0; c < Smart::COUNTERS; c++)
+      {
+        uint64_t stat;
+
+        if((SOURCES[c].page != page_) || (SOURCES[c].offset == 0))
+          continue;
+
+        stat = le_to_u64(&buf[SOURCES[c].offset],8);
+        if((stat & 0xC000000000000000ULL) != 0xC000000000000000ULL)
+          continue;
+
+        snapshot_.value[c] = (stat & 0x0000FFFFFFFFFFFFULL);
+      }
+
+    return 0;
+  }
+
+  static
+  bool
+  known(const Smart::Snapshot &snapshot_)
+  {
+    for(int c = 0; c < Smart::COUNTERS; c++)
+      if(snapshot_.value[c] != Smart::UNKNOWN)
+        return true;
+
+    return false;
+  }
+
+  static
+  void
+  print_value(std::ostream   &os_,
+              const uint64_t  value_)
+  {
+    if(value_ == Smart::UNKNOWN)
+      os_ << '?';
+    else
+      os_ << value_;
+  }
+}
+
+namespace Smart
+{
+  const char*
+  name(const int counter_)
+  {
+    return l::SOURCES[counter_].name;
+  }
+
+  /*
+    Returns 0 when at least one counter was read. A drive busy with a
+    bad sector shouldn't hold the run up for the full command timeout
+    here so at most 10 seconds are given.
+  */
+  int
+  snapshot(const BlkDev &blkdev_,
+           Snapshot     &snapshot_,
+           Progress     *progress_)
+  {
+    int timeout;
+
+    for(int c = 0; c < COUNTERS; c++)
+      snapshot_.value[c] = UNKNOWN;
+
+    if(blkdev_.sim() || !blkdev_.has_identity())
+      return -ENOTSUP;
+
+    timeout = std::min(blkdev_.timeout(),10000);
+
+    if(blkdev_.identity().smart_enabled)
+      l::attributes(blkdev_,timeout,snapshot_);
+
+    if(blkdev_.identity().gpl_supported)
+      {
+        l::device_statistics(blkdev_,timeout,0x03,snapshot_);
+        l::device_statistics(blkdev_,timeout,0x04,snapshot_);
+        l::device_statistics(blkdev_,timeout,0x06,snapshot_);
+      }
+
+    if(progress_)
+      progress_->set_smart(snapshot_.value[REALLOCATED],
+                           snapshot_.value[PENDING]);
+
+    return (l::known(snapshot_) ? 0 : -ENODATA);
+  }
+
+  void
+  print(std::ostream   &os_,
+        const Snapshot &snapshot_)
+  {
+    if(!l::known(snapshot_))
+      return;
+
+    os_ << " - smart:" << std::endl;
+    for(int c = 0; c < COUNTERS; c++)
+      {
+        if(snapshot_.value[c] == UNKNOWN)
+          continue;
+
+        os_ << "   - " << name(c) << ": " << snapshot_.value[c] << std::endl;
+      }
+  }
+
+  /* "reallocated sectors: 8 -> 10 (+2)" for each counter known */
+  void
+  print(std::ostream   &os_,
+        const Snapshot &before_,
+        const Snapshot &after_)
+  {
+    if(!l::known(before_) && !l::known(after_))
+      return;
+
+    os_ << "SMART:" << std::endl;
+    for(int c = 0; c < COUNTERS; c++)
+      {
+        const uint64_t a = before_.value[c];
+        const uint64_t b = after_.value[c];
+
+        if((a == UNKNOWN) && (b == UNKNOWN))
+          continue;
+
+        os_ << " - " << name(c) << ": ";
+        l::print_value(os_,a);
+        os_ << " -> ";
+        l::print_value(os_,b);
+        if((a != UNKNOWN) && (b != UNKNOWN) && (a != b))
+          os_ << " (" << ((b > a) ? '+' : '-')
+              << ((b > a) ? (b - a) : (a - b)) << ')';
+        os_ << std::endl;
+      }
+  }
+}
@@ -0,0 +1,68 @@
+/*
+  ISC License
+
+  Copyright (c) 2016, Antonio SJ Musumeci <trapexit@spawn.link>
+
+  Permission to use, copy, modify, and/or distribute this software for any
+  purpose with or without fee is hereby granted, provided that the above
+  copyright notice and this permission notice appear in all copies.
+
+  THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+  WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+  MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+  ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+  WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+  ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+  OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+*/
+
+#pragma once
+
+#include <stdint.h>
+
+#include <ostream>
+
+class BlkDev;
+class Progress;
+
+/*
+  The counters which show a drive remapping sectors or failing to
+  read them, snapshotted before and after a scan, burnin or fix so
+  the effect of the run is reported without a separate smartctl pass.
+  Taken from the Device Statistics log (GPL log 0x04), whose layout is
+  standardized, where the drive provides it and otherwise from the
+  conventional SMART attribute IDs. Counters the drive doesn't report
+  are UNKNOWN.
+*/
+namespace Smart
+{
+  enum Counter
+    {
+      REALLOCATED,
+      PENDING,
+      OFFLINE_UNCORRECTABLE,
+      REPORTED_UNCORRECTABLE,
+      REALLOCATION_EVENTS,
+      CRC_ERRORS,
+      COUNTERS
+    };
+
+  static const uint64_t UNKNOWN = UINT64_MAX;
+
+  struct Snapshot
+  {
+    uint64_t value[COUNTERS];
+  };
+
+  const char *name(const int counter);
+
+  int snapshot(const BlkDev &blkdev,
+               Snapshot     &snapshot,
+               Progress     *progress = NULL);
+
+  void print(std::ostream   &os,
+             const Snapshot &snapshot);
+  void print(std::ostream   &os,
+             const Snapshot &before,
+             const Snapshot &after);
+}
@@ -0,0 +1,183 @@
+/*
+  ISC License
+
+  Copyright (c) 2016, Antonio SJ Musumeci <trapexit@spawn.link>
+
+  Permission to use, copy, modify, and/or distribute this software for any
+  purpose with or without fee is hereby granted, provided that the above
+  copyright notice and this permission notice appear in all copies.
+
+  THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+  WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+  MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+  ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+  WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+  ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+  OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+*/
+
+#include "throttle.hpp"
+
+#include "time.hpp"
+
+#include <errno.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+#include <algorithm>
+
+#define IOPRIO_CLASS_SHIFT 13
+#define IOPRIO_CLASS_IDLE  3
+#define IOPRIO_WHO_PROCESS 1
+
+namespace l
+{
+  static const double BURST           = 0.1;
+  static const double MIN_DELAY       = 0.001;
+  static const double MAX_DELAY       = 1.0;
+  static const double ADJUST_INTERVAL = 0.1;
+}
+
+Throttle::Throttle(const uint64_t bytes_per_second_,
+                   const uint64_t requests_per_second_,
+                   const double   latency_target_)
+  : _bytes_rate(bytes_per_second_),
+    _requests_rate(requests_per_second_),
+    _latency_target(latency_target_),
+    _bytes(bytes_per_second_ * l::BURST),
+    _requests(requests_per_second_ * l::BURST),
+    _delay(0),
+    _last_refill(Time::get_monotonic()),
+    _last_adjust(0)
+{
+  pthread_mutex_init(&_lock,NULL);
+}
+
+Throttle::~Throttle()
+{
+  pthread_mutex_destroy(&_lock);
+}
+
+/*
+  Moves the calling process into the idle I/O scheduling class so its
+  requests are only served when nothing else wants the device. Threads
+  created afterwards inherit it. Only honoured by schedulers which
+  support priorities such as BFQ.
+*/
+int
+Throttle::set_idle_priority(void)
+{
+  int rv;
+
+  rv = ::syscall(SYS_ioprio_set,
+                 IOPRIO_WHO_PROCESS,
+                 0,
+                 (IOPRIO_CLASS_IDLE << IOPRIO_CLASS_SHIFT));
+
+  return ((rv == -1) ? -errno : 0);
+}
+
+bool
+Throttle::enabled(void) const
+{
+  return ((_bytes_rate > 0) ||
+          (_requests_rate > 0) ||
+          (_latency_target > 0));
+}
+
+double
+Throttle::delay(void) const
+{
+  double rv;
+
+  pthread_mutex_lock(&_lock);
+  rv = _delay;
+  pthread_mutex_unlock(&_lock);
+
+  return rv;
+}
+
+void
+Throttle::refill(const double now_)
+{
+  const double elapsed = (now_ - _last_refill);
+
+  _last_refill = now_;
+  if(_bytes_rate > 0)
+    _bytes = std::min((_bytes + (elapsed * _bytes_rate)),(_bytes_rate * l::BURST));
+  if(_requests_rate > 0)
+    _requests = std::min((_requests + (elapsed * _requests_rate)),(_requests_rate * l::BURST));
+}
+
+/*
+  Takes the tokens for one request of `bytes` and returns how many
+  seconds the caller should wait before issuing it.
+*/
+double
+Throttle::reserve(const uint64_t bytes_)
+{
+  double rv;
+
+  pthread_mutex_lock(&_lock);
+
+  refill(Time::get_monotonic());
+
+  rv = 0;
+  if(_bytes_rate > 0)
+    {
+      _bytes -= bytes_;
+      if(_bytes < 0)
+        rv = std::max(rv,(-_bytes / _bytes_rate));
+    }
+  if(_requests_rate > 0)
+    {
+      _requests -= 1;
+      if(_requests < 0)
+        rv = std::max(rv,(-_requests / _requests_rate));
+    }
+
+  rv += _delay;
+
+  pthread_mutex_unlock(&_lock);
+
+  return rv;
+}
+
+void
+Throttle::wait(const uint64_t bytes_)
+{
+  double seconds;
+
+  seconds = reserve(bytes_);
+  if(seconds > 0)
+    Time::sleep(seconds);
+}
+
+void
+Throttle::observe(const double seconds_)
+{
+  double now;
+
+  if(_latency_target <= 0)
+    return;
+
+  now = Time::get_monotonic();
+
+  pthread_mutex_lock(&_lock);
+
+  if((now - _last_adjust) >= l::ADJUST_INTERVAL)
+    {
+      if(seconds_ > _latency_target)
+        {
+          _delay       = std::min(std::max((_delay * 2),l::MIN_DELAY),l::MAX_DELAY);
+          _last_adjust = now;
+        }
+      else if(_delay > 0)
+        {
+          _delay       = (((_delay / 2) < l::MIN_DELAY) ? 0 : (_delay / 2));
+          _last_adjust = now;
+        }
+    }
+
+  pthread_mutex_unlock(&_lock);
+}
@@ -0,0 +1,73 @@
+/*
+  ISC License
+
+  Copyright (c) 2016, Antonio SJ Musumeci <trapexit@spawn.link>
+
+  Permission to use, copy, modify, and/or distribute this software for any
+  purpose with or without fee is hereby granted, provided that the above
+  copyright notice and this permission notice appear in all copies.
+
+  THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+  WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+  MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+  ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+  WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+  ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+  OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+*/
+
+#pragma once
+
+#include <pthread.h>
+#include <stdint.h>
+
+/*
+  Paces the requests of a scan or burnin so it can share a device
+  with live I/O. Token buckets of bytes and requests per second
+  refill continuously up to BURST seconds worth. A request takes its
+  tokens up front, running into debt if need be, and the caller waits
+  until the debt would be repaid.
+
+  With a latency target requests taking longer than it are taken as
+  a sign of competing load: a delay added before every request
+  doubles, from MIN_DELAY up to MAX_DELAY, and halves again once
+  requests complete within the target. The delay changes at most once
+  per ADJUST_INTERVAL so a queue full of slow requests counts once.
+
+  One Throttle is shared by every thread issuing requests to a device.
+*/
+
+class Throttle
+{
+public:
+  Throttle(const uint64_t bytes_per_second,
+           const uint64_t requests_per_second,
+           const double   latency_target);
+  ~Throttle();
+
+public:
+  static int set_idle_priority(void);
+
+public:
+  double reserve(const uint64_t bytes);
+  void   wait(const uint64_t bytes);
+  void   observe(const double seconds);
+
+public:
+  bool   enabled(void) const;
+  double delay(void) const;
+
+private:
+  void refill(const double now);
+
+private:
+  mutable pthread_mutex_t _lock;
+  double _bytes_rate;
+  double _requests_rate;
+  double _latency_target;
+  double _bytes;
+  double _requests;
+  double _delay;
+  double _last_refill;
+  double _last_adjust;
+};
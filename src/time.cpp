@@ -29,4 +29,15 @@ namespace Time
 
     return ((double)now.tv_sec + ((double)now.tv_nsec / 1000000000.0));
   }
+
+  void
+  sleep(const double seconds_)
+  {
+    struct timespec ts;
+
+    ts.tv_sec  = (time_t)seconds_;
+    ts.tv_nsec = (long)((seconds_ - ts.tv_sec) * 1000000000.0);
+
+    nanosleep(&ts,NULL);
+  }
 }
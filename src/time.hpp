@@ -22,4 +22,7 @@ namespace Time
 {
   double
   get_monotonic(void);
+
+  void
+  sleep(const double seconds);
 }
@@ -0,0 +1,218 @@
+/*
+  ISC License
+
+  Copyright (c) 2016, Antonio SJ Musumeci <trapexit@spawn.link>
+
+  Permission to use, copy, modify, and/or distribute this software for any
+  purpose with or without fee is hereby granted, provided that the above
+  copyright notice and this permission notice appear in all copies.
+
+  THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+  WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+  MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+  ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+  WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+  ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+  OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+*/
+
+#include "topology.hpp"
+
+#include <errno.h>
+#include <limits.h>
+#include <linux/mempolicy.h>
+#include <pthread.h>
+#include <sched.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <sys/stat.h>
+#include <sys/syscall.h>
+#include <sys/sysmacros.h>
+#include <sys/types.h>
+#include <unistd.h>
+
+#include <fstream>
+#include <sstream>
+#include <string>
+
+namespace l
+{
+  static
+  int
+  read_int(const std::string &path_,
+           int               &value_)
+  {
+    std::ifstream file;
+
+    file.open(path_.c_str());
+    if(!(file >> value_))
+      return -ENOENT;
+
+    return 0;
+  }
+
+  /*
+    Parses a sysfs list ("0-15,32-47") of CPUs or nodes into
+    set_. Returns the number of entries.
+  */
+  static
+  int
+  parse_cpulist(const std::string &list_,
+                cpu_set_t         &set_)
+  {
+    int count;
+    std::string range;
+    std::istringstream is(list_);
+
+    count = 0;
+    while(std::getline(is,range,','))
+      {
+        int n;
+        int lo;
+        int hi;
+
+        n = ::sscanf(range.c_str(),"%d-%d",&lo,&hi);
+        if(n == 1)
+          hi = lo;
+        else if(n != 2)
+          continue;
+
+        for(int cpu = lo; (cpu <= hi) && (cpu < CPU_SETSIZE); cpu++)
+          {
+            CPU_SET(cpu,&set_);
+            count++;
+          }
+      }
+
+    return count;
+  }
+}
+
+/*
+  Number of online NUMA nodes, 1 on machines without NUMA.
+*/
+int
+Topology::nodes(void)
+{
+  int count;
+  std::string online;
+  std::ifstream file;
+  cpu_set_t set;
+
+  file.open("/sys/devices/system/node/online");
+  if(!std::getline(file,online))
+    return 1;
+
+  CPU_ZERO(&set);
+  count = l::parse_cpulist(online,set);
+
+  return ((count > 0) ? count : 1);
+}
+
+int
+Topology::device_node(const std::string &devpath_)
+{
+  int rv;
+  int node;
+  struct stat st;
+  std::string path;
+  char sysfs[PATH_MAX];
+  char real[PATH_MAX];
+
+  rv = ::stat(devpath_.c_str(),&st);
+  if((rv == -1) || !S_ISBLK(st.st_mode))
+    return -1;
+
+  ::snprintf(sysfs,sizeof(sysfs),"/sys/dev/block/%u:%u",
+             major(st.st_rdev),minor(st.st_rdev));
+  if(::realpath(sysfs,real) == NULL)
+    return -1;
+
+  // partition -> disk -> ... -> PCI function, which knows its node
+  path = real;
+  while(path.size() > (sizeof("/sys/devices") - 1))
+    {
+      rv = l::read_int(path + "/numa_node",node);
+      if(rv == 0)
+        return node;
+
+      path.erase(path.rfind('/'));
+    }
+
+  return -1;
+}
+
+int
+Topology::current_node(void)
+{
+  int rv;
+  unsigned cpu;
+  unsigned node;
+
+  rv = ::syscall(SYS_getcpu,&cpu,&node,NULL);
+  if(rv == -1)
+    return -1;
+
+  return (int)node;
+}
+
+/*
+  CPUs of node_ as sysfs lists them.
+*/
+std::string
+Topology::cpulist(const int node_)
+{
+  std::string list;
+  std::ifstream file;
+  char path[PATH_MAX];
+
+  ::snprintf(path,sizeof(path),"/sys/devices/system/node/node%d/cpulist",
+             node_);
+
+  file.open(path);
+  std::getline(file,list);
+
+  return list;
+}
+
+/*
+  Restricts the calling thread to the CPUs of node_ it was already
+  allowed to use and has it prefer node_'s memory. Threads it creates
+  inherit both.
+*/
+int
+Topology::bind(const int node_)
+{
+  int rv;
+  cpu_set_t allowed;
+  cpu_set_t local;
+  cpu_set_t set;
+  unsigned long nodemask[16] = {0};
+  const int bits = (sizeof(unsigned long) * 8);
+
+  if((node_ < 0) || (node_ >= (int)(sizeof(nodemask) * 8)))
+    return -EINVAL;
+
+  CPU_ZERO(&local);
+  if(l::parse_cpulist(cpulist(node_),local) == 0)
+    return -ENOENT;
+
+  rv = pthread_getaffinity_np(pthread_self(),sizeof(allowed),&allowed);
+  if(rv != 0)
+    return -rv;
+
+  CPU_AND(&set,&allowed,&local);
+  if(CPU_COUNT(&set) == 0)
+    return -ENOENT;
+
+  rv = pthread_setaffinity_np(pthread_self(),sizeof(set),&set);
+  if(rv != 0)
+    return -rv;
+
+  nodemask[node_ / bits] |= (1UL << (node_ % bits));
+  rv = ::syscall(SYS_set_mempolicy,MPOL_PREFERRED,nodemask,(sizeof(nodemask) * 8));
+  if(rv == -1)
+    return -errno;
+
+  return 0;
+}
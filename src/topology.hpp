@@ -0,0 +1,38 @@
+/*
+  ISC License
+
+  Copyright (c) 2016, Antonio SJ Musumeci <trapexit@spawn.link>
+
+  Permission to use, copy, modify, and/or distribute this software for any
+  purpose with or without fee is hereby granted, provided that the above
+  copyright notice and this permission notice appear in all copies.
+
+  THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+  WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+  MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+  ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+  WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+  ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+  OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+*/
+
+#pragma once
+
+#include <string>
+
+/*
+  Where a block device sits in the machine's NUMA topology, found by
+  walking up its sysfs path to the PCI function (HBA, NVMe controller)
+  it hangs off. A thread bound to a node only runs on that node's CPUs
+  and allocates its memory there first. Nodes are -1 when unknown:
+  virtual devices, simulators or machines without NUMA.
+*/
+namespace Topology
+{
+  int nodes(void);
+  int device_node(const std::string &devpath);
+  int current_node(void);
+
+  std::string cpulist(const int node);
+  int         bind(const int node);
+}
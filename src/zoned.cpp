@@ -0,0 +1,141 @@
+/*
+  ISC License
+
+  Copyright (c) 2016, Antonio SJ Musumeci <trapexit@spawn.link>
+
+  Permission to use, copy, modify, and/or distribute this software for any
+  purpose with or without fee is hereby granted, provided that the above
+  copyright notice and this permission notice appear in all copies.
+
+  THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+  WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+  MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+  ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+  WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+  ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+  OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+*/
+
+#include "zoned.hpp"
+
+#include "ioctl.hpp"
+
+#include <errno.h>
+#include <limits.h>
+#include <linux/blkzoned.h>
+#include <stdio.h>
+#include <sys/stat.h>
+#include <sys/sysmacros.h>
+#include <sys/types.h>
+
+#include <fstream>
+
+/*
+  Returns the number of zones, 0 for a device which isn't zoned or
+  isn't a block device at all (a simulator image).
+*/
+int
+Zoned::report(const BlkDev      &blkdev_,
+              std::vector<Zone> &zones_)
+{
+  int rv;
+  std::vector<IOCtl::Zone> zones;
+  const uint64_t spb = (blkdev_.logical_block_size() / 512);
+
+  if(blkdev_.sim())
+    return 0;
+
+  rv = IOCtl::report_zones(blkdev_.fd(),zones);
+  if((rv == -ENOTTY) || (rv == -EINVAL))
+    return 0;
+  if(rv <= 0)
+    return rv;
+
+  zones_.reserve(zones.size());
+  for(size_t i = 0; i < zones.size(); i++)
+    {
+      Zone zone;
+
+      zone.start      = (zones[i].start / spb);
+      zone.length     = (zones[i].length / spb);
+      zone.capacity   = (zones[i].capacity / spb);
+      zone.wp         = (zones[i].wp / spb);
+      zone.sequential = (zones[i].type != BLK_ZONE_TYPE_CONVENTIONAL);
+      zone.cond       = zones[i].cond;
+      zones_.push_back(zone);
+    }
+
+  return zones_.size();
+}
+
+/*
+  Blocks from the zone's start which can be read: all of a
+  conventional or full zone, up to the write pointer otherwise.
+*/
+uint64_t
+Zoned::written(const Zone &zone_)
+{
+  if(!zone_.sequential)
+    return zone_.length;
+
+  switch(zone_.cond)
+    {
+    case BLK_ZONE_COND_FULL:
+      return zone_.capacity;
+    case BLK_ZONE_COND_EMPTY:
+    case BLK_ZONE_COND_OFFLINE:
+      return 0;
+    default:
+      break;
+    }
+
+  return ((zone_.wp > zone_.start) ? (zone_.wp - zone_.start) : 0);
+}
+
+bool
+Zoned::usable(const Zone &zone_)
+{
+  return ((zone_.cond != BLK_ZONE_COND_OFFLINE) &&
+          (zone_.cond != BLK_ZONE_COND_READONLY));
+}
+
+int
+Zoned::reset(const BlkDev &blkdev_,
+             const Zone   &zone_)
+{
+  const uint64_t spb = (blkdev_.logical_block_size() / 512);
+
+  if(!zone_.sequential)
+    return 0;
+
+  return IOCtl::reset_zone(blkdev_.fd(),
+                           (zone_.start * spb),
+                           (zone_.length * spb));
+}
+
+/*
+  The device's limit on zones open for writing at once from
+  queue/max_open_zones, 0 when it has none or doesn't say.
+*/
+uint64_t
+Zoned::max_open_zones(const BlkDev &blkdev_)
+{
+  int rv;
+  uint64_t count;
+  struct stat st;
+  std::ifstream file;
+  char sysfs[PATH_MAX];
+
+  rv = ::fstat(blkdev_.fd(),&st);
+  if((rv == -1) || !S_ISBLK(st.st_mode))
+    return 0;
+
+  ::snprintf(sysfs,sizeof(sysfs),"/sys/dev/block/%u:%u/queue/max_open_zones",
+             major(st.st_rdev),minor(st.st_rdev));
+
+  file.open(sysfs);
+  if(!(file >> count))
+    return 0;
+
+  return count;
+}
@@ -0,0 +1,56 @@
+/*
+  ISC License
+
+  Copyright (c) 2016, Antonio SJ Musumeci <trapexit@spawn.link>
+
+  Permission to use, copy, modify, and/or distribute this software for any
+  purpose with or without fee is hereby granted, provided that the above
+  copyright notice and this permission notice appear in all copies.
+
+  THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+  WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+  MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+  ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+  WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+  ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+  OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+*/
+
+#pragma once
+
+#include "blkdev.hpp"
+
+#include <stdint.h>
+
+#include <vector>
+
+/*
+  Zones of a host managed / host aware SMR or ZNS device in logical
+  blocks. Sequential zones can only be written at their write pointer
+  and have to be reset to be written again; reading past the write
+  pointer returns nothing useful or fails. Capacity is how much of
+  the zone can be written, less than its length on some ZNS drives.
+*/
+namespace Zoned
+{
+  struct Zone
+  {
+    uint64_t start;
+    uint64_t length;
+    uint64_t capacity;
+    uint64_t wp;
+    bool     sequential;
+    uint8_t  cond;
+  };
+
+  int report(const BlkDev      &blkdev,
+             std::vector<Zone> &zones);
+
+  uint64_t written(const Zone &zone);
+  bool     usable(const Zone &zone);
+
+  int reset(const BlkDev &blkdev,
+            const Zone   &zone);
+
+  uint64_t max_open_zones(const BlkDev &blkdev);
+}